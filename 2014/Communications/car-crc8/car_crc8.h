@@ -0,0 +1,30 @@
+#ifndef car_crc8_h
+#define car_crc8_h
+
+// The CRC-8 every CAR link uses: polynomial 0x07, initial value 0, no final
+// XOR (as SMBus PEC, check value 0xF4 for "123456789"). Header only and free
+// of Arduino calls, so car-wire, the 2015 brain board frames, the collision
+// board's report frame and the pi's nodes all build the same one.
+//
+// Pass 0 to start and the last result to carry on, so a CRC can run over
+// pieces that aren't next to each other:
+//
+//	crc = car_crc8(car_crc8(0, &reg, 1), frame, bytes);
+
+#include <stdint.h>
+
+static inline uint8_t car_crc8(uint8_t crc, const uint8_t* data, uint8_t bytes){
+	// A nibble at a time: two lookups a byte instead of eight shifts
+	static const uint8_t table[16] = {
+		0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+		0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+	};
+	for (uint8_t i=0; i<bytes; i++){
+		crc ^= data[i];
+		crc = (uint8_t)(crc << 4) ^ table[crc >> 4];
+		crc = (uint8_t)(crc << 4) ^ table[crc >> 4];
+	}
+	return crc;
+}
+
+#endif
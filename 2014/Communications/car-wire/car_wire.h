@@ -0,0 +1,27 @@
+#ifndef car_wire_h
+#define car_wire_h
+
+// What goes over the wire for one register (a block of data on a slave):
+//
+//	[sequence] [data, length fixed per register] [CRC-8]
+//
+// The slave bumps sequence each time it publishes new data, so the master
+// can tell a repeat from a new sample. The CRC-8 (car_crc8.h: polynomial
+// 0x07, as SMBus PEC) covers the register number, sequence and data, so a
+// block read from the wrong register or cut short doesn't pass.
+//
+// A master write is [register] [data] [CRC-8 over register and data]; the
+// slave keeps the CRC of the last good write at CAR_WIRE_ACK_REG for the
+// master to read back.
+
+#include <Arduino.h>
+#include <i2c_t3.h>
+#include <car_crc8.h>
+
+#define CAR_WIRE_OVERHEAD	2	// sequence before the data, CRC-8 after
+#define CAR_WIRE_MAX_DATA	32	// longest block
+#define CAR_WIRE_ACK_REG	0xFF	// CRC of the last good write, one byte
+
+#define CAR_WIRE_FRAME(bytes)	((bytes) + CAR_WIRE_OVERHEAD)
+
+#endif
@@ -1,49 +1,94 @@
 #include "master_car_wire.h"
 
-bool master_car_wire::requestFrom(void* buffer, unsigned char bytes, unsigned char devAddr, unsigned char register){
-	_sum=0;
-
-	Wire.beginTransmission(register);
-	Wire.write(register);
-	Wire.endTranmission();
-
-	Wire.requestFrom(devAddr, bytes+2);
-	while(Wire.available() < (bytes+2){}
-	for (int i=0; i<bytes; i++){
-		buffer[i] = Wire.read();
-		_sum += buffer[i];
+#include <string.h>
+
+car_wire_block::car_wire_block(unsigned char devAddr, unsigned char reg, void* buffer, unsigned char bytes){
+	this->devAddr = devAddr;
+	this->reg = reg;
+	this->bytes = bytes;
+	this->buffer = buffer;
+	sequence = 0;
+	unchanged = 0;
+	status = CAR_WIRE_NONE;
+}
+
+master_car_wire::master_car_wire(i2c_t3& bus) : _bus(bus){
+}
+
+// Register write and repeated start read of one frame into _frame. Returns
+// CAR_WIRE_FRESH for a good frame, whatever its sequence.
+unsigned char master_car_wire::readFrame(unsigned char devAddr, unsigned char reg, unsigned char bytes, i2c_stop stop){
+	unsigned char frameBytes = CAR_WIRE_FRAME(bytes);
+
+	if (bytes > CAR_WIRE_MAX_DATA)
+		return CAR_WIRE_BAD_CRC;
+
+	_bus.beginTransmission(devAddr);
+	_bus.write(reg);
+	if (_bus.endTransmission(I2C_NOSTOP) != 0)
+		return CAR_WIRE_NAK;
+	if (_bus.requestFrom(devAddr, frameBytes, stop) < frameBytes)
+		return CAR_WIRE_NAK;
+	unsigned char all = 0xFF;
+	for (unsigned char i=0; i<frameBytes; i++){
+		_frame[i] = _bus.readByte();
+		all &= _frame[i];
 	}
-	void * checkSumAddr = &_checkSum;
-	checkSumAddr[0]=Wire.read();
-	checkSumAddr[1]=Wire.read();
-	if(_sum!=_checkSum)
-		return false;
-	else
-		return true;
+
+	// A slave with nothing for reg leaves the bus high, whatever the CRC says
+	if (all == 0xFF || car_crc8(car_crc8(0, &reg, 1), _frame, frameBytes - 1) != _frame[frameBytes - 1])
+		return CAR_WIRE_BAD_CRC;
+	return CAR_WIRE_FRESH;
 }
 
-bool master_car_wire::write(void* buffer, unsigned char bytes, unsigned char devAddr, unsigned char register){
-	_sum=0;
-	Wire.beginTransmission(devAddr);
-	Wire.write(register);
-	for (int i=0; i<bytes; i++){
-		Wire.write(buffer[i]);
-		_sum+=buffer[i];
+unsigned char master_car_wire::poll(car_wire_block* blocks, unsigned char count){
+	unsigned char fresh = 0;
+
+	for (unsigned char i=0; i<count; i++){
+		car_wire_block& block = blocks[i];
+		unsigned char status = readFrame(block.devAddr, block.reg, block.bytes, i == count - 1 ? I2C_STOP : I2C_NOSTOP);
+
+		if (status == CAR_WIRE_FRESH && block.status != CAR_WIRE_NONE && _frame[0] == block.sequence)
+			status = CAR_WIRE_UNCHANGED;
+		if (status == CAR_WIRE_FRESH){
+			memcpy(block.buffer, &_frame[1], block.bytes);
+			block.sequence = _frame[0];
+			block.unchanged = 0;
+			fresh++;
+		}
+		else if (block.unchanged < 255){
+			block.unchanged++;
+		}
+		block.status = status;
 	}
-	Wire.endTranmission();
-
-	//Get checksum
-	Wire.beginTransmission(devAddr);
-	Wire.write(CHECKSUM_ADDR);
-	Wire.endTranmission();
-
-	Wite.requestFrom(devAddr, 2);
-	while(Wire.available() < 2) {}
-	void * checkSumAddr = &_checkSum;
-	checkSumAddr[0]=Wire.read();
-	checkSumAddr[1]=Wire.read();
-	if(_sum!=_checkSum)
+	return fresh;
+}
+
+bool master_car_wire::request(void* buffer, unsigned char bytes, unsigned char devAddr, unsigned char reg){
+	if (readFrame(devAddr, reg, bytes, I2C_STOP) != CAR_WIRE_FRESH)
+		return false;
+	memcpy(buffer, &_frame[1], bytes);
+	return true;
+}
+
+bool master_car_wire::write(const void* buffer, unsigned char bytes, unsigned char devAddr, unsigned char reg){
+	const unsigned char* data = (const unsigned char*)buffer;
+	unsigned char crc = car_crc8(car_crc8(0, &reg, 1), data, bytes);
+
+	_bus.beginTransmission(devAddr);
+	_bus.write(reg);
+	_bus.write(data, bytes);
+	_bus.write(crc);
+	if (_bus.endTransmission(I2C_STOP) != 0)
+		return false;
+
+	//Get the CRC the slave accepted
+	unsigned char ack = CAR_WIRE_ACK_REG;
+	_bus.beginTransmission(devAddr);
+	_bus.write(ack);
+	if (_bus.endTransmission(I2C_NOSTOP) != 0)
+		return false;
+	if (_bus.requestFrom(devAddr, (size_t)1, I2C_STOP) < 1)
 		return false;
-	else
-		return true;
+	return _bus.readByte() == crc;
 }
@@ -1,11 +1,51 @@
+#ifndef master_car_wire_h
+#define master_car_wire_h
+
+#include "car_wire.h"
+
+enum car_wire_status {
+	CAR_WIRE_NONE,		// not read yet
+	CAR_WIRE_FRESH,		// new sequence, buffer updated
+	CAR_WIRE_UNCHANGED,	// same sequence as last time, buffer left alone
+	CAR_WIRE_BAD_CRC,	// garbled or short, buffer left alone
+	CAR_WIRE_NAK		// slave didn't answer
+};
+
+// One block to read in a poll. Set devAddr, reg, bytes and buffer, and leave
+// the rest to poll().
+struct car_wire_block {
+	unsigned char devAddr;
+	unsigned char reg;
+	unsigned char bytes;		// data length, at most CAR_WIRE_MAX_DATA
+	void* buffer;
+	unsigned char sequence;		// last one accepted
+	unsigned char unchanged;	// polls since sequence last moved, stops at 255
+	unsigned char status;		// car_wire_status of the last poll
+
+	car_wire_block(unsigned char devAddr, unsigned char reg, void* buffer, unsigned char bytes);
+};
 
 class master_car_wire {
 
 private:
-    uint16_t _sum, _checkSum;
+	i2c_t3& _bus;
+	unsigned char _frame[CAR_WIRE_FRAME(CAR_WIRE_MAX_DATA)];
+
+	unsigned char readFrame(unsigned char devAddr, unsigned char reg, unsigned char bytes, i2c_stop stop);
 
 public:
-    bool request(void* buffer, unsigned char bytes, unsigned char devAddr, unsigned               char register);
-    bool write(void* buffer, unsigned char bytes, unsigned char devAddr, unsigned                 char register);
+	master_car_wire(i2c_t3& bus);
+
+	// Reads every block in one pass: a repeated start between blocks, even
+	// to different slaves, and one STOP at the end. Returns how many were
+	// FRESH; check each block's status to skip the others.
+	unsigned char poll(car_wire_block* blocks, unsigned char count);
+
+	// One block on its own. True if it came through, new or not.
+	bool request(void* buffer, unsigned char bytes, unsigned char devAddr, unsigned char reg);
+	// True if the slave took the data, checked by reading back its CRC
+	bool write(const void* buffer, unsigned char bytes, unsigned char devAddr, unsigned char reg);
+
+};
 
-}; 
\ No newline at end of file
+#endif
@@ -1,15 +1,93 @@
 #include "slave_car_wire.h"
 
-void slave_car_wire::receiveEvent(){
+#include <string.h>
 
-	if (Wire.available()){}
-		_cmd = Wire.readByte();
+slave_car_wire::slave_car_wire(i2c_t3& bus, car_wire_register* registers, unsigned char count) : _bus(bus){
+	_registers = registers;
+	_count = count;
+	_reg = 0;
+	_ack = 0;
+	_crcErrors = 0;
+	for (unsigned char i=0; i<count; i++){
+		memset(registers[i].frame, 0, CAR_WIRE_FRAME(registers[i].bytes));
+		registers[i].written = false;
+		stamp(&registers[i]);
 	}
+}
 
+car_wire_register* slave_car_wire::find(unsigned char reg){
+	for (unsigned char i=0; i<_count; i++){
+		if (_registers[i].reg == reg)
+			return &_registers[i];
+	}
+	return NULL;
 }
 
-void slave_car_wire::requestEvent(){
+// CRC over the register number, sequence and data
+void slave_car_wire::stamp(car_wire_register* r){
+	r->frame[r->bytes + 1] = car_crc8(car_crc8(0, &r->reg, 1), r->frame, r->bytes + 1);
+}
 
-	//You kinda need to write this one yourself
+void slave_car_wire::publish(unsigned char reg, const void* data){
+	car_wire_register* r = find(reg);
+	if (r == NULL)
+		return;
 
-}
\ No newline at end of file
+	noInterrupts();
+	memcpy(&r->frame[1], data, r->bytes);
+	r->frame[0]++;
+	stamp(r);
+	interrupts();
+}
+
+bool slave_car_wire::take(unsigned char reg, void* data){
+	car_wire_register* r = find(reg);
+	bool written = false;
+	if (r == NULL)
+		return false;
+
+	noInterrupts();
+	if (r->written){
+		memcpy(data, &r->frame[1], r->bytes);
+		r->written = false;
+		written = true;
+	}
+	interrupts();
+	return written;
+}
+
+void slave_car_wire::receiveEvent(size_t len){
+	if (!_bus.available())
+		return;
+	_reg = _bus.readByte();
+	if (len <= 1)
+		return;
+
+	// A write: [register] [data] [CRC-8]
+	car_wire_register* r = find(_reg);
+	unsigned char data[CAR_WIRE_MAX_DATA + 1];
+	unsigned char n = 0;
+	while (_bus.available() && n < sizeof(data))
+		data[n++] = _bus.readByte();
+	unsigned char reg = _reg;
+	if (r == NULL || !r->writable || n != r->bytes + 1 || car_crc8(car_crc8(0, &reg, 1), data, r->bytes) != data[r->bytes]){
+		_crcErrors++;
+		return;
+	}
+	memcpy(&r->frame[1], data, r->bytes);
+	r->frame[0]++;
+	stamp(r);
+	r->written = true;
+	_ack = data[r->bytes];
+}
+
+void slave_car_wire::requestEvent(){
+	if (_reg == CAR_WIRE_ACK_REG){
+		_bus.write(_ack);
+		return;
+	}
+	// An unknown register sends nothing; the master reads 0xFF and the CRC fails
+	car_wire_register* r = find(_reg);
+	if (r != NULL)
+		_bus.write(r->frame, CAR_WIRE_FRAME(r->bytes));
+}
@@ -1,12 +1,48 @@
+#ifndef slave_car_wire_h
+#define slave_car_wire_h
 
-static class slave_car_wire{
+#include "car_wire.h"
+
+// One block the master can read, and write if writable. frame holds
+// CAR_WIRE_FRAME(bytes) and belongs to the library once registered.
+struct car_wire_register {
+	unsigned char reg;
+	unsigned char bytes;
+	unsigned char* frame;
+	bool writable;
+	volatile bool written;	// the master wrote new data, see take()
+};
+
+class slave_car_wire {
 
 private:
-	uint16_t _checkSum;
-	unsigned char _cmd;
+	i2c_t3& _bus;
+	car_wire_register* _registers;
+	unsigned char _count;
+	volatile unsigned char _reg;
+	volatile unsigned char _ack;
+	volatile unsigned int _crcErrors;
+
+	car_wire_register* find(unsigned char reg);
+	void stamp(car_wire_register* r);
+
+public:
+	slave_car_wire(i2c_t3& bus, car_wire_register* registers, unsigned char count);
 
-public:	
-	void recieveEvent();
+	// From loop(): copies in new data for reg and bumps its sequence. The
+	// master sees the old frame or the new one, never a mix.
+	void publish(unsigned char reg, const void* data);
+	// From loop(): copies out what the master last wrote to reg. False if
+	// nothing new was written since the last take.
+	bool take(unsigned char reg, void* data);
+
+	// Call from the bus's onReceive and onRequest
+	void receiveEvent(size_t len);
 	void requestEvent();
 
-};
\ No newline at end of file
+	// Master writes thrown away for a bad CRC or length
+	unsigned int crcErrors() const { return _crcErrors; }
+
+};
+
+#endif
@@ -36,7 +36,29 @@ void ADXL345::updateAccelValues(){
 void ADXL345::updateAccelValuesWithRepeatedStart(){
   unsigned char byteArray[6];
   readSequentialRegisters(DATAX0, byteArray, 6);
-  
+  setValues(byteArray);
+}
+
+// Queue Accelerometer Read
+bool ADXL345::queueAccelRead(){
+  if (read.status == I2C_READ_QUEUED)
+    return false;
+  read.address = DEVICE_ADDRESS;
+  read.reg = DATAX0;
+  read.length = 6;
+  read.data = readBuffer;
+  read.done = readDone;
+  read.context = this;
+  return sensorBus.submit(&read);
+}
+
+// Runs in the I2C interrupt
+void ADXL345::readDone(I2CRead* read){
+  if (read->status == I2C_READ_DONE)
+    ((ADXL345*)read->context)->setValues(read->data);
+}
+
+void ADXL345::setValues(const unsigned char* byteArray){
   x = byteArray[0] | (byteArray[1] << 8);
   y = byteArray[2] | (byteArray[3] << 8);
   z = byteArray[4] | (byteArray[5] << 8);
@@ -15,6 +15,7 @@
 /*============================================================================*/
 #include <Arduino.h>
 #include <i2c_t3.h>
+#include "I2CQueue.h"
 
 #define DEVICE_ADDRESS 0x53  // Slave Address
 
@@ -59,6 +60,12 @@
 class ADXL345 {
   private:
   int16_t x,y,z;
+  I2CRead read;
+  unsigned char readBuffer[6];
+
+  // Stores the 6 output registers in x, y and z
+  void setValues(const unsigned char* byteArray);
+  static void readDone(I2CRead* read);
   
   public:
   // Get Accelerometer Data
@@ -78,6 +85,18 @@ class ADXL345 {
   //  readSequentialRegisters(). Readings are stored in the x, y, and z integer 
   //  variables.  
   void updateAccelValuesWithRepeatedStart();
+
+  // Queue Accel Read
+  //  Starts the same read as updateAccelValuesWithRepeatedStart() on the sensor
+  //  bus queue and returns straight away. x, y and z are updated from the I2C
+  //  interrupt when it completes; check readStatus() before getAccelerometerValues().
+  // Returns:
+  //  false if the last queued read hasn't finished, or the queue is full
+  bool queueAccelRead();
+
+  // Read Status
+  //  i2c_read_status of the last queued read
+  uint8_t readStatus() const { return read.status; }
   
   // Read Sequential Registers
   //  Reads multiple registers with adjacent addresses. This function takes 
@@ -33,7 +33,32 @@ void HMC5883L::getMagnetometerValues(float* array){
 void HMC5883L::updateMagValuesWithRepeatedStart(){
   unsigned char byteArray[6];
   readSequentialRegisters(DATA_XH, byteArray, 6); // 
-  
+  setValues(byteArray);
+}
+
+
+// Queue Magnetometer Read
+bool HMC5883L::queueMagRead(){
+  if (read.status == I2C_READ_QUEUED)
+    return false;
+  read.address = DEVICE_ADDRESS;
+  read.reg = DATA_XH;
+  read.length = 6;
+  read.data = readBuffer;
+  read.done = readDone;
+  read.context = this;
+  return sensorBus.submit(&read);
+}
+
+
+// Runs in the I2C interrupt
+void HMC5883L::readDone(I2CRead* read){
+  if (read->status == I2C_READ_DONE)
+    ((HMC5883L*)read->context)->setValues(read->data);
+}
+
+
+void HMC5883L::setValues(const unsigned char* byteArray){
   x = byteArray[1] | (byteArray[0] << 8);
   y = byteArray[5] | (byteArray[4] << 8);
   z = byteArray[3] | (byteArray[2] << 8); 
@@ -18,6 +18,7 @@
 #define HMC5883L_H
 #include <Arduino.h>
 #include <i2c_t3.h>
+#include "I2CQueue.h"
 
 // Slave Address. In the documentation, this address is called SAD
 #define DEVICE_ADDRESS 0x1E
@@ -45,6 +46,12 @@
 class HMC5883L {
   private:
   int16_t x,y,z;                        // 16-bit magnetometer output values
+  I2CRead read;
+  unsigned char readBuffer[6];
+
+  // Stores the 6 output registers in x, y and z, calibrated
+  void setValues(const unsigned char* byteArray);
+  static void readDone(I2CRead* read);
 
   public:
   // Get Magnetometer Data
@@ -66,6 +73,18 @@ class HMC5883L {
   //  variables.                                                                
   void updateMagValuesWithRepeatedStart();
 
+  // Queue Mag Read
+  //  Starts the same read as updateMagValuesWithRepeatedStart() on the sensor
+  //  bus queue and returns straight away. x, y and z are updated from the I2C
+  //  interrupt when it completes; check readStatus() before getMagnetometerValues().
+  // Returns:
+  //  false if the last queued read hasn't finished, or the queue is full
+  bool queueMagRead();
+
+  // Read Status
+  //  i2c_read_status of the last queued read
+  uint8_t readStatus() const { return read.status; }
+
 
   // Read Sequential Registers
   //  Reads multiple registers with adjacent addresses. This function takes 
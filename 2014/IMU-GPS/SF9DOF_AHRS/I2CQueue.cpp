@@ -0,0 +1,102 @@
+#include "I2CQueue.h"
+
+I2CQueue sensorBus;
+
+I2CQueue::I2CQueue(){
+  head = tail = 0;
+  reading = false;
+  startTime = 0;
+  failed = 0;
+}
+
+// Begin
+void I2CQueue::begin(){
+  Wire.onMasterDone(onMasterDone);
+}
+
+// Submit
+bool I2CQueue::submit(I2CRead* read){
+  bool ok = false;
+
+  noInterrupts();
+  if (read->status != I2C_READ_QUEUED && (uint8_t)(head - tail) < I2C_QUEUE_SIZE){
+    read->status = I2C_READ_QUEUED;
+    ring[head & (I2C_QUEUE_SIZE - 1)] = read;
+    head++;
+    if ((uint8_t)(head - tail) == 1)
+      start();
+    ok = true;
+  }
+  interrupts();
+  return ok;
+}
+
+// Service
+void I2CQueue::service(){
+  noInterrupts();
+  if (head != tail && micros() - startTime > I2C_QUEUE_TIMEOUT_US){
+    // i2c_t3 sends STOP at the next interrupt, if one ever comes, and the
+    // callback for that is ignored
+    Wire.finish(1);
+    finish(I2C_READ_FAILED);
+  }
+  interrupts();
+}
+
+// Wire's ISR, at the end of each half of a read
+void I2CQueue::onMasterDone(){
+  sensorBus.advance();
+}
+
+void I2CQueue::advance(){
+  i2c_status status = Wire.status();
+
+  if (head == tail || status == I2C_TIMEOUT)
+    return;
+
+  if (status != I2C_WAITING){
+    finish(I2C_READ_FAILED);
+  }
+  else if (!reading){
+    // Register address sent, read from it with a repeated start
+    I2CRead* read = ring[tail & (I2C_QUEUE_SIZE - 1)];
+    reading = true;
+    Wire.sendRequest(read->address, read->length, I2C_STOP);
+  }
+  else{
+    I2CRead* read = ring[tail & (I2C_QUEUE_SIZE - 1)];
+    if (Wire.available() < read->length){
+      finish(I2C_READ_FAILED);
+      return;
+    }
+    for (int i = 0; i < read->length; i++){
+      read->data[i] = Wire.readByte();
+    }
+    finish(I2C_READ_DONE);
+  }
+}
+
+// Writes the register address of the read at tail, with no STOP
+void I2CQueue::start(){
+  I2CRead* read = ring[tail & (I2C_QUEUE_SIZE - 1)];
+  reading = false;
+  startTime = micros();
+  Wire.beginTransmission(read->address);
+  Wire.write(read->reg);
+  Wire.sendTransmission(I2C_NOSTOP);
+}
+
+// Retires the read at tail. The next read goes on the bus before the
+// callback runs, and the callback may submit more
+void I2CQueue::finish(uint8_t status){
+  I2CRead* read = ring[tail & (I2C_QUEUE_SIZE - 1)];
+
+  if (status == I2C_READ_FAILED)
+    failed++;
+  tail++;
+  read->status = status;
+  if (head != tail)
+    start();
+  if (read->done != NULL)
+    read->done(read);
+}
@@ -0,0 +1,83 @@
+/*============================================================================*/
+//  I2CQueue.h - queued register reads on the sensor bus (Wire), 2014.
+//
+//  The sensor drivers used to read their output registers with blocking
+//  calls, so the 300 Hz loop sat idle while the bus was busy. Here a read is
+//  described once (an I2CRead) and submitted; it runs in the background as
+//  a register address write and a repeated start read. The i2c_t3 ISR calls
+//  back when each half finishes, and the next read in the queue is started
+//  from the same interrupt, so any number of reads go back to back without
+//  the loop polling. The loop only checks status when it wants the data.
+//
+//  A read's done callback, if it has one, runs in the I2C interrupt: copy or
+//  convert the bytes and return.
+//
+/*============================================================================*/
+
+#ifndef I2CQueue_h
+#define I2CQueue_h
+
+#include <Arduino.h>
+#include <i2c_t3.h>
+
+#define I2C_QUEUE_SIZE       8    // reads waiting or on the bus, power of 2
+#define I2C_QUEUE_TIMEOUT_US 2000 // a read holding the bus longer is failed
+
+enum i2c_read_status {I2C_READ_IDLE,     // never submitted
+                      I2C_READ_QUEUED,   // waiting or on the bus
+                      I2C_READ_DONE,     // data holds length fresh bytes
+                      I2C_READ_FAILED};  // NAK, lost arbitration or timeout
+
+struct I2CRead {
+  uint8_t address;              // 7 bit slave address
+  uint8_t reg;                  // first register, with any auto-increment bit
+  uint8_t length;               // bytes to read into data
+  uint8_t* data;
+  void (*done)(I2CRead* read);  // called from the ISR when finished, or NULL
+  void* context;                // for done
+  volatile uint8_t status;      // i2c_read_status
+};
+
+class I2CQueue {
+public:
+  I2CQueue();
+
+  // Begin
+  //  Hooks the queue to Wire's interrupt. Wire must already be a master.
+  void begin();
+
+  // Submit
+  //  Queues a read and starts it if the bus is free. The I2CRead must stay
+  //  put until its status leaves I2C_READ_QUEUED.
+  // Returns:
+  //  false if the read is already queued or the queue is full
+  bool submit(I2CRead* read);
+
+  // Idle
+  //  True once every submitted read has finished.
+  bool idle() const { return head == tail; }
+
+  // Service
+  //  Call from loop(). Fails a read that has held the bus for longer than
+  //  I2C_QUEUE_TIMEOUT_US, so a missing sensor can't stall the others.
+  void service();
+
+  // Reads failed since start up
+  uint16_t failures() const { return failed; }
+
+private:
+  I2CRead* ring[I2C_QUEUE_SIZE];
+  volatile uint8_t head, tail;  // free running, tail is on the bus
+  volatile bool reading;        // second half of the read at tail
+  volatile uint32_t startTime;
+  volatile uint16_t failed;
+
+  static void onMasterDone();
+  void advance();
+  void start();
+  void finish(uint8_t status);
+};
+
+extern I2CQueue sensorBus;
+
+#endif
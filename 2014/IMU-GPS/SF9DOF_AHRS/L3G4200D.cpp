@@ -34,7 +34,32 @@ void L3G4200D::getGyroValues(float* array){
 void L3G4200D::updateGyroValuesWithRepeatedStart(){
   unsigned char byteArray[6];
   readSequentialRegisters(OUT_X_L, byteArray, 6); // 
-  
+  setValues(byteArray);
+}
+
+
+// Queue Gyro Read
+bool L3G4200D::queueGyroRead(){
+  if (read.status == I2C_READ_QUEUED)
+    return false;
+  read.address = DEVICE_ADDRESS;
+  read.reg = OUT_X_L | ( 1 << 7 ); // Auto-Increment
+  read.length = 6;
+  read.data = readBuffer;
+  read.done = readDone;
+  read.context = this;
+  return sensorBus.submit(&read);
+}
+
+
+// Runs in the I2C interrupt
+void L3G4200D::readDone(I2CRead* read){
+  if (read->status == I2C_READ_DONE)
+    ((L3G4200D*)read->context)->setValues(read->data);
+}
+
+
+void L3G4200D::setValues(const unsigned char* byteArray){
   x = (int16_t)(byteArray[0] | (byteArray[1] << 8)); // 
   y = (int16_t)(byteArray[2] | (byteArray[3] << 8));
   z = (int16_t)(byteArray[4] | (byteArray[5] << 8)); 
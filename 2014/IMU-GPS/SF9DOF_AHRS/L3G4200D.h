@@ -19,6 +19,7 @@
 
 #include <Arduino.h>
 #include <i2c_t3.h>
+#include "I2CQueue.h"
 
 // Slave Address. In the documentation, this address is called SAD
 #define DEVICE_ADDRESS 0x69
@@ -63,6 +64,12 @@
 class L3G4200D {
 private:
   float x, y, z;
+  I2CRead read;
+  unsigned char readBuffer[6];
+
+  // Converts the 6 output registers to dps in x, y and z
+  void setValues(const unsigned char* byteArray);
+  static void readDone(I2CRead* read);
 
 
 public:
@@ -91,6 +98,18 @@ public:
   //  variables.                                                                
   void updateGyroValuesWithRepeatedStart();
 
+  // Queue Gyro Read
+  //  Starts the same read as updateGyroValuesWithRepeatedStart() on the sensor
+  //  bus queue and returns straight away. x, y and z are updated from the I2C
+  //  interrupt when it completes; check readStatus() before getGyroValues().
+  // Returns:
+  //  false if the last queued read hasn't finished, or the queue is full
+  bool queueGyroRead();
+
+  // Read Status
+  //  i2c_read_status of the last queued read
+  uint8_t readStatus() const { return read.status; }
+
   // Read Sequential Registers
   //  Reads multiple registers with adjacent addresses. This function takes 
   //  advantage of I2C's repeated start mechanism, which avoids unnecessary start
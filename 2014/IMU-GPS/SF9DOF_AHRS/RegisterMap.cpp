@@ -0,0 +1,55 @@
+#include "RegisterMap.h"
+
+#include <car_crc8.h>
+#include <string.h>
+
+RegisterMap registers;
+
+RegisterMap::RegisterMap(){
+  memset(maps, 0, sizeof(maps));
+  maps[0].version = maps[1].version = AHRS_MAP_VERSION;
+  maps[0].gpsAge = maps[1].gpsAge = 0xFFFF;
+  crcs[0] = crcs[1] = frameCrc(maps[0]);
+  front = 0;
+  reg = 0;
+}
+
+// The car-wire CRC-8 of a copy: register, sequence byte, map
+uint8_t RegisterMap::frameCrc(const AHRSMap& map){
+  uint8_t head[2] = {AHRS_CAR_WIRE_REG, (uint8_t)map.sequence};
+  return car_crc8(car_crc8(0, head, 2), (const uint8_t*)&map, sizeof(AHRSMap));
+}
+
+// Publish
+void RegisterMap::publish(){
+  AHRSMap& next = maps[front ^ 1];
+
+  next.version = AHRS_MAP_VERSION;
+  next.sequence = maps[front].sequence + 1;
+  // Worked out here, so the slave interrupt only has to send it
+  crcs[front ^ 1] = frameCrc(next);
+  // One byte store: the slave interrupt sends either copy whole, never a mix
+  front ^= 1;
+  // The old front is the back now, bring it up to date
+  maps[front ^ 1] = maps[front];
+}
+
+// Select
+void RegisterMap::select(uint8_t reg){
+  this->reg = reg < sizeof(AHRSMap) || reg == AHRS_CAR_WIRE_REG ? reg : 0;
+}
+
+// Serve
+void RegisterMap::serve(){
+  // Runs in the slave interrupt, which loop() can't get in the middle of, and
+  // i2c_t3 clocks the bytes out of its own buffer
+  const AHRSMap& map = maps[front];
+  const uint8_t* bytes = (const uint8_t*)&map;
+  if (reg == AHRS_CAR_WIRE_REG){
+    Wire1.write((uint8_t)map.sequence);
+    Wire1.write(bytes, sizeof(AHRSMap));
+    Wire1.write(crcs[front]);
+    return;
+  }
+  Wire1.write(bytes + reg, sizeof(AHRSMap) - reg);
+}
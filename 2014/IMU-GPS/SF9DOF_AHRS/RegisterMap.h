@@ -0,0 +1,90 @@
+/*============================================================================*/
+//  RegisterMap.h - what the brain board reads from the AHRS over Wire1, 2014.
+//
+//  The results used to be copied a byte at a time into mem[] from loop() and
+//  sent from requestEvent(), so a read landing in the middle of a copy got
+//  half of an old float and half of a new one. Now there are two copies of
+//  the map. loop() writes fields into the back one and publish() swaps them
+//  with a single byte store; the slave interrupt only ever sends the front
+//  one, which nothing writes while it is in front.
+//
+//  The master writes one byte, the register to start at, then reads any
+//  number of bytes. Reading all of AHRSMap in one transaction gets one
+//  consistent sample; sequence tells it apart from the last one read.
+//
+//  AHRS_CAR_WIRE_REG serves the same sample as a car-wire block (see
+//  2014/Communications/car-wire): the low byte of sequence, the map and a
+//  CRC-8 over the register, that byte and the map, so master_car_wire's
+//  poll() can read it alongside the other boards.
+//
+/*============================================================================*/
+
+#ifndef RegisterMap_h
+#define RegisterMap_h
+
+#include <Arduino.h>
+#include <i2c_t3.h>
+
+#define AHRS_MAP_VERSION 2  // 1 was the loose floats in mem[0x01..0x14]
+#define AHRS_CAR_WIRE_REG 0x80  // the whole map as a car-wire block
+
+// status bits
+#define AHRS_STATUS_GPS_FIX   0x01  // latE7/lngE7 valid and under 2 s old
+#define AHRS_STATUS_GYRO_SAT  0x02  // a gyro has saturated recently
+#define AHRS_STATUS_SENSOR    0x04  // the last read of a sensor failed
+
+// Little endian, as the Teensy stores it. Every field is on its own
+// alignment, so there is no padding.
+struct AHRSMap {
+  uint8_t  version;         // 0x00 AHRS_MAP_VERSION
+  uint8_t  status;          // 0x01 AHRS_STATUS_*
+  uint16_t sequence;        // 0x02 one more on each publish
+  float    roll;            // 0x04 degrees
+  float    pitch;           // 0x08 degrees
+  float    yaw;             // 0x0C degrees
+  int32_t  latE7;           // 0x10 degrees * 10^7, north positive
+  int32_t  lngE7;           // 0x14 degrees * 10^7, east positive
+  uint16_t gpsAge;          // 0x18 ms since the fix, 0xFFFF if older or none
+  uint8_t  satellites;      // 0x1A
+  uint8_t  sensorFailures;  // 0x1B sensor bus reads failed, wraps
+};
+
+class RegisterMap {
+public:
+  RegisterMap();
+
+  // Back
+  //  The copy loop() fills in. It starts as a copy of what was last
+  //  published, so only the fields that changed need writing.
+  AHRSMap& back() { return maps[front ^ 1]; }
+
+  // Publish
+  //  Makes the back copy the one the master reads, and bumps sequence.
+  void publish();
+
+  // The copy the master reads, for printing
+  const AHRSMap& current() const { return maps[front]; }
+
+  // Select
+  //  Call from the slave receive event with the first byte written.
+  //  Registers past the end, other than AHRS_CAR_WIRE_REG, select 0x00.
+  void select(uint8_t reg);
+
+  // Serve
+  //  Call from the slave request event. Queues the front copy on Wire1,
+  //  from the selected register to the end of the map, or framed for
+  //  car-wire.
+  void serve();
+
+private:
+  AHRSMap maps[2];
+  uint8_t crcs[2];         // car-wire CRC-8 of each copy, set by publish()
+  volatile uint8_t front;  // the slave interrupt reads only maps[front]
+  volatile uint8_t reg;
+
+  static uint8_t frameCrc(const AHRSMap& map);
+};
+
+extern RegisterMap registers;
+
+#endif
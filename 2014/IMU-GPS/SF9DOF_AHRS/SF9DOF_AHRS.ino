@@ -33,6 +33,7 @@
 //TODO: Use i2c_t3 instead
 #include <i2c_t3.h>
 #include <TinyGPS++.h>
+#include <MatVec.h>
 //#include <Wire.h>
 #include <SPI.h>
 #include <SoftwareSerial.h>
@@ -40,6 +41,8 @@
 #include "ADXL345.h"
 #include "HMC5883L.h"
 #include "L3G4200D.h"
+#include "I2CQueue.h"
+#include "RegisterMap.h"
 
 // ADXL345 Sensitivity(from datasheet) => 4mg/LSB   1G => 1000mg/4mg = 256 steps
 // Tested value : 249
@@ -63,15 +66,8 @@
 #define PRINT_ANALOGS 0 //Will print the analog raw data
 #define PRINT_EULER 1   //Will print the Euler angles Roll, Pitch and Yaw
 
-// I2C command definitions
-#define WRITE 0x10
-#define READ  0x20
-// Slave Memory
-#define MEM_LEN 21
-uint8_t mem[MEM_LEN];
-uint8_t cmd;
-size_t  addr;
-int     bytes;
+// Slave register map, see RegisterMap.h
+#define GPS_FIX_AGE 2000  // ms before the GPS position stops counting as a fix
 
 #define STATUS_LED 13 
 
@@ -152,6 +148,7 @@ void setup()
   gyro.setupGyro();
   magnetometer.setupMagnetometer();
   accelerometer.setupAccel();
+  sensorBus.begin();
 
   digitalWrite(STATUS_LED,LOW);
   
@@ -161,16 +158,18 @@ void setup()
     
   timer=micros();
   counter=0;
-  
-  mem[0] = 0x01;
 }
 
 void loop() // Main Loop
 {  
-  // Update GPS
-  while(Serial2.available()>0){
-    int c = Serial2.read();
-    if (gps.encode(c)){
+  // Update GPS, whatever the UART has buffered in one call
+  char gpsBuffer[64];
+  int gpsBytes;
+  while((gpsBytes = Serial2.available())>0){
+    if (gpsBytes > (int)sizeof(gpsBuffer))
+      gpsBytes = sizeof(gpsBuffer);
+    gpsBytes = Serial2.readBytes(gpsBuffer, gpsBytes);
+    if (gps.encode(gpsBuffer, gpsBytes)){
       Serial.print("lat: ");
       Serial.print(gps.location.lat());
       Serial.print("   lon: ");
@@ -187,15 +186,11 @@ void loop() // Main Loop
       Serial.print(gps.time.minute());
       Serial.print(":");
       Serial.println(gps.time.second());
-      //Copy updated values into the data array
-      float latlng[2];
-      latlng[0] = gps.location.lat();
-      latlng[1] = gps.location.lng();
-      uint8_t* bytePtr = (uint8_t*)latlng;
-      for (int b=0x0D; b<0x15; b++){
-        mem[b] = *bytePtr;
-        bytePtr++;
-      }
+      //Goes to the master with the next attitude
+      AHRSMap& out = registers.back();
+      out.latE7 = gps.location.latE7();
+      out.lngE7 = gps.location.lngE7();
+      out.satellites = gps.satellites.value();
     }
   }
   
@@ -212,22 +207,34 @@ void loop() // Main Loop
       G_Dt = 0;
     
     //Read sensors
-    gyro.updateGyroValuesWithRepeatedStart();
-    accelerometer.updateAccelValuesWithRepeatedStart();
-    gyro.getGyroValues(Gyro_Vector);
-    accelerometer.getAccelerometerValues(Accl_Vector);
-    
-    for (int i = 0; i < 3; i++){
-      Gyro_Vector[i] = ToRad(Gyro_Vector[i]);
+    //The reads queued last tick ran on the bus while the DCM was computed,
+    //and have normally finished long ago. A failed read keeps the old values.
+    while(!sensorBus.idle())
+      sensorBus.service();
+    bool readFailed = gyro.readStatus() == I2C_READ_FAILED || accelerometer.readStatus() == I2C_READ_FAILED;
+    if (gyro.readStatus() == I2C_READ_DONE){
+      gyro.getGyroValues(Gyro_Vector);
+      for (int i = 0; i < 3; i++){
+        Gyro_Vector[i] = ToRad(Gyro_Vector[i]);
+      }
     }
+    if (accelerometer.readStatus() == I2C_READ_DONE)
+      accelerometer.getAccelerometerValues(Accl_Vector);
   
     if (counter > 10)  // Read compass data at 30Hz... (5 loop runs)
     {
       counter=0;
-      magnetometer.updateMagValuesWithRepeatedStart();
-      magnetometer.getMagnetometerValues(Mgnt_Vector);
+      readFailed |= magnetometer.readStatus() == I2C_READ_FAILED;
+      if (magnetometer.readStatus() == I2C_READ_DONE)
+        magnetometer.getMagnetometerValues(Mgnt_Vector);
     }
     
+    //Queue the reads for the next tick, they finish from the I2C interrupt
+    gyro.queueGyroRead();
+    accelerometer.queueAccelRead();
+    if (counter == 10)
+      magnetometer.queueMagRead();
+    
     // Calculations...
     Matrix_update(); 
     Normalize();
@@ -254,17 +261,22 @@ void loop() // Main Loop
     else
       digitalWrite(STATUS_LED,HIGH);
     
-    //Copy updated values into the data array
-    float DAISY[3];  //roll pitch yaw
-    DAISY[0] = ToDeg(roll);
-    DAISY[1] = ToDeg(pitch);
-    DAISY[2] = ToDeg(yaw);
-    uint8_t* bytePtr = (uint8_t*)DAISY;
-    //for (int b=0x01; b<0x0C; b++){
-    for (int b=0x01; b<0x0D; b++){
-      mem[b] = *bytePtr;
-      bytePtr++;
-    }
+    //Fill in the back copy of the register map and hand it to the master
+    AHRSMap& out = registers.back();
+    uint32_t gpsAge = gps.location.age();
+    out.roll = ToDeg(roll);
+    out.pitch = ToDeg(pitch);
+    out.yaw = ToDeg(yaw);
+    out.gpsAge = gpsAge < 0xFFFF ? gpsAge : 0xFFFF;
+    out.sensorFailures = sensorBus.failures();
+    out.status = 0;
+    if (gps.location.isValid() && gpsAge < GPS_FIX_AGE)
+      out.status |= AHRS_STATUS_GPS_FIX;
+    if (gyro_sat>0)
+      out.status |= AHRS_STATUS_GYRO_SAT;
+    if (readFailed)
+      out.status |= AHRS_STATUS_SENSOR;
+    registers.publish();
   }
   // TODO: Check if GPS is good to go
 }
@@ -276,10 +288,8 @@ void receiveEvent(size_t len)
 {
   if(Wire1.available())
   {
-    // grab command
-    cmd = Wire1.readByte();
-    //Don't actually do anything for now.
-    //Could be used to select the status byte.
+    // first byte is the register to read from
+    registers.select(Wire1.readByte());
   }
 }
 
@@ -288,20 +298,6 @@ void receiveEvent(size_t len)
 //
 void requestEvent(void)
 {
-  //Need a way to get length, but for now 'cmd' is where to start reading from...
-  //Serial.println("Request made");
-  //for (int i=1; i<5; i++)
-//  float flMem[5];
-//  uint8_t* bytePtr = (uint8_t*)flMem;
-//  Serial.println("Stuff:");
-//  for (int i=1; i<21; i++){
-//    *bytePtr=mem[i];
-//    bytePtr++;
-//  }
-//  Serial.println("meh");
-//  for (int i=0; i<5; i++)
-//    Serial.println(flMem[i]);
-  for(int i=1; i<21; i++){
-    Wire1.write(mem[i]);
-  }
+  // the whole map from the selected register, from the front copy
+  registers.serve();
 }
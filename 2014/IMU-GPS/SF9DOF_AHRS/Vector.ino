@@ -1,39 +1,26 @@
+//Vector helpers for the DCM code, on MatVec's unrolled kernels
+
 //Computes the dot product of two vectors
 float Vector_Dot_Product(float vector1[3],float vector2[3])
 {
-  float op=0;
-  
-  for(int c=0; c<3; c++)
-  {
-  op+=vector1[c]*vector2[c];
-  }
-  
-  return op; 
+  return matvec::dot(matvec::load<3>(vector1), matvec::load<3>(vector2));
 }
 
 //Computes the cross product of two vectors
 void Vector_Cross_Product(float vectorOut[3], float v1[3],float v2[3])
 {
-  vectorOut[0]= (v1[1]*v2[2]) - (v1[2]*v2[1]);
-  vectorOut[1]= (v1[2]*v2[0]) - (v1[0]*v2[2]);
-  vectorOut[2]= (v1[0]*v2[1]) - (v1[1]*v2[0]);
+  matvec::store(matvec::cross(matvec::load<3>(v1), matvec::load<3>(v2)), vectorOut);
 }
 
 //Multiply the vector by a scalar. 
 void Vector_Scale(float vectorOut[3],float vectorIn[3], float scale2)
 {
-  for(int c=0; c<3; c++)
-  {
-   vectorOut[c]=vectorIn[c]*scale2; 
-  }
+  matvec::store(matvec::load<3>(vectorIn) * scale2, vectorOut);
 }
 
 void Vector_Add(float vectorOut[3],float vectorIn1[3], float vectorIn2[3])
 {
-  for(int c=0; c<3; c++)
-  {
-     vectorOut[c]=vectorIn1[c]+vectorIn2[c];
-  }
+  matvec::store(matvec::load<3>(vectorIn1) + matvec::load<3>(vectorIn2), vectorOut);
 }
 
 
@@ -1,22 +1,9 @@
 /**************************************************/
-//Multiply two 3x3 matrixs. This function developed by Jordi can be easily adapted to multiple n*n matrix's. (Pero me da flojera!). 
+//Multiply two 3x3 matrixs, written out by MatVec
 void Matrix_Multiply(float a[3][3], float b[3][3],float mat[3][3])
 {
-  float op[3]; 
-  for(int x=0; x<3; x++)
-  {
-    for(int y=0; y<3; y++)
-    {
-      for(int w=0; w<3; w++)
-      {
-       op[w]=a[x][w]*b[w][y];
-      } 
-      mat[x][y]=0;
-      mat[x][y]=op[0]+op[1]+op[2];
-      
-      float test=mat[x][y];
-    }
-  }
+  const matvec::Mat3f product = matvec::loadMat<3, 3>(&a[0][0]) * matvec::loadMat<3, 3>(&b[0][0]);
+  matvec::store(product, &mat[0][0]);
 }
 
 
@@ -0,0 +1,343 @@
+/*
+ * MatVec.h - small fixed-size vectors and matrices, header only.
+ *
+ * Vec<N, T> and Mat<N, M, T> are plain aggregates (an array of T, row major
+ * for matrices), so they line up with float[3] and float[3][3] and can be
+ * brace initialised. Every operation is a constexpr C++11 function whose
+ * loops are template recursion or index pack expansion: the compiler sees
+ * straight-line code for each size, and with constant arguments the result
+ * is worked out at compile time.
+ *
+ * T is float, double or Fixed<F>, a Q(31-F).F number whose products round
+ * down exactly like mulQ16 and mulQ30 in the IMU board's fixedPoint.h.
+ *
+ * Only <stdint.h> is used, no standard library, so the same header builds
+ * for the Teensy and AVR Arduinos, the host tools and the ROS nodes.
+ * matvec_c.h has the same 3-vector and 3x3 kernels for C, for XC16.
+ */
+
+#ifndef MATVEC_H
+#define MATVEC_H
+
+#include <stdint.h>
+
+namespace matvec
+{
+
+//------------------------------------------------------------------------------
+// Fixed point element type
+
+template <int F>
+struct Fixed
+{
+  int32_t raw;
+
+  static constexpr Fixed fromRaw(int32_t r) { return Fixed{r}; }
+  static constexpr Fixed fromDouble(double d)
+  {
+    return Fixed{(int32_t) (d * (double) (1L << F) + (d < 0 ? -0.5 : 0.5))};
+  }
+  constexpr double toDouble() const { return (double) raw / (double) (1L << F); }
+};
+
+template <int F>
+constexpr Fixed<F> operator+(Fixed<F> a, Fixed<F> b) { return Fixed<F>{a.raw + b.raw}; }
+template <int F>
+constexpr Fixed<F> operator-(Fixed<F> a, Fixed<F> b) { return Fixed<F>{a.raw - b.raw}; }
+template <int F>
+constexpr Fixed<F> operator-(Fixed<F> a) { return Fixed<F>{-a.raw}; }
+template <int F>
+constexpr Fixed<F> operator*(Fixed<F> a, Fixed<F> b)
+{
+  return Fixed<F>{(int32_t) (((int64_t) a.raw * b.raw) >> F)};
+}
+template <int F>
+constexpr bool operator==(Fixed<F> a, Fixed<F> b) { return a.raw == b.raw; }
+template <int F>
+constexpr bool operator!=(Fixed<F> a, Fixed<F> b) { return a.raw != b.raw; }
+
+typedef Fixed<16> Q16;    // q16_t: vectors, angles
+typedef Fixed<30> Q30;    // q30_t: unit quaternion parts, rotation matrices
+
+//------------------------------------------------------------------------------
+// Types
+
+template <int N, typename T = float>
+struct Vec
+{
+  T v[N];
+
+  // Writes only through named vectors, so temporaries stay constexpr
+  constexpr const T &operator[](int i) const & { return v[i]; }
+  T &operator[](int i) & { return v[i]; }
+};
+
+template <int N, int M, typename T = float>
+struct Mat
+{
+  T m[N * M];
+
+  constexpr const T &operator()(int i, int j) const & { return m[i * M + j]; }
+  T &operator()(int i, int j) & { return m[i * M + j]; }
+};
+
+typedef Vec<3, float> Vec3f;
+typedef Mat<3, 3, float> Mat3f;
+typedef Vec<3, Q16> Vec3q;
+typedef Mat<3, 3, Q16> Mat3q;
+
+namespace detail
+{
+
+// 0, 1 .. N - 1 as a parameter pack
+template <int... I>
+struct Indices {};
+template <int N, int... I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template <int... I>
+struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+// Sum of a[i] * b[i] for i < K, written out
+template <int K>
+struct Dot
+{
+  template <typename A, typename B>
+  static constexpr auto sum(const A &a, const B &b) -> decltype(a[0] * b[0])
+  {
+    return Dot<K - 1>::sum(a, b) + a[K - 1] * b[K - 1];
+  }
+};
+template <>
+struct Dot<1>
+{
+  template <typename A, typename B>
+  static constexpr auto sum(const A &a, const B &b) -> decltype(a[0] * b[0])
+  {
+    return a[0] * b[0];
+  }
+};
+
+// Row i of a (N x KK) times column j of b (KK x M), the first K terms
+template <int K, int KK, int M>
+struct Product
+{
+  template <typename T>
+  static constexpr T sum(const T *a, const T *b, int i, int j)
+  {
+    return Product<K - 1, KK, M>::sum(a, b, i, j) + a[i * KK + K - 1] * b[(K - 1) * M + j];
+  }
+};
+template <int KK, int M>
+struct Product<1, KK, M>
+{
+  template <typename T>
+  static constexpr T sum(const T *a, const T *b, int i, int j)
+  {
+    return a[i * KK] * b[j];
+  }
+};
+
+template <int N, typename T, int... I>
+constexpr Vec<N, T> add(const Vec<N, T> &a, const Vec<N, T> &b, Indices<I...>)
+{
+  return Vec<N, T>{{(a.v[I] + b.v[I])...}};
+}
+template <int N, typename T, int... I>
+constexpr Vec<N, T> sub(const Vec<N, T> &a, const Vec<N, T> &b, Indices<I...>)
+{
+  return Vec<N, T>{{(a.v[I] - b.v[I])...}};
+}
+template <int N, typename T, int... I>
+constexpr Vec<N, T> neg(const Vec<N, T> &a, Indices<I...>)
+{
+  return Vec<N, T>{{(-a.v[I])...}};
+}
+template <int N, typename T, int... I>
+constexpr Vec<N, T> scale(const Vec<N, T> &a, T s, Indices<I...>)
+{
+  return Vec<N, T>{{(a.v[I] * s)...}};
+}
+template <int N, typename T, int... I>
+constexpr Vec<N, T> load(const T *p, Indices<I...>)
+{
+  return Vec<N, T>{{p[I]...}};
+}
+
+template <int N, int M, typename T, int... I>
+constexpr Mat<N, M, T> add(const Mat<N, M, T> &a, const Mat<N, M, T> &b, Indices<I...>)
+{
+  return Mat<N, M, T>{{(a.m[I] + b.m[I])...}};
+}
+template <int N, int M, typename T, int... I>
+constexpr Mat<N, M, T> sub(const Mat<N, M, T> &a, const Mat<N, M, T> &b, Indices<I...>)
+{
+  return Mat<N, M, T>{{(a.m[I] - b.m[I])...}};
+}
+template <int N, int M, typename T, int... I>
+constexpr Mat<N, M, T> scale(const Mat<N, M, T> &a, T s, Indices<I...>)
+{
+  return Mat<N, M, T>{{(a.m[I] * s)...}};
+}
+template <int N, int K, int M, typename T, int... I>
+constexpr Mat<N, M, T> multiply(const Mat<N, K, T> &a, const Mat<K, M, T> &b, Indices<I...>)
+{
+  return Mat<N, M, T>{{Product<K, K, M>::sum(a.m, b.m, I / M, I % M)...}};
+}
+template <int N, int K, typename T, int... I>
+constexpr Vec<N, T> multiply(const Mat<N, K, T> &a, const Vec<K, T> &b, Indices<I...>)
+{
+  return Vec<N, T>{{Product<K, K, 1>::sum(a.m, b.v, I, 0)...}};
+}
+template <int N, int M, typename T, int... I>
+constexpr Mat<M, N, T> transpose(const Mat<N, M, T> &a, Indices<I...>)
+{
+  return Mat<M, N, T>{{a.m[(I % N) * M + I / N]...}};
+}
+template <int N, typename T, int... I>
+constexpr Mat<N, N, T> identity(T one, Indices<I...>)
+{
+  return Mat<N, N, T>{{(I / N == I % N ? one : T())...}};
+}
+template <int N, int M, typename T, int... I>
+constexpr Vec<M, T> row(const Mat<N, M, T> &a, int i, Indices<I...>)
+{
+  return Vec<M, T>{{a.m[i * M + I]...}};
+}
+template <int N, int M, typename T, int... I>
+constexpr Mat<N, M, T> loadMat(const T *p, Indices<I...>)
+{
+  return Mat<N, M, T>{{p[I]...}};
+}
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+// Vectors
+
+template <int N, typename T>
+constexpr Vec<N, T> operator+(const Vec<N, T> &a, const Vec<N, T> &b)
+{
+  return detail::add(a, b, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T> &a, const Vec<N, T> &b)
+{
+  return detail::sub(a, b, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T> &a)
+{
+  return detail::neg(a, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator*(const Vec<N, T> &a, T s)
+{
+  return detail::scale(a, s, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, typename T>
+constexpr Vec<N, T> operator*(T s, const Vec<N, T> &a)
+{
+  return detail::scale(a, s, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, typename T>
+constexpr T dot(const Vec<N, T> &a, const Vec<N, T> &b)
+{
+  return detail::Dot<N>::sum(a.v, b.v);
+}
+
+template <typename T>
+constexpr Vec<3, T> cross(const Vec<3, T> &a, const Vec<3, T> &b)
+{
+  return Vec<3, T>{{a.v[1] * b.v[2] - a.v[2] * b.v[1],
+                    a.v[2] * b.v[0] - a.v[0] * b.v[2],
+                    a.v[0] * b.v[1] - a.v[1] * b.v[0]}};
+}
+
+// From and to plain arrays, such as float[3] or a row of float[3][3]
+template <int N, typename T>
+constexpr Vec<N, T> load(const T *p)
+{
+  return detail::load<N, T>(p, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, typename T>
+inline void store(const Vec<N, T> &a, T *p)
+{
+  for (int i = 0; i < N; ++i)
+    p[i] = a.v[i];
+}
+
+//------------------------------------------------------------------------------
+// Matrices
+
+template <int N, int M, typename T>
+constexpr Mat<N, M, T> operator+(const Mat<N, M, T> &a, const Mat<N, M, T> &b)
+{
+  return detail::add(a, b, typename detail::MakeIndices<N * M>::type());
+}
+
+template <int N, int M, typename T>
+constexpr Mat<N, M, T> operator-(const Mat<N, M, T> &a, const Mat<N, M, T> &b)
+{
+  return detail::sub(a, b, typename detail::MakeIndices<N * M>::type());
+}
+
+template <int N, int M, typename T>
+constexpr Mat<N, M, T> operator*(const Mat<N, M, T> &a, T s)
+{
+  return detail::scale(a, s, typename detail::MakeIndices<N * M>::type());
+}
+
+template <int N, int K, int M, typename T>
+constexpr Mat<N, M, T> operator*(const Mat<N, K, T> &a, const Mat<K, M, T> &b)
+{
+  return detail::multiply(a, b, typename detail::MakeIndices<N * M>::type());
+}
+
+template <int N, int K, typename T>
+constexpr Vec<N, T> operator*(const Mat<N, K, T> &a, const Vec<K, T> &b)
+{
+  return detail::multiply(a, b, typename detail::MakeIndices<N>::type());
+}
+
+template <int N, int M, typename T>
+constexpr Mat<M, N, T> transpose(const Mat<N, M, T> &a)
+{
+  return detail::transpose(a, typename detail::MakeIndices<N * M>::type());
+}
+
+// one is T's 1, e.g. 1.0f or Q30::fromRaw(1L << 30)
+template <int N, typename T>
+constexpr Mat<N, N, T> identity(T one)
+{
+  return detail::identity<N>(one, typename detail::MakeIndices<N * N>::type());
+}
+
+template <int N, int M, typename T>
+constexpr Vec<M, T> row(const Mat<N, M, T> &a, int i)
+{
+  return detail::row(a, i, typename detail::MakeIndices<M>::type());
+}
+
+// p is N * M values row major, e.g. &a[0][0] of a float[N][M]
+template <int N, int M, typename T>
+constexpr Mat<N, M, T> loadMat(const T *p)
+{
+  return detail::loadMat<N, M, T>(p, typename detail::MakeIndices<N * M>::type());
+}
+
+template <int N, int M, typename T>
+inline void store(const Mat<N, M, T> &a, T *p)
+{
+  for (int i = 0; i < N * M; ++i)
+    p[i] = a.m[i];
+}
+
+} // namespace matvec
+
+#endif // MATVEC_H
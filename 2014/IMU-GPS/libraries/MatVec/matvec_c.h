@@ -0,0 +1,98 @@
+/*
+ * matvec_c.h - the 3-vector and 3x3 matrix kernels of MatVec.h for C
+ * compilers (XC16, or C files anywhere else), as static inline functions on
+ * plain arrays, written out with no loops.
+ *
+ * Two element types, same names with a suffix:
+ *   _f    float
+ *   _q16  int32_t Q16.16, products rounded down. Define MATVEC_Q16_MUL
+ *         before including to use something faster than the 64 bit product,
+ *         e.g. mulQ16 from the IMU board's fixedPoint.h.
+ * Sums are taken in the same order as MatVec.h, so results are identical.
+ * Outputs may alias inputs.
+ */
+
+#ifndef MATVEC_C_H
+#define MATVEC_C_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MATVEC_Q16_MUL
+#define MATVEC_Q16_MUL(a, b) ((int32_t) (((int64_t) (a) * (b)) >> 16))
+#endif
+
+#define MATVEC_F_MUL(a, b) ((a) * (b))
+
+/*One set of kernels for element type T, products through MUL*/
+#define MATVEC_DEFINE(SUFFIX, T, MUL)                                          \
+static inline void mv3_add##SUFFIX(T out[3], const T a[3], const T b[3])     \
+{                                                                              \
+    out[0] = a[0] + b[0];                                                      \
+    out[1] = a[1] + b[1];                                                      \
+    out[2] = a[2] + b[2];                                                      \
+}                                                                              \
+static inline void mv3_sub##SUFFIX(T out[3], const T a[3], const T b[3])     \
+{                                                                              \
+    out[0] = a[0] - b[0];                                                      \
+    out[1] = a[1] - b[1];                                                      \
+    out[2] = a[2] - b[2];                                                      \
+}                                                                              \
+static inline void mv3_scale##SUFFIX(T out[3], const T a[3], T s)            \
+{                                                                              \
+    out[0] = MUL(a[0], s);                                                     \
+    out[1] = MUL(a[1], s);                                                     \
+    out[2] = MUL(a[2], s);                                                     \
+}                                                                              \
+static inline T mv3_dot##SUFFIX(const T a[3], const T b[3])                  \
+{                                                                              \
+    return MUL(a[0], b[0]) + MUL(a[1], b[1]) + MUL(a[2], b[2]);                \
+}                                                                              \
+static inline void mv3_cross##SUFFIX(T out[3], const T a[3], const T b[3])   \
+{                                                                              \
+    T x = MUL(a[1], b[2]) - MUL(a[2], b[1]);                                   \
+    T y = MUL(a[2], b[0]) - MUL(a[0], b[2]);                                   \
+    T z = MUL(a[0], b[1]) - MUL(a[1], b[0]);                                   \
+    out[0] = x;                                                                \
+    out[1] = y;                                                                \
+    out[2] = z;                                                                \
+}                                                                              \
+/*out = a b, row major 3x3; out may not alias a or b*/                        \
+static inline void mm33_mul##SUFFIX(T out[9], const T a[9], const T b[9])    \
+{                                                                              \
+    out[0] = MUL(a[0], b[0]) + MUL(a[1], b[3]) + MUL(a[2], b[6]);              \
+    out[1] = MUL(a[0], b[1]) + MUL(a[1], b[4]) + MUL(a[2], b[7]);              \
+    out[2] = MUL(a[0], b[2]) + MUL(a[1], b[5]) + MUL(a[2], b[8]);              \
+    out[3] = MUL(a[3], b[0]) + MUL(a[4], b[3]) + MUL(a[5], b[6]);              \
+    out[4] = MUL(a[3], b[1]) + MUL(a[4], b[4]) + MUL(a[5], b[7]);              \
+    out[5] = MUL(a[3], b[2]) + MUL(a[4], b[5]) + MUL(a[5], b[8]);              \
+    out[6] = MUL(a[6], b[0]) + MUL(a[7], b[3]) + MUL(a[8], b[6]);              \
+    out[7] = MUL(a[6], b[1]) + MUL(a[7], b[4]) + MUL(a[8], b[7]);              \
+    out[8] = MUL(a[6], b[2]) + MUL(a[7], b[5]) + MUL(a[8], b[8]);              \
+}                                                                              \
+/*out = a v; out may not alias v*/                                            \
+static inline void mm33_mulv##SUFFIX(T out[3], const T a[9], const T v[3])   \
+{                                                                              \
+    out[0] = MUL(a[0], v[0]) + MUL(a[1], v[1]) + MUL(a[2], v[2]);              \
+    out[1] = MUL(a[3], v[0]) + MUL(a[4], v[1]) + MUL(a[5], v[2]);              \
+    out[2] = MUL(a[6], v[0]) + MUL(a[7], v[1]) + MUL(a[8], v[2]);              \
+}                                                                              \
+/*out = a'; out may not alias a*/                                             \
+static inline void mm33_transpose##SUFFIX(T out[9], const T a[9])            \
+{                                                                              \
+    out[0] = a[0]; out[1] = a[3]; out[2] = a[6];                               \
+    out[3] = a[1]; out[4] = a[4]; out[5] = a[7];                               \
+    out[6] = a[2]; out[7] = a[5]; out[8] = a[8];                               \
+}
+
+MATVEC_DEFINE(_f, float, MATVEC_F_MUL)
+MATVEC_DEFINE(_q16, int32_t, MATVEC_Q16_MUL)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MATVEC_C_H */
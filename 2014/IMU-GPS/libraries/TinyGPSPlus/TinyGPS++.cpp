@@ -27,8 +27,20 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <ctype.h>
 #include <stdlib.h>
 
-#define _GPRMCterm   "GPRMC"
-#define _GPGGAterm   "GPGGA"
+// Sentence types by hashSentenceName(), checked with strcmp on a hash match.
+// type is TinyGPSPlus's GPS_SENTENCE_GPGGA (0) or GPS_SENTENCE_GPRMC (1).
+static const struct
+{
+  uint16_t hash;
+  char name[6];
+  uint8_t type;
+} sentenceTypes[] =
+{
+  {0x113e, "GPRMC", 1},
+  {0xe1ab, "GPGGA", 0},
+  {0xf87c, "GNRMC", 1}, // multi-constellation receivers
+  {0xc8e9, "GNGGA", 0},
+};
 
 TinyGPSPlus::TinyGPSPlus()
   :  parity(0)
@@ -37,14 +49,15 @@ TinyGPSPlus::TinyGPSPlus()
   ,  curTermNumber(0)
   ,  curTermOffset(0)
   ,  sentenceHasFix(false)
-  ,  customElts(0)
   ,  customCandidates(0)
+  ,  customNext(0)
   ,  encodedCharCount(0)
   ,  sentencesWithFixCount(0)
   ,  failedChecksumCount(0)
   ,  passedChecksumCount(0)
 {
   term[0] = '\0';
+  memset(customBuckets, 0, sizeof(customBuckets));
 }
 
 //
@@ -58,30 +71,13 @@ bool TinyGPSPlus::encode(char c)
   switch(c)
   {
   case ',': // term terminators
-    parity ^= (uint8_t)c;
   case '\r':
   case '\n':
   case '*':
-    {
-      bool isValidSentence = false;
-      if (curTermOffset < sizeof(term))
-      {
-        term[curTermOffset] = 0;
-        isValidSentence = endOfTermHandler();
-      }
-      ++curTermNumber;
-      curTermOffset = 0;
-      isChecksumTerm = c == '*';
-      return isValidSentence;
-    }
-    break;
+    return endOfTerm(c);
 
   case '$': // sentence begin
-    curTermNumber = curTermOffset = 0;
-    parity = 0;
-    curSentenceType = GPS_SENTENCE_OTHER;
-    isChecksumTerm = false;
-    sentenceHasFix = false;
+    beginSentence();
     return false;
 
   default: // ordinary characters
@@ -91,13 +87,76 @@ bool TinyGPSPlus::encode(char c)
       parity ^= c;
     return false;
   }
+}
 
-  return false;
+// Same as encode(char) on each character, but the characters of a term are
+// copied in a tight loop and only the delimiters take the switch
+size_t TinyGPSPlus::encode(const char *buf, size_t n)
+{
+  const char *end = buf + n;
+  size_t sentences = 0;
+
+  encodedCharCount += n;
+  while (buf != end)
+  {
+    uint8_t offset = curTermOffset;
+    uint8_t p = parity;
+    char c;
+
+    // All the delimiters sort at or below ',', digits and letters above it
+    while (buf != end && ((uint8_t)(c = *buf) > ',' ||
+           (c != ',' && c != '*' && c != '$' && c != '\r' && c != '\n')))
+    {
+      if (offset < sizeof(term) - 1)
+        term[offset++] = c;
+      p ^= c;
+      ++buf;
+    }
+    curTermOffset = offset;
+    if (!isChecksumTerm)
+      parity = p;
+
+    if (buf == end)
+      break;
+    if (*buf == '$')
+      beginSentence();
+    else if (endOfTerm(*buf))
+      ++sentences;
+    ++buf;
+  }
+
+  return sentences;
 }
 
 //
 // internal utilities
 //
+void TinyGPSPlus::beginSentence()
+{
+  curTermNumber = curTermOffset = 0;
+  parity = 0;
+  curSentenceType = GPS_SENTENCE_OTHER;
+  isChecksumTerm = false;
+  sentenceHasFix = false;
+  customCandidates = customNext = NULL;
+}
+
+bool TinyGPSPlus::endOfTerm(char c)
+{
+  bool isValidSentence = false;
+  if (c == ',')
+    parity ^= (uint8_t)c;
+  if (curTermOffset < sizeof(term))
+  {
+    term[curTermOffset] = 0;
+    isValidSentence = endOfTermHandler();
+  }
+  ++curTermNumber;
+  curTermOffset = 0;
+  isChecksumTerm = c == '*';
+  return isValidSentence;
+}
+
 int TinyGPSPlus::fromHex(char a)
 {
   if (a >= 'A' && a <= 'F')
@@ -125,6 +184,16 @@ int32_t TinyGPSPlus::parseDecimal(const char *term)
   return negative ? -ret : ret;
 }
 
+// static
+// djb2 on 16 bits: a shift and two adds per character on the AVR too
+uint16_t TinyGPSPlus::hashSentenceName(const char *name)
+{
+  uint16_t hash = 5381;
+  while (*name)
+    hash = (hash << 5) + hash + (uint8_t)*name++;
+  return hash;
+}
+
 // static
 // Parse degrees in that funny NMEA format DDMM.MMMM
 void TinyGPSPlus::parseDegrees(const char *term, RawDegrees &deg)
@@ -191,7 +260,7 @@ bool TinyGPSPlus::endOfTermHandler()
       }
 
       // Commit all custom listeners of this sentence type
-      for (TinyGPSCustom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0; p = p->next)
+      for (TinyGPSCustom *p = customCandidates; p != NULL && p->sentenceName == customCandidates->sentenceName; p = p->next)
          p->commit();
       return true;
     }
@@ -207,17 +276,21 @@ bool TinyGPSPlus::endOfTermHandler()
   // the first term determines the sentence type
   if (curTermNumber == 0)
   {
-    if (!strcmp(term, _GPRMCterm))
-      curSentenceType = GPS_SENTENCE_GPRMC;
-    else if (!strcmp(term, _GPGGAterm))
-      curSentenceType = GPS_SENTENCE_GPGGA;
-    else
-      curSentenceType = GPS_SENTENCE_OTHER;
+    uint16_t hash = hashSentenceName(term);
+
+    curSentenceType = GPS_SENTENCE_OTHER;
+    for (uint8_t i = 0; i < sizeof(sentenceTypes) / sizeof(sentenceTypes[0]); ++i)
+      if (sentenceTypes[i].hash == hash && !strcmp(sentenceTypes[i].name, term))
+      {
+        curSentenceType = sentenceTypes[i].type;
+        break;
+      }
 
     // Any custom candidates of this sentence type?
-    for (customCandidates = customElts; customCandidates != NULL && strcmp(customCandidates->sentenceName, term) < 0; customCandidates = customCandidates->next);
-    if (customCandidates != NULL && strcmp(customCandidates->sentenceName, term) > 0)
-       customCandidates = NULL;
+    for (customCandidates = customBuckets[hash & (_GPS_CUSTOM_BUCKETS - 1)];
+         customCandidates != NULL && (customCandidates->sentenceHash != hash || strcmp(customCandidates->sentenceName, term) != 0);
+         customCandidates = customCandidates->next);
+    customNext = customCandidates;
 
     return false;
   }
@@ -271,10 +344,11 @@ bool TinyGPSPlus::endOfTermHandler()
       break;
   }
 
-  // Set custom values as needed
-  for (TinyGPSCustom *p = customCandidates; p != NULL && strcmp(p->sentenceName, customCandidates->sentenceName) == 0 && p->termNumber <= curTermNumber; p = p->next)
-    if (p->termNumber == curTermNumber)
-         p->set(term);
+  // Set custom values as needed. Terms only go up, so carry on from the
+  // first candidate not passed yet
+  for (; customNext != NULL && customNext->sentenceName == customCandidates->sentenceName && customNext->termNumber <= curTermNumber; customNext = customNext->next)
+    if (customNext->termNumber == curTermNumber)
+         customNext->set(term);
 
   return false;
 }
@@ -364,6 +438,24 @@ double TinyGPSLocation::lng()
    return rawLngData.negative ? -ret : ret;
 }
 
+static int32_t degreesE7(const RawDegrees &raw)
+{
+   int32_t ret = raw.deg * 10000000L + (int32_t)((raw.billionths + 50) / 100);
+   return raw.negative ? -ret : ret;
+}
+
+int32_t TinyGPSLocation::latE7()
+{
+   updated = false;
+   return degreesE7(rawLatData);
+}
+
+int32_t TinyGPSLocation::lngE7()
+{
+   updated = false;
+   return degreesE7(rawLngData);
+}
+
 void TinyGPSDate::commit()
 {
    date = newDate;
@@ -485,17 +577,24 @@ void TinyGPSCustom::set(const char *term)
    strncpy(this->stagingBuffer, term, sizeof(this->stagingBuffer));
 }
 
+// Elements of one sentence are kept together, in term order, and share the
+// first one's name pointer so the parser compares pointers, not strings
 void TinyGPSPlus::insertCustom(TinyGPSCustom *pElt, const char *sentenceName, int termNumber)
 {
-   TinyGPSCustom **ppelt;
+   uint16_t hash = hashSentenceName(sentenceName);
+   TinyGPSCustom **ppelt = &this->customBuckets[hash & (_GPS_CUSTOM_BUCKETS - 1)];
+   TinyGPSCustom **ppgroup = ppelt;
 
-   for (ppelt = &this->customElts; *ppelt != NULL; ppelt = &(*ppelt)->next)
-   {
-      int cmp = strcmp(sentenceName, (*ppelt)->sentenceName);
-      if (cmp < 0 || (cmp == 0 && termNumber < (*ppelt)->termNumber))
+   for (; *ppelt != NULL; ppelt = &(*ppelt)->next)
+      if ((*ppelt)->sentenceHash == hash && strcmp(sentenceName, (*ppelt)->sentenceName) == 0)
+      {
+         pElt->sentenceName = (*ppelt)->sentenceName;
+         for (; *ppelt != NULL && (*ppelt)->sentenceName == pElt->sentenceName && (*ppelt)->termNumber <= termNumber; ppelt = &(*ppelt)->next);
+         ppgroup = ppelt;
          break;
-   }
+      }
 
-   pElt->next = *ppelt;
-   *ppelt = pElt;
+   pElt->sentenceHash = hash;
+   pElt->next = *ppgroup;
+   *ppgroup = pElt;
 }
@@ -39,6 +39,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define _GPS_KM_PER_METER 0.001
 #define _GPS_FEET_PER_METER 3.2808399
 #define _GPS_MAX_FIELD_SIZE 15
+#define _GPS_CUSTOM_BUCKETS 8 // power of two
 
 struct RawDegrees
 {
@@ -61,6 +62,10 @@ public:
    const RawDegrees &rawLng()     { updated = false; return rawLngData; }
    double lat();
    double lng();
+   // Signed degrees * 10^7, rounded: about 1 cm. The same units as the CAN
+   // position frame and u-blox receivers; nano-degrees would overflow 32 bits.
+   int32_t latE7();
+   int32_t lngE7();
 
    TinyGPSLocation() : valid(false), updated(false)
    {}
@@ -206,6 +211,7 @@ private:
    unsigned long lastCommitTime;
    bool valid, updated;
    const char *sentenceName;
+   uint16_t sentenceHash;
    int termNumber;
    friend class TinyGPSPlus;
    TinyGPSCustom *next;
@@ -216,6 +222,8 @@ class TinyGPSPlus
 public:
   TinyGPSPlus();
   bool encode(char c); // process one character received from GPS
+  // process n characters, returns how many sentences passed their checksum
+  size_t encode(const char *buf, size_t n);
   TinyGPSPlus &operator << (char c) {encode(c); return *this;}
 
   TinyGPSLocation location;
@@ -235,6 +243,7 @@ public:
 
   static int32_t parseDecimal(const char *term);
   static void parseDegrees(const char *term, RawDegrees &deg);
+  static uint16_t hashSentenceName(const char *name);
 
   uint32_t charsProcessed()   const { return encodedCharCount; }
   uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
@@ -253,10 +262,12 @@ private:
   uint8_t curTermOffset;
   bool sentenceHasFix;
 
-  // custom element support
+  // custom element support: lists hashed on the sentence name, each sorted
+  // by term number, so a term only looks at the next candidate
   friend class TinyGPSCustom;
-  TinyGPSCustom *customElts;
+  TinyGPSCustom *customBuckets[_GPS_CUSTOM_BUCKETS];
   TinyGPSCustom *customCandidates;
+  TinyGPSCustom *customNext;
   void insertCustom(TinyGPSCustom *pElt, const char *sentenceName, int index);
 
   // statistics
@@ -268,6 +279,8 @@ private:
   // internal utilities
   int fromHex(char a);
   bool endOfTermHandler();
+  bool endOfTerm(char c);
+  void beginSentence();
 };
 
 #endif // def(__TinyGPSPlus_h)
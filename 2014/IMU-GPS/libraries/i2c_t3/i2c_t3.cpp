@@ -108,12 +108,12 @@ struct i2cStruct i2c_t3::i2cData[] =
     {&I2C0_A1, &I2C0_F, &I2C0_C1, &I2C0_S, &I2C0_D, &I2C0_C2,
      &I2C0_FLT, &I2C0_RA, &I2C0_SMB, &I2C0_A2, &I2C0_SLTH, &I2C0_SLTL,
      {}, 0, 0, {}, 0, 0, I2C_MASTER, I2C_PINS_18_19, I2C_STOP, I2C_WAITING,
-     0, 0, 0, 0, NULL, NULL}
+     0, 0, 0, 0, NULL, NULL, NULL}
 #if I2C_BUS_NUM >= 2
    ,{&I2C1_A1, &I2C1_F, &I2C1_C1, &I2C1_S, &I2C1_D, &I2C1_C2,
      &I2C1_FLT, &I2C1_RA, &I2C1_SMB, &I2C1_A2, &I2C1_SLTH, &I2C1_SLTL,
      {}, 0, 0, {}, 0, 0, I2C_MASTER, I2C_PINS_29_30, I2C_STOP, I2C_WAITING,
-     0, 0, 0, 0, NULL, NULL}
+     0, 0, 0, 0, NULL, NULL, NULL}
 #endif
 };
 
@@ -755,6 +755,8 @@ void i2c_isr_handler(struct i2cStruct* i2c, uint8_t bus)
                 }
                 I2C_DEBUG_STRB("\n");
                 *(i2c->S) = I2C_S_IICIF; // clear intr
+                if(i2c->currentStatus != I2C_SENDING && i2c->user_onMasterDone != NULL)
+                    i2c->user_onMasterDone(); // Tx complete or NAK
                 return;
             }
             else if(i2c->currentStatus == I2C_SEND_ADDR)
@@ -767,6 +769,8 @@ void i2c_isr_handler(struct i2cStruct* i2c, uint8_t bus)
                     i2c->currentStatus = I2C_ARB_LOST;
                     *(i2c->C1) = I2C_C1_IICEN; // change to Rx mode, intr disabled (does this send STOP if ARBL flagged?)
                     *(i2c->S) = I2C_S_ARBL | I2C_S_IICIF; // clear arbl flag and intr
+                    if(i2c->user_onMasterDone != NULL)
+                        i2c->user_onMasterDone();
                     return;
                 }
                 if(status & I2C_S_RXAK)
@@ -791,6 +795,8 @@ void i2c_isr_handler(struct i2cStruct* i2c, uint8_t bus)
                 }
                 I2C_DEBUG_STRB("\n");
                 *(i2c->S) = I2C_S_IICIF; // clear intr
+                if(i2c->currentStatus == I2C_ADDR_NAK && i2c->user_onMasterDone != NULL)
+                    i2c->user_onMasterDone();
                 return;
             }
             else if(i2c->currentStatus == I2C_TIMEOUT)
@@ -825,6 +831,7 @@ void i2c_isr_handler(struct i2cStruct* i2c, uint8_t bus)
         else
         {
             // Continue Master Receive
+            uint8_t rxDone = 0;
             I2C_DEBUG_STR("MR"); // master receive
             // check if 2nd to last byte or timeout
             if((i2c->rxBufferLength+2) == i2c->reqCount ||
@@ -834,6 +841,7 @@ void i2c_isr_handler(struct i2cStruct* i2c, uint8_t bus)
             if((i2c->rxBufferLength+1) >= i2c->reqCount ||
                (i2c->currentStatus == I2C_TIMEOUT && i2c->timeoutRxNAK))
             {
+                rxDone = 1;
                 i2c->timeoutRxNAK = 0; // clear flag
                 if(i2c->currentStatus != I2C_TIMEOUT)
                     i2c->currentStatus = I2C_WAITING; // Rx complete, change to waiting state
@@ -867,6 +875,8 @@ void i2c_isr_handler(struct i2cStruct* i2c, uint8_t bus)
             if(i2c->currentStatus == I2C_TIMEOUT && !i2c->timeoutRxNAK)
                 i2c->timeoutRxNAK = 1; // set flag to indicate NAK sent
             *(i2c->S) = I2C_S_IICIF; // clear intr
+            if(rxDone && i2c->user_onMasterDone != NULL)
+                i2c->user_onMasterDone(); // Rx complete or timed out
             return;
         }
     }
@@ -2,6 +2,10 @@
     ------------------------------------------------------------------------------------------------------
     i2c_t3 - I2C library for Teensy3, derived from Teensy3 TwoWire library
 
+    - Modified 2014 for the SF9DOF AHRS
+        - added onMasterDone() callback, called from the ISR when a non-blocking master Tx or Rx
+          completes or fails, so transfers can be chained without polling done()
+
     - Modified 16Jan14 by Brian (nox771 at gmail.com)
         - all new structure using dereferenced pointers instead of hardcoding. This allows functions
           (including ISRs) to be reused across multiple I2C buses.  Most functions moved to static,
@@ -431,6 +435,7 @@ struct i2cStruct
     uint8_t  timeoutRxNAK;                   // Rx Timeout NAK flag               (ISR)
     void (*user_onReceive)(size_t len);      // Slave Rx Callback Function        (User)
     void (*user_onRequest)(void);            // Slave Tx Callback Function        (User)
+    void (*user_onMasterDone)(void);         // Master Tx/Rx Done Callback        (User)
 };
 
 
@@ -764,6 +769,12 @@ public:
     //
     inline void onRequest(void (*function)(void)) { i2c->user_onRequest = function; }
 
+    // ------------------------------------------------------------------------------------------------------
+    // Set callback function for Master Tx/Rx done - called from the ISR once a sendTransmission() or
+    // sendRequest() has completed or failed (check status()). It may start the next transfer.
+    //
+    inline void onMasterDone(void (*function)(void)) { i2c->user_onMasterDone = function; }
+
     // ------------------------------------------------------------------------------------------------------
     // for compatibility with pre-1.0 sketches and libraries
     inline void send(uint8_t b)             { write(b); }
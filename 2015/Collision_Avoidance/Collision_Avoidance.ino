@@ -1,4 +1,5 @@
 #include <Servo.h>
+#include "Ranging.h"
 
 unsigned int ir1Pin = 14;
 unsigned int ir2Pin = 15;
@@ -18,11 +19,6 @@ unsigned int servoSweepAngle = 10;
 
 unsigned int usEchoPin = 7;
 unsigned int usTrigPin = 8;
-unsigned long usTime = 0; 
-unsigned long usPrevTime = 0;
-unsigned int usErrorThreshold = 800;
-unsigned int usReadDelay = 250;
-unsigned long usReadPrevTime = 0; 
 unsigned int usThreshold = 25; 
 
 unsigned int led1GPin = 3;
@@ -45,14 +41,25 @@ unsigned int alert3Pin = 18;
 unsigned int alert1 = 0;
 unsigned int alert2 = 0; 
 unsigned int alert3 = 0;
+unsigned int ledAlert = 2;  // neither, so the first loop sets the LEDs
+
+UltrasonicChannel ultrasonic[] =
+{
+  ULTRASONIC(usTrigPin, usEchoPin, alert1Pin, usThreshold)
+};
+
+DigitalChannel ir[] =
+{
+  DIGITAL(ir1Pin, alert2Pin),
+  DIGITAL(ir2Pin, alert3Pin)
+};
+
+uint8_t frame[RANGE_FRAME_MAX];
 
 void setup()
 {
   ir1Servo.attach(ir1ServoPin);
   ir2Servo.attach(ir2ServoPin);
-  pinMode (ir1Pin, INPUT);
-  pinMode (ir2Pin, INPUT);
-  
   pinMode (led1GPin, OUTPUT);
   pinMode (led1RPin, OUTPUT);
   pinMode (led1BPin, OUTPUT);
@@ -60,111 +67,30 @@ void setup()
   pinMode (led2RPin, OUTPUT);
   pinMode (led2BPin, OUTPUT);
   
-  pinMode (usTrigPin, OUTPUT);
-  digitalWrite(usTrigPin, HIGH);
-  pinMode(usEchoPin, INPUT);
-  
-  pinMode (alert1Pin, OUTPUT);
-  pinMode (alert2Pin, OUTPUT);
-  pinMode (alert3Pin, OUTPUT);
   pinMode (13, OUTPUT);
   digitalWrite (13, HIGH);
   
   Serial.begin(9600);
+  ranging_begin(ultrasonic, 1, ir, 2);
 }
 
 void loop()
 {
-  if ( (millis() - usReadPrevTime) > usReadDelay)
-  {
-    digitalWrite(usEchoPin, LOW);
-    digitalWrite(usTrigPin, LOW);
-    delayMicroseconds(20);
-    digitalWrite(usTrigPin, HIGH);
-    usTime = pulseIn(usEchoPin, HIGH) /58;
-    if (usTime > usPrevTime)
-    {
-      if (usTime - usPrevTime > usErrorThreshold)
-          usTime = usPrevTime;
-    }
-    if (usTime < usPrevTime)
-    {
-      if (usPrevTime - usTime > usErrorThreshold)
-          usTime = usPrevTime;
-    }
-    usReadPrevTime = millis();
-  }
-  
-  Serial.println(usTime);
-  
-  if (usTime < usThreshold)
-  {
-    digitalWrite(alert1Pin, HIGH);
-    alert1 = 1;
-    /*
-    analogWrite(led1GPin, 0); 
-    analogWrite(led1BPin, 0); 
-    analogWrite(led1RPin, 255);
-  
-    analogWrite(led2GPin, 0); 
-    analogWrite(led2BPin, 0); 
-    analogWrite(led2RPin, 255);
-    */
-  }
-  
-  else
-  { 
-    digitalWrite(alert1Pin, LOW);
-    alert1 = 0;
-  }
-  
-  /*if (digitalRead(ir1Pin))
+  // never waits on a sensor: each call moves the ranging along and
+  // the alert pins are already up to date when it returns
+  if (ranging_update())
   {
-    digitalWrite(alert2Pin, HIGH); 
-    alert2 = 1;
-    servo1Stop = 1;  
-    /*
-    analogWrite(led1GPin, 0); 
-    analogWrite(led1BPin, 0); 
-    analogWrite(led1RPin, 255);
-  
-    analogWrite(led2GPin, 0); 
-    analogWrite(led2BPin, 0); 
-    analogWrite(led2RPin, 255);
-    
-    
+    Serial.write(frame, ranging_frame(frame));
   }
   
-  else 
-  {
-    digitalWrite(alert2Pin, LOW);
-    alert2 = 0;
-    servo1Stop = 0;
-  }
-    
-   if (digitalRead(ir2Pin))
-   {
-     digitalWrite(alert3Pin, HIGH);
-     servo2Stop = 1;
-     alert3 = 1;
-     /*
-     analogWrite(led1GPin, 0); 
-     analogWrite(led1BPin, 0); 
-     analogWrite(led1RPin, 255);
+  alert1 = ultrasonic[0].alert;
+  alert2 = ir[0].alert;
+  alert3 = ir[1].alert;
   
-    analogWrite(led2GPin, 0); 
-    analogWrite(led2BPin, 0); 
-    analogWrite(led2RPin, 255); 
-    
-   }
+  /*
+  servo1Stop = alert2;
+  servo2Stop = alert3;
   
-  else 
-  {
-    digitalWrite(alert3Pin, LOW);
-    servo2Stop = 0; 
-    alert3 = 0;
-  }
-    
     if ((millis() - servoPrevTime) > servoDelay) 
     {
       if (!servo1Stop)
@@ -201,7 +127,12 @@ void loop()
     ir1Servo.write(servo1Pos);
     ir2Servo.write(servo2Pos);  
     */
+    
     //if (alert1 || alert2 || alert3)
+    if (alert1 == ledAlert)
+      return;
+    ledAlert = alert1;
+    
     if (alert1)
     {
     analogWrite(led1GPin, 0); 
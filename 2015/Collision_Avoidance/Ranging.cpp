@@ -0,0 +1,246 @@
+#include "Ranging.h"
+
+#include <car_crc8.h>
+
+enum
+{
+  SLOT_TRIGGER,  // trigger held low
+  SLOT_LISTEN,   // waiting for the echo
+  SLOT_QUIET     // reading taken, letting the echoes die down
+};
+
+static UltrasonicChannel *usChannels;
+static uint8_t usCount;
+static DigitalChannel *irChannels;
+static uint8_t irCount;
+
+static uint8_t active;
+static uint8_t slotState;
+static uint32_t slotStart;
+static uint8_t fresh;
+static uint32_t irNext;
+
+// shared with echoChange()
+static volatile uint8_t echoPin;
+static volatile bool echoHigh;
+static volatile bool echoDone;
+static volatile uint32_t echoRise;
+static volatile uint32_t echoWidth;
+
+// Only the active channel's echo pin is attached, so this is the only
+// edge it can see. The rising edge starts the pulse, the falling edge
+// ends it; a falling edge without a rise (attached mid pulse) is ignored.
+static void echoChange()
+{
+  uint32_t now = micros();
+  if (digitalRead(echoPin))
+  {
+    echoRise = now;
+    echoHigh = true;
+  }
+  else if (echoHigh)
+  {
+    echoWidth = now - echoRise;
+    echoHigh = false;
+    echoDone = true;
+  }
+}
+
+static uint16_t median(const uint16_t *readings)
+{
+  uint16_t sorted[RANGE_MEDIAN];
+  for (uint8_t i = 0; i < RANGE_MEDIAN; i++)
+  {
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > readings[i])
+    {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = readings[i];
+  }
+  return sorted[RANGE_MEDIAN / 2];
+}
+
+static void setAlert(uint8_t pin, bool *alert, bool on)
+{
+  if (*alert != on)
+  {
+    *alert = on;
+    digitalWrite(pin, on ? HIGH : LOW);
+  }
+}
+
+static void record(UltrasonicChannel *ch, uint16_t cm)
+{
+  ch->readings[ch->next] = cm;
+  ch->next = (ch->next + 1) % RANGE_MEDIAN;
+  ch->range = median(ch->readings);
+  // on at once, off when the median agrees
+  setAlert(ch->alertPin, &ch->alert,
+           cm < ch->threshold || (ch->alert && ch->range < ch->threshold));
+}
+
+static void startSlot(uint32_t now)
+{
+  UltrasonicChannel *ch = &usChannels[active];
+  echoPin = ch->echoPin;
+  echoHigh = false;
+  echoDone = false;
+  attachInterrupt(ch->echoPin, echoChange, CHANGE);
+
+  // the sensor fires on the trigger going back high
+  digitalWrite(ch->trigPin, LOW);
+  slotStart = now;
+  slotState = SLOT_TRIGGER;
+}
+
+// Takes the reading, or no echo, and stops listening
+static void endListen()
+{
+  UltrasonicChannel *ch = &usChannels[active];
+  detachInterrupt(ch->echoPin);
+
+  uint32_t width = RANGE_ECHO_MAX_US;
+  noInterrupts();
+  if (echoDone)
+    width = echoWidth;
+  interrupts();
+
+  record(ch, width < RANGE_ECHO_MAX_US ? width / 58 : RANGE_NO_ECHO);
+  fresh |= 1 << active;
+  slotState = SLOT_QUIET;
+}
+
+static void sampleDigital(uint32_t now)
+{
+  if (irCount == 0 || (int32_t)(now - irNext) < 0)
+    return;
+
+  for (uint8_t i = 0; i < irCount; i++)
+  {
+    DigitalChannel *ch = &irChannels[i];
+    ch->samples = ((ch->samples << 1) | (digitalRead(ch->pin) ? 1 : 0)) & ((1 << RANGE_MEDIAN) - 1);
+
+    uint8_t seen = 0;
+    for (uint8_t bits = ch->samples; bits; bits >>= 1)
+      seen += bits & 1;
+    setAlert(ch->alertPin, &ch->alert, seen > RANGE_MEDIAN / 2);
+  }
+
+  // on the grid, unless a whole period was missed
+  irNext += RANGE_DIGITAL_US;
+  if ((int32_t)(now - irNext) >= 0)
+    irNext = now + RANGE_DIGITAL_US;
+}
+
+void ranging_begin(UltrasonicChannel *ultrasonic, uint8_t ultrasonicCount,
+                   DigitalChannel *digital, uint8_t digitalCount)
+{
+  usChannels = ultrasonic;
+  usCount = ultrasonicCount > RANGE_MAX_ULTRASONIC ? RANGE_MAX_ULTRASONIC : ultrasonicCount;
+  irChannels = digital;
+  irCount = digitalCount > RANGE_MAX_DIGITAL ? RANGE_MAX_DIGITAL : digitalCount;
+
+  for (uint8_t i = 0; i < usCount; i++)
+  {
+    UltrasonicChannel *ch = &usChannels[i];
+    pinMode(ch->trigPin, OUTPUT);
+    digitalWrite(ch->trigPin, HIGH);
+    pinMode(ch->echoPin, INPUT);
+    pinMode(ch->alertPin, OUTPUT);
+    digitalWrite(ch->alertPin, LOW);
+
+    // nothing seen until told otherwise
+    for (uint8_t k = 0; k < RANGE_MEDIAN; k++)
+      ch->readings[k] = RANGE_NO_ECHO;
+    ch->next = 0;
+    ch->range = RANGE_NO_ECHO;
+    ch->alert = false;
+  }
+
+  for (uint8_t i = 0; i < irCount; i++)
+  {
+    DigitalChannel *ch = &irChannels[i];
+    pinMode(ch->pin, INPUT);
+    pinMode(ch->alertPin, OUTPUT);
+    digitalWrite(ch->alertPin, LOW);
+    ch->samples = 0;
+    ch->alert = false;
+  }
+
+  uint32_t now = micros();
+  irNext = now;
+  fresh = 0;
+  active = 0;
+  if (usCount > 0)
+    startSlot(now);
+}
+
+bool ranging_update()
+{
+  uint32_t now = micros();
+  sampleDigital(now);
+  if (usCount == 0)
+    return false;
+
+  uint32_t elapsed = now - slotStart;
+  switch (slotState)
+  {
+  case SLOT_TRIGGER:
+    if (elapsed >= RANGE_TRIGGER_US)
+    {
+      digitalWrite(usChannels[active].trigPin, HIGH);
+      slotState = SLOT_LISTEN;
+    }
+    break;
+
+  case SLOT_LISTEN:
+    if (echoDone || elapsed >= RANGE_TRIGGER_US + RANGE_ECHO_MAX_US)
+      endListen();
+    break;
+
+  case SLOT_QUIET:
+    if (elapsed >= RANGE_SLOT_US)
+    {
+      active = (active + 1) % usCount;
+      startSlot(now);
+    }
+    break;
+  }
+
+  if (fresh == (1 << usCount) - 1)
+  {
+    fresh = 0;
+    return true;
+  }
+  return false;
+}
+
+uint8_t ranging_frame(uint8_t *out)
+{
+  uint8_t n = 0;
+  uint8_t flags = 0;
+
+  out[n++] = RANGE_FRAME_SYNC;
+  out[n++] = RANGE_FRAME_ID;
+  out[n++] = usCount;
+  for (uint8_t i = 0; i < usCount; i++)
+  {
+    out[n++] = usChannels[i].range & 0xFF;
+    out[n++] = usChannels[i].range >> 8;
+    if (usChannels[i].alert)
+      flags |= 1 << i;
+  }
+  for (uint8_t i = 0; i < irCount; i++)
+  {
+    if (irChannels[i].alert)
+      flags |= 1 << (4 + i);
+  }
+  out[n++] = flags;
+
+  // CRC-8 over everything after the sync byte
+  out[n] = car_crc8(0, &out[1], n - 1);
+  n++;
+  return n;
+}
@@ -0,0 +1,82 @@
+/*
+  Ranging.h - non-blocking ranging for Collision_Avoidance.
+
+  The ultrasonic sensors are fired one at a time, round robin, each in its
+  own RANGE_SLOT_US slot so one sensor's echo can't be heard by the next.
+  The echo pin's change interrupt times the pulse; nothing waits for it.
+  Each channel keeps its last RANGE_MEDIAN readings and uses the median,
+  so a single missed or stray echo doesn't move the range. The digital IR
+  sensors are sampled every RANGE_DIGITAL_US and take the majority of their
+  last RANGE_MEDIAN samples.
+
+  Call ranging_update() from loop() as often as possible. An ultrasonic
+  alert is raised by the raw reading, not the median, so an obstacle is
+  flagged at the end of the slot its echo comes back in. It clears once a
+  raw reading and the median are both past the threshold again, so one
+  missed echo doesn't drop it; one stray short echo does flag for a slot.
+  The reported range is still the median.
+*/
+
+#ifndef RANGING_H
+#define RANGING_H
+
+#include <Arduino.h>
+
+#define RANGE_SLOT_US     30000  // per ultrasonic trigger, echo and quiet time
+#define RANGE_ECHO_MAX_US 25000  // longer is no echo: about 4.3 m
+#define RANGE_TRIGGER_US  20     // trigger pulse width
+#define RANGE_NO_ECHO     500    // cm, reported when nothing came back
+#define RANGE_MEDIAN      5      // readings per channel median
+#define RANGE_DIGITAL_US  6000   // IR sample period, RANGE_MEDIAN of them per slot
+
+#define RANGE_MAX_ULTRASONIC 4
+#define RANGE_MAX_DIGITAL    4
+
+// Report frame:
+//   0xA5 | 0x10 | n | range cm, uint16 little endian, x n | flags | CRC-8
+// flags bit i is ultrasonic channel i's alert, bit 4 + i is digital
+// channel i. The CRC-8 (polynomial 0x07) covers everything after 0xA5.
+#define RANGE_FRAME_SYNC 0xA5
+#define RANGE_FRAME_ID   0x10
+#define RANGE_FRAME_MAX  (5 + 2 * RANGE_MAX_ULTRASONIC)
+
+struct UltrasonicChannel
+{
+  uint8_t trigPin;
+  uint8_t echoPin;
+  uint8_t alertPin;
+  uint16_t threshold;              // cm, alert below this
+
+  // kept by the engine
+  uint16_t readings[RANGE_MEDIAN]; // cm
+  uint8_t next;
+  uint16_t range;                  // cm, median of readings
+  bool alert;                      // see above, not just range < threshold
+};
+
+struct DigitalChannel
+{
+  uint8_t pin;                     // high when something is seen
+  uint8_t alertPin;
+
+  // kept by the engine
+  uint8_t samples;                 // last RANGE_MEDIAN samples, one per bit
+  bool alert;
+};
+
+#define ULTRASONIC(trig, echo, alert, threshold) \
+  { (uint8_t)(trig), (uint8_t)(echo), (uint8_t)(alert), (uint16_t)(threshold), {0}, 0, 0, false }
+#define DIGITAL(pin, alert) { (uint8_t)(pin), (uint8_t)(alert), 0, false }
+
+// Sets up the pins and the echo interrupts, and starts the first slot
+void ranging_begin(UltrasonicChannel *ultrasonic, uint8_t ultrasonicCount,
+                   DigitalChannel *digital, uint8_t digitalCount);
+
+// Moves the measurements along. Returns true when every ultrasonic
+// channel has a new reading since the last true: time to report.
+bool ranging_update();
+
+// Writes the report frame into out, returns its length
+uint8_t ranging_frame(uint8_t *out);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+*	Author:		Kevin McLean
+*	Project:	Project C.A.R. Brain board
+*	Discription:Binary frames between the brain board and the pi. Header
+*				only and free of Arduino calls, so the pi's serial node
+*				(2015/Vision/ROS/car_serial_comms) builds the same encoder
+*				and parser.
+*
+*	Frame, 7 bytes:
+*		0xA5 | id | a low | a high | b low | b high | CRC-8
+*	a and b are int16, little endian. The CRC-8 (polynomial 0x07) covers id,
+*	a and b. A drive command is one frame, where "<-30,1500>" was 10 chars
+*	and "<id,value,checksum>" pairs took two frames of up to 19.
+*/
+
+#ifndef CAR_COMMS_H
+#define CAR_COMMS_H
+
+#include <stdint.h>
+#include <car_crc8.h>
+
+#define CAR_COMMS_SYNC	0xA5
+#define CAR_COMMS_FRAME	7
+
+//ids
+#define CAR_COMMS_DRIVE		0x01	//a steering angle, b speed
+#define CAR_COMMS_STOP		0x02	//a non zero to stop
+#define CAR_COMMS_STATUS	0x03	//a battery voltage, b battery current
+
+struct Car_Comms_Message
+{
+	uint8_t id;
+	int16_t a;
+	int16_t b;
+};
+
+/*
+class Car_Comms
+/brief
+-Zero allocation parser: feed it bytes as they arrive, in any split, and
+it says when a whole frame with a good CRC is in.
+-A bad frame costs only its own bytes: the parser picks up at the next
+sync byte inside it.
+*/
+class Car_Comms
+{
+public:
+	Car_Comms() : count(0), errors(0) {}
+
+	/*
+	function parse
+	/brief
+	-Takes one received byte.
+
+	/return
+	-bool: True if it finished a good frame; it's in message() until the
+	next one.
+	*/
+	bool parse(uint8_t c)
+	{
+		if (count == 0 && c != CAR_COMMS_SYNC)
+			return false;
+		frame[count++] = c;
+		if (count < CAR_COMMS_FRAME)
+			return false;
+
+		if (crc8(&frame[1], CAR_COMMS_FRAME - 2) == frame[CAR_COMMS_FRAME - 1])
+		{
+			count = 0;
+			msg.id = frame[1];
+			msg.a = (int16_t)(frame[2] | (frame[3] << 8));
+			msg.b = (int16_t)(frame[4] | (frame[5] << 8));
+			return true;
+		}
+
+		//bad: start again from the next sync byte in what we have
+		errors++;
+		uint8_t from = 1;
+		while (from < CAR_COMMS_FRAME && frame[from] != CAR_COMMS_SYNC)
+			from++;
+		count = 0;
+		while (from < CAR_COMMS_FRAME)
+			frame[count++] = frame[from++];
+		return false;
+	}
+
+	const Car_Comms_Message &message() const { return msg; }
+
+	//frames thrown away for a bad CRC
+	unsigned int crc_errors() const { return errors; }
+
+	/*
+	function encode
+	/brief
+	-Writes a frame into out, which must hold CAR_COMMS_FRAME bytes.
+
+	/return
+	-uint8_t: bytes written, always CAR_COMMS_FRAME.
+	*/
+	static uint8_t encode(uint8_t *out, uint8_t id, int16_t a, int16_t b)
+	{
+		out[0] = CAR_COMMS_SYNC;
+		out[1] = id;
+		out[2] = (uint8_t)a;
+		out[3] = (uint8_t)((uint16_t)a >> 8);
+		out[4] = (uint8_t)b;
+		out[5] = (uint8_t)((uint16_t)b >> 8);
+		out[6] = crc8(&out[1], CAR_COMMS_FRAME - 2);
+		return CAR_COMMS_FRAME;
+	}
+
+	//CRC-8, polynomial 0x07, see car_crc8.h
+	static uint8_t crc8(const uint8_t *data, uint8_t length)
+	{
+		return car_crc8(0, data, length);
+	}
+
+private:
+	uint8_t frame[CAR_COMMS_FRAME];
+	uint8_t count;
+	unsigned int errors;
+	Car_Comms_Message msg;
+};
+
+#endif
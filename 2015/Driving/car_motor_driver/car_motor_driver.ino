@@ -38,6 +38,8 @@
 
 #include <Wire.h>
 #include <Servo.h>
+#include "scheduler.h"
+#include "car_comms.h"
 
 #ifdef MOTORS
 Servo motor;
@@ -63,8 +65,9 @@ unsigned long new_timer[4] = { 0, 0, 0, 0 };
 unsigned long old_timer[4] = { 0, 0, 0, 0 };
 
 #ifdef USB
-static boolean serial_get_value(uint8_t &id, int16_t &value);
-static boolean serial_send_value(int angle, int speed);
+Car_Comms pi;		//frames from the pi, see car_comms.h
+boolean serial_get_value(int &first, int &second);
+boolean serial_send_value(int angle, int speed);
 #endif
 
 #ifdef I2C
@@ -73,6 +76,25 @@ boolean wire_get_value(int &data, int address);
 
 void pause();
 
+//tasks, highest priority first
+void comms_task();
+void control_task();
+void telemetry_task();
+void report_task();
+
+Task tasks[] =
+{
+	//serial and bluetooth RX, faster than a frame arrives at 115200
+	TASK("comms", comms_task, 1000, 1000),
+	//encoders, speed control and the servos, once per servo frame
+	TASK("control", control_task, 20000, 2000),
+	//battery, speed and distance to the emergency stop app, race mode LED
+	TASK("telemetry", telemetry_task, 200000, 20000),
+	//worst case jitter and run time of each task, over USB
+	TASK("report", report_task, 5000000, 20000),
+};
+#define TASK_COUNT (sizeof(tasks) / sizeof(tasks[0]))
+
 void setup()
 {
 	//Collision avoidance config
@@ -91,6 +113,7 @@ void setup()
 
 #ifdef BLUETOOTH
 	Serial1.begin(9600);			//Start bluetooth communications 
+	Serial1.setTimeout(2);			//parseInt() waits this long for more digits, not a second
 #endif
 
 #ifdef AUTONOMOUS
@@ -136,9 +159,16 @@ void setup()
 	}
 #endif
 	timer = millis();
+	scheduler_start(tasks, TASK_COUNT);
 }
 
 void loop()
+{
+	scheduler_run(tasks, TASK_COUNT);
+}
+
+//commands from the pi and the bluetooth remote
+void comms_task()
 {
 	//set speed and steering angle when in autonomous mode
 #ifdef AUTONOMOUS
@@ -159,14 +189,11 @@ void loop()
 	}
 	else if (race_mode == 2)
 	{
-		if ((millis()%1000)<500)
-			digitalWrite(12,HIGH);
-		else
-			digitalWrite(12,LOW);
 #ifdef USB
 		//put pi communication stuff here
-		serial_get_value(battery_voltage, battery_current);
-		serial_send_value(battery_voltage, battery_current);
+		//echo each command back to the pi as it comes in
+		if (serial_get_value(battery_voltage, battery_current))
+			serial_send_value(battery_voltage, battery_current);
 		//if (base_speed != 0)
 		steering_angle = battery_voltage;
 			base_speed = 2000;
@@ -176,83 +203,90 @@ void loop()
 	}
 #endif
 
+	//Remote control code
+#ifdef REMOTE_CONTROL
+#ifdef BLUETOOTH
+	if (Serial1.available() > 1)
+	{
+		base_speed = (Serial1.parseInt() / 5 - 100);
+		if ((base_speed < -100) || (base_speed>100))
+		{
+			base_speed = 0;
+		}
+		steering_angle = (Serial1.parseInt() / 10 - 90);
+		emergency_stop = false;
+		timer = millis();
+	}
+#endif
+#endif
+
+#ifdef AUTONOMOUS
+	//communicate with the remote emergency stop app
+#ifdef BLUETOOTH
+	if (Serial1.available() > 0)
+	{
+		emergency_stop = Serial1.parseInt();    // test this is still working.
+		timer = millis();
+	}
+#endif
+#endif
+}
+
+//encoders, speed error and the servos
+void control_task()
+{
 	//get data over I2C
 #ifdef I2C
 	//this needs to be fixed????
 	//read real speed and find the speed error
-	real_speed = 0;
 	if (!(emergency_stop||stop||base_speed==0))
 	{
+		int speed = 0;
+		boolean read = true;
 		for (int i = 0; i < 1; i++)
 		{
 			int encoder_distance = 0;
-			new_timer[i] = micros();
-			while (!wire_get_value(encoder_distance, encoders[i]))
+			//no answer: keep the last speed and try again next tick
+			if (!wire_get_value(encoder_distance, encoders[i]))
 			{
-				delay(1);
-				new_timer[i] = micros();
+				read = false;
+				break;
 			}
+			new_timer[i] = micros();
 			//check for rollover
 			if(encoder_distance<(old_encoder_distance[i]%256))
 			{
 				//there was roll over
-				real_speed += (encoder_distance - (old_encoder_distance[i] % 256) + 256)*52500/(new_timer[i]-old_timer[i]);
+				speed += (encoder_distance - (old_encoder_distance[i] % 256) + 256)*52500/(new_timer[i]-old_timer[i]);
 				old_timer[i] = new_timer[i];
 				old_encoder_distance[i]+=encoder_distance-(old_encoder_distance[i]%256)+256;
 			}
 			else
 			{
 				//no rollover
-				real_speed += (encoder_distance - (old_encoder_distance[i] % 256)) *52500/ (new_timer[i] - old_timer[i]);
+				speed += (encoder_distance - (old_encoder_distance[i] % 256)) *52500/ (new_timer[i] - old_timer[i]);
 				old_timer[i] = new_timer[i];
 				old_encoder_distance[i]+=encoder_distance-(old_encoder_distance[i]%256);
 			}
 		}
-		//average values
-		real_speed = real_speed;		//speed in mm/s
-		distance = old_encoder_distance[0];//(old_encoder_distance[0]+old_encoder_distance[1]+old_encoder_distance[2]+old_encoder_distance[3])/4;
-
-		//calculate speed error
-		accumulated_speed_error += base_speed - real_speed;
-		speed_error = constrain(0.9*(base_speed - real_speed) + 0.1*accumulated_speed_error, -1000, 1000);
-	}
-
-	//get data from power board
-	//while (!wire_get_value(battery_voltage, battery_current, power_board)){delay(10);}
-#endif
-
-	//Remote control code
-#ifdef REMOTE_CONTROL
-#ifdef BLUETOOTH
-	if (Serial1.available() > 1)
-	{
-		base_speed = (Serial1.parseInt() / 5 - 100);
-		if ((base_speed < -100) || (base_speed>100))
+		if (read)
 		{
-			base_speed = 0;
+			//average values
+			real_speed = speed;		//speed in mm/s
+			distance = old_encoder_distance[0];//(old_encoder_distance[0]+old_encoder_distance[1]+old_encoder_distance[2]+old_encoder_distance[3])/4;
+
+			//calculate speed error
+			accumulated_speed_error += base_speed - real_speed;
+			speed_error = constrain(0.9*(base_speed - real_speed) + 0.1*accumulated_speed_error, -1000, 1000);
 		}
-		steering_angle = (Serial1.parseInt() / 10 - 90);
-		Serial1.print(battery_voltage);
-		Serial1.print(",");
-		Serial1.print(battery_current);
-		Serial1.print(",");
-		Serial1.print(base_speed);
-		Serial1.print(",");
-		Serial1.println(steering_angle);
-		emergency_stop = false;
-		timer = millis();
 	}
-	if ((millis() - timer) >= 300)
+	else
 	{
-		emergency_stop = true;
+		real_speed = 0;
 	}
-#endif
 
-#ifdef USB
-	//put pi communication stuff here
-	//only for getting the training video
-	serial_send_value(constrain(steering_angle, -30, 40), base_speed);
-#endif
+	//get data from power board
+	//while (!wire_get_value(battery_voltage, battery_current, power_board)){delay(10);}
 #endif
 
 #ifdef AUTONOMOUS
@@ -265,26 +299,14 @@ void loop()
 	{
 		steering_angle -= 10;
 	}*/
+#endif
 
-	//communicate with the remote emergency stop app
+	//stop if the remote or the emergency stop app has gone quiet
 #ifdef BLUETOOTH
-	if (Serial1.available() > 0)
-	{
-		emergency_stop = Serial1.parseInt();    // test this is still working.
-		Serial1.print(battery_voltage);
-		Serial1.print(",");
-		Serial1.print(battery_current);
-		Serial1.print(",");
-		Serial1.print(real_speed);
-		Serial1.print(",");
-		Serial1.println(distance);
-		timer = millis();
-	}
 	if ((millis() - timer) >= 300)
 	{
 		emergency_stop = true;
 	}
-#endif
 #endif
 
 	//emergency_stop=false;
@@ -301,6 +323,66 @@ void loop()
 		steer.write(90 + constrain(steering_angle, -30, 40));
 	}
 #endif
+
+#ifdef REMOTE_CONTROL
+#ifdef USB
+	//put pi communication stuff here
+	//only for getting the training video
+	serial_send_value(constrain(steering_angle, -30, 40), base_speed);
+#endif
+#endif
+}
+
+//status back to the remote or the emergency stop app
+void telemetry_task()
+{
+#ifdef AUTONOMOUS
+	if (race_mode == 2)
+	{
+		if ((millis()%1000)<500)
+			digitalWrite(12,HIGH);
+		else
+			digitalWrite(12,LOW);
+	}
+#endif
+
+#ifdef BLUETOOTH
+	Serial1.print(battery_voltage);
+	Serial1.print(",");
+	Serial1.print(battery_current);
+	Serial1.print(",");
+#ifdef REMOTE_CONTROL
+	Serial1.print(base_speed);
+	Serial1.print(",");
+	Serial1.println(steering_angle);
+#else
+	Serial1.print(real_speed);
+	Serial1.print(",");
+	Serial1.println(distance);
+#endif
+#endif
+}
+
+//worst case start jitter and run time of each task since the last report
+void report_task()
+{
+#ifdef USB
+	//text lines; the pi's frame parser skips anything without a sync byte
+	for (uint8_t i = 0; i < TASK_COUNT; i++)
+	{
+		Serial.print("# ");
+		Serial.print(tasks[i].name);
+		Serial.print(" jitter ");
+		Serial.print(tasks[i].max_jitter);
+		Serial.print("us run ");
+		Serial.print(tasks[i].max_run);
+		Serial.print("us missed ");
+		Serial.print(tasks[i].missed);
+		Serial.print(" skipped ");
+		Serial.println(tasks[i].skipped);
+	}
+#endif
+	scheduler_clear(tasks, TASK_COUNT);
 }
 
 //collision avoidance ISR
@@ -309,90 +391,32 @@ void pause()
 	stop = digitalRead(2);
 }
 
-/*
-class Car_Comms
-/brief
--Sends and receives serial id-value pairs.
--Uses and deals with 16-bit checksums. In this case it's practically sending
-data twice.
--All methods are static. Do not instantiate.
-*/
-//class Car_Comms {
-//public:
-
 #ifdef USB
 /*
 function serial_get_value
 /brief
--Attempts to read an id and value using our comms protocol.
--Reference arguments are only updated if a new package is completed -
-they will be unmodified if a complete, valid entry is not obtained.
+-Runs everything the pi has sent through the frame parser (car_comms.h).
+-Reference arguments are only updated if a drive frame with a good CRC
+came in - they will be unmodified otherwise. If several did, the last wins.
 
 /params
--uint8_t &id: Reference to id variable to read into
--int16_t &value: Reference to value variable to read into
+-int &first: Reference to the steering angle
+-int &second: Reference to the speed
 
 /return
--bool: True if a id-value pair was obtained. False otherwise.
+-bool: True if a drive frame was obtained. False otherwise.
 */
 boolean serial_get_value(int &first, int &second)
 {
-	// Static variables remain between calls
-	int buffer[2] = { 0, 0 };
-	char buf16[4]={'0','0','0','\0'};
-	boolean started = false;
 	boolean success = false;
-	// Read chars until there is no data in the buffer or we find a terminator
-	while (Serial.available() >= 5)
+	while (Serial.available() > 0)
 	{
-		// Check for start of package
-		if (Serial.peek() == '<')
+		if (pi.parse(Serial.read()) && pi.message().id == CAR_COMMS_DRIVE)
 		{
-			Serial.read(); // Eat the byte
-			started = true;
-		}
-		else
-		{
-			// Skip this char, go to next until a packet opener is found.
-			Serial.read(); // Eat byte.
-			continue;
-		}
-
-		//read the first int
-		for (int i = 0; i < 3 && Serial.peek() != ','; i++)
-			buf16[i] = Serial.read();
-		buffer[0] = atoi(buf16);
-
-		//check for parser
-		if (Serial.peek() == ',')
-		{
-			Serial.read(); // Eat the byte
-		}
-		else
-		{
-			started = false; // Throw away this packet
-			continue;
-		}
-
-		//read the second int
-		for (int i = 0; i < 3 && Serial.peek() != '>'; i++)
-			buf16[i] = Serial.read();
-		buffer[1] = atoi(buf16);
-
-		//check for terminator
-		if (Serial.peek() == '>')
-		{
-			Serial.read(); // Eat the byte
-			//pass the variables back to the caller
-			first = buffer[0];
-			second = buffer[1];
+			first = pi.message().a;
+			second = pi.message().b;
 			success = true;
 		}
-		else
-		{
-			started = false; // Throw away this packet
-			continue;
-		}
 	}
 	return success;
 }
@@ -400,23 +424,21 @@ boolean serial_get_value(int &first, int &second)
 /*
 function serial_send_value
 /brief
--Sends steering angle and real speed over serial in our format.
+-Sends steering angle and speed to the pi as a drive frame.
 -Always returns true because I can't think of a failure mechanism.
 
 /params
 -int angle: The steering angle
--int speed: The real speed.
+-int speed: The speed.
 
 /return
 -bool: True if transmission was successful. Always true.
 */
 boolean serial_send_value(int angle, int speed)
 {
-	Serial.print('<');
-	Serial.print(angle);
-	Serial.print(',');
-	Serial.print(speed);
-	Serial.print('>');
+	uint8_t frame[CAR_COMMS_FRAME];
+	Car_Comms::encode(frame, CAR_COMMS_DRIVE, angle, speed);
+	Serial.write(frame, CAR_COMMS_FRAME);
 	return true;
 }
 #endif
@@ -476,4 +498,3 @@ Wire.print('>');
 return !Wire.endTransmission();
 }*/
 #endif
-//};
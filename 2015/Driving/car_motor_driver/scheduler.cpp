@@ -0,0 +1,57 @@
+#include "scheduler.h"
+
+void scheduler_start(Task *tasks, uint8_t count)
+{
+	uint32_t now = micros();
+	for (uint8_t i = 0; i < count; i++)
+	{
+		tasks[i].release = now;
+	}
+	scheduler_clear(tasks, count);
+}
+
+Task *scheduler_run(Task *tasks, uint8_t count)
+{
+	uint32_t start = micros();
+	for (uint8_t i = 0; i < count; i++)
+	{
+		Task *task = &tasks[i];
+		//signed difference so micros() rolling over doesn't matter
+		int32_t late = (int32_t)(start - task->release);
+		if (late < 0)
+			continue;
+
+		task->run();
+		uint32_t end = micros();
+
+		if ((uint32_t)late > task->max_jitter)
+			task->max_jitter = late;
+		if (end - start > task->max_run)
+			task->max_run = end - start;
+		if (end - task->release > task->deadline)
+			task->missed++;
+
+		//next release on the period grid, so the rate doesn't drift, but if
+		//a whole period was lost don't run it again and again to catch up
+		task->release += task->period;
+		if ((int32_t)(end - task->release) >= (int32_t)task->period)
+		{
+			uint32_t behind = (end - task->release) / task->period;
+			task->release += behind * task->period;
+			task->skipped += behind;
+		}
+		return task;
+	}
+	return NULL;
+}
+
+void scheduler_clear(Task *tasks, uint8_t count)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		tasks[i].max_run = 0;
+		tasks[i].max_jitter = 0;
+		tasks[i].missed = 0;
+		tasks[i].skipped = 0;
+	}
+}
@@ -0,0 +1,43 @@
+/*
+*	Author:		Kevin McLean
+*	Project:	Project C.A.R. Brain board
+*	Discription:Cooperative fixed rate task scheduler for car_motor_driver.
+*				Tasks are declared in a table, highest priority first. Each
+*				loop() runs the first task that is due, then returns, so a
+*				task only ever waits for one other task to finish. Tasks
+*				must not block: a task that runs long delays everything
+*				below it, and shows up in the jitter report.
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+typedef struct
+{
+	const char *name;
+	void (*run)(void);
+	uint32_t period;			//us between releases
+	uint32_t deadline;			//us after release it must be done by
+
+	//kept by the scheduler
+	uint32_t release;			//micros() when it is next due
+	uint32_t max_run;			//longest run, us
+	uint32_t max_jitter;		//latest start after release, us
+	unsigned int missed;		//runs that finished past the deadline
+	unsigned int skipped;		//releases dropped because it fell a period behind
+} Task;
+
+#define TASK(name, run, period, deadline) { name, run, period, deadline, 0, 0, 0, 0, 0 }
+
+//releases every task now
+void scheduler_start(Task *tasks, uint8_t count);
+
+//runs the highest priority task that is due, if any; returns it or NULL
+Task *scheduler_run(Task *tasks, uint8_t count);
+
+//clears the measurements, after they have been reported
+void scheduler_clear(Task *tasks, uint8_t count);
+
+#endif
@@ -5,53 +5,86 @@
 #include <p33FJ06GS101A.h>
 #include <xc.h>
 
+#include "Variable_Init.h"
+#include "Quadrature.h"
 #include "Interrupts.h"
 
 
 
 //*********ISRs being used*****************
-void __attribute__((interrupt,no_auto_psv)) _CNInterrupt(void)
+//Timer2 ticks, extended to 32 bits by its interrupt. T2 is above every
+//caller's priority, so a wrap is either counted already or still pending.
+uint32_t TimerTicks(void)
 {
-    if (edgeDir == 1)    //if on rising edge
-    {
-        LATBbits.LATB2 = 1; //turn Red LED on
-        countNumber++;
-        if (countNumber == countTotalNumber)
-        {
-            pulseCountDist++;
-            countNumber = 0; 
-        }
-        edgeDir = 0;
-    }
+    unsigned int high, low;
 
-    else
+    do
+    {
+        high = timerHigh;
+        low = TMR2;
+    } while (high != timerHigh);
+    if (IFS0bits.T2IF && low < 0x8000)
     {
-       LATBbits.LATB2 = 0; //turn Red LED off
-       //only count on high pulseCountDist++;
-       edgeDir = 1;
+        high++;     //wrapped, interrupt not taken yet
     }
+    return ((uint32_t) high << 16) | low;
+}
+
+void __attribute__((interrupt,no_auto_psv)) _T2Interrupt(void)
+{
+    timerHigh++;
+    IFS0bits.T2IF = 0;
+}
+
+//either encoder channel changed
+void __attribute__((interrupt,no_auto_psv)) _CNInterrupt(void)
+{
+    uint32_t ticks;
+    unsigned int a, b;
 
-    IFS1bits.CNIF = 0; // Clear CN interrupt
+    //Clear first, so a change after the pins are read interrupts again
+    //instead of being lost until the next one
+    IFS1bits.CNIF = 0;
+    ticks = TimerTicks();
+    a = ENCODER_A;
+    b = ENCODER_B;
+
+    QuadEdge(QUAD_AB(a, b), ticks);
+    LATBbits.LATB2 = a; //Red LED follows channel A
 }
 
+//The snapshot is taken when the master addresses us to read, then sent a
+//byte for each byte the master acks. Writes are ignored.
 void __attribute__((interrupt,no_auto_psv)) _SI2C1Interrupt(void)
+{
+    unsigned char dummy;
 
-{   if(justSent)
+    if (I2C1STATbits.R_W)
     {
-        IFS1bits.SI2C1IF = 0;
-        justSent = 0;
+        if (!I2C1STATbits.D_A)
+        {
+            dummy = I2C1RCV;    //the address
+            QuadGetSnapshot(&snapshot, TimerTicks());
+            QuadPackSnapshot(&snapshot, i2cFrame);
+            i2cIndex = 0;
+        }
+        else if (I2C1STATbits.ACKSTAT)
+        {
+            IFS1bits.SI2C1IF = 0;   //master nacked, read is over
+            return;
+        }
+        I2C1TRN = i2cIndex < QUAD_FRAME_SIZE ? i2cFrame[i2cIndex++] : 0xFF;
+        I2C1CONbits.SCLREL = 1;
     }
-     
     else
     {
-            
-      I2C1TRN = pulseCountDist;  //sends out current data
-      
-      justSent = 1;
-      IFS1bits.SI2C1IF = 0;
+        dummy = I2C1RCV;
+        I2C1STATbits.I2COV = 0;
     }
+    (void) dummy;
 
- }
+    IFS1bits.SI2C1IF = 0;
+}
 
 
 //************Empty ISRs for the fix***************
@@ -91,11 +124,6 @@ void __attribute__((interrupt,no_auto_psv)) _T1Interrupt(void)
     IFS0bits.T1IF = 0;
 }
 
-void __attribute__((interrupt,no_auto_psv)) _T2Interrupt(void)
-{
-    IFS0bits.T2IF = 0;
-}
-
 void __attribute__((interrupt,no_auto_psv)) _SPI1ErrInterrupt (void)
 {
     IFS0bits.SPI1EIF = 0;
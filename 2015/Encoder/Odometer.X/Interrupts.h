@@ -12,6 +12,7 @@
 
 //function definitions for interrupts being used
 void __attribute__((interrupt,no_auto_psv)) _CNInterrupt(void);
+void __attribute__((interrupt,no_auto_psv)) _T2Interrupt(void);
 
 //function definititons for inturrupts for the fix
 void __attribute__((interrupt,no_auto_psv)) _OscillatorFail(void);
@@ -22,7 +23,6 @@ void __attribute__((interrupt,no_auto_psv)) _MathError(void);
 void __attribute__((interrupt,no_auto_psv)) _INT0Interrupt(void);
 void __attribute__((interrupt,no_auto_psv)) _OC1Interrupt(void);
 void __attribute__((interrupt,no_auto_psv)) _T1Interrupt(void);
-void __attribute__((interrupt,no_auto_psv)) _T2Interrupt(void);
 
 void __attribute__((interrupt,no_auto_psv)) _SPI1ErrInterrupt(void);
 void __attribute__((interrupt,no_auto_psv)) _SPI1Interrupt(void);
@@ -45,12 +45,11 @@ void __attribute__((interrupt,no_auto_psv)) _ADCP3Interrupt(void);
 //void __attribute__((interrupt,no_auto_psv)) _ADCP6Interrupt(void);
 
 //variables used in interrupts
-volatile char edgeDir = 1;   //keeps track of edge direction (1 = rising, 0 = low)
-volatile int pulseCountDist = 0;    //hold the number of pulses
+volatile unsigned int timerHigh = 0;    //Timer2 wraps
 
-volatile char justSent = 0;
-volatile char countNumber = 0;
-volatile char countTotalNumber = 10; 
+QuadSnapshot snapshot;                  //being sent over I2C
+unsigned char i2cFrame[QUAD_FRAME_SIZE];
+unsigned int i2cIndex = 0;
 
 
 #endif	/* INTERRUPTS_H */
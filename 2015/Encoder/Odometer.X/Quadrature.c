@@ -0,0 +1,134 @@
+//odometer board
+
+/*
+ * File:   Quadrature.c
+ * Author: Kevin
+ *
+ * See Quadrature.h
+ */
+
+#include <xc.h>
+
+#include "Quadrature.h"
+
+#define QUAD_ILLEGAL 2
+
+//indexed by old state << 2 | new state: +1 forward, -1 back, 0 no change,
+//QUAD_ILLEGAL both pins changed (an edge was missed)
+static const signed char quadTable[16] =
+{
+     0, -1,  1,  QUAD_ILLEGAL,
+     1,  0,  QUAD_ILLEGAL, -1,
+    -1,  QUAD_ILLEGAL,  0,  1,
+     QUAD_ILLEGAL,  1, -1,  0
+};
+
+//written by the change notification interrupt
+static unsigned int state;
+static int32_t count;
+static signed char lastDir;
+//ring of the last edges, one more than a period needs
+#define QUAD_EDGE_TIMES (QUAD_PERIOD_EDGES + 1)
+static uint32_t edgeTimes[QUAD_EDGE_TIMES];
+static unsigned int edgeIndex;
+static unsigned int sameDirEdges;               //edges in a row the same way
+static unsigned int errors;
+
+void QuadInit(unsigned int ab)
+{
+    unsigned int i;
+
+    IEC1bits.CNIE = 0;
+    state = ab & 3;
+    count = 0;
+    lastDir = 0;
+    for (i = 0; i < QUAD_EDGE_TIMES; i++)
+    {
+        edgeTimes[i] = 0;
+    }
+    edgeIndex = 0;
+    sameDirEdges = 0;
+    errors = 0;
+    IEC1bits.CNIE = 1;
+}
+
+void QuadEdge(unsigned int ab, uint32_t ticks)
+{
+    signed char step;
+
+    ab &= 3;
+    step = quadTable[(state << 2) | ab];
+    state = ab;
+
+    if (step == 0)
+    {
+        return;     //changed and back before the interrupt, or a glitch
+    }
+    if (step == QUAD_ILLEGAL)
+    {
+        //two edges, most likely still going the same way
+        if (errors < 255)
+        {
+            errors++;
+        }
+        count += 2 * lastDir;
+        sameDirEdges = 0;   //the period would be off
+    }
+    else
+    {
+        count += step;
+        if (step == lastDir)
+        {
+            //only compared against QUAD_EDGE_TIMES, stop there so it
+            //can't wrap to 0 while driving steadily
+            if (sameDirEdges < QUAD_EDGE_TIMES)
+            {
+                sameDirEdges++;
+            }
+        }
+        else
+        {
+            sameDirEdges = 1;
+            lastDir = step;
+        }
+    }
+
+    edgeIndex = (edgeIndex + 1) % QUAD_EDGE_TIMES;
+    edgeTimes[edgeIndex] = ticks;
+}
+
+void QuadGetSnapshot(QuadSnapshot* snapshot, uint32_t now)
+{
+    uint32_t oldest;
+    unsigned int valid;
+
+    IEC1bits.CNIE = 0;
+    snapshot->count = count;
+    snapshot->lastEdge = edgeTimes[edgeIndex];
+    oldest = edgeTimes[(edgeIndex + 1) % QUAD_EDGE_TIMES];
+    //the oldest edge has to be one of the run too
+    valid = sameDirEdges >= QUAD_EDGE_TIMES;
+    snapshot->errors = errors;
+    IEC1bits.CNIE = 1;
+
+    snapshot->period = valid ? snapshot->lastEdge - oldest : 0;
+    snapshot->now = now;
+}
+
+static unsigned char* put32(unsigned char* frame, uint32_t value)
+{
+    *frame++ = value & 0xFF;
+    *frame++ = (value >> 8) & 0xFF;
+    *frame++ = (value >> 16) & 0xFF;
+    *frame++ = (value >> 24) & 0xFF;
+    return frame;
+}
+
+void QuadPackSnapshot(const QuadSnapshot* snapshot, unsigned char* frame)
+{
+    frame = put32(frame, (uint32_t) snapshot->count);
+    frame = put32(frame, snapshot->lastEdge);
+    frame = put32(frame, snapshot->period);
+    frame = put32(frame, snapshot->now);
+    *frame = snapshot->errors;
+}
@@ -0,0 +1,62 @@
+//odometer board
+
+/*
+ * File:   Quadrature.h
+ * Author: Kevin
+ *
+ * Quadrature decoding of the encoder's A and B channels. The change
+ * notification interrupt passes the state of both pins and a timestamp to
+ * QuadEdge() on every change of either one, so all four edges of a cycle
+ * count and the direction comes from the order they come in. The count is
+ * 32 bits and signed, forward (A leading B) is positive.
+ *
+ * The I2C slave sends a QuadSnapshot taken at the start of each read, so
+ * the master gets a count, the time of the last edge and the period that
+ * all go together:
+ *   count      int32, edges
+ *   lastEdge   uint32, timer ticks of the last edge
+ *   period     uint32, ticks over the last QUAD_PERIOD_EDGES edges, 0 if
+ *              they weren't all the same way
+ *   now        uint32, ticks when the snapshot was taken
+ *   errors     uint8, missed edges so far, stops at 255
+ * little endian, QUAD_FRAME_SIZE bytes. Speed is QUAD_PERIOD_EDGES edges
+ * per period, or less if now - lastEdge is already longer than that.
+ */
+
+#ifndef QUADRATURE_H
+#define	QUADRATURE_H
+
+#include <stdint.h>
+
+//Timer2 at Fcy / 8, FRC 7.37MHz with no PLL
+#define QUAD_TICK_HZ        460625UL
+
+//one full cycle, so duty and phase errors between the channels cancel
+#define QUAD_PERIOD_EDGES   4
+
+#define QUAD_FRAME_SIZE     17
+
+//ab: A in bit 1, B in bit 0
+#define QUAD_AB(a, b)       ((((a) & 1) << 1) | ((b) & 1))
+
+typedef struct
+{
+    int32_t count;
+    uint32_t lastEdge;
+    uint32_t period;
+    uint32_t now;
+    unsigned int errors;
+} QuadSnapshot;
+
+//starting state of the pins, the count starts at 0
+void QuadInit(unsigned int ab);
+
+//change notification interrupt
+void QuadEdge(unsigned int ab, uint32_t ticks);
+
+//copies the state with the change notification interrupt off
+void QuadGetSnapshot(QuadSnapshot* snapshot, uint32_t now);
+
+void QuadPackSnapshot(const QuadSnapshot* snapshot, unsigned char* frame);
+
+#endif	/* QUADRATURE_H */
@@ -8,9 +8,14 @@
 #ifndef VARIABLE_INIT_H
 #define	VARIABLE_INIT_H
 
-//used in the interrupt declared in Inteurrupt.h
-extern volatile char edgeDir ;  //keeps track of edge direction (1 = rising, 0 = low)
-extern volatile int pulseCountDist  ;  //hold the number of pulses
+#include <stdint.h>
+
+//encoder channels: A on pin 5 (RB0, CN0), B on RA1 (CN3)
+#define ENCODER_A PORTBbits.RB0
+#define ENCODER_B PORTAbits.RA1
+
+//Timer2 ticks since reset, QUAD_TICK_HZ; defined in Interrupts.c
+uint32_t TimerTicks(void);
 
 #endif
 
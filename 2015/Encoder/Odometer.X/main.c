@@ -17,6 +17,7 @@
 
 #include <xc.h>
 #include "Variable_Init.h"
+#include "Quadrature.h"
 
 // FICD
 #pragma config ICS = PGD2               // ICD Communication Channel Select bits (Communicate on PGEC1 and PGED1)
@@ -53,19 +54,35 @@ int main()
     I2C1CONbits.GCEN = 0;       //disables general calls
     I2C1CONbits.DISSLW = 1;     //disables slew rate since not on 400kHz
 
-    IPC4bits.SI2C1IP = 7;
+    IPC4bits.SI2C1IP = 3;       //below CN, which the snapshot holds off
     IFS1bits.SI2C1IF = 0;       //resets i2c slave interrupt
     IEC1bits.SI2C1IE = 1;       //enables slave interrupt
     I2C1CONbits.I2CEN = 1;      //enables i2c module
     I2C1TRN = 0x00;        //empty the transmit register (resets to 0xFF)
 
    
-    //Sets up the change notification interrupt
+    //Timer2 free running for the edge timestamps, Fcy / 8
+    T2CONbits.TON = 0;
+    T2CONbits.TCS = 0;
+    T2CONbits.TGATE = 0;
+    T2CONbits.TCKPS = 0b01;
+    TMR2 = 0x00;
+    PR2 = 0xFFFF;
+    IPC1bits.T2IP = 5;      //above CN and I2C, see TimerTicks()
+    IFS0bits.T2IF = 0;
+    IEC0bits.T2IE = 1;
+    T2CONbits.TON = 1;
+
+    //Sets up the change notification interrupt, on both channels
     ADPCFGbits.PCFG3 = 1;   //turns off ADC AN3 shared with CN0 pin (automatically turns on)
-    TRISBbits.TRISB0 = 1;   //sets pin 5 CN0 to input
+    TRISBbits.TRISB0 = 1;   //sets pin 5 CN0 to input, channel A
     CNEN1bits.CN0IE = 1;    //Enable CN0 pin for interrupt detection
     CNPU1bits.CN0PUE = 0;  //disables internal pullup on input change pin 0
-    
+    ADPCFGbits.PCFG1 = 1;   //AN1 shared with CN3, channel B
+    TRISAbits.TRISA1 = 1;
+    CNEN1bits.CN3IE = 1;
+    CNPU1bits.CN3PUE = 0;
+
 
     //sets up Red LED
     TRISBbits.TRISB1 = 0; //sets it as output
@@ -84,7 +101,7 @@ int main()
     //interrupt setup
     IPC4bits.CNIP = 4; //set CN Interrupt priority
     IFS1bits.CNIF = 0; // Reset CN interrupt
-    IEC1bits.CNIE = 1; // Enable CN interrupts
+    QuadInit(QUAD_AB(ENCODER_A, ENCODER_B)); //enables CN interrupts
 
     while (1)
     {}
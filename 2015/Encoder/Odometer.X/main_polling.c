@@ -42,6 +42,11 @@
 
 
 
+//polling version only, the interrupt build counts in Quadrature.c
+static char edgeDir;            //keeps track of edge direction (1 = rising, 0 = low)
+static int pulseCountDist;      //hold the number of pulses
+static unsigned int speedFreq;  //Timer1 counts between rising edges
+
 /*
  * 
  */
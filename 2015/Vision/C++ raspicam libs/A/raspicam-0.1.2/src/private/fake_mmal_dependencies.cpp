@@ -386,6 +386,13 @@ MMAL_POOL_T *mmal_port_pool_create(MMAL_PORT_T *port,
  * @param header buffer header to release
  */
 void mmal_buffer_header_release(MMAL_BUFFER_HEADER_T *header){}
+/** Acquire a buffer header.
+ * Acquiring a buffer header increases a reference counter on it and makes sure that the
+ * buffer header won't be recycled until all the references to it are gone.
+ *
+ * @param header buffer header to acquire
+ */
+void mmal_buffer_header_acquire(MMAL_BUFFER_HEADER_T *header){}
 /** Get the number of MMAL_BUFFER_HEADER_T currently in a queue.
  *
  * @param queue  Pointer to a queue
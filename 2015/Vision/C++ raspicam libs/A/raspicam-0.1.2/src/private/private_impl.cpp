@@ -47,7 +47,7 @@ namespace raspicam {
 #define MMAL_CAMERA_VIDEO_PORT 1
 #define MMAL_CAMERA_CAPTURE_PORT 2
 #define VIDEO_FRAME_RATE_DEN 1
-#define VIDEO_OUTPUT_BUFFERS_NUM 3
+#define VIDEO_OUTPUT_BUFFERS_NUM 4 //3 for the camera, and the last grabbed frame
 
 
         Private_Impl::Private_Impl() {
@@ -105,6 +105,7 @@ namespace raspicam {
             commitParameters();
             camera_video_port   = State.camera_component->output[MMAL_CAMERA_VIDEO_PORT];
             callback_data.pstate = &State;
+            callback_data.pool=std::make_shared<FramePool> ( State.camera_component,State.video_pool );
             // assign data to use for callback
             camera_video_port->userdata = ( struct MMAL_PORT_USERDATA_T * ) &callback_data;
 
@@ -144,6 +145,7 @@ namespace raspicam {
 
         void Private_Impl::release() {
             if ( !_isOpened ) return;
+            callback_data._frame.release();
 
             // Disable camera_video_port
             if ( camera_video_port && camera_video_port->is_enabled ) {
@@ -171,23 +173,27 @@ namespace raspicam {
             return true;
         }
         /**
+        *The callback only sets _frame while grabbing, so it is safe to copy here
+         */
+        bool Private_Impl::grab ( RaspiCamFrame &frame ) {
+            if ( !grab() ) return false;
+            frame=callback_data._frame;
+            return true;
+        }
+        /**
         *
          */
         void Private_Impl::retrieve ( unsigned char *data,RASPICAM_FORMAT type ) {
-            if ( callback_data._buffData.size==0 ) return;
+            if ( callback_data._frame.empty() ) return;
             if ( type!=RASPICAM_FORMAT_IGNORE ) {
                 cerr<<__FILE__<<":"<<__LINE__<<" :Private_Impl::retrieve type is not RASPICAM_FORMAT_IGNORE as it should be"<<endl;
             }
-            if ( State.captureFtm==RASPICAM_FORMAT_BGR ) {//need to swap channels
-                convertBGR2RGB ( callback_data._buffData.data,data,getImageTypeSize ( State.captureFtm ) );
-            } else
-
-                memcpy ( data,callback_data._buffData.data,getImageTypeSize ( State.captureFtm ) );
+            memcpy ( data,callback_data._frame.getData(),getImageTypeSize ( State.captureFtm ) );
         }
 
 
         unsigned char *Private_Impl::getImageBufferData() const{
-            return callback_data._buffData.data;
+            return callback_data._frame.getData();
         }
 
         size_t Private_Impl::getImageBufferSize() const{
@@ -226,12 +232,17 @@ namespace raspicam {
          *
          */
         void Private_Impl::destroy_camera_component ( RASPIVID_STATE *state ) {
-            if ( state->video_pool )
-                mmal_port_pool_destroy ( state->camera_component->output[MMAL_CAMERA_VIDEO_PORT], state->video_pool );
-            if ( state->camera_component ) {
-                mmal_component_destroy ( state->camera_component );
-                state->camera_component = NULL;
-            }
+            //frames still held keep the component and pool until the last of them goes
+            callback_data.pool.reset();
+            state->video_pool = NULL;
+            state->camera_component = NULL;
+        }
+
+        Private_Impl::FramePool::~FramePool() {
+            if ( pool )
+                mmal_port_pool_destroy ( camera->output[MMAL_CAMERA_VIDEO_PORT], pool );
+            if ( camera )
+                mmal_component_destroy ( camera );
         }
         MMAL_COMPONENT_T *Private_Impl::create_camera_component ( RASPIVID_STATE *state ) {
             MMAL_COMPONENT_T *camera = 0;
@@ -301,16 +312,13 @@ namespace raspicam {
                 return 0;
             }
 
-            // Ensure there are enough buffers to avoid dropping frames
-            if ( video_port->buffer_num < VIDEO_OUTPUT_BUFFERS_NUM )
-                video_port->buffer_num = VIDEO_OUTPUT_BUFFERS_NUM;
-
-
-
             //PR : create pool of message on video port
             MMAL_POOL_T *pool;
             video_port->buffer_size = video_port->buffer_size_recommended;
             video_port->buffer_num = video_port->buffer_num_recommended;
+            // Ensure there are enough buffers to avoid dropping frames
+            if ( video_port->buffer_num < VIDEO_OUTPUT_BUFFERS_NUM )
+                video_port->buffer_num = VIDEO_OUTPUT_BUFFERS_NUM;
             pool = mmal_port_pool_create ( video_port, video_port->buffer_num, video_port->buffer_size );
             if ( !pool ) {
                 cerr<< ( "Failed to create buffer header pool for video output port" );
@@ -468,7 +476,6 @@ namespace raspicam {
 
 
         void Private_Impl::video_buffer_callback ( MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer ) {
-            MMAL_BUFFER_HEADER_T *new_buffer;
             PORT_USERDATA *pData = ( PORT_USERDATA * ) port->userdata;
 
             bool hasGrabbed=false;
@@ -476,30 +483,18 @@ namespace raspicam {
              std::unique_lock<std::mutex> lck ( pData->_mutex );
             if ( pData ) {
                 if ( pData->wantToGrab &&  buffer->length ) {
-                    mmal_buffer_header_mem_lock ( buffer );
-                    pData->_buffData.resize ( buffer->length );
-                    memcpy ( pData->_buffData.data,buffer->data,buffer->length );
+                    //no copy, the frame holds on to the buffer (and lets go of the last one)
+                    pData->_frame=leaseBuffer ( pData,buffer );
                     pData->wantToGrab =false;
                     hasGrabbed=true;
-                    mmal_buffer_header_mem_unlock ( buffer );
                 }
             }
             //pData->_mutex.unlock();
            // if ( hasGrabbed ) pData->Thcond.BroadCast(); //wake up waiting client
-            // release buffer back to the pool
+            // release buffer back to the pool, unless a frame holds it
             mmal_buffer_header_release ( buffer );
             // and send one back to the port (if still open)
-            if ( port->is_enabled ) {
-                MMAL_STATUS_T status;
-
-                new_buffer = mmal_queue_get ( pData->pstate->video_pool->queue );
-
-                if ( new_buffer )
-                    status = mmal_port_send_buffer ( port, new_buffer );
-
-                if ( !new_buffer || status != MMAL_SUCCESS )
-                    printf ( "Unable to return a buffer to the encoder port" );
-            }
+            sendFreeBuffer ( port,pData->pstate->video_pool );
 
             if ( pData->pstate->shutterSpeed!=0 )
                 mmal_port_parameter_set_uint32 ( pData->pstate->camera_component->control, MMAL_PARAMETER_SHUTTER_SPEED, pData->pstate->shutterSpeed ) ;
@@ -509,6 +504,38 @@ namespace raspicam {
 
 
 
+        /**
+         * Wraps a buffer from the video port as a frame. The frame takes a reference on the
+         * buffer header, so releasing it from the callback does not put it back in the pool;
+         * that happens when the last copy of the frame goes, which also passes a free buffer
+         * on to the port in case it ran out while frames were held. The frame holds the
+         * FramePool, not pData, so it can outlive the camera.
+         */
+        RaspiCamFrame Private_Impl::leaseBuffer ( PORT_USERDATA *pData, MMAL_BUFFER_HEADER_T *buffer ) {
+            RaspiCamFrame frame;
+            std::shared_ptr<FramePool> pool=pData->pool;
+            mmal_buffer_header_acquire ( buffer );
+            mmal_buffer_header_mem_lock ( buffer );
+            frame._buffer=std::shared_ptr<void> ( buffer,[pool] ( MMAL_BUFFER_HEADER_T *header ) {
+                mmal_buffer_header_mem_unlock ( header );
+                mmal_buffer_header_release ( header );
+                //a disabled port (after release()) takes no buffers
+                sendFreeBuffer ( pool->camera->output[MMAL_CAMERA_VIDEO_PORT],pool->pool );
+            } );
+            frame._data=buffer->data+buffer->offset;
+            frame._size=buffer->length;
+            return frame;
+        }
+
+        void Private_Impl::sendFreeBuffer ( MMAL_PORT_T *port, MMAL_POOL_T *pool ) {
+            if ( !port->is_enabled ) return;
+            MMAL_BUFFER_HEADER_T *new_buffer = mmal_queue_get ( pool->queue );
+            //none free: all with the port or held by frames
+            if ( !new_buffer ) return;
+            if ( mmal_port_send_buffer ( port, new_buffer ) != MMAL_SUCCESS )
+                printf ( "Unable to return a buffer to the encoder port" );
+        }
+
         void Private_Impl::setWidth ( unsigned int width ) {
             State.width = width;
         }
@@ -751,10 +778,11 @@ namespace raspicam {
 
         int Private_Impl::convertFormat ( RASPICAM_FORMAT fmt ) {
             switch ( fmt ) {
+            //the camera's 24 bit encodings come out in the opposite byte order to their names
             case RASPICAM_FORMAT_RGB:
                 return MMAL_ENCODING_BGR24;
             case RASPICAM_FORMAT_BGR:
-                return MMAL_ENCODING_BGR24;
+                return MMAL_ENCODING_RGB24;
             case RASPICAM_FORMAT_GRAY:
                 return MMAL_ENCODING_I420;
             case RASPICAM_FORMAT_YUV420:
@@ -792,17 +820,6 @@ namespace raspicam {
             return serial;
         }
 
-        void Private_Impl::convertBGR2RGB ( unsigned char *  in_bgr,unsigned char *  out_rgb,int size ) {
-            unsigned char *end=in_bgr+size;
-            unsigned char *in_ptr=in_bgr;
-            while ( in_ptr<end ) {
-                swap ( in_ptr[2],in_ptr[0] );
-                in_ptr+=3;
-            }
-            mempcpy ( out_rgb,in_bgr,size );
-
-
-        }
         void Private_Impl::commitAWB_RB() {
            MMAL_PARAMETER_AWB_GAINS_T param = {{MMAL_PARAMETER_CUSTOM_AWB_GAINS,sizeof(param)}, {0,0}, {0,0}};
            param.r_gain.num = (unsigned int)(State.awbg_red * 65536);
@@ -39,9 +39,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _Private_RaspiCam_IMPL_H
 #include "mmal/mmal.h"
 //#include "mmal_connection.h"
+#include <memory>
 #include <mutex>
 #include <string>
 #include "raspicamtypes.h"
+#include "raspicamframe.h"
 #include "private_types.h" 
 #include "threadcondition.h"
 namespace raspicam {
@@ -52,6 +54,20 @@ namespace raspicam {
          */
         class Private_Impl
         {
+            /** The camera component and its video pool. The camera and every frame leased
+            * from the pool share it, so a frame that outlives release() or the camera still
+            * has a pool to go back to; whichever goes last destroys both.
+            */
+            struct FramePool
+            {
+                FramePool ( MMAL_COMPONENT_T *camera,MMAL_POOL_T *pool ) {
+                    this->camera=camera;
+                    this->pool=pool;
+                }
+                ~FramePool();
+                MMAL_COMPONENT_T *camera;
+                MMAL_POOL_T *pool;
+            };
             /** Struct used to pass information in encoder port userdata to callback
             */
             struct PORT_USERDATA
@@ -76,7 +92,8 @@ namespace raspicam {
                  std::mutex _mutex;
                 ThreadCondition Thcond;
                 bool wantToGrab;
-                membuf<unsigned char> _buffData;
+                RaspiCamFrame _frame;//last grabbed, in its MMAL buffer
+                std::shared_ptr<FramePool> pool;//set while opened
             };
 
             public:
@@ -105,6 +122,9 @@ namespace raspicam {
             /**Grabs the next frame and keeps it in internal buffer. Blocks until next frame arrives
             */
             bool grab();
+            /**Grabs the next frame and returns it in the camera's buffer, see RaspiCamFrame
+            */
+            bool grab ( RaspiCamFrame &frame );
             /**Retrieves the buffer previously grabbed.
             * NOTE: Change in version 0.0.5. Format is stablished in setFormat function
             * So type param is ignored. Do not use this parameter.
@@ -230,6 +250,8 @@ namespace raspicam {
 
             private:
             static void video_buffer_callback ( MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer );
+            static RaspiCamFrame leaseBuffer ( PORT_USERDATA *pData, MMAL_BUFFER_HEADER_T *buffer );
+            static void sendFreeBuffer ( MMAL_PORT_T *port, MMAL_POOL_T *pool );
             void setDefaultStateParams();
             MMAL_COMPONENT_T *create_camera_component ( RASPIVID_STATE *state );
             void destroy_camera_component ( RASPIVID_STATE *state );
@@ -260,8 +282,6 @@ namespace raspicam {
             int convertFormat ( RASPICAM_FORMAT fmt ) ;
 
 
-            //Color conversion
-	    void convertBGR2RGB(unsigned char *  in_bgr,unsigned char *  out_rgb,int size);
             float VIDEO_FRAME_RATE_NUM;
             RASPIVID_STATE State;
             MMAL_STATUS_T status;
@@ -59,6 +59,9 @@ namespace raspicam {
     bool RaspiCam::grab() {
         return _impl->grab();
     }
+    bool RaspiCam::grab ( RaspiCamFrame &frame ) {
+        return _impl->grab ( frame );
+    }
 
     void RaspiCam::retrieve ( unsigned char *data,RASPICAM_FORMAT type ) {
         _impl->retrieve ( data,type );
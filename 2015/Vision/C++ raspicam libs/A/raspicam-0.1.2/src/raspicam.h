@@ -40,6 +40,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <cstdio>
 #include <string>
 #include "raspicamtypes.h"
+#include "raspicamframe.h"
 namespace raspicam {
 
     namespace _private{
@@ -69,6 +70,11 @@ namespace raspicam {
         /**Grabs the next frame and keeps it in internal buffer. Blocks until next frame arrives
         */
         bool grab();
+        /**Grabs the next frame and hands it out in the camera's own buffer, with no copy.
+         * The frame is also what retrieve() and getImageBufferData() use until the next grab.
+         * See RaspiCamFrame for how long the buffer is held.
+         */
+        bool grab ( RaspiCamFrame &frame );
         /**Retrieves the buffer previously grabbed.
          * You can decide how image is given by setting type. The input buffer provided must have the appropriate
          * size accordingly. You can use getImageTypeSize() to determine the size
@@ -82,6 +82,18 @@ namespace raspicam {
         _impl->retrieve ( image.ptr<uchar> ( 0 ));
     }
 
+    bool RaspiCam_Cv::grab ( RaspiCamFrame &frame ) {
+        return _impl->grab ( frame );
+    }
+
+    void RaspiCam_Cv::retrieve ( const RaspiCamFrame &frame, cv::Mat& image ) {
+        if ( frame.empty() ) {
+            image.release();
+            return;
+        }
+        image=cv::Mat ( _impl->getHeight(),_impl->getWidth(),imgFormat,frame.getData() );
+    }
+
     /**Returns the specified VideoCapture property
      */
 
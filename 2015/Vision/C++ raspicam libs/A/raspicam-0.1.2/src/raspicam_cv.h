@@ -39,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define RaspiCam_CV_H
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
+#include "raspicamframe.h"
 namespace raspicam {
 
     namespace _private{
@@ -77,6 +78,17 @@ namespace raspicam {
          */
         void retrieve ( cv::Mat& image );
 
+        /**
+         * Grabs the next frame and hands it out in the camera's own buffer, see RaspiCamFrame.
+         */
+        bool grab ( RaspiCamFrame &frame );
+
+        /**
+         *Wraps a frame from grab(RaspiCamFrame&) as a cv::Mat, without copying. The image
+         *points into the frame's buffer, so it is only good while the frame is held.
+         */
+        void retrieve ( const RaspiCamFrame &frame, cv::Mat& image );
+
         /**Returns the specified VideoCapture property
          */
 
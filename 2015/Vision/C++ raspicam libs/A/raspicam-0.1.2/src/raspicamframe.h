@@ -0,0 +1,80 @@
+/**********************************************************
+ Software developed by AVA ( Ava Group of the University of Cordoba, ava  at uco dot es)
+ Main author Rafael Munoz Salinas (rmsalinas at uco dot es)
+ This software is released under BSD license as expressed below
+-------------------------------------------------------------------
+Copyright (c) 2013, AVA ( Ava Group University of Cordoba, ava  at uco dot es)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+3. All advertising materials mentioning features or use of this software
+   must display the following acknowledgement:
+
+   This product includes software developed by the Ava group of the University of Cordoba.
+
+4. Neither the name of the University nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY AVA ''AS IS'' AND ANY
+EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL AVA BE LIABLE FOR ANY
+DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+****************************************************************/
+
+#ifndef _RASPICAM_FRAME_H
+#define _RASPICAM_FRAME_H
+#include <cstddef>
+#include <memory>
+namespace raspicam {
+
+    namespace _private{
+        class Private_Impl;
+    };
+    /**A grabbed frame, left in the camera's own buffer rather than copied out.
+     * Copies of a frame share the buffer, which goes back to the camera when the
+     * last of them is released or destroyed. The camera only has a few buffers:
+     * while frames are held it has that many fewer to fill, and once all are
+     * held it stops until one comes back. A frame may outlive the camera: the
+     * buffer pool is only destroyed once the camera and all its frames are gone.
+     */
+    class RaspiCamFrame
+    {
+        public:
+        RaspiCamFrame() {
+            _data=0;
+            _size=0;
+        }
+        /**Image data, in the camera's format (see RaspiCam::getFormat)
+         */
+        unsigned char *getData() const {return _data;}
+        size_t getSize() const {return _size;}
+        bool empty() const {return _data==0;}
+        /**Gives up this reference to the buffer
+         */
+        void release() {
+            _buffer.reset();
+            _data=0;
+            _size=0;
+        }
+        private:
+        friend class _private::Private_Impl;
+        std::shared_ptr<void> _buffer;//the MMAL buffer header, released by its deleter
+        unsigned char *_data;
+        size_t _size;
+    };
+};
+#endif
@@ -45,6 +45,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 using namespace std;
 bool doTestSpeedOnly=false;
+bool doNoCopy=false;
 //parse command line
 //returns the index of a command line param in argv. If not found, return -1
 int findParam ( string param,int argc,char **argv ) {
@@ -75,6 +76,8 @@ void processCommandLine ( int argc,char **argv,raspicam::RaspiCam_Cv &Camera ) {
         Camera.set ( CV_CAP_PROP_FORMAT, CV_8UC1 );
     if ( findParam ( "-test_speed",argc,argv ) !=-1 )
         doTestSpeedOnly=true;
+    if ( findParam ( "-no_copy",argc,argv ) !=-1 )
+        doNoCopy=true;
     if ( findParam ( "-ss",argc,argv ) !=-1 )
         Camera.set ( CV_CAP_PROP_EXPOSURE, getParamVal ( "-ss",argc,argv )  );
     if ( findParam ( "-wb_r",argc,argv ) !=-1 )
@@ -95,6 +98,7 @@ void showUsage() {
     cout<<"Usage: "<<endl;
     cout<<"[-gr set gray color capture]\n";
     cout<<"[-test_speed use for test speed and no images will be saved]\n";
+    cout<<"[-no_copy images point into the camera buffers instead of being copied]\n";
     cout<<"[-w width] [-h height] \n[-br brightness_val(0,100)]\n";
     cout<<"[-co contrast_val (0 to 100)]\n[-sa saturation_val (0 to 100)]";
     cout<<"[-g gain_val  (0 to 100)]\n";
@@ -126,14 +130,20 @@ int main ( int argc,char **argv ) {
     cout<<"Connected to camera ="<<Camera.getId() <<endl;
 
     cv::Mat image;
+    raspicam::RaspiCamFrame frame;
     int nCount=100;
     cout<<"Capturing"<<endl;
 
     double time_=cv::getTickCount();
 
     for ( int i=0; i<nCount; i++ ) {
-        Camera.grab();
-        Camera.retrieve ( image );
+        if ( doNoCopy ) {
+            Camera.grab ( frame );
+            Camera.retrieve ( frame,image );
+        } else {
+            Camera.grab();
+            Camera.retrieve ( image );
+        }
         if ( !doTestSpeedOnly ) {
             if ( i%5==0 ) 	  cout<<"\r capturing ..."<<i<<"/"<<nCount<<std::flush;
             if ( i%30==0 && i!=0 )
@@ -143,6 +153,8 @@ int main ( int argc,char **argv ) {
     if ( !doTestSpeedOnly )  cout<<endl<<"Images saved in imagexx.jpg"<<endl;
     double secondsElapsed= double ( cv::getTickCount()-time_ ) /double ( cv::getTickFrequency() ); //time in second
     cout<< secondsElapsed<<" seconds for "<< nCount<<"  frames : FPS = "<< ( float ) ( ( float ) ( nCount ) /secondsElapsed ) <<endl;
+    image.release();
+    frame.release();
     Camera.release();
 
 }
@@ -0,0 +1,188 @@
+/*
+
+ Copyright (c) by Emil Valkov,
+ All rights reserved.
+
+ License: http://www.opensource.org/licenses/bsd-license.php
+*/
+
+#include "Arduino.h"
+#include "SensorManager.h"
+
+SensorManager* SensorManager::gActive = NULL;
+
+SensorManager::SensorManager() {
+	fSonarCount = 0;
+	fIRCount = 0;
+	fActiveSonar = -1;
+	fNextSonar = 0;
+	fLastSonarFinish = 0;
+	fAdcMux = 0;
+	fAdcConverting = 0;
+	fAdcSamples = 0;
+	fAdcSum = 0;
+	fAdcReady = 0;
+	memset(&fSnapshot, 0, sizeof(fSnapshot));
+}
+
+boolean SensorManager::AddSonar(UltraSound1* sonar) {
+	if (fSonarCount >= kMaxSonars) {
+		return false;
+	}
+	for (byte i = 0; i < kSonarMedian; i++) {
+		fSonarHistory[fSonarCount][i] = 0;
+	}
+	fSonarNext[fSonarCount] = 0;
+	fSonars[fSonarCount++] = sonar;
+	return true;
+}
+
+boolean SensorManager::AddIRSensor(SharpIRSensor* sensor) {
+	if (fIRCount >= kMaxIRSensors) {
+		return false;
+	}
+	fIRSensors[fIRCount++] = sensor;
+	return true;
+}
+
+void SensorManager::Start() {
+	gActive = this;
+	fActiveSonar = -1;
+	fNextSonar = 0;
+	fLastSonarFinish = millis() - kMinMeasureInterval;
+
+	if (fIRCount == 0) {
+		return;
+	}
+	fAdcSamples = 0;
+	fAdcSum = 0;
+	fAdcReady = 0;
+	SetAdcSensor(0);
+	fAdcConverting = 0;
+#ifdef __AVR__
+	// free running, interrupt on each conversion, clock / 128: about
+	// 9600 conversions a second at 16MHz
+	ADCSRB = 0;
+	ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+	ADCSRA |= (1 << ADSC);
+#endif
+}
+
+void SensorManager::SetAdcSensor(byte index) {
+	fAdcMux = index;
+#ifdef __AVR__
+	int channel = fIRSensors[index]->GetPinNumber();
+	if (channel >= A0) {
+		channel -= A0;
+	}
+	// AVcc reference; channels 0 to 7
+	ADMUX = (1 << REFS0) | (channel & 0x07);
+#endif
+}
+
+void SensorManager::AdcSample(int value) {
+	// The next conversion started as this one finished, with the mux as it
+	// was then. A mux change only applies to the one after, so the first
+	// result after a change still belongs to the old sensor: drop it.
+	if (fIRCount == 0) {
+		return;
+	}
+	byte sampled = fAdcConverting;
+	fAdcConverting = fAdcMux;
+	if (sampled != fAdcMux) {
+		return;
+	}
+
+	fAdcSum += value;
+	if (++fAdcSamples < kIRAverage) {
+		return;
+	}
+	fAdcAverage[sampled] = fAdcSum / kIRAverage;
+	fAdcReady |= 1 << sampled;
+	fAdcSum = 0;
+	fAdcSamples = 0;
+	SetAdcSensor((sampled + 1) % fIRCount);
+}
+
+#ifdef __AVR__
+ISR(ADC_vect) {
+	SensorManager* manager = SensorManager::gActive;
+	if (manager) {
+		manager->AdcSample(ADC);
+	}
+}
+#endif
+
+void SensorManager::EchoInterrupt() {
+	if (gActive && gActive->fActiveSonar >= 0) {
+		gActive->fSonars[gActive->fActiveSonar]->EchoChange();
+	}
+}
+
+void SensorManager::RecordSonar(byte index, int value) {
+	int* history = fSonarHistory[index];
+	history[fSonarNext[index]] = value;
+	fSonarNext[index] = (fSonarNext[index] + 1) % kSonarMedian;
+
+	// median, with no echo (0) counted as the farthest
+	int sorted[kSonarMedian];
+	for (byte i = 0; i < kSonarMedian; i++) {
+		unsigned int key = (unsigned int)history[i] - 1;
+		byte j = i;
+		while (j > 0 && (unsigned int)sorted[j - 1] - 1 > key) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = history[i];
+	}
+	fSnapshot.fSonarMicros[index] = sorted[kSonarMedian / 2];
+}
+
+boolean SensorManager::Update() {
+	boolean changed = false;
+
+	if (fActiveSonar >= 0) {
+		UltraSound1* sonar = fSonars[fActiveSonar];
+		if (sonar->PollMeasure()) {
+			detachInterrupt(digitalPinToInterrupt(sonar->GetPin()));
+			RecordSonar(fActiveSonar, sonar->GetLastMeasure());
+			fLastSonarFinish = millis();
+			fNextSonar = (fActiveSonar + 1) % fSonarCount;
+			fActiveSonar = -1;
+			changed = true;
+		}
+	}
+
+	// one sonar at a time, and a quiet interval between them so one
+	// doesn't hear the last one's echo
+	if (fActiveSonar < 0 && fSonarCount > 0 && millis() - fLastSonarFinish >= kMinMeasureInterval) {
+		UltraSound1* sonar = fSonars[fNextSonar];
+		sonar->Trigger();
+		fActiveSonar = fNextSonar;
+		attachInterrupt(digitalPinToInterrupt(sonar->GetPin()), EchoInterrupt, CHANGE);
+	}
+
+	if (fIRCount > 0) {
+		int averages[kMaxIRSensors];
+		noInterrupts();
+		byte ready = fAdcReady;
+		fAdcReady = 0;
+		for (byte i = 0; i < fIRCount; i++) {
+			averages[i] = fAdcAverage[i];
+		}
+		interrupts();
+
+		for (byte i = 0; i < fIRCount; i++) {
+			if (ready & (1 << i)) {
+				fSnapshot.fIRDistance[i] = fIRSensors[i]->Filter(averages[i]);
+				changed = true;
+			}
+		}
+	}
+
+	if (changed) {
+		fSnapshot.fSequence++;
+		fSnapshot.fTime = millis();
+	}
+	return changed;
+}
@@ -0,0 +1,92 @@
+/*
+
+ Copyright (c) by Emil Valkov,
+ All rights reserved.
+
+ License: http://www.opensource.org/licenses/bsd-license.php
+
+ Runs UltraSound1 sonars and SharpIRSensors without ever waiting on them.
+ The sonars are triggered one at a time, kMinMeasureInterval apart, and
+ their echoes are timed by the pin's change interrupt (attachInterrupt, so
+ on an Uno the sonar pins must be 2 or 3). The IR sensors are sampled by
+ the ADC in free running mode from its interrupt, kIRAverage conversions
+ per reading, one sensor after the other.
+
+ Call Update() from loop(): it triggers the next sonar when it is due and
+ turns finished echoes and ADC averages into filtered readings, which are
+ in GetSnapshot(). The ADC belongs to the manager once Start() is called:
+ analogRead() can't be used with IR sensors added.
+*/
+
+#ifndef __SensorManager__
+#define __SensorManager__
+
+#include "Arduino.h"
+#include <UltraSound1.h>
+#include <SharpIRSensor.h>
+
+#define kMaxSonars 2
+#define kMaxIRSensors 4
+#define kSonarMedian 3
+#define kIRAverage 8
+
+struct SensorSnapshot {
+	unsigned int fSequence;           // bumped on every new reading
+	unsigned long fTime;              // millis() of the last new reading
+	int fSonarMicros[kMaxSonars];     // median of the last kSonarMedian echoes, 0 for none
+	int fIRDistance[kMaxIRSensors];   // averaged, then as SharpIRSensor::GetDistance()
+};
+
+class SensorManager {
+public:
+	SensorManager();
+
+	// Sensors are numbered in the order they are added
+	boolean AddSonar(UltraSound1* sonar);
+	boolean AddIRSensor(SharpIRSensor* sensor);
+
+	void Start();
+
+	// Returns true if there are new readings in the snapshot
+	boolean Update();
+
+	const SensorSnapshot& GetSnapshot() const {return fSnapshot;}
+
+	// A finished ADC conversion, from the ADC interrupt
+	void AdcSample(int value);
+
+	// The IR sensor whose conversion is running
+	int GetAdcSensor() const {return fAdcConverting;}
+
+	// The manager the interrupts go to, set by Start()
+	static SensorManager* gActive;
+
+private:
+	void SetAdcSensor(byte index);
+	void RecordSonar(byte index, int value);
+
+	static void EchoInterrupt();
+
+	UltraSound1* fSonars[kMaxSonars];
+	byte fSonarCount;
+	int fSonarHistory[kMaxSonars][kSonarMedian];
+	byte fSonarNext[kMaxSonars];
+	int fActiveSonar;                 // measuring, or -1
+	byte fNextSonar;
+	unsigned long fLastSonarFinish;
+
+	SharpIRSensor* fIRSensors[kMaxIRSensors];
+	byte fIRCount;
+
+	// shared with the ADC interrupt
+	volatile byte fAdcMux;            // sensor the next conversion will sample
+	volatile byte fAdcConverting;     // sensor the running conversion samples
+	volatile byte fAdcSamples;
+	volatile unsigned int fAdcSum;
+	volatile int fAdcAverage[kMaxIRSensors];
+	volatile byte fAdcReady;          // one bit per sensor with a new average
+
+	SensorSnapshot fSnapshot;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/*
+
+ Copyright (c) by Emil Valkov,
+ All rights reserved.
+
+ License: http://www.opensource.org/licenses/bsd-license.php
+*/
+
+#include <UltraSound1.h>
+#include <SharpIRSensor.h>
+#include <SensorManager.h>
+
+UltraSound1 gSonar;
+SharpIRSensor gLeftIR;
+SharpIRSensor gRightIR;
+SensorManager gSensors;
+unsigned long gLastPrint = 0;
+
+void setup() {
+  gSonar.Initialize(2);
+  gLeftIR.Initialize(A0);
+  gRightIR.Initialize(A1);
+  gSensors.AddSonar(&gSonar);
+  gSensors.AddIRSensor(&gLeftIR);
+  gSensors.AddIRSensor(&gRightIR);
+  gSensors.Start();
+  Serial.begin(115200);
+}
+
+void loop() {
+  gSensors.Update();
+
+  // the readings are always at hand; nothing here waits for a sensor
+  if (millis() - gLastPrint >= 200) {
+    const SensorSnapshot& snapshot = gSensors.GetSnapshot();
+    gLastPrint = millis();
+    Serial.print(snapshot.fSonarMicros[0] / 58);
+    Serial.print(" ");
+    Serial.print(SharpIRSensor::LinearizeIRSensor(snapshot.fIRDistance[0]));
+    Serial.print(" ");
+    Serial.println(SharpIRSensor::LinearizeIRSensor(snapshot.fIRDistance[1]));
+  }
+}
@@ -32,7 +32,12 @@ public:
 	}
 
 	int GetDistance() {
-		int value = analogRead(fPinNumber);
+		return Filter(analogRead(fPinNumber));
+	}
+
+	// GetDistance() on a value read elsewhere, such as SensorManager's
+	// averaged free running ADC
+	int Filter(int value) {
 		unsigned long curTime = millis();
 		if (fLastValue < kIRInfinityThreshold) {
 			if (curTime - fLastValueTime < 40) {
@@ -52,6 +57,8 @@ public:
 		return value;
 	}
 
+	int GetPinNumber() const {return fPinNumber;}
+
 	static int LinearizeIRSensor(int value) {
 		return (kK - kB * (value - kC)) / (kA * (value - kC));
 	}
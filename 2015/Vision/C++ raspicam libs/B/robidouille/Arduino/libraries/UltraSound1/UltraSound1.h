@@ -15,12 +15,20 @@
 #include "Arduino.h"
 
 #define kMinMeasureInterval 32
+#define kEchoTimeoutMicros 32768
+
+// Non-blocking measure states
+#define kEchoIdle 0
+#define kEchoWaiting 1
+#define kEchoHigh 2
+#define kEchoDone 3
 
 class UltraSound1 {
 public:
 	UltraSound1() {
 		fLastMeasureFinish = millis() - kMinMeasureInterval;
 		fLastMeasure = 0;
+		fEchoState = kEchoIdle;
 	}
 
 	void Initialize(int pin) {
@@ -70,10 +78,69 @@ public:
 		return MeasureMicroseconds() / 58;
 	}
 
+	// Non-blocking measure, as used by SensorManager: Trigger() sends the
+	// pulse and leaves the pin listening, EchoChange() is called from the
+	// pin's change interrupt, and PollMeasure() returns true once the echo
+	// is in or timed out, with the result in GetLastMeasure().
+	void Trigger() {
+		pinMode(fPin, OUTPUT);
+		digitalWrite(fPin, HIGH);
+		delayMicroseconds(10);
+		digitalWrite(fPin, LOW);
+
+		pinMode(fPin, INPUT);
+		fEchoState = kEchoWaiting;
+		fTriggerTime = micros();
+	}
+
+	void EchoChange() {
+		unsigned long now = micros();
+		if (digitalRead(fPin)) {
+			fEchoStart = now;
+			fEchoState = kEchoHigh;
+		}
+		else if (fEchoState == kEchoHigh) {
+			fEchoWidth = now - fEchoStart;
+			fEchoState = kEchoDone;
+		}
+	}
+
+	boolean PollMeasure() {
+		noInterrupts();
+		byte state = fEchoState;
+		unsigned long width = fEchoWidth;
+		interrupts();
+
+		if (state == kEchoIdle) {
+			return false;
+		}
+		if (state == kEchoDone) {
+			fLastMeasure = (int)width;
+		}
+		else if (micros() - fTriggerTime >= kEchoTimeoutMicros) {
+			fLastMeasure = 0; // as pulseIn() on a timeout
+		}
+		else {
+			return false;
+		}
+
+		fEchoState = kEchoIdle;
+		fLastMeasureFinish = millis();
+		return true;
+	}
+
+	int GetPin() const {return fPin;}
+	int GetLastMeasure() const {return fLastMeasure;}
+
 private:
 	int fPin;
 	unsigned long fLastMeasureFinish;
 	int fLastMeasure;
+
+	volatile byte fEchoState;
+	volatile unsigned long fEchoStart;
+	volatile unsigned long fEchoWidth;
+	unsigned long fTriggerTime;
 };
 
 #endif
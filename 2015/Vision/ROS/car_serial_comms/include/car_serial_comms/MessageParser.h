@@ -1,22 +1,26 @@
 /*
- * Insert documentation
+ * MessageParser - drive frames from the Arduino brain board.
+ *
+ * The frame format and its parser live with the Arduino sketch
+ * (2015/Driving/car_motor_driver/car_comms.h) so both ends build the same
+ * code; this only keeps the last steering and throttle seen.
  */
 
 #include <stdlib.h>
 #include <stdint.h>
-//#include <stdbool.h>
+
+#include "car_comms.h"
 
 class MessageParser
 {
 private:
-  char parse_buffer[5];
+  Car_Comms parser_;
   int steering;
   int throttle;
 public:
   MessageParser();
-  bool parse_message(uint8_t *buffer, int length, int8_t &cnt);
+  bool parse_message(const uint8_t *buffer, size_t length);
   int get_steering();
   int get_throttle();
-private:
-  bool next_int(int &retval, uint8_t *buffer, int &idx, int length);
+  static size_t encode_drive(uint8_t *frame, int steering, int throttle);
 };
@@ -1,40 +1,32 @@
 /*
- * Insert documentation
+ * MessageParser - drive frames from the Arduino brain board.
  */
 
 #include "car_serial_comms/MessageParser.h"
 
 MessageParser::MessageParser()
+  : steering(0), throttle(0)
 {
   return;
 }
 
-bool MessageParser::parse_message(uint8_t *buffer, int length, int8_t &cnt)
+/*
+ * parse_message - feed received bytes, in any split. Returns true if at
+ * least one drive frame finished; the last one wins.
+ */
+bool MessageParser::parse_message(const uint8_t *buffer, size_t length)
 {
-  // Get data out of the buffer
-  int idx = 0;
-  while (buffer[idx] != '<' && idx < (length-1))
-    idx++;
-  if (buffer[idx] != '<')
-    return false;
-  if (++idx == (length-1))
-    return false;
-
-  if (next_int(steering,buffer,idx,length))
+  bool updated = false;
+  for (size_t i = 0; i < length; i++)
   {
-    idx++; // Next!
-    if (next_int(throttle,buffer,idx,length))
+    if (parser_.parse(buffer[i]) && parser_.message().id == CAR_COMMS_DRIVE)
     {
-      if (idx>=length || buffer[idx] != '>')
-        return false;
-      idx++;
-      for (int i=0; i<(length-idx); i++)
-        buffer[i] = buffer[i+idx];
-      cnt = cnt - idx; // Next empty slot / new size
-      return true;
+      steering = parser_.message().a;
+      throttle = parser_.message().b;
+      updated = true;
     }
   }
-  return false;
+  return updated;
 }
 
 int MessageParser::get_steering()
@@ -47,33 +39,11 @@ int MessageParser::get_throttle()
   return throttle;
 }
 
-bool MessageParser::next_int(int &retval, uint8_t *buffer, int &idx, int length)
+/*
+ * encode_drive - a drive command for the Arduino into frame, which must
+ * hold CAR_COMMS_FRAME bytes. Returns the length.
+ */
+size_t MessageParser::encode_drive(uint8_t *frame, int steering, int throttle)
 {
-  // Move subsequent chars into parse buffer
-  if (buffer[idx]!='-' && (buffer[idx]<48 || buffer[idx]>57))
-    return false;
-  int parse_idx=0;
-  parse_buffer[parse_idx] = buffer[idx];
-  idx++;
-
-  // Get the rest of the number
-  while ((buffer[idx]>=48) &&
-         (buffer[idx]<=57) &&
-         (idx<=(length-1))  &&
-         (parse_idx<4))
-  {
-    parse_buffer[++parse_idx] = buffer[idx++];
-  }
-  // Check if a valid number (only invalid if "-", otherwise OK)
-  if (parse_idx==0 && parse_buffer[0]=='-')
-    return false;
-
-  // Add null terminator
-  parse_buffer[++parse_idx] = '\0';
-
-  // Get the number out
-  retval = atoi(parse_buffer);
-
-  // Got a reading!
-  return true;
+  return Car_Comms::encode(frame, CAR_COMMS_DRIVE, steering, throttle);
 }
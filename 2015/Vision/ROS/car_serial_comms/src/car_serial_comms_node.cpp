@@ -35,9 +35,8 @@ private:
   ros::Subscriber comms_sub_;
   MessageParser mp_;
 
-  // Reused variables for parsing serial input
+  // Reused buffer for serial input
   uint8_t buffer_[BUFFER_SIZE];
-  int8_t cnt_;
 
 public:
   //----------------------------------------------------------------------------
@@ -53,7 +52,6 @@ public:
       &Serial_Manager::send_serial_callback, this);
 
     // Initialize buffer
-    cnt_ = 0;
     for (int i=0; i<BUFFER_SIZE; ++i)
       buffer_[i] = 0;
   }
@@ -65,12 +63,12 @@ public:
    */
   void send_serial_callback(const car_serial_comms::ThrottleAndSteering& msg)
   {
-    // Build string to send
-    std::stringstream ss;
-    ss << "<" << msg.steering << "," << msg.throttle << ">";
+    // Build the frame to send
+    uint8_t frame[CAR_COMMS_FRAME];
+    size_t length = MessageParser::encode_drive(frame, msg.steering, msg.throttle);
 
     // Write out over serial port
-    serial_port_.write(ss.str());
+    serial_port_.write(frame, length);
   }
 
   /*
@@ -79,32 +77,35 @@ public:
   void check_serial()
   {
     // Check for available data
-    if (serial_port_.available() > 0)
+    size_t available = serial_port_.available();
+    bool updated = false;
+    while (available > 0)
     {
-      // Load up the buffer
-      while (serial_port_.available() && cnt_ < BUFFER_SIZE)
-      {
-        // Get one char at a time because lazy
-        serial_port_.read(&buffer_[cnt_++], 1);
-      }
-
-      // Hand over the message and see if new values are produced
-      if (mp_.parse_message(buffer_, BUFFER_SIZE, cnt_))
-      {
-        // Get updated values
-        int steering = mp_.get_steering();
-        int throttle = mp_.get_throttle();
-
-        // Make message, load with data, then publish
-        car_serial_comms::ThrottleAndSteering msg;
-        msg.header.stamp = ros::Time::now();
-        msg.header.frame_id = "/chassis";
-        msg.steering = steering;
-        msg.throttle = throttle;
-
-        // Publish to send out
-        comms_pub_.publish(msg);
-      }
+      // Whatever has come in, a buffer at a time
+      size_t got = serial_port_.read(buffer_,
+        available < BUFFER_SIZE ? available : BUFFER_SIZE);
+      if (got == 0)
+        break;
+      available -= got;
+
+      // Hand over the bytes and see if new values are produced
+      updated |= mp_.parse_message(buffer_, got);
+    }
+    if (updated)
+    {
+      // Get updated values
+      int steering = mp_.get_steering();
+      int throttle = mp_.get_throttle();
+
+      // Make message, load with data, then publish
+      car_serial_comms::ThrottleAndSteering msg;
+      msg.header.stamp = ros::Time::now();
+      msg.header.frame_id = "/chassis";
+      msg.steering = steering;
+      msg.throttle = throttle;
+
+      // Publish to send out
+      comms_pub_.publish(msg);
     }
   }
 };
@@ -14,6 +14,10 @@
 //#define COLLISION_AVOIDANCE
 //#define IMU_GPS
 
+#ifdef CAN2USB
+#include "SLCAN.h"
+#endif
+
 
 
 //This is the ECAN message buffer declaration. Note the buffer alignment and the start address.
@@ -21,6 +25,21 @@ unsigned int ecan1MsgBuffer[NUM_OF_ECAN_BUFFERS][8]
 __attribute__((address(0x7000), aligned(NUM_OF_ECAN_BUFFERS * 16)));
 
 volatile unsigned int CANReceiveCount = 0;
+
+#define CAN_TX_QUEUE_MASK (CAN_TX_QUEUE_SIZE - 1)
+
+/*Frame as laid out in a message buffer: SID, EID, DLC and 4 data words*/
+typedef struct
+{
+    unsigned int word[7];
+} CANFrame;
+
+/*Software transmit queue behind each class's hardware buffer. The main loop
+ *adds with the CAN interrupt held off and _C1Interrupt removes.*/
+static CANFrame canTxQueue[CAN_NUM_CLASSES][CAN_TX_QUEUE_SIZE];
+static volatile unsigned int canTxHead[CAN_NUM_CLASSES];
+static volatile unsigned int canTxTail[CAN_NUM_CLASSES];
+volatile unsigned int CANTxOverflowCount = 0;
 #ifdef MOTOR_CONTROLLER
 extern char manualEStop;
 extern char collisionEmergency;
@@ -42,6 +61,55 @@ void __attribute__((__interrupt__, no_auto_psv)) _DMA1Interrupt(void)
     IFS0bits.DMA1IF = 0; /* Clear interrupt flag */
 }
 
+static int CAN1TxBufferBusy(unsigned int buffer)
+{
+    switch (buffer)
+    {
+        case 0: return C1TR01CONbits.TXREQ0;
+        case 1: return C1TR01CONbits.TXREQ1;
+        case 2: return C1TR23CONbits.TXREQ2;
+        default: return C1TR23CONbits.TXREQ3;
+    }
+}
+
+static void CAN1LoadTxBuffer(unsigned int buffer, CANFrame* frame)
+{
+    int i;
+    for (i = 0; i < 7; i++)
+    {
+        ecan1MsgBuffer[buffer][i] = frame->word[i];
+    }
+    /* Request message buffer transmission */
+    switch (buffer)
+    {
+        case 0: C1TR01CONbits.TXREQ0 = 1; break;
+        case 1: C1TR01CONbits.TXREQ1 = 1; break;
+        case 2: C1TR23CONbits.TXREQ2 = 1; break;
+        default: C1TR23CONbits.TXREQ3 = 1; break;
+    }
+}
+
+/*CAN1 event ISR, only the transmit buffer interrupt is enabled*/
+void __attribute__((__interrupt__, no_auto_psv)) _C1Interrupt(void)
+{
+    unsigned int cls;
+    if (C1INTFbits.TBIF)
+    {
+        C1INTFbits.TBIF = 0;
+        /*Refill whichever class buffers have finished sending*/
+        for (cls = 0; cls < CAN_NUM_CLASSES; cls++)
+        {
+            unsigned int tail = canTxTail[cls];
+            if (tail != canTxHead[cls] && !CAN1TxBufferBusy(cls))
+            {
+                CAN1LoadTxBuffer(cls, &canTxQueue[cls][tail]);
+                canTxTail[cls] = (tail + 1) & CAN_TX_QUEUE_MASK;
+            }
+        }
+    }
+    IFS2bits.C1IF = 0;
+}
+
 void CAN1Init()
 {
     //remap IO for CAN module
@@ -65,6 +133,10 @@ void CAN1Init()
     TRISEbits.TRISE0 = 0;
     LATEbits.LATE0 = 1; //put tranceiver in standby mode
 #endif
+#ifdef IMU_GPS
+    RPINR26bits.C1RXR = 0b0110001;
+    RPOR4bits.RP80R = 0b001110;
+#endif
 
     //put module in configuration mode
     C1CTRL1bits.REQOP = 4;
@@ -101,7 +173,7 @@ void CAN1Init()
     C1RXF11SIDbits.SID = CANMSG_NAVRPY;
     C1RXF12SIDbits.SID = CANMSG_NAVLONLAT;
     C1RXF13SIDbits.SID = CANMSG_START;
-    C1RXF14SIDbits.SID = 0x07FF; //unused
+    C1RXF14SIDbits.SID = CANMSG_BATTSTATUS;
     C1RXF15SIDbits.SID = 0x07FF; //unused
     /*Set filters to check for for standard frames*/
     C1RXM0SIDbits.MIDE = 1;
@@ -120,28 +192,17 @@ void CAN1Init()
     C1RXF13SIDbits.EXIDE = 0;
     C1RXF14SIDbits.EXIDE = 0;
     C1RXF15SIDbits.EXIDE = 0;
-    /*Set filter to use buffers to store messages*/
-    C1BUFPNT1bits.F1BP = 1;
-    C1BUFPNT1bits.F2BP = 2;
-    C1BUFPNT1bits.F3BP = 3;
-    C1BUFPNT2bits.F4BP = 4;
-    C1BUFPNT2bits.F5BP = 5;
-    C1BUFPNT2bits.F6BP = 6;
-    C1BUFPNT2bits.F7BP = 7;
-    C1BUFPNT3bits.F8BP = 8;
-    C1BUFPNT3bits.F9BP = 9;
-    C1BUFPNT3bits.F10BP = 10;
-    C1BUFPNT3bits.F11BP = 11;
-    C1BUFPNT4bits.F12BP = 12;
-    C1BUFPNT4bits.F13BP = 13;
-    C1BUFPNT4bits.F14BP = 14;
-    C1BUFPNT4bits.F15BP = 15;
-    /*Enable the first 13 filters*/
-    C1FEN1 = 0x3FFE;
+    /*Send every filter hit to the receive FIFO*/
+    C1BUFPNT1 = 0xFFFF;
+    C1BUFPNT2 = 0xFFFF;
+    C1BUFPNT3 = 0xFFFF;
+    C1BUFPNT4 = 0xFFFF;
+    /*Enable the first 14 filters*/
+    C1FEN1 = 0x7FFE;
     /*Use 16 DMA buffers*/
     C1FCTRLbits.DMABS = 4;
-    /*No FIFO buffers*/
-    C1FCTRLbits.FSA = 15;
+    /*Buffers 4-15 are the receive FIFO*/
+    C1FCTRLbits.FSA = CAN_RX_FIFO_START;
     /*No devicenet filtering*/
     C1CTRL2bits.DNCNT = 0;
     /*Set up DMA module*/
@@ -166,15 +227,35 @@ void CAN1Init()
     DMA1STAH = 0;
     DMA1CONbits.CHEN = 1;
 
-    /*Setup Tx buffer*/
+    /*Setup Tx buffers, one per message class, most urgent class highest*/
     C1CTRL1bits.WIN = 0;
-    C1TR01CONbits.TXEN0 = 1; //Set buffer 0 to Tx
+    C1TR01CONbits.TXEN0 = 1; //Set buffers 0-3 to Tx
+    C1TR01CONbits.TXEN1 = 1;
+    C1TR23CONbits.TXEN2 = 1;
+    C1TR23CONbits.TXEN3 = 1;
     C1TR01CONbits.RTREN0 = 0; //No auto remote transmit
-    C1TR01CONbits.TX0PRI = 3; //Set priority to highest
+    C1TR01CONbits.RTREN1 = 0;
+    C1TR23CONbits.RTREN2 = 0;
+    C1TR23CONbits.RTREN3 = 0;
+    C1TR01CONbits.TX0PRI = 3; //Class A
+    C1TR01CONbits.TX1PRI = 2; //Class B
+    C1TR23CONbits.TX2PRI = 1; //Class C
+    C1TR23CONbits.TX3PRI = 0; //Class D
+
+    int cls;
+    for (cls = 0; cls < CAN_NUM_CLASSES; cls++)
+    {
+        canTxHead[cls] = 0;
+        canTxTail[cls] = 0;
+    }
 
     /*Initialize the interrupts*/
     IEC0bits.DMA0IE = 0;
     IEC0bits.DMA1IE = 1;
+    C1INTEbits.TBIE = 1; //Tx buffer emptied, refill from the queue
+    IPC8bits.C1IP = 5;
+    IFS2bits.C1IF = 0;
+    IEC2bits.C1IE = 1;
 
     /*Put module in normal mode*/
     C1CTRL1bits.REQOP = 0;
@@ -192,242 +273,161 @@ void CAN1Init()
 
 int CAN1IsTransmitComplete()
 {
-    return (C1TR01CONbits.TXREQ0 != 1);
+    unsigned int cls;
+    for (cls = 0; cls < CAN_NUM_CLASSES; cls++)
+    {
+        if (canTxHead[cls] != canTxTail[cls] || CAN1TxBufferBusy(cls))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*Hand a frame to its class's Tx buffer if it is idle, otherwise queue it
+ *behind it. Never waits on the bus, returns 0 only if the queue is full.*/
+static int CAN1Queue(CANFrame* frame)
+{
+    unsigned int cls = CAN_MSG_CLASS((frame->word[0] >> 2) & 0x07FF);
+    unsigned int head;
+    unsigned int ie = IEC2bits.C1IE; //restored as found, the caller may have it off
+    int queued = 1;
+
+    IEC2bits.C1IE = 0; //keep the Tx ISR off the queue while it is changed
+    head = canTxHead[cls];
+    if (head == canTxTail[cls] && !CAN1TxBufferBusy(cls))
+    {
+        CAN1LoadTxBuffer(cls, frame);
+    }
+    else if (((head + 1) & CAN_TX_QUEUE_MASK) == canTxTail[cls])
+    {
+        CANTxOverflowCount++;
+        queued = 0;
+    }
+    else
+    {
+        canTxQueue[cls][head] = *frame;
+        canTxHead[cls] = (head + 1) & CAN_TX_QUEUE_MASK;
+    }
+    IEC2bits.C1IE = ie;
+    return queued;
 }
 
 int CAN1Transmit(unsigned int SID, unsigned int length, unsigned int* data)
 {
-    /*check the length is within range and if the buffer is free*/
-    if (length > 8 || !CAN1IsTransmitComplete())
+    CANFrame frame;
+    int i;
+    /*check the length is within range*/
+    if (length > 8)
     {
         return 0;
     }
-    /* Write to message buffer 0 */
     /* CiTRBnSID = 0bxxx1 0010 0011 1100
     IDE = 0b0
     SRR = 0b0
     SID<10:0>= 0b100 1000 1111 */
-    ecan1MsgBuffer[0][0] = ((SID & 0x07FF) << 2) & 0xFFFC;
-    //ecan1MsgBuffer[0][0] = 0x123C;
+    frame.word[0] = ((SID & 0x07FF) << 2) & 0xFFFC;
     /* CiTRBnEID = 0bxxxx 0000 0000 0000
     EID<17:6> = 0b0000 0000 0000 */
-    ecan1MsgBuffer[0][1] = 0x0000;
+    frame.word[1] = 0x0000;
     /* CiTRBnDLC = 0b0000 0000 xxx0 1111
     EID<17:6> = 0b000000
     RTR = 0b0
     RB1 = 0b0
     RB0 = 0b0
     DLC = 0b1111 */
-    ecan1MsgBuffer[0][2] = (length) & 0x000F;
-    //ecan1MsgBuffer[0][2] = 0x0008;
+    frame.word[2] = (length) & 0x000F;
     /* Write message data bytes */
-    int i;
-    for (i = 0; i < (length+1) / 2; i++)
+    for (i = 0; i < 4; i++)
     {
-        ecan1MsgBuffer[0][i + 3] = data[i];
+        frame.word[i + 3] = (i < (length + 1) / 2) ? data[i] : 0;
     }
-    //    ecan1MsgBuffer[0][3] = 0xabcd;
-    //    ecan1MsgBuffer[0][4] = 0xabcd;
-    //    ecan1MsgBuffer[0][5] = 0xabcd;
-    //    ecan1MsgBuffer[0][6] = 0xabcd;
-    /* Request message buffer 0 transmission */
-    C1TR01CONbits.TXREQ0 = 0x1;
-    return 1;
+    return CAN1Queue(&frame);
 }
 
 int CAN1TransmitRemote(unsigned int SID, unsigned int length)
 {
-    /*check if the buffer is free*/
-    if (!CAN1IsTransmitComplete())
-    {
-        return 0;
-    }
+    CANFrame frame;
     /*check the length is within range*/
     if (length > 8)
     {
         length = 8;
     }
-    /* Write to message buffer 0 */
-    /* CiTRBnSID = 0bxxx1 0010 0011 1100
+    /* CiTRBnSID = 0bxxx1 0010 0011 1110
     IDE = 0b0
     SRR = 0b1
     SID<10:0>= 0b100 1000 1111 */
-    //    ecan1MsgBuffer[0][0] = ((SID & 0x07ff) << 2) | 0x2 & 0xFFFE;
-    ecan1MsgBuffer[0][0] = 0x123E;
-    /* CiTRBnEID = 0bxxxx 0000 0000 0000
-    EID<17:6> = 0b0000 0000 0000 */
-    ecan1MsgBuffer[0][1] = 0x0000;
-    /* CiTRBnDLC = 0b0000 0000 xxx0 0000
-    EID<17:6> = 0b000000
-    RTR = 0b0
-    RB1 = 0b0
-    RB0 = 0b0
-    DLC = 0b0000 */
-    //    ecan1MsgBuffer[0][2] = length & 0x000F;
-    ecan1MsgBuffer[0][2] = 0x0000;
-    /* Request message buffer 0 transmission */
-    C1TR01CONbits.TXREQ0 = 0x1;
-    return 1;
+    frame.word[0] = (((SID & 0x07FF) << 2) | 0x0002) & 0xFFFE;
+    frame.word[1] = 0x0000;
+    /* DLC = requested length */
+    frame.word[2] = length & 0x000F;
+    frame.word[3] = 0;
+    frame.word[4] = 0;
+    frame.word[5] = 0;
+    frame.word[6] = 0;
+    return CAN1Queue(&frame);
 }
 
 void CAN1EmptyReveiveBuffer(int index)
 {
 #ifdef CAN2USB
-    char str[13];
     if (index > 0 && index < 16)
     {
-        str[0] = '<';
-        str[1] = (char) ((ecan1MsgBuffer[index][0] & 0x1FFC) >> 2);
-        str[2] = (char) ((ecan1MsgBuffer[index][0] & 0x1FFC) >> 10);
-        int i;
-        for (i = 0; i < (ecan1MsgBuffer[index][2] & 0x000F); i++)
-        {
-            if (i & 1)
-                str[3 + i] = (char) (ecan1MsgBuffer[index][3 + i / 2] >> 8);
-            else
-                str[3 + i] = (char) ecan1MsgBuffer[index][3 + i / 2];
-        }
-        /*Calculate checksum*/
-        int j;
-        for (j = 0; j < i + 2; j++)
-        {
-            str[3 + i] = str[j + 1];
-        }
-        str[4 + i] = '>';
-        UART1WriteStr(str, i + 5);
+        SLCANForwardFrame(ecan1MsgBuffer[index]);
     }
 #endif
 }
 
-void CAN1CheckReceiveBuffer()
+static void CAN1HandleMessage(unsigned int index)
 {
-    while (CANReceiveCount)
-    {
-        CANReceiveCount--;
-        if (C1RXFUL1bits.RXFUL1)
-        {
 #ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(1);
+    CAN1EmptyReveiveBuffer(index);
 #endif
+    switch ((ecan1MsgBuffer[index][0] & 0x1FFC) >> 2)
+    {
+        case CANMSG_ESTOP:
 #ifdef MOTOR_CONTROLLER
-            manualEStop = ecan1MsgBuffer[1][3] & 0x1;
+            manualEStop = ecan1MsgBuffer[index][3] & 0x1;
 #endif
 #ifdef COLLISION_AVOIDANCE
-            manualEStop = ecan1MsgBuffer[1][3] & 0x1;
-            remoteEStop = ecan1MsgBuffer[1][3] & 0x2;
-#endif
-            C1RXFUL1bits.RXFUL1 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL2)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(2);
+            manualEStop = ecan1MsgBuffer[index][3] & 0x1;
+            remoteEStop = ecan1MsgBuffer[index][3] & 0x2;
 #endif
+            break;
+        case CANMSG_COLLEMERG:
 #ifdef MOTOR_CONTROLLER
-            collisionEmergency = ecan1MsgBuffer[2][3]&0xff;
-#endif
-            C1RXFUL1bits.RXFUL2 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL3)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(3);
-#endif
-            C1RXFUL1bits.RXFUL3 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL4)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(4);
-#endif
-            C1RXFUL1bits.RXFUL4 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL5)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(5);
-#endif
-            C1RXFUL1bits.RXFUL5 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL6)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(6);
-#endif
-            C1RXFUL1bits.RXFUL6 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL7)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(7);
-#endif
-            C1RXFUL1bits.RXFUL7 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL8)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(8);
-#endif
-            C1RXFUL1bits.RXFUL8 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL9)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(9);
+            collisionEmergency = ecan1MsgBuffer[index][3]&0xff;
 #endif
+            break;
+        case CANMSG_DESTRAJ:
 #ifdef MOTOR_CONTROLLER
-            desSpeed = ecan1MsgBuffer[9][3];
-            desAngle = ecan1MsgBuffer[9][4];
-#endif
-            C1RXFUL1bits.RXFUL9 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL10)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(10);
-#endif
-            C1RXFUL1bits.RXFUL10 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL11)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(11);
-#endif
-            C1RXFUL1bits.RXFUL11 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL12)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(12);
-#endif
-            C1RXFUL1bits.RXFUL12 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL13)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(13);
+            desSpeed = ecan1MsgBuffer[index][3];
+            desAngle = ecan1MsgBuffer[index][4];
 #endif
+            break;
+        case CANMSG_START:
 #ifdef MOTOR_CONTROLLER
             start = 1;
 #endif
 #ifdef COLLISION_AVOIDANCE
             start = 1;
 #endif
-            C1RXFUL1bits.RXFUL13 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL14)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(14);
-#endif
-            C1RXFUL1bits.RXFUL14 = 0;
-        }
-        else if (C1RXFUL1bits.RXFUL15)
-        {
-#ifdef CAN2USB
-            CAN1EmptyReveiveBuffer(15);
-#endif
-            C1RXFUL1bits.RXFUL15 = 0;
-        }
+            break;
+        default:
+            break;
+    }
+}
+
+void CAN1CheckReceiveBuffer()
+{
+    /*Drain the receive FIFO in arrival order. Clearing a buffer's RXFUL bit
+     *moves FNRB on to the next one. RXFUL bits ignore writes of 1.*/
+    unsigned int index = C1FIFObits.FNRB;
+    while (C1RXFUL1 & (1u << index))
+    {
+        CAN1HandleMessage(index);
+        C1RXFUL1 = ~(1u << index);
+        index = C1FIFObits.FNRB;
     }
-}
\ No newline at end of file
+    CANReceiveCount = 0;
+}
@@ -14,7 +14,6 @@
 #ifdef	__cplusplus
 extern "C" {
 #endif
-#include <p33Exxxx.h>
 #include "CAN_Msg_Priorities.h"
 
 #define CANMSG_ESTOP            CLB_PRTY01 // E-Stop sent received over Bluetooth at Motor board
@@ -32,14 +31,29 @@ extern "C" {
 #define CANMSG_NAVRPY           CLD_PRTY02 // Roll-Pitch-Yaw navigation data reported by IMU/GPS board
 #define CANMSG_NAVLONLAT        CLD_PRTY03 // Longitude-Latitude navigation data reported by IMU/GPS board
 #define CANMSG_START            CLD_PRTY04 // Start buton has been pushed. The CAR is ready to race.
+#define CANMSG_BATTSTATUS       CLD_PRTY05 // Pack voltage, current and charge from power board, see Power/Battery_Monitoring_2016.X/battery.h
+
+/*The IDs above are the one list for every board and the host tools. Off the
+ *dsPIC33E (the PIC24 boards, the Jetson's nodes) only they are defined.*/
+#if defined(__dsPIC33E__) || defined(__HOST_SIM__)
+#include <p33Exxxx.h>
 
 #define NUM_OF_ECAN_BUFFERS 16  //only used for memory allocation
 
+/*Message buffers 0-3 transmit, one per message class. Buffer n carries class n
+ *and gets hardware priority 3-n, so an A/B frame is always sent before C/D.
+ *Buffers 4-15 make up the receive FIFO.*/
+#define CAN_TX_BUFFERS          CAN_NUM_CLASSES
+#define CAN_RX_FIFO_START       4
+#define CAN_TX_QUEUE_SIZE       8   //frames queued per class, must be a power of 2
+
     //This is the ECAN message buffer declaration.
     extern unsigned int ecan1MsgBuffer[NUM_OF_ECAN_BUFFERS][8];
 
     //Public functions
     void CAN1Init();
+    extern volatile unsigned int CANTxOverflowCount;
+
     int CAN1IsTransmitComplete();
     int CAN1Transmit(unsigned int SID, unsigned int length, unsigned int* data);
     int CAN1TransmitRemote(unsigned int SID, unsigned int length);
@@ -48,6 +62,8 @@ extern "C" {
 
     //ISRs
     void __attribute__((__interrupt__, no_auto_psv)) _DMA1Interrupt(void);
+    void __attribute__((__interrupt__, no_auto_psv)) _C1Interrupt(void);
+#endif
 
 #ifdef	__cplusplus
 }
@@ -89,6 +89,18 @@ extern "C"
   
 #define UNASSIGNED 0xA5A5
 
+/************************************
+ *  Message classes
+ * *********************************/
+// The class is bits 5:4 of the ID, class A being the most urgent
+#define CAN_CLASS_A 0
+#define CAN_CLASS_B 1
+#define CAN_CLASS_C 2
+#define CAN_CLASS_D 3
+#define CAN_NUM_CLASSES 4
+
+#define CAN_MSG_CLASS(sid) (((sid) >> 4) & 0x0003)
+
 
 #ifdef	__cplusplus
 }
@@ -0,0 +1,272 @@
+/*
+ * File:   SLCAN.c
+ * Author: Kevin
+ *
+ * Description: slcan host protocol for the CAN to USB tranciever. See SLCAN.h.
+ */
+
+#include "SLCAN.h"
+#include "UART.h"
+#include "CAN.h"
+
+volatile unsigned int SLCANTimestamp = 0;
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+static char slcanOpen = 0;          //frames are only forwarded while open
+static char slcanListenOnly = 0;    //opened with 'L', refuse to transmit
+static char slcanTimestamps = 0;    //append TTTT to forwarded frames
+static unsigned int lastCANTxOverflow = 0;
+static unsigned int lastUARTTxOverflow = 0;
+
+/*Timer 1 ISR, 1ms tick for frame timestamps*/
+void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void)
+{
+    if (++SLCANTimestamp >= 60000)
+    {
+        SLCANTimestamp = 0;
+    }
+    IFS0bits.T1IF = 0;
+}
+
+void SLCANInit()
+{
+    slcanOpen = 0;
+    slcanListenOnly = 0;
+    slcanTimestamps = 0;
+
+    /*Timer 1 at 1ms off the 3.685MHz instruction clock*/
+    T1CON = 0;
+    TMR1 = 0;
+    PR1 = 3684;
+    IPC0bits.T1IP = 2;
+    IFS0bits.T1IF = 0;
+    IEC0bits.T1IE = 1;
+    T1CONbits.TON = 1;
+}
+
+static void SLCANReply(char c)
+{
+    UART1WriteStr(&c, 1);
+}
+
+static int SLCANHexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+/*Read count hex digits, returns -1 on a bad digit*/
+static long SLCANHex(char* str, unsigned int count)
+{
+    long value = 0;
+    unsigned int i;
+    for (i = 0; i < count; i++)
+    {
+        int digit = SLCANHexValue(str[i]);
+        if (digit < 0)
+        {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+
+/*Send a received message buffer to the host as one slcan line*/
+void SLCANForwardFrame(unsigned int* msgBuffer)
+{
+    char str[SLCAN_MAX_LINE];
+    unsigned int sid = (msgBuffer[0] & 0x1FFC) >> 2;
+    unsigned int dlc = msgBuffer[2] & 0x000F;
+    unsigned int length = 0;
+    unsigned int i;
+
+    if (!slcanOpen)
+    {
+        return;
+    }
+    if (dlc > 8)
+    {
+        dlc = 8;
+    }
+    /*SRR marks a remote request on standard frames*/
+    str[length++] = (msgBuffer[0] & 0x0002) ? 'r' : 't';
+    str[length++] = hexDigits[(sid >> 8) & 0x7];
+    str[length++] = hexDigits[(sid >> 4) & 0xF];
+    str[length++] = hexDigits[sid & 0xF];
+    str[length++] = hexDigits[dlc];
+    if (str[0] == 't')
+    {
+        for (i = 0; i < dlc; i++)
+        {
+            unsigned int data = msgBuffer[3 + i / 2];
+            if (i & 1)
+                data >>= 8;
+            str[length++] = hexDigits[(data >> 4) & 0xF];
+            str[length++] = hexDigits[data & 0xF];
+        }
+    }
+    if (slcanTimestamps)
+    {
+        unsigned int timestamp = SLCANTimestamp;
+        str[length++] = hexDigits[timestamp >> 12];
+        str[length++] = hexDigits[(timestamp >> 8) & 0xF];
+        str[length++] = hexDigits[(timestamp >> 4) & 0xF];
+        str[length++] = hexDigits[timestamp & 0xF];
+    }
+    str[length++] = '\r';
+    UART1WriteStr(str, length);
+}
+
+/*t/r command: tIIILDD.. or rIIIL*/
+static char SLCANTransmit(char* line, unsigned int length)
+{
+    unsigned int data[4] = {0, 0, 0, 0};
+    long sid;
+    int dlc;
+    unsigned int i;
+
+    if (!slcanOpen || slcanListenOnly || length < 5)
+    {
+        return SLCAN_ERROR;
+    }
+    sid = SLCANHex(&line[1], 3);
+    dlc = SLCANHexValue(line[4]);
+    if (sid < 0 || sid > 0x7FF || dlc < 0 || dlc > 8)
+    {
+        return SLCAN_ERROR;
+    }
+    if (line[0] == 'r')
+    {
+        if (length != 5 || !CAN1TransmitRemote(sid, dlc))
+            return SLCAN_ERROR;
+        return 'z';
+    }
+    if (length != 5 + 2 * dlc)
+    {
+        return SLCAN_ERROR;
+    }
+    for (i = 0; i < dlc; i++)
+    {
+        long byte = SLCANHex(&line[5 + 2 * i], 2);
+        if (byte < 0)
+        {
+            return SLCAN_ERROR;
+        }
+        data[i / 2] |= (i & 1) ? (byte << 8) : byte;
+    }
+    if (!CAN1Transmit(sid, dlc, data))
+    {
+        return SLCAN_ERROR;
+    }
+    return 'z';
+}
+
+/*F command: report queue overflows since the last F*/
+static void SLCANStatus()
+{
+    char str[4];
+    unsigned int flags = 0;
+    if (CANTxOverflowCount != lastCANTxOverflow)
+    {
+        flags |= 0x02; //Tx queue full
+        lastCANTxOverflow = CANTxOverflowCount;
+    }
+    if (UART1TxOverflowCount != lastUARTTxOverflow)
+    {
+        flags |= 0x08; //data overrun
+        lastUARTTxOverflow = UART1TxOverflowCount;
+    }
+    str[0] = 'F';
+    str[1] = hexDigits[flags >> 4];
+    str[2] = hexDigits[flags & 0xF];
+    str[3] = '\r';
+    UART1WriteStr(str, 4);
+}
+
+static void SLCANCommand(char* line, unsigned int length)
+{
+    char reply = SLCAN_ERROR;
+    switch (line[0])
+    {
+        case 'O':
+        case 'L':
+            if (!slcanOpen)
+            {
+                slcanOpen = 1;
+                slcanListenOnly = (line[0] == 'L');
+                reply = SLCAN_OK;
+            }
+            break;
+        case 'C':
+            slcanOpen = 0;
+            reply = SLCAN_OK;
+            break;
+        case 'S':
+            /*Bus timing is fixed in CAN1Init, accept so host tools can open*/
+            if (!slcanOpen && length == 2 && line[1] >= '0' && line[1] <= '8')
+                reply = SLCAN_OK;
+            break;
+        case 'Z':
+            if (length == 2 && (line[1] == '0' || line[1] == '1'))
+            {
+                slcanTimestamps = line[1] - '0';
+                reply = SLCAN_OK;
+            }
+            break;
+        case 'F':
+            SLCANStatus();
+            return;
+        case 'V':
+            UART1WriteStrNT("V1016\r");
+            return;
+        case 'N':
+            UART1WriteStrNT("NCAR0\r");
+            return;
+        case 't':
+        case 'r':
+            reply = SLCANTransmit(line, length);
+            if (reply == 'z')
+            {
+                char str[2] = {'z', '\r'};
+                UART1WriteStr(str, 2);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    SLCANReply(reply);
+}
+
+void SLCANReceiveChar(char c)
+{
+    static char line[SLCAN_MAX_LINE];
+    static unsigned int lineLength = 0;
+    static char overflow = 0;
+
+    if (c == '\n')
+    {
+        return;
+    }
+    if (c == '\r')
+    {
+        if (overflow)
+            SLCANReply(SLCAN_ERROR);
+        else if (lineLength > 0)
+            SLCANCommand(line, lineLength);
+        lineLength = 0;
+        overflow = 0;
+        return;
+    }
+    if (lineLength < SLCAN_MAX_LINE)
+        line[lineLength++] = c;
+    else
+        overflow = 1;
+}
@@ -0,0 +1,40 @@
+/*
+ * File:   SLCAN.h
+ * Author: Kevin
+ *
+ * Description: Lawicel/slcan ASCII protocol between the CAN to USB tranciever
+ *              and the host. Frames go out as "tIIILDD..[TTTT]\r", the host
+ *              sends the usual O/C/L/Sn/Z/F/V and t/r commands. Only standard
+ *              (11-bit) IDs are used on the CAR so T/R are refused.
+ *              Developed for use as part of WE Bots Project C.A.R.
+ */
+
+#ifndef SLCAN_H
+#define	SLCAN_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+#include <p33Exxxx.h>
+
+#define SLCAN_MAX_LINE      32  //"T" + 8 ID + DLC + 16 data + 4 timestamp + CR
+#define SLCAN_OK            '\r'
+#define SLCAN_ERROR         '\a'
+
+    /*Millisecond timestamp from Timer 1, wraps at 60000 as slcan expects*/
+    extern volatile unsigned int SLCANTimestamp;
+
+    //Public functions
+    void SLCANInit();
+    void SLCANForwardFrame(unsigned int* msgBuffer);
+    void SLCANReceiveChar(char c);
+
+    //ISRs
+    void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SLCAN_H */
+
@@ -7,31 +7,105 @@
 
 #include "UART.h"
 #include "CAN.h"
+#include "SLCAN.h"
+
+#define UART1_TX_BUFFER_MASK (UART1_TX_BUFFER_SIZE - 1)
+#define UART1_RX_BUFFER_MASK (UART1_RX_BUFFER_SIZE - 1)
+
+/*Transmit ring buffer. The head is only moved by the main loop and the tail
+ *only by the TX ISR, so no locking is needed around either index.*/
+static volatile char uart1TxBuffer[UART1_TX_BUFFER_SIZE];
+static volatile unsigned int uart1TxHead = 0;
+static volatile unsigned int uart1TxTail = 0;
+volatile unsigned int UART1TxOverflowCount = 0;
+
+/*Receive ring buffer, the other way round: the RX ISR moves the head and
+ *the main loop the tail.*/
+static volatile char uart1RxBuffer[UART1_RX_BUFFER_SIZE];
+static volatile unsigned int uart1RxHead = 0;
+static volatile unsigned int uart1RxTail = 0;
+volatile unsigned int UART1RxOverrunCount = 0;
 
 /*UART1 ISRs*/
 void __attribute__((__interrupt__, no_auto_psv)) _U1RXInterrupt(void)
 {
+    unsigned int head = uart1RxHead;
+    while (U1STAbits.URXDA)
+    {
+        char c = U1RXREG;
+        unsigned int next = (head + 1) & UART1_RX_BUFFER_MASK;
+        if (next == uart1RxTail)
+        {
+            UART1RxOverrunCount++; /*Dropped, the host times out on that command*/
+        }
+        else
+        {
+            uart1RxBuffer[head] = c;
+            head = next;
+        }
+    }
+    uart1RxHead = head;
+    /*An overrun stops reception until OERR is cleared, the FIFO has just
+     *been read so nothing more is lost clearing it*/
+    if (U1STAbits.OERR)
+    {
+        UART1RxOverrunCount++;
+        U1STAbits.OERR = 0;
+    }
     IFS0bits.U1RXIF = 0;
 }
 
 void __attribute__((__interrupt__, no_auto_psv)) _U1TXInterrupt(void)
 {
     IFS0bits.U1TXIF = 0;
+    /*Top up the hardware FIFO from the ring buffer*/
+    unsigned int tail = uart1TxTail;
+    while (tail != uart1TxHead && !U1STAbits.UTXBF)
+    {
+        U1TXREG = uart1TxBuffer[tail];
+        tail = (tail + 1) & UART1_TX_BUFFER_MASK;
+    }
+    uart1TxTail = tail;
+    /*Nothing left to send, stay quiet until the next write*/
+    if (tail == uart1TxHead)
+    {
+        IEC0bits.U1TXIE = 0;
+    }
 }
 
-void UART1Init(unsigned int baud)
+void UART1Init(unsigned long baud)
 {
     //Map UART1 to the proper output pins
     RPINR18bits.U1RXR = 0b1001001;
     RPOR0bits.RP64R = 1;
+#ifdef UART1_FLOW_CONTROL
+    RPINR18bits.U1CTSR = UART1_CTS_RPI;
+    UART1_MAP_RTS();
+#endif
 
     //UART configuration
-    //8-bit data, no parity, one stop bit, no interruts
-    U1BRG = (unsigned int) (230312.5 / baud - 0.5);
+    //8-bit data, no parity, one stop bit
+    if (baud > 57600)
+    {
+        U1MODE = 0x8008; //BRGH=1, 4 clocks per bit
+        U1BRG = (unsigned int) ((921250UL + baud / 2) / baud - 1);
+    }
+    else
+    {
+        U1MODE = 0x8000;
+        U1BRG = (unsigned int) (230312.5 / baud - 0.5);
+    }
+#ifdef UART1_FLOW_CONTROL
+    U1MODEbits.UEN = 2; //U1TX, U1RX, U1CTS and U1RTS in use
+#endif
+    //TX interrupt whenever a character moves to the shift register
+    U1STA = 0x0400;
+    uart1TxHead = 0;
+    uart1TxTail = 0;
+    uart1RxHead = 0;
+    uart1RxTail = 0;
     IEC0bits.U1RXIE = 1;
-    IEC0bits.U1TXIE = 1;
-    U1MODE = 0x8000;
-    U1STA = 0xA400;
+    IEC0bits.U1TXIE = 0; //enabled once there is something queued
 }
 
 void UART1Enable()
@@ -47,12 +121,15 @@ void UART1Disable()
 
 unsigned int UART1Read()
 {
-    return U1RXREG;
+    unsigned int tail = uart1RxTail;
+    char c = uart1RxBuffer[tail];
+    uart1RxTail = (tail + 1) & UART1_RX_BUFFER_MASK;
+    return (unsigned char) c;
 }
 
 unsigned int UART1ReadReady()
 {
-    return U1STAbits.URXDA;
+    return uart1RxTail != uart1RxHead;
 }
 
 void UART1Write(char data)
@@ -65,89 +142,62 @@ unsigned int UART1WriteReady()
     return !U1STAbits.UTXBF;
 }
 
-void UART1WriteStr(char * data, unsigned int length)
+unsigned int UART1WriteSpace()
 {
-    int i = 0;
+    return (uart1TxTail - uart1TxHead - 1) & UART1_TX_BUFFER_MASK;
+}
+
+/*Queue a block for transmission without waiting on the UART. The block is
+ *either queued whole or dropped (returns 0) so frames never go out torn.*/
+unsigned int UART1WriteStr(char * data, unsigned int length)
+{
+    unsigned int i;
+    unsigned int head = uart1TxHead;
+    if (length > UART1WriteSpace())
+    {
+        UART1TxOverflowCount++;
+        return 0;
+    }
     for (i = 0; i < length; i++)
     {
-        while (!UART1WriteReady())
-        {
-        }
-        UART1Write(data[i]);
+        uart1TxBuffer[head] = data[i];
+        head = (head + 1) & UART1_TX_BUFFER_MASK;
     }
+    uart1TxHead = head;
+    IEC0bits.U1TXIE = 1; //ISR drains the buffer
+    return length;
 }
 
-void UART1WriteStrNT(char * data)
+unsigned int UART1WriteStrNT(char * data)
 {
-    int i = 0;
-    while (data[i] != '\0')
+    unsigned int length = 0;
+    while (data[length] != '\0')
     {
-        while (!UART1WriteReady())
-        {
-        }
-        UART1Write(data[i++]);
+        length++;
     }
+    return UART1WriteStr(data, length);
 }
 
 void UART1EnableInterrupts()
 {
     IEC0bits.U1RXIE = 1;
-    IEC0bits.U1TXIE = 1;
+    if (uart1TxHead != uart1TxTail)
+    {
+        IEC0bits.U1TXIE = 1;
+    }
 }
 
 void UART1DisableInterrupts()
 {
-    IEC0bits.U1RXIE = 1;
-    IEC0bits.U1TXIE = 1;
+    IEC0bits.U1RXIE = 0;
+    IEC0bits.U1TXIE = 0;
 }
 
 void UART1CheckReceiveBuffer()
 {
-    static char buffer [6]; //4 byte data, 1 byte checksum, 1 byte buffer to store frame close char
-    static int bufferIndex=0;
-    static int started=0;
-
+    /*Host commands are slcan lines, see SLCAN.c*/
     while (UART1ReadReady())
     {
-        buffer[bufferIndex]=UART1Read();
-        /*Check for start of frame*/
-        if (buffer[bufferIndex]=='<')
-        {
-            started=1;
-            bufferIndex=0;
-            continue;
-        }
-        /*Read data*/
-        if (started)
-        {
-            /*Check for end of frame*/
-            if (bufferIndex==5 && buffer[5]=='>')
-            {
-                /*Check checksum*/
-                //if(buffer[0]+buffer[1]+buffer[2]+buffer[3]!=buffer[4])
-                //{
-                  //  started=0;
-                   // continue;
-               // }
-                /*Transmit over CAN*/
-                while(!CAN1IsTransmitComplete())
-                {}
-                unsigned int temp=0xFFff;
-                CAN1Transmit(CANMSG_ESTOP, 1, &temp);
-                started=0;
-                continue;
-            }
-            /*check for frame error*/
-            else if (bufferIndex==5 || buffer[bufferIndex]=='>')
-            {
-                started=0;
-                continue;
-            }
-            /*Must be valid data*/
-            else
-            {
-                bufferIndex++;
-            }
-        }
+        SLCANReceiveChar(UART1Read());
     }
-}
\ No newline at end of file
+}
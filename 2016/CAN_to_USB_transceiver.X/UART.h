@@ -14,16 +14,36 @@ extern "C" {
 
 #include <p33Exxxx.h>
 
+    /*Link to the host. Above 57600 baud the BRGH (4x clock) divider is used,
+     *which reaches 921250 baud off the 3.685MHz instruction clock.*/
+#define UART1_BAUD 460800UL
+
+    /*Uncomment to use U1CTS/U1RTS hardware flow control to the host*/
+    //#define UART1_FLOW_CONTROL
+#define UART1_CTS_RPI       0b1000101   //U1CTS input on RP69 (RD5)
+#define UART1_MAP_RTS()     RPOR2bits.RP68R = 2  //U1RTS output on RP68 (RD4)
+
+    /*Transmit ring buffer size, must be a power of 2*/
+#define UART1_TX_BUFFER_SIZE 512
+
+    /*Receive ring buffer size, must be a power of 2. Filled by the RX ISR so
+     *a busy main loop doesn't overrun the 4 deep hardware FIFO.*/
+#define UART1_RX_BUFFER_SIZE 256
+
+    extern volatile unsigned int UART1TxOverflowCount;
+    extern volatile unsigned int UART1RxOverrunCount;
+
     /*Public Funtions*/
-    void UART1Init(unsigned int baud);
+    void UART1Init(unsigned long baud);
     void UART1Enable();
     void UART1Disable();
     unsigned int UART1Read();
     unsigned int UART1ReadReady();
     void UART1Write(char data);
     unsigned int UART1WriteReady();
-    void UART1WriteStr(char * data, unsigned int length);
-    void UART1WriteStrNT(char * data);
+    unsigned int UART1WriteStr(char * data, unsigned int length);
+    unsigned int UART1WriteStrNT(char * data);
+    unsigned int UART1WriteSpace();
     void UART1EnableInterrupts();
     void UART1DisableInterrupts();
 
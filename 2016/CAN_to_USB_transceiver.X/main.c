@@ -7,12 +7,13 @@
 
 #include "UART.h"
 #include "CAN.h"
+#include "SLCAN.h"
 
 int main(void)
 {
-    UART1Init(9600);
+    UART1Init(UART1_BAUD);
     CAN1Init();
-    UART1WriteStrNT("Start\n");
+    SLCANInit();
     while (1)
     {
         CAN1CheckReceiveBuffer();
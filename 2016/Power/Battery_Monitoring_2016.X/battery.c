@@ -0,0 +1,174 @@
+/*
+ * File:   battery.c
+ * Author: Kevin
+ *
+ * Description: Oversampling, decimation and charge counting for the ADC
+ *              scan, see battery.h. BatterySweep() runs in the ADC
+ *              interrupt and only adds; the divides that turn readings into
+ *              millivolts are left to BatteryGetStatus() in the main loop,
+ *              except the current, which the charge count needs.
+ */
+
+#include <xc.h>
+#include "battery.h"
+
+#define BATT_IE IEC0bits.AD1IE
+
+/*mA seconds per permille of the capacity*/
+#define BATT_MAS_PER_PERMILLE ((long) BATT_CAPACITY_MAH * 36 / 10)
+
+/*LiPo cell resting voltage at 0%, 10% ... 100%*/
+static const unsigned int ocvMv[11] = {
+    3300, 3680, 3740, 3770, 3790, 3820, 3870, 3920, 3980, 4060, 4200
+};
+
+/*Interrupt side*/
+static uint32_t sums[BATT_SCAN_CHANNELS];
+static unsigned int irqCount;
+static uint32_t lastMs;
+static long partialMams; //mA ms not yet in usedMas
+
+/*Written by the ADC interrupt, read with it off*/
+static unsigned int reading[BATT_SCAN_CHANNELS];
+static long currentMa;
+static long usedMas;
+static unsigned int readings;
+
+static unsigned int tapMv(unsigned int tap, unsigned int vbg, unsigned int num, unsigned int den) {
+    if (vbg == 0) {
+        return 0;
+    }
+    //65535 * 1200 * 11 still fits, so divide once
+    return (unsigned int) ((uint32_t) tap * BATT_VBG_MV * num / ((uint32_t) vbg * den));
+}
+
+static long toMa(unsigned int current) {
+    return ((long) current - BATT_CURRENT_ZERO) * BATT_CURRENT_MA_NUM / BATT_CURRENT_MA_DEN;
+}
+
+/*State of charge of a resting cell, permille*/
+static unsigned int ocvPermille(unsigned int cellMv) {
+    unsigned int i;
+
+    if (cellMv <= ocvMv[0]) {
+        return 0;
+    }
+    for (i = 1; i < 11; i++) {
+        if (cellMv < ocvMv[i]) {
+            return (i - 1) * 100 + (unsigned int) ((uint32_t) (cellMv - ocvMv[i - 1]) * 100 / (ocvMv[i] - ocvMv[i - 1]));
+        }
+    }
+    return 1000;
+}
+
+void BatteryInit(void) {
+    unsigned int i;
+
+    BATT_IE = 0;
+    for (i = 0; i < BATT_SCAN_CHANNELS; i++) {
+        sums[i] = 0;
+        reading[i] = 0;
+    }
+    irqCount = 0;
+    lastMs = 0;
+    partialMams = 0;
+    currentMa = 0;
+    usedMas = 0;
+    readings = 0;
+    BATT_IE = 1;
+}
+
+void BatterySweep(const volatile unsigned int* results, uint32_t nowMs) {
+    unsigned int sweep, ch;
+
+    for (sweep = 0; sweep < BATT_SWEEPS_PER_IRQ; sweep++) {
+        for (ch = 0; ch < BATT_SCAN_CHANNELS; ch++) {
+            sums[ch] += *results++;
+        }
+    }
+    if (++irqCount < BATT_DECIMATE) {
+        return;
+    }
+    irqCount = 0;
+
+    //decimate to counts * 16
+    for (ch = 0; ch < BATT_SCAN_CHANNELS; ch++) {
+        reading[ch] = (unsigned int) (sums[ch] * 16 / BATT_SAMPLES);
+        sums[ch] = 0;
+    }
+
+    currentMa = toMa(reading[BATT_RESULT_CURRENT]);
+    if (readings == 0) {
+        //the resting voltage at power up says where the count starts
+        unsigned int packMv = tapMv(reading[BATT_RESULT_PACK], reading[BATT_RESULT_VBG],
+                BATT_PACK_DIV_NUM, BATT_PACK_DIV_DEN);
+        unsigned int cellMv = packMv / (2 * BATT_CELLS_PER_TAP);
+        usedMas = BATT_MAS_PER_PERMILLE * (1000 - ocvPermille(cellMv));
+    } else {
+        partialMams += currentMa * (long) (nowMs - lastMs);
+        usedMas += partialMams / 1000;
+        partialMams %= 1000;
+    }
+    lastMs = nowMs;
+    readings++;
+}
+
+void BatteryGetStatus(BatteryStatus* status) {
+    unsigned int r[BATT_SCAN_CHANNELS];
+    unsigned int ch, cellMv;
+    long used;
+
+    BATT_IE = 0;
+    for (ch = 0; ch < BATT_SCAN_CHANNELS; ch++) {
+        r[ch] = reading[ch];
+    }
+    status->currentMa = currentMa;
+    status->usedMas = usedMas;
+    status->readings = readings;
+    BATT_IE = 1;
+
+    status->lowerMv = tapMv(r[BATT_RESULT_LOWER], r[BATT_RESULT_VBG], BATT_LOWER_DIV_NUM, BATT_LOWER_DIV_DEN);
+    status->packMv = tapMv(r[BATT_RESULT_PACK], r[BATT_RESULT_VBG], BATT_PACK_DIV_NUM, BATT_PACK_DIV_DEN);
+    status->upperMv = status->packMv > status->lowerMv ? status->packMv - status->lowerMv : 0;
+
+    used = status->usedMas;
+    if (used <= 0) {
+        status->socPermille = 1000;
+    } else if (used >= BATT_MAS_PER_PERMILLE * 1000) {
+        status->socPermille = 0;
+    } else {
+        status->socPermille = 1000 - (unsigned int) (used / BATT_MAS_PER_PERMILLE);
+    }
+
+    status->flags = 0;
+    if (status->readings == 0) {
+        status->flags |= BATT_FLAG_NO_DATA;
+        return;
+    }
+    //the weaker group of cells
+    cellMv = (status->lowerMv < status->upperMv ? status->lowerMv : status->upperMv) / BATT_CELLS_PER_TAP;
+    if (cellMv < BATT_CELL_LOW_MV) {
+        status->flags |= BATT_FLAG_LOW;
+    }
+    if (cellMv < BATT_CELL_CRITICAL_MV) {
+        status->flags |= BATT_FLAG_CRITICAL;
+    }
+}
+
+//CANMSG_BATTSTATUS payload, see battery.h
+void BatteryGetFrame(unsigned int* data, unsigned int flags) {
+    BatteryStatus status;
+    long centiamps;
+
+    BatteryGetStatus(&status);
+    centiamps = status.currentMa / 10;
+    if (centiamps > 32767) {
+        centiamps = 32767;
+    } else if (centiamps < -32768) {
+        centiamps = -32768;
+    }
+    data[0] = status.packMv;
+    data[1] = (unsigned int) (int) centiamps;
+    data[2] = (unsigned int) (int) (status.usedMas / 3600);
+    data[3] = (status.socPermille / 10) | ((status.flags | flags) << 8);
+}
@@ -0,0 +1,113 @@
+/*
+ * File:   battery.h
+ * Author: Kevin
+ *
+ * Description: Pack voltage, current and state of charge for the 2016 power
+ *              board. The ADC scans its inputs on its own, auto sampling in
+ *              channel order, and interrupts every BATT_SWEEPS_PER_IRQ
+ *              sweeps with the results in one half of its buffer. The ADC
+ *              interrupt (adc1.c) hands them to BatterySweep(), which adds
+ *              them up and every BATT_DECIMATE interrupts publishes the
+ *              oversampled averages and counts the charge used since the
+ *              last. Nothing is read ad hoc from the main loop.
+ *
+ *              The charge used starts from the resting pack voltage, through
+ *              a LiPo open circuit voltage table, then follows the current.
+ *
+ *              CANMSG_BATTSTATUS frame, little endian words:
+ *                pack      mV
+ *                current   int, 10mA, out of the pack is positive
+ *                used      int, mAh used from full
+ *                soc/flags low byte state of charge %, high byte BATT_FLAG_
+ */
+
+#ifndef BATTERY_H
+#define	BATTERY_H
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*Scan list. The ADC takes the selected inputs in channel number order, so
+ *this is the order of the results too. AN0 is BattCurrent, AN2 (RB0) and
+ *AN3 (RB1) are the divider taps at the top of cells 1-3 and of the pack.
+ *The band gap is scanned so the taps are measured against it, not AVDD.*/
+#define BATT_SCAN_CSSL          0x000D  //AN0, AN2, AN3
+#define BATT_SCAN_CSSH          0x0400  //CSS26, VBG
+#define BATT_RESULT_CURRENT     0
+#define BATT_RESULT_LOWER       1
+#define BATT_RESULT_PACK        2
+#define BATT_RESULT_VBG         3
+#define BATT_SCAN_CHANNELS      4
+
+/*Each interrupt brings BATT_SWEEPS_PER_IRQ sweeps, half the ADC buffer.
+ *BATT_DECIMATE interrupts make one reading of BATT_SAMPLES conversions per
+ *input, at 720us a conversion (see ADC1_Initialize) that's every 92ms.*/
+#define BATT_SWEEPS_PER_IRQ     2
+#define BATT_DECIMATE           16
+#define BATT_SAMPLES            (BATT_SWEEPS_PER_IRQ * BATT_DECIMATE)
+#define BATT_IRQ_RESULTS        (BATT_SCAN_CHANNELS * BATT_SWEEPS_PER_IRQ)
+
+/*BUFM splits the 18 word ADC1BUF0-17 into halves of 9: ADC1BUF0-8 and
+ *ADC1BUF9-17. A half has to hold one interrupt's results.*/
+#define BATT_ADC_BUF_WORDS      18
+#define BATT_ADC_HALF_WORDS     (BATT_ADC_BUF_WORDS / 2)
+#if BATT_IRQ_RESULTS > BATT_ADC_HALF_WORDS
+#error "BATT_IRQ_RESULTS doesn't fit in half the ADC buffer"
+#endif
+
+/*The half the ADC has just filled, from ADC1BUF0 and BUFS: BUFS set means
+ *it is filling the second half now, so the first is done*/
+#define BATT_ADC_DONE_HALF(buf0, bufs) \
+    ((bufs) ? (buf0) : (buf0) + BATT_ADC_HALF_WORDS)
+
+/*Calibration, from the board's resistors and sense amplifier; check them
+ *against a meter. Readings are 12 bit ADC counts * 16, the sum of the 32
+ *samples halved.*/
+#define BATT_VBG_MV             1200    //band gap
+#define BATT_LOWER_DIV_NUM      6       //lower tap divider, (top + bottom) / bottom
+#define BATT_LOWER_DIV_DEN      1
+#define BATT_PACK_DIV_NUM       11      //pack tap divider
+#define BATT_PACK_DIV_DEN       1
+#define BATT_CURRENT_ZERO       32760   //BattCurrent reading at 0A
+#define BATT_CURRENT_MA_NUM     25      //mA per reading count
+#define BATT_CURRENT_MA_DEN     4
+#define BATT_CELLS_PER_TAP      3
+#define BATT_CAPACITY_MAH       5000
+
+#define BATT_CELL_LOW_MV        3400
+#define BATT_CELL_CRITICAL_MV   3200
+
+#define BATT_FLAG_LOW           0x01    //a cell group averages under BATT_CELL_LOW_MV
+#define BATT_FLAG_CRITICAL      0x02    //under BATT_CELL_CRITICAL_MV
+#define BATT_FLAG_ESTOP         0x04    //set by main, E-Stop pressed
+#define BATT_FLAG_NO_DATA       0x80    //no reading yet
+
+typedef struct {
+    unsigned int packMv;
+    unsigned int lowerMv;       //cells 1-3
+    unsigned int upperMv;       //cells 4-6
+    long currentMa;             //out of the pack is positive
+    long usedMas;               //mA seconds used from full
+    unsigned int socPermille;
+    unsigned int flags;
+    unsigned int readings;      //published so far
+} BatteryStatus;
+
+void BatteryInit(void);
+
+/*ADC interrupt: one half buffer of results, and TMR3_ms_Timer()*/
+void BatterySweep(const volatile unsigned int* results, uint32_t nowMs);
+
+void BatteryGetStatus(BatteryStatus* status);
+
+/*CANMSG_BATTSTATUS payload, 4 words; flags are added to BATT_FLAG_ bits*/
+void BatteryGetFrame(unsigned int* data, unsigned int flags);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BATTERY_H */
@@ -49,6 +49,11 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 
 #include "mcc_generated_files/mcc.h"
 #include <libpic30.h>
+#include "battery.h"
+#include "mcp2515.h"
+#include "../../CAN_to_USB_transceiver.X/CAN.h"
+
+#define BATT_FRAME_PERIOD_MS 100
 
 /*
                          Main application
@@ -76,8 +81,22 @@ int main(void)
     uint16_t switchPeriod = 5000;
     */
     
+    // The ADC has been scanning since SYSTEM_Initialize(); the frames go
+    // out on the grid of BATT_FRAME_PERIOD_MS
+    MCP2515Init();
+    uint32_t nextFrame = TMR3_ms_Timer();
+    unsigned int battFrame[4];
+    unsigned int battFlags = 0;
+    
     while (1)
     {
+        if ((int32_t) (TMR3_ms_Timer() - nextFrame) >= 0)
+        {
+            nextFrame += BATT_FRAME_PERIOD_MS;
+            BatteryGetFrame(battFrame, battFlags);
+            MCP2515Transmit(CANMSG_BATTSTATUS, 8, battFrame);
+        }
+        
         //regulatorSwitch_SetHigh();
         // Handle the E-Stop
         // Check if the normally open port of the E-Stop is pressed
@@ -89,6 +108,7 @@ int main(void)
             motorSwitch_SetLow(); 
             regulatorSwitch_SetLow();
             Set_Debug_Message(DEBUG_LED_MESSAGE_5);
+            battFlags = BATT_FLAG_ESTOP;
         }
         // The E-Stop isn't pressed
         else 
@@ -97,6 +117,7 @@ int main(void)
             motorSwitch_SetHigh();
             regulatorSwitch_SetHigh();
             Set_Debug_Message(DEBUG_LED_MESSAGE_2);
+            battFlags = 0;
         }
     }
 
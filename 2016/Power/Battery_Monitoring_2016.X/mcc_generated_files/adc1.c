@@ -51,6 +51,8 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 
 #include <xc.h>
 #include "adc1.h"
+#include "tmr3.h"
+#include "../battery.h"
 
 /**
   Section: Data Type Definitions
@@ -80,33 +82,46 @@ static ADC_OBJECT adc1_obj;
 
 
 void ADC1_Initialize(void) {
-    // ADSIDL disabled; ASAM disabled; FORM Absolute decimal result, unsigned, right-justified; MODE12 enabled; ADON disabled; DONE disabled; SAMP disabled; SSRC Clearing sample bit ends sampling and starts conversion; 
+    // ADSIDL disabled; ASAM enabled; FORM Absolute decimal result, unsigned, right-justified; MODE12 enabled; ADON disabled; DONE disabled; SAMP disabled; SSRC Internal counter ends sampling and starts conversion; 
 
-    AD1CON1 = 0x0400;
+    AD1CON1 = 0x0474;
 
-    // OFFCAL disabled; ALTS disabled; PVCFG AVDD; BUFM disabled; BUFREGEN disabled; SMPI 1; CSCNA disabled; NVCFG AVSS; 
+    // OFFCAL disabled; ALTS disabled; PVCFG AVDD; BUFM enabled; BUFREGEN disabled; SMPI 8; CSCNA enabled; NVCFG AVSS; 
 
-    AD1CON2 = 0x0000;
+    AD1CON2 = 0x041E;
 
-    // ADRC RC clock; SAMC 14; EXTSAM disabled; ADCS 0; 
+    // ADRC FOSC/2; SAMC 31; EXTSAM disabled; ADCS 3; 
+    // TAD 16us: 31 TAD sampling and 14 converting, 720us a conversion
 
-    AD1CON3 = 0x8E00;
+    AD1CON3 = 0x1F03;
 
     // CH0SA AN0; CH0SB AN0; CH0NB AVSS; CH0NA AVSS; 
 
     AD1CHS = 0x0000;
 
-    // CSS3 disabled; CSS4 disabled; CSS5 disabled; CSS6 disabled; CSS7 disabled; CSS8 disabled; CSS9 disabled; CSS10 disabled; CSS11 disabled; CSS0 disabled; CSS12 disabled; CSS13 disabled; CSS2 disabled; CSS14 disabled; CSS1 disabled; CSS15 disabled; 
+    // Scan AN0, AN2, AN3, see battery.h
 
-    AD1CSSL = 0x0000;
+    AD1CSSL = BATT_SCAN_CSSL;
 
-    // CSS16 disabled; CSS29 disabled; CSS17 disabled; CSS27 disabled; CSS28 disabled; CSS30 disabled; CSS26 disabled; 
+    // Scan CSS26 (VBG), see battery.h
 
-    AD1CSSH = 0x0000;
+    AD1CSSH = BATT_SCAN_CSSH;
 
 
     adc1_obj.intSample = AD1CON2bits.SMPI;
 
+    BatteryInit();
+    IFS0bits.AD1IF = false;
+    IEC0bits.AD1IE = true;
+    AD1CON1bits.ADON = 1;
+
+}
+
+/* Each interrupt the ADC has filled one half of its buffer and moved on to
+   the other: BUFS says which it is filling now. ADC1BUF0-17 are contiguous. */
+void __attribute__((interrupt, no_auto_psv)) _ADC1Interrupt(void) {
+    BatterySweep(BATT_ADC_DONE_HALF(&ADC1BUF0, AD1CON2bits.BUFS), TMR3_ms_Timer());
+    IFS0bits.AD1IF = false;
 }
 
 /**
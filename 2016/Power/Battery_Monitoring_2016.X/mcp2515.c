@@ -0,0 +1,125 @@
+/*
+ * File:   mcp2515.c
+ * Author: Kevin
+ *
+ * Description: See mcp2515.h. SPI mode 0,0, most significant bit first.
+ */
+
+#define FCY _XTAL_FREQ
+
+#include "mcc_generated_files/mcc.h"
+#include <libpic30.h>
+#include "mcp2515.h"
+
+#define MCP_RESET       0xC0
+#define MCP_READ        0x03
+#define MCP_WRITE       0x02
+#define MCP_LOAD_TXB0   0x40    //from TXB0SIDH
+#define MCP_RTS_TXB0    0x81
+#define MCP_READ_STATUS 0xA0
+#define MCP_STATUS_TXB0_BUSY 0x04
+
+#define MCP_CANSTAT     0x0E
+#define MCP_CANCTRL     0x0F
+#define MCP_CNF3        0x28
+
+#define MCP_MODE_MASK   0xE0
+#define MCP_MODE_NORMAL 0x00
+
+unsigned int MCP2515DroppedCount = 0;
+
+static unsigned char spiTransfer(unsigned char out) {
+    unsigned char in = 0;
+    unsigned char bit;
+
+    for (bit = 0; bit < 8; bit++) {
+        if (out & 0x80) {
+            CAN_MOSI_SetHigh();
+        } else {
+            CAN_MOSI_SetLow();
+        }
+        out <<= 1;
+        CAN_SCK_SetHigh();
+        in = (in << 1) | CAN_MISO_GetValue();
+        CAN_SCK_SetLow();
+    }
+    return in;
+}
+
+static unsigned char readRegister(unsigned char address) {
+    unsigned char value;
+
+    CAN_CS_SetLow();
+    spiTransfer(MCP_READ);
+    spiTransfer(address);
+    value = spiTransfer(0);
+    CAN_CS_SetHigh();
+    return value;
+}
+
+int MCP2515Init(void) {
+    CAN_MISO_SetDigitalInput();
+    CAN_SCK_SetLow();
+    CAN_CS_SetHigh();
+    //transceiver out of standby
+    CAN_STBY_SetLow();
+
+    CAN_CS_SetLow();
+    spiTransfer(MCP_RESET);
+    CAN_CS_SetHigh();
+    //comes back up in configuration mode
+    __delay_ms(1);
+
+    //CNF3, CNF2 and CNF1 are consecutive
+    CAN_CS_SetLow();
+    spiTransfer(MCP_WRITE);
+    spiTransfer(MCP_CNF3);
+    spiTransfer(MCP2515_CNF3);
+    spiTransfer(MCP2515_CNF2);
+    spiTransfer(MCP2515_CNF1);
+    CAN_CS_SetHigh();
+
+    //normal mode, CLKOUT off
+    CAN_CS_SetLow();
+    spiTransfer(MCP_WRITE);
+    spiTransfer(MCP_CANCTRL);
+    spiTransfer(MCP_MODE_NORMAL);
+    CAN_CS_SetHigh();
+
+    return (readRegister(MCP_CANSTAT) & MCP_MODE_MASK) == MCP_MODE_NORMAL ? 0 : -1;
+}
+
+int MCP2515Transmit(unsigned int SID, unsigned int length, unsigned int* data) {
+    unsigned int i;
+    unsigned char status;
+
+    CAN_CS_SetLow();
+    spiTransfer(MCP_READ_STATUS);
+    status = spiTransfer(0);
+    CAN_CS_SetHigh();
+    if (status & MCP_STATUS_TXB0_BUSY) {
+        MCP2515DroppedCount++;
+        return -1;
+    }
+
+    if (length > 8) {
+        length = 8;
+    }
+    //SIDH, SIDL, EID8, EID0, DLC, then the data, little endian words
+    CAN_CS_SetLow();
+    spiTransfer(MCP_LOAD_TXB0);
+    spiTransfer(SID >> 3);
+    spiTransfer((SID & 0x07) << 5);
+    spiTransfer(0);
+    spiTransfer(0);
+    spiTransfer(length);
+    for (i = 0; i < length; i++) {
+        spiTransfer(i & 1 ? data[i / 2] >> 8 : data[i / 2] & 0xFF);
+    }
+    CAN_CS_SetHigh();
+
+    CAN_CS_SetLow();
+    spiTransfer(MCP_RTS_TXB0);
+    CAN_CS_SetHigh();
+    return 0;
+}
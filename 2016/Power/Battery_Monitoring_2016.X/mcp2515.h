@@ -0,0 +1,40 @@
+/*
+ * File:   mcp2515.h
+ * Author: Kevin
+ *
+ * Description: Transmit only driver for the board's MCP2515 CAN controller,
+ *              over the CAN_SCK/CAN_MOSI/CAN_MISO/CAN_CS pins (bit banged,
+ *              the pin manager leaves them as I/O). Only transmit buffer 0
+ *              is used, and a frame is dropped rather than waited for if it
+ *              is still busy: the power board only broadcasts.
+ *
+ *              Bit timing matches CAN1Init() on the dsPIC boards, 8 time
+ *              quanta a bit at 230.4kbit/s, for a 7.3728MHz MCP2515 crystal.
+ */
+
+#ifndef MCP2515_H
+#define	MCP2515_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define MCP2515_CNF1    0x41    //SJW 2 Tq, BRP 1: Tq = 4 / 7.3728MHz
+#define MCP2515_CNF2    0xD1    //PHSEG1 3 Tq, PRSEG 2 Tq, sampled 3 times
+#define MCP2515_CNF3    0x01    //PHSEG2 2 Tq
+
+/*Resets the controller and puts it on the bus; returns 0, or -1 if it
+ *didn't come out of configuration mode*/
+int MCP2515Init(void);
+
+/*Same arguments as CAN1Transmit() on the dsPIC boards. Returns 0, or -1 if
+ *the last frame hasn't gone yet and this one was dropped.*/
+int MCP2515Transmit(unsigned int SID, unsigned int length, unsigned int* data);
+
+extern unsigned int MCP2515DroppedCount;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* MCP2515_H */
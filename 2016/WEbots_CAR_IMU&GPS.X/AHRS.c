@@ -0,0 +1,475 @@
+/*
+ * File:   AHRS.c
+ * Author: Michael Buchel
+ *
+ * MPU9250 attitude filter, see AHRS.h
+ *
+ * Mahony filter: the error between the measured and predicted gravity
+ * direction (their cross product) and the heading error from the field are
+ * fed back into the gyro rates through a PI controller, and the rates are
+ * integrated into the quaternion. All of it in Q1.30, no floating point in
+ * the interrupt.
+ */
+
+#include "AHRS.h"
+#include "MPU9250.h"
+
+#define AK8963_HOFL 0x08            //ST2 magnetic sensor overflow
+#define AK8963_CONTINUOUS_100HZ 0x16
+#define AK8963_FUSE_ROM 0x0F
+#define AK8963_POWER_DOWN 0x00
+
+#define Q30_HALF (Q30_ONE / 2)
+
+//Gyro LSB to half the rotation in one sample, Q1.30 per LSB scaled by 2^16
+#define GYRO_HALF_STEP ((int32_t) (3.14159265 / 180.0 / AHRS_GYRO_LSB_PER_DPS \
+        / (2.0 * AHRS_SAMPLE_HZ) * 70368744177664.0 + 0.5))
+//Gain * dt / 2 and dt / 2 in Q1.30, gain * dt for the integral
+#define HALF_DT(gain) ((int32_t) ((gain) / (2.0 * AHRS_SAMPLE_HZ) * 1073741824.0 + 0.5))
+#define KI_DT ((int32_t) (AHRS_KI / AHRS_SAMPLE_HZ * 1073741824.0 + 0.5))
+#define INTEGRAL_LIMIT Q30_FROM_DOUBLE(0.25)    //rad/s, well past the gyro bias spec
+//Squared horizontal part of the unit field in Q2.29, below it heading is noise
+#define MAG_MIN_HORIZONTAL ((uint32_t) (0.01 * 536870912.0))
+
+#define EDGE_TIMES 32               //INT pulse times kept, more than a full FIFO, power of 2
+
+#ifdef AHRS_TIMER_SAMPLING
+#define UPDATE_IE IEC0bits.T1IE
+#else
+#define UPDATE_IE IEC2bits.DMA3IE
+#endif
+
+//yaw in Q16.16 radians to 0.01 degrees, with fixedMul shift 31
+#define HEADING_SCALE ((int32_t) (18000.0 / 3.14159265 * 32768.0 + 0.5))
+
+volatile unsigned int AHRSSampleCount = 0;
+volatile unsigned int AHRSMagSkipCount = 0;
+volatile unsigned int AHRSFifoDropCount = 0;
+
+static quaternionFixed attitude;
+static q30_t integral[3];
+static char aligned;                //attitude set from a sample yet
+static int magAdjust[3];            //AK8963 sensitivity adjustment, Q14
+
+static quaternionFixed published;
+static unsigned long publishedTime;
+static unsigned int publishCount;
+static volatile char publishReady = 0;
+
+#ifdef AHRS_TIMER_SAMPLING
+static volatile unsigned long sampleTime;   //Timer 1 start of the current period
+#else
+static volatile unsigned int timerOverflow = 0;
+/*INT pulse times, written by INT1 and read back by DMA3 for the packets of
+ *a drain. A drain is at most a FIFO full old, so those stay put.*/
+static unsigned long edgeTimes[EDGE_TIMES];
+static volatile unsigned char edgeIndex;
+static volatile unsigned char pending;      //samples since the last drain
+static volatile char draining;              //DMA3 owns SPI1 and fifoBuffer
+static char fifoSynced;                     //FIFO packets line up with edgeTimes
+static unsigned char drainEdge;             //edgeIndex of the newest packet
+static unsigned char drainPackets;          //packets to run, 0 to throw it away
+static unsigned char fifoBuffer[MPU_FIFO_SIZE];
+#endif
+
+//Writes one AK8963 register through the MPU's I2C master
+static void writeAK8963(unsigned char reg, unsigned char value) {
+    WriteReg(MPUREG_I2C_SLV0_ADDR, AK8963_I2C_ADDR);
+    WriteReg(MPUREG_I2C_SLV0_REG, reg);
+    WriteReg(MPUREG_I2C_SLV0_DO, value);
+    WriteReg(MPUREG_I2C_SLV0_CTRL, 0x81);
+    __delay_ms(10);
+}
+
+//Starts the I2C master copying count AK8963 registers from reg into EXT_SENS_DATA every sample
+static void readAK8963(unsigned char reg, unsigned char count) {
+    WriteReg(MPUREG_I2C_SLV0_ADDR, AK8963_I2C_ADDR | READ_FLAG);
+    WriteReg(MPUREG_I2C_SLV0_REG, reg);
+    WriteReg(MPUREG_I2C_SLV0_CTRL, 0x80 | count);
+    __delay_ms(10);
+}
+
+void AHRSReset(void) {
+    init1Fixed(&attitude);
+    integral[0] = integral[1] = integral[2] = 0;
+    aligned = 0;
+    published = attitude;
+    publishedTime = 0;
+    publishCount = 0;
+    publishReady = 0;
+    AHRSSampleCount = 0;
+    AHRSMagSkipCount = 0;
+    AHRSFifoDropCount = 0;
+}
+
+//Sets up the MPU9250 to sample at AHRS_SAMPLE_HZ and starts Timer 1 and the interrupts, after init_SPI
+void AHRS_init(void) {
+    unsigned char asa[3];
+    int i;
+
+    WriteReg(MPUREG_PWR_MGMT_1, BIT_H_RESET);
+    __delay_ms(100);
+    WriteReg(MPUREG_PWR_MGMT_1, MPU_CLK_SEL_PLLGYROX);
+    WriteReg(MPUREG_PWR_MGMT_2, 0x00);
+    WriteReg(MPUREG_CONFIG, BITS_DLPF_CFG_188HZ);   //1kHz internal rate
+    WriteReg(MPUREG_SMPLRT_DIV, 1000 / AHRS_SAMPLE_HZ - 1);
+    WriteReg(MPUREG_GYRO_CONFIG, BITS_FS_500DPS);
+    WriteReg(MPUREG_ACCEL_CONFIG, BITS_FS_4G);
+    WriteReg(MPUREG_ACCEL_CONFIG_2, BITS_DLPF_CFG_188HZ);
+
+    //I2C master at 400kHz for the AK8963
+    WriteReg(MPUREG_USER_CTRL, 0x20);
+    WriteReg(MPUREG_I2C_MST_CTRL, 0x0D);
+    writeAK8963(AK8963_CNTL2, 0x01);                //Reset
+
+    //Sensitivity adjustment is only readable in fuse ROM mode
+    writeAK8963(AK8963_CNTL1, AK8963_FUSE_ROM);
+    readAK8963(AK8963_ASAX, 3);
+    ReadRegs(MPUREG_EXT_SENS_DATA_00, asa, 3);
+    for (i = 0; i < 3; i++) {
+        magAdjust[i] = (1 << 14) + (((int) asa[i] - 128) << 6);
+    }
+    writeAK8963(AK8963_CNTL1, AK8963_POWER_DOWN);
+    writeAK8963(AK8963_CNTL1, AK8963_CONTINUOUS_100HZ);
+
+    //From now on every sample also copies HXL..ST2, reading ST2 unlatches the next one
+    readAK8963(AK8963_HXL, 7);
+
+#ifndef AHRS_TIMER_SAMPLING
+    //FIFO gets accel, temperature, gyro and SLV0 in register order, INT pulses 50us per sample
+    WriteReg(MPUREG_FIFO_EN, BITS_FIFO_TEMP_GYRO_ACCEL | BIT_FIFO_SLV0);
+    WriteReg(MPUREG_INT_PIN_CFG, 0x00);
+    WriteReg(MPUREG_INT_ENABLE, BIT_RAW_RDY_EN);
+    WriteReg(MPUREG_USER_CTRL, BIT_I2C_MST_EN | BIT_FIFO_RST);
+    WriteReg(MPUREG_USER_CTRL, BIT_I2C_MST_EN | BIT_FIFO_EN);
+#endif
+    set_SPI_fast();
+
+    AHRSReset();
+
+    //Timer 1, 1:64: sample rate, or free running for the timestamps
+    T1CON = 0;
+    T1CONbits.TCKPS = 0b10;
+    TMR1 = 0;
+#ifdef AHRS_TIMER_SAMPLING
+    sampleTime = 0;
+    PR1 = (unsigned int) (AHRS_TIMER_HZ / AHRS_SAMPLE_HZ - 1);
+    IPC0bits.T1IP = 4;
+#else
+    timerOverflow = 0;
+    PR1 = 0xFFFF;
+    IPC0bits.T1IP = 6;                      //above INT1 so overflows are never late
+#endif
+    IFS0bits.T1IF = 0;
+    IEC0bits.T1IE = 1;
+    T1CONbits.TON = 1;
+
+#ifndef AHRS_TIMER_SAMPLING
+    //WriteReg's delays have let the FIFO fill, the first drain throws it away
+    edgeIndex = 0;
+    pending = 0;
+    draining = 0;
+    fifoSynced = 0;
+    IPC9bits.DMA3IP = 4;
+    IFS2bits.DMA3IF = 0;
+    IEC2bits.DMA3IE = 1;
+
+    //INT1 on the MPU's INT pin, rising edge
+    RPINR0bits.INT1R = AHRS_INT_RP;
+    INTCON2bits.INT1EP = 0;
+    IPC5bits.INT1IP = 5;
+    IFS1bits.INT1IF = 0;
+    IEC1bits.INT1IE = 1;
+#endif
+}
+
+/*First attitude straight from the measurements, instead of waiting for the
+ *filter to pull in a large error: tilt from gravity, then heading from the
+ *tilt corrected field. a and m are unit vectors, m may be 0.*/
+static void align(const vectorFixed* a, const vectorFixed* m) {
+    vectorFixed up = {0, 0, Q16_ONE};
+    vectorFixed h;
+    quaternionFixed tilt, heading;
+    q30_t hx, hy, hz, length;
+
+    init4Fixed(&tilt, a, &up);
+    if (m->x == 0 && m->y == 0 && m->z == 0) {
+        attitude = tilt;
+        return;
+    }
+    rotateVectorFixed(&tilt, m, &h);
+    h.z = 0;
+    normalizeQ30Fixed(&h, &hx, &hy, &hz);
+    //Rotation about z taking h onto north, from whichever half angle form is not near 0/0
+    length = Q30_ONE;
+    if (hx >= 0) {
+        init2Fixed(&heading, length + hx, 0, 0, -hy);
+    } else {
+        init2Fixed(&heading, -hy, 0, 0, length - hx);
+    }
+    normalizeQuatFixed(&heading);
+    multiplyQuatFixed(&heading, &tilt, &attitude);
+}
+
+void AHRSUpdate(const unsigned char* burst, unsigned long time) {
+    vectorFixed accel, mag;
+    q30_t w, x, y, z;
+    q30_t ww, xx, yy, zz, wx, wy, wz, xy, xz, yz;
+    q30_t a[3], m[3], v[3], e[3];
+    q30_t hx, hy;
+    int32_t h[3];
+    int magValid;
+    int i;
+
+    //Accelerometer, big endian
+    accel.x = (int16_t) ((burst[0] << 8) | burst[1]);
+    accel.y = (int16_t) ((burst[2] << 8) | burst[3]);
+    accel.z = (int16_t) ((burst[4] << 8) | burst[5]);
+    //AK8963, little endian, its X and Y are the MPU's Y and X and its Z points the other way
+    mag.y = ((long) (int16_t) ((burst[15] << 8) | burst[14]) * magAdjust[0]) >> 14;
+    mag.x = ((long) (int16_t) ((burst[17] << 8) | burst[16]) * magAdjust[1]) >> 14;
+    mag.z = -(((long) (int16_t) ((burst[19] << 8) | burst[18]) * magAdjust[2]) >> 14);
+    magValid = !(burst[20] & AK8963_HOFL) && (mag.x != 0 || mag.y != 0 || mag.z != 0);
+    if (!magValid) {
+        AHRSMagSkipCount++;
+    }
+
+    if (!aligned && (accel.x != 0 || accel.y != 0 || accel.z != 0)) {
+        vectorFixed magUnit = {0, 0, 0};
+        if (magValid) {
+            normalizeFixed(&mag, &magUnit);
+        }
+        align(&accel, &magUnit);
+        aligned = 1;
+    }
+
+    w = attitude.w;
+    x = attitude.x;
+    y = attitude.y;
+    z = attitude.z;
+    ww = mulQ30(w, w);
+    xx = mulQ30(x, x);
+    yy = mulQ30(y, y);
+    zz = mulQ30(z, z);
+    wx = mulQ30(w, x);
+    wy = mulQ30(w, y);
+    wz = mulQ30(w, z);
+    xy = mulQ30(x, y);
+    xz = mulQ30(x, z);
+    yz = mulQ30(y, z);
+    e[0] = e[1] = e[2] = 0;
+
+    //Up in the body frame, as the current attitude predicts it
+    v[0] = 2 * (xz - wy);
+    v[1] = 2 * (wx + yz);
+    v[2] = ww - xx - yy + zz;
+
+    //Nothing to correct with in free fall
+    if (accel.x != 0 || accel.y != 0 || accel.z != 0) {
+        normalizeQ30Fixed(&accel, &a[0], &a[1], &a[2]);
+        e[0] = mulQ30(a[1], v[2]) - mulQ30(a[2], v[1]);
+        e[1] = mulQ30(a[2], v[0]) - mulQ30(a[0], v[2]);
+        e[2] = mulQ30(a[0], v[1]) - mulQ30(a[1], v[0]);
+    }
+
+    /*Field only corrects heading: the angle of its horizontal part from
+     *north, about the up axis, so the dip and any field disturbance can't
+     *tilt the attitude and the heading gain doesn't shrink with the dip*/
+    if (magValid) {
+        uint32_t horizontal;
+        normalizeQ30Fixed(&mag, &m[0], &m[1], &m[2]);
+        //Field in the earth frame, north and west parts
+        hx = fixedMul(m[0], Q30_HALF - yy - zz, 29) + fixedMul(m[1], xy - wz, 29) + fixedMul(m[2], xz + wy, 29);
+        hy = fixedMul(m[0], xy + wz, 29) + fixedMul(m[1], Q30_HALF - xx - zz, 29) + fixedMul(m[2], yz - wx, 29);
+        horizontal = (uint32_t) (fixedMul(hx, hx, 31) + fixedMul(hy, hy, 31));
+        if (horizontal > MAG_MIN_HORIZONTAL) {
+            int exponent;
+            int32_t r = fixedRsqrt(horizontal, 29, &exponent);
+            //sin of the heading error, hy / |h|
+            q30_t heading = fixedMul(hy, r, 28);
+            heading = exponent >= 0 ? heading << exponent : heading >> -exponent;
+            e[0] -= mulQ30(heading, v[0]);
+            e[1] -= mulQ30(heading, v[1]);
+            e[2] -= mulQ30(heading, v[2]);
+        }
+    }
+
+    //Gyro plus feedback, as half the rotation over this sample
+    for (i = 0; i < 3; i++) {
+        int16_t gyro = (int16_t) ((burst[8 + 2 * i] << 8) | burst[9 + 2 * i]);
+        if (AHRS_KI > 0) {
+            integral[i] += fixedMul(e[i], KI_DT, 30);
+            if (integral[i] > INTEGRAL_LIMIT) {
+                integral[i] = INTEGRAL_LIMIT;
+            } else if (integral[i] < -INTEGRAL_LIMIT) {
+                integral[i] = -INTEGRAL_LIMIT;
+            }
+        }
+        h[i] = fixedMul(gyro, GYRO_HALF_STEP, 16) + fixedMul(e[i], HALF_DT(AHRS_KP), 30)
+                + fixedMul(integral[i], HALF_DT(1.0), 30);
+    }
+
+    //q += q * (0, h), then back to unit length
+    attitude.w = w - mulQ30(x, h[0]) - mulQ30(y, h[1]) - mulQ30(z, h[2]);
+    attitude.x = x + mulQ30(w, h[0]) + mulQ30(y, h[2]) - mulQ30(z, h[1]);
+    attitude.y = y + mulQ30(w, h[1]) - mulQ30(x, h[2]) + mulQ30(z, h[0]);
+    attitude.z = z + mulQ30(w, h[2]) + mulQ30(x, h[1]) - mulQ30(y, h[0]);
+    normalizeQuatFixed(&attitude);
+
+    AHRSSampleCount++;
+    if (++publishCount >= AHRS_PUBLISH_DIVIDER) {
+        publishCount = 0;
+        published = attitude;
+        publishedTime = time;
+        publishReady = 1;
+    }
+}
+
+#ifdef AHRS_TIMER_SAMPLING
+/*Timer 1 ISR, one sample. The MPU samples on its own clock at the same
+ *rate, so now and then a sample is read twice or skipped.*/
+void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void) {
+    unsigned char burst[AHRS_BURST_BYTES];
+
+    sampleTime += AHRS_TIMER_HZ / AHRS_SAMPLE_HZ;
+    ReadRegs(MPUREG_ACCEL_XOUT_H, burst, AHRS_BURST_BYTES);
+    AHRSUpdate(burst, sampleTime);
+    IFS0bits.T1IF = 0;
+}
+
+unsigned long AHRSTimeNow(void) {
+    unsigned long time;
+    unsigned int now;
+    do {
+        time = sampleTime;
+        now = TMR1;
+    } while (time != sampleTime);
+    return time + now;
+}
+#else
+//Timer 1 ISR, extends the timestamp timebase
+void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void) {
+    timerOverflow++;
+    IFS0bits.T1IF = 0;
+}
+
+unsigned long AHRSTimeNow(void) {
+    unsigned int overflow;
+    unsigned int now;
+    do {
+        overflow = timerOverflow;
+        now = TMR1;
+    } while (overflow != timerOverflow);
+    //Wrapped, but Timer 1's interrupt hasn't run yet
+    if (IFS0bits.T1IF && now < 0x8000) {
+        overflow++;
+    }
+    return ((unsigned long) overflow << 16) | now;
+}
+
+/*INT1 ISR, the MPU has put a sample in the FIFO. Timestamps it and every
+ *AHRS_FIFO_BATCH samples reads the FIFO count and starts draining it.*/
+void __attribute__((__interrupt__, no_auto_psv)) _INT1Interrupt(void) {
+    unsigned char count[2];
+    unsigned int bytes;
+
+    edgeTimes[++edgeIndex & (EDGE_TIMES - 1)] = AHRSTimeNow();
+    if (++pending >= AHRS_FIFO_BATCH && !draining) {
+        ReadRegs(MPUREG_FIFO_COUNTH, count, 2);
+        bytes = ((unsigned int) (count[0] & 0x1F) << 8) | count[1];
+        /*After an overflow the oldest bytes are gone and the packets no
+         *longer line up, so everything there is thrown away. The FIFO only
+         *gets whole packets, so it is lined up again once emptied.*/
+        if (!fifoSynced || bytes % AHRS_BURST_BYTES != 0 || bytes > sizeof (fifoBuffer)) {
+            drainPackets = 0;
+            if (bytes > sizeof (fifoBuffer)) {
+                bytes = sizeof (fifoBuffer);
+            }
+            if (fifoSynced) {
+                AHRSFifoDropCount++;
+            }
+            fifoSynced = 1;
+        } else {
+            drainPackets = bytes / AHRS_BURST_BYTES;
+        }
+        if (bytes > 0) {
+            drainEdge = edgeIndex;
+            pending = 0;
+            draining = 1;
+            ReadRegsDMA(MPUREG_FIFO_R_W, fifoBuffer, bytes);
+        }
+    }
+    IFS1bits.INT1IF = 0;
+}
+
+/*DMA3 ISR, a FIFO drain is in fifoBuffer. One filter update per packet, the
+ *newest was taken at the INT pulse that started the drain.*/
+void __attribute__((__interrupt__, no_auto_psv)) _DMA3Interrupt(void) {
+    unsigned char i;
+
+    for (i = 0; i < drainPackets; i++) {
+        unsigned char edge = drainEdge - (drainPackets - 1 - i);
+        AHRSUpdate(&fifoBuffer[i * AHRS_BURST_BYTES], edgeTimes[edge & (EDGE_TIMES - 1)]);
+    }
+    draining = 0;
+    IFS2bits.DMA3IF = 0;
+}
+#endif
+
+void AHRSGetQuaternion(quaternionFixed* result) {
+    UPDATE_IE = 0;
+    *result = attitude;
+    UPDATE_IE = 1;
+}
+
+//Returns 1 once per AHRS_PUBLISH_DIVIDER samples
+int AHRSReady(void) {
+    if (!publishReady) {
+        return 0;
+    }
+    publishReady = 0;
+    return 1;
+}
+
+//Q1.30 to Q15, rounded and saturated
+static int toQ15(q30_t part) {
+    int32_t v = (part + (1L << 14)) >> 15;
+
+    if (v > 32767) {
+        return 32767;
+    }
+    if (v < -32767) {
+        return -32767;
+    }
+    return (int) v;
+}
+
+//Timer 1 time of the sample the latest frame comes from, AHRS_TIMER_HZ
+unsigned long AHRSGetTimestamp(void) {
+    unsigned long time;
+
+    UPDATE_IE = 0;
+    time = publishedTime;
+    UPDATE_IE = 1;
+    return time;
+}
+
+//CANMSG_NAVRPY payload, see AHRS.h
+void AHRSGetFrame(unsigned int* data) {
+    quaternionFixed q;
+    vectorFixed euler;
+
+    UPDATE_IE = 0;
+    q = published;
+    UPDATE_IE = 1;
+
+    //q and -q are the same attitude, send the one with w >= 0 so w can be left out
+    if (q.w < 0) {
+        init2Fixed(&q, -q.w, -q.x, -q.y, -q.z);
+    }
+    getEulerRepresentationFixed(&q, &euler);
+    data[0] = (unsigned int) toQ15(q.x);
+    data[1] = (unsigned int) toQ15(q.y);
+    data[2] = (unsigned int) toQ15(q.z);
+    data[3] = (unsigned int) (int) fixedMul(euler.z, HEADING_SCALE, 31);
+}
@@ -0,0 +1,90 @@
+/*
+ * File:   AHRS.h
+ * Author: Michael Buchel
+ *
+ * Attitude from the MPU9250 on the board. With AHRS_INT_SAMPLING the MPU
+ * samples on its own clock into its FIFO, in register order, so every
+ * packet is the same 21 bytes a burst read from ACCEL_XOUT_H gives:
+ * accelerometer, temperature, gyroscope and the AK8963 registers its I2C
+ * master copies in. Its INT pin pulses on every sample; the INT1 interrupt
+ * timestamps the pulse against Timer 1 and every AHRS_FIFO_BATCH samples
+ * starts a DMA drain of the FIFO. The DMA3 interrupt then runs the fixed
+ * point Mahony update on each packet with its own timestamp. By default
+ * (AHRS_TIMER_SAMPLING) the registers are read on Timer 1 instead, one
+ * burst per sample.
+ *
+ * The first sample sets the attitude directly from gravity and the field so
+ * the filter starts aligned. Every AHRS_PUBLISH_DIVIDER samples the
+ * attitude is latched for the CANMSG_NAVRPY frame, so the host gets a
+ * quaternion and heading instead of raw registers.
+ *
+ * Frame, little endian int16s:
+ *   x, y, z   quaternion parts in Q15, w is sqrt(1 - x^2 - y^2 - z^2) >= 0
+ *   heading   yaw from getEulerRepresentation, 0.01 degrees, -18000..18000
+ */
+
+#ifndef AHRS_H
+#define	AHRS_H
+
+#include <xc.h>
+#include "quaternionFixed.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+//The INT pin's mapping (AHRS_INT_RP) hasn't been checked against the board,
+//so sampling is on Timer 1 until it is. Define AHRS_INT_SAMPLING for the FIFO.
+//#define AHRS_INT_SAMPLING
+#if !defined(AHRS_INT_SAMPLING) && !defined(AHRS_TIMER_SAMPLING)
+#define AHRS_TIMER_SAMPLING
+#endif
+
+#define AHRS_FCY 60000000UL         //instruction clock after init_SPI
+#define AHRS_TIMER_HZ (AHRS_FCY / 64)   //Timer 1, timestamps
+#define AHRS_SAMPLE_HZ 500          //MPU sample rate and filter update rate
+#define AHRS_PUBLISH_HZ 50          //CAN frame rate, divides AHRS_SAMPLE_HZ
+#define AHRS_PUBLISH_DIVIDER (AHRS_SAMPLE_HZ / AHRS_PUBLISH_HZ)
+
+//Sensor ranges, must match what AHRS_init writes
+#define AHRS_GYRO_LSB_PER_DPS 65.5  //+-500 dps
+
+//Mahony gains, rad/s per unit of error. Gyro bias settles in about KP / KI s.
+#define AHRS_KP 1.0
+#define AHRS_KI 0.1
+
+//Burst from MPUREG_ACCEL_XOUT_H: accel, temperature, gyro, then AK8963 HXL..ST2
+#define AHRS_BURST_BYTES 21
+
+#define AHRS_FIFO_BATCH 4           //samples per FIFO drain
+#define AHRS_INT_RP 0b1001010       //RPI74, MPU INT pin to INT1, check against the board
+
+extern volatile unsigned int AHRSSampleCount;
+extern volatile unsigned int AHRSMagSkipCount;  //samples without a usable magnetometer reading
+extern volatile unsigned int AHRSFifoDropCount; //FIFO drains thrown away, after an overflow
+
+void AHRS_init(void);
+void AHRSReset(void);
+
+//One filter update from a burst read or FIFO packet taken at time, split out of the ISRs for testing
+void AHRSUpdate(const unsigned char* burst, unsigned long time);
+
+//Timer 1 extended to 32 bits, AHRS_TIMER_HZ
+unsigned long AHRSTimeNow(void);
+
+void AHRSGetQuaternion(quaternionFixed* result);
+int AHRSReady(void);
+unsigned long AHRSGetTimestamp(void);
+void AHRSGetFrame(unsigned int* data);
+
+void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void);
+#ifndef AHRS_TIMER_SAMPLING
+void __attribute__((__interrupt__, no_auto_psv)) _INT1Interrupt(void);
+void __attribute__((__interrupt__, no_auto_psv)) _DMA3Interrupt(void);
+#endif
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* AHRS_H */
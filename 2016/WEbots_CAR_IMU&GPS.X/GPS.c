@@ -8,130 +8,50 @@
  */
 
 #include "GPS.h"
+#include "AHRS.h"
+#include "NMEA.h"
+#include "UBX.h"
+#include "MPU9250.h"
+#include "../CAN_to_USB_transceiver.X/CAN.h"
 
-int i; //Keeps track of letter
-int good; //Used to check if the command string is the same
-int commaNumber, counter; //Keeps track for parsing the data
-char receivedChars[300]; //Keeps track of chars brought in
-char command[7] = "$GPRMC"; //Command string
-char Time[9], Status, Latitude[7], DirectionNS, //Parsed data
-        Longitude[8], DirectionEW, Speed[3], Heading[3],
-        Date[6], Magnetic[3], MagneticEW, Mode,
-        Checksum;
+unsigned int navFrame[4]; //CANMSG_NAVRPY payload
+unsigned int positionFrame[4]; //CANMSG_NAVLONLAT payload
+NMEAFix fix; //Latest from the GPS
+long lastFixTime = -1; //Time of the last position sent, one frame per GPS epoch
 
-void init() {
-    RPINR18 = 0x003E; //Sets pin 48 as UART receiver
-    RPINR26 = 0x0031; //Sets pin 61 for CAN receiver
-    RPOR4 = 0x0F00; //Sets pin 60 for CAN transmitter
+void initGPS() {
+    init_SPI(); //Also switches the clock up to FP
     
-    U1MODEbits.STSEL = 0; //1 stop bit
-    U1MODEbits.PDSEL = 0; //No parity 8 data bits
-    U1MODEbits.ABAUD = 0; //Auto baud disabled
-    U1MODEbits.BRGH = 0; //Standard speed mode
-    
-    U1BRG = BRGVAL; //Baud rate setting for 4800 
-    U1STAbits.URXISEL = 0; //Interrupt after 1 character is recieved
-    U1MODEbits.UARTEN = 1; //Enable UART
-    
-    for (i = 0; i < 300; i++) { //Clear received array
-        receivedChars[i] = 0x0;
+    NMEA_init(BAUDRATE); //UART1 receive interrupt and NMEA parser
+#ifdef GPS_UBX
+    if (UBXConfigure(UBX_BAUDRATE, UBX_RATE_HZ) == UBX_CONFIG_NO_ACK) { //Binary NAV-PVT from here on
+        NMEASetBaud(BAUDRATE); //Not answering at the new rate, stay on NMEA
     }
+#endif
     
-    i = 0; //Set counter back to 0
+    AHRS_init(); //Attitude filter on the MPU9250
+    CAN1Init(); //Pins 61 and 60, build CAN.c with IMU_GPS
     
     return;
 }
 
 int main(void) {
-    init(); //Runs the setup function
+    initGPS(); //Runs the setup function
     
     while(1) {
-        if (U1STAbits.OERR == 1) { //Checks if buffer is overflowing
-            U1STAbits.OERR = 0;
-            continue;
+        if (AHRSReady()) { //Attitude out at AHRS_PUBLISH_HZ
+            AHRSGetFrame(navFrame);
+            CAN1Transmit(CANMSG_NAVRPY, 8, navFrame);
         }
         
-        if (U1STAbits.URXDA == 1) { //If byte is passed
-            receivedChars[i++] = U1RXREG; //Put byte into array
-            
-            if (U1RXREG == 0x0D) { //If byte is end of transmission
-                good = 0; //Uses this for a check
-                
-                for (i = 1; i < 7; i++) { //Because <LF> is the first character in receivedChars
-                    if (receivedChars[i] == command[i-1]) {
-                        good++;
-                    }
-                }
-                
-                if (good == 6) { //Command starts with $GPRMC command string we are looking for
-                    commaNumber = 0; //Counter
-                    counter = 0; //Counter
-                    
-                    for (i = 0; i < 300; i++) { //Loops through array
-                        if (receivedChars[i] == ',' || receivedChars[i] == '*') { //Keeps track of the breaks in data
-                            commaNumber++;
-                            continue; //Skips the parsing code
-                        }
-                        
-                        switch (commaNumber) { //Depending on which break in data fill a different array
-                            case 0:
-                                break;
-                            case 1:
-                                Time[counter++] = receivedChars[i]; //If after first comma fill Time array
-                                break;
-                            case 2:
-                                counter = 0; //Clear array counter
-                                Status = receivedChars[i]; //Fill Status
-                                break;
-                            case 3:
-                                Latitude[counter++] = receivedChars[i]; //Fill latitude array
-                                break;
-                            case 4:
-                                counter = 0; //Resets counter
-                                DirectionNS = receivedChars[i]; //Sets N/S direction
-                                break;
-                            case 5:
-                                Longitude[counter++] = receivedChars[i]; //Fills longitude array
-                                break;
-                            case 6:
-                                counter = 0; //Clear counter
-                                DirectionEW = receivedChars[i]; //Sets E/W direction
-                                break;
-                            case 7:
-                                Speed[counter++] = receivedChars[i]; //Fills speed array
-                                if (counter == 3) { //Checks counter to prevent more checks later on
-                                    counter = 0;
-                                }
-                                break;
-                            case 8:
-                                Heading[counter++] = receivedChars[i]; //Fills heading array
-                                if (counter == 3) { //Checks counter to prevent more checks later on
-                                    counter = 0;
-                                }
-                                break;
-                            case 9:
-                                Date[counter++] = receivedChars[i]; //Fills date array
-                                break;
-                            case 10:
-                                if (counter == 6) { //Clears counter after date
-                                    counter = 0;
-                                }
-                                Magnetic[counter++] = receivedChars[i]; //Fills magnetic drift array
-                                break;
-                            case 11:
-                                MagneticEW = receivedChars[i]; //Fills the direction of magnetic drift
-                                break;
-                            case 12:
-                                Mode = receivedChars[i]; //Fills mode
-                                break;
-                            case 13:
-                                Checksum = receivedChars[i]; //Fills checksum
-                                break;
-                        }
-                    }
-                }
+        if (NMEAProcess() & (NMEA_RMC | NMEA_GGA | NMEA_PVT)) { //Sentences with a position
+            NMEAGetFix(&fix);
+            if (fix.valid && fix.time != lastFixTime) { //RMC and GGA of one epoch carry the same position
+                lastFixTime = fix.time;
+                NMEAGetFrame(positionFrame);
+                CAN1Transmit(CANMSG_NAVLONLAT, 8, positionFrame);
             }
         }
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -58,9 +58,11 @@
 #include <p33EP256MU806.h>
 
 //Important values
-#define FP 40000000
-#define BAUDRATE 4800
-#define BRGVAL ((FP/BAUDRATE)/16)-1
+#define FP 60000000 //Fcy once init_SPI has switched to the PLL
+#define BAUDRATE 4800 //GPS default, 10Hz updates need 38400 or more, see NMEA.h
+//#define GPS_UBX //u-blox receiver switched to NAV-PVT at start up, needs U1TX on RP67: check against the board first
+#define UBX_BAUDRATE 115200 //NAV-PVT is 100 bytes, 25Hz needs 38400 or more
+#define UBX_RATE_HZ 10 //Fixes per second, 10 to 25 depending on the receiver
 
 #ifdef	__cplusplus
 extern "C" {
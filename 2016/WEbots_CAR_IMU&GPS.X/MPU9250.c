@@ -13,11 +13,11 @@
  * new_MPU9250: Creates a new MPU struct which saves incoming data from the MPU9250
  * mostly useful for calibration.
  *
- * @param low_pass_filter
- * @param low_pass_filter_acc
+ * @param low_pass_filter BITS_DLPF_CFG_188HZ normally
+ * @param low_pass_filter_acc BITS_DLPF_CFG_188HZ normally
  * @return
  */
-MPU9250* *new_MPU9250(unsigned char low_pass_filter = BITS_DLPF_CFG_188HZ, unsigned char low_pass_filter_acc = BITS_DLPF_CFG_188HZ) {
+MPU9250* new_MPU9250(unsigned char low_pass_filter, unsigned char low_pass_filter_acc) {
     MPU9250 *mpu = (MPU9250 *) malloc(sizeof(MPU9250));
     mpu->my_low_pass_filter = low_pass_filter;
     mpu->my_low_pass_filter_acc = low_pass_filter_acc;
@@ -68,6 +68,18 @@ void init_SPI (void) {
     RPOR1bits.RP66R = 7;    //SPI slave select mapped to pin 50
 }
 
+/**
+ * set_SPI_fast: The MPU9250 only allows 1MHz SPI for writing registers but
+ * up to 20MHz for reading the sensor registers. Call after setup is done,
+ * so the burst reads take microseconds instead of hundreds of them.
+ */
+void set_SPI_fast (void) {
+    SPI1STATbits.SPIEN = 0;
+    SPI1CON1bits.PPRE = 0b10;                   // 4:1
+    SPI1CON1bits.SPRE = 0b110;                  // 2:1, 60MHz / 8 = 7.5MHz
+    SPI1STATbits.SPIEN = 1;
+}
+
 /**
  * WriteReg: Write out commands to the MPU9250 using
  *           SPI communication and return data returned
@@ -111,22 +123,84 @@ unsigned int ReadReg(signed int WriteAddr, signed int WriteData)
 }
 
 
-void ReadRegs(signed int ReadAddr, signed int *ReadBuf, signed int Bytes )
+/**
+ * ReadRegs: Burst read of Bytes registers starting at ReadAddr, the
+ *           MPU9250 increments the address itself. No delays so it can
+ *           be used from the sample interrupt.
+ *
+ * @param ReadAddr First register
+ * @param ReadBuf Filled with the register values
+ * @param Bytes Number of registers to read
+ */
+void ReadRegs(unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes )
 {
     unsigned int  i = 0;    //Counter variable
-    signed int temp_val;    //
+    unsigned char temp_val;
 
     temp_val = SPI1BUF;     //Dummy read to clear SPIRBF flag
 
     SPI1BUF = (ReadAddr | READ_FLAG);    //Write address to SPI which will be sent to MPU9250
-    while( !SPI1STATbits.SPITBF );  // wait for the data to be sent out
+    while( !SPI1STATbits.SPIRBF );  // wait for the address to be clocked out
+    temp_val = SPI1BUF;     //Nothing useful comes back during the address
     for(i = 0; i < Bytes; i++) {
-        SPI1BUF = 0x00;    //Write data to SPI which will be sent to MPU9250
-        while( !SPI1STATbits.SPITBF);  // wait for the data to be sent out
+        SPI1BUF = 0x00;    //Clock out a dummy byte to read the next register
         while( !SPI1STATbits.SPIRBF);  // wait for MPU9250 to return data
-        temp_val = SPI1BUF;     //Read value returned over SPI
+        ReadBuf[i] = SPI1BUF;   //Read value returned over SPI
     }
-    __delay_ms(50);
+    (void) temp_val;
+}
+
+/**
+ * ReadRegsDMA: Starts the same burst read as ReadRegs but lets DMA move the
+ *              bytes, DMA2 clocking out the dummy bytes and DMA3 storing
+ *              what comes back, and returns once the address is sent.
+ *              DMA0 and DMA1 belong to CAN.c. The DMA3 interrupt flag is
+ *              set when ReadBuf is full, the caller supplies _DMA3Interrupt
+ *              and must not touch SPI1 until then.
+ *
+ * @param ReadAddr First register, or MPUREG_FIFO_R_W to drain the FIFO
+ * @param ReadBuf Filled with the register values, must stay valid
+ * @param Bytes Number of registers to read, 1 to 1024
+ */
+void ReadRegsDMA(unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes )
+{
+    static unsigned char dummy = 0x00;  //DMA2 source, sent Bytes times
+    unsigned char temp_val;
+
+    temp_val = SPI1BUF;     //Dummy read to clear SPIRBF flag
+    SPI1BUF = (ReadAddr | READ_FLAG);
+    while( !SPI1STATbits.SPIRBF );  // wait for the address to be clocked out
+    temp_val = SPI1BUF;
+
+    //DMA3: SPI1BUF to ReadBuf, one byte per SPI1 transfer done
+    DMA3CON = 0;
+    DMA3CONbits.SIZE = 1;
+    DMA3CONbits.DIR = 0;
+    DMA3CONbits.AMODE = 0;              //post increment
+    DMA3CONbits.MODE = 1;               //one shot
+    DMA3REQ = 0x000A;                   //SPI1 transfer done
+    DMA3PAD = (volatile unsigned int) &SPI1BUF;
+    DMA3STAL = (unsigned int) ReadBuf;
+    DMA3STAH = 0;
+    DMA3CNT = Bytes - 1;
+
+    //DMA2: the same byte to SPI1BUF every transfer, keeps the clock going
+    DMA2CON = 0;
+    DMA2CONbits.SIZE = 1;
+    DMA2CONbits.DIR = 1;
+    DMA2CONbits.AMODE = 1;              //no increment
+    DMA2CONbits.MODE = 1;
+    DMA2REQ = 0x000A;
+    DMA2PAD = (volatile unsigned int) &SPI1BUF;
+    DMA2STAL = (unsigned int) &dummy;
+    DMA2STAH = 0;
+    DMA2CNT = Bytes - 1;
+
+    IFS2bits.DMA3IF = 0;
+    DMA3CONbits.CHEN = 1;
+    DMA2CONbits.CHEN = 1;
+    DMA2REQbits.FORCE = 1;              //first byte, SPI1 triggers the rest
+    (void) temp_val;
 }
 
 
@@ -173,10 +247,10 @@ bool init(MPU9250* mpu, bool calib_gyro, bool calib_acc){
         {BIT_H_RESET, MPUREG_PWR_MGMT_1},     // Reset Device
         {0x01, MPUREG_PWR_MGMT_1},     // Clock Source
         {0x00, MPUREG_PWR_MGMT_2},     // Enable Acc & Gyro
-        {mpu.my_low_pass_filter, MPUREG_CONFIG},         // Use DLPF set Gyroscope bandwidth 184Hz, temperature bandwidth 188Hz
+        {mpu->my_low_pass_filter, MPUREG_CONFIG},         // Use DLPF set Gyroscope bandwidth 184Hz, temperature bandwidth 188Hz
         {BITS_FS_250DPS, MPUREG_GYRO_CONFIG},    // +-250dps
         {BITS_FS_2G, MPUREG_ACCEL_CONFIG},   // +-2G
-        {mpu.my_low_pass_filter_acc, MPUREG_ACCEL_CONFIG_2}, // Set Acc Data Rates, Enable Acc LPF , Bandwidth 184Hz
+        {mpu->my_low_pass_filter_acc, MPUREG_ACCEL_CONFIG_2}, // Set Acc Data Rates, Enable Acc LPF , Bandwidth 184Hz
         {0x30, MPUREG_INT_PIN_CFG},    //
         //{0x40, MPUREG_I2C_MST_CTRL},   // I2C Speed 348 kHz
         //{0x20, MPUREG_USER_CTRL},      // Enable AUX
@@ -207,8 +281,8 @@ bool init(MPU9250* mpu, bool calib_gyro, bool calib_acc){
         __delay_us(1000);
     }
 
-    set_acc_scale(BITS_FS_2G);
-    set_gyro_scale(BITS_FS_250DPS);
+    set_acc_scale(mpu, BITS_FS_2G);
+    set_gyro_scale(mpu, BITS_FS_250DPS);
 
     //calib_mag();  //Can't load this function here , strange problem?
     return 0;
@@ -302,7 +376,7 @@ unsigned int set_gyro_scale(MPU9250* mpu, int scale){
  * mpu9250 which should be 0x71
  */
 
-unsigned int whoami(){
+unsigned int whoami(MPU9250* mpu){
     unsigned int response;
     response = WriteReg(MPUREG_WHOAMI|READ_FLAG, 0x00);
     return response;
@@ -386,7 +460,7 @@ void calib_acc(MPU9250* mpu)
     int temp_scale;
     //READ CURRENT ACC SCALE
     temp_scale=WriteReg(MPUREG_ACCEL_CONFIG|READ_FLAG, 0x00);
-    set_acc_scale(BITS_FS_8G);
+    set_acc_scale(mpu, BITS_FS_8G);
     //ENABLE SELF TEST need modify
     //temp_scale=WriteReg(MPUREG_ACCEL_CONFIG, 0x80>>axis);
 
@@ -395,10 +469,10 @@ void calib_acc(MPU9250* mpu)
     mpu->calib_data[1] = ((response[1]&11100000)>>3) | ((response[3]&00001100)>>2);
     mpu->calib_data[2] = ((response[2]&11100000)>>3) | ((response[3]&00000011));
 
-    set_acc_scale(temp_scale);
+    set_acc_scale(mpu, temp_scale);
 }
 
-unsigned char AK8963_whoami(){
+unsigned char AK8963_whoami(MPU9250* mpu){
     unsigned char response;
     WriteReg(MPUREG_I2C_SLV0_ADDR,AK8963_I2C_ADDR|READ_FLAG); //Set the I2C slave addres of AK8963 and set for read.
     WriteReg(MPUREG_I2C_SLV0_REG, AK8963_WIA); //I2C slave 0 register address from where to begin data transfer
@@ -452,7 +526,7 @@ void read_mag(MPU9250* mpu){
     }
 }
 
-unsigned char get_CNTL1(){
+unsigned char get_CNTL1(MPU9250* mpu){
     WriteReg(MPUREG_I2C_SLV0_ADDR,AK8963_I2C_ADDR|READ_FLAG); //Set the I2C slave addres of AK8963 and set for read.
     WriteReg(MPUREG_I2C_SLV0_REG, AK8963_CNTL1); //I2C slave 0 register address from where to begin data transfer
     WriteReg(MPUREG_I2C_SLV0_CTRL, 0x81); //Read 1 byte from the magnetometer
@@ -492,8 +566,8 @@ void read_all(MPU9250 *mpu){
     }
     //Get Magnetometer value
     for(i=7; i < 10; i++) {
-        mpu->mag_data_raw[i] = ((signed int)response[i*2+1]<<8) | response[i*2];
-        data = (float) mpu->mag_data_raw[i];
+        mpu->mag_data_raw[i-7] = ((signed int)response[i*2+1]<<8) | response[i*2];
+        data = (float) mpu->mag_data_raw[i-7];
         mpu->mag_data[i-7] = data * mpu->Magnetometer_ASA[i-7];
     }
 }
@@ -613,7 +687,7 @@ void calibrate(float *dest1, float *dest2){
     unsigned long mask = 1uL; // Define mask for temperature compensation bit 0 of lower byte of accelerometer bias registers
     unsigned char mask_bit[3] = {0, 0, 0}; // Define array to hold mask bit for each accelerometer bias axis
 
-    for(int ii = 0; ii < 3; ii++) {
+    for(ii = 0; ii < 3; ii++) {
       if((accel_bias_reg[ii] & mask)) mask_bit[ii] = 0x01; // If temperature compensation bit is set, record that fact in mask_bit
     }
 
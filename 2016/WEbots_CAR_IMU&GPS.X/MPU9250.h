@@ -10,6 +10,8 @@
 #define MPU9250_h
 #include <xc.h>
 #include <stdlib.h>
+
+#define FCY 60000000UL  // instruction clock after init_SPI's clock switch, for __delay_ms
 #include <libpic30.h>
 
 // #define AK8963FASTMODE
@@ -186,6 +188,12 @@
 #define BIT_INT_ANYRD_2CLEAR        0x10
 #define BIT_RAW_RDY_EN              0x01
 #define BIT_I2C_IF_DIS              0x10
+#define BIT_FIFO_EN                 0x40
+#define BIT_I2C_MST_EN              0x20
+#define BIT_FIFO_RST                0x04
+#define BITS_FIFO_TEMP_GYRO_ACCEL   0xF8
+#define BIT_FIFO_SLV0               0x01
+#define MPU_FIFO_SIZE               512
 
 #define READ_FLAG   0x80
 
@@ -230,7 +238,7 @@ typedef struct MPU9250 {
   float g_bias[3];
   float a_bias[3];      // Bias corrections for gyro and accelerometer
   
-};
+} MPU9250;
 
 typedef int bool;
 #define true 1
@@ -239,9 +247,11 @@ typedef int bool;
     //Functions part of original library
     unsigned int WriteReg(signed int WriteAddr, signed int WriteData );
     unsigned int ReadReg(signed int WriteAddr, signed int WriteData );
-    void ReadRegs(MPU9250* mpu, unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes );
+    void ReadRegs(unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes );
+    void ReadRegsDMA(unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes );
 
-    bool init(MPU9250* mpu, bool calib_gyro = true, bool calib_acc = true);
+    MPU9250* new_MPU9250(unsigned char low_pass_filter, unsigned char low_pass_filter_acc);
+    bool init(MPU9250* mpu, bool calib_gyro, bool calib_acc);
     void read_temp(MPU9250* mpu);
     void read_acc(MPU9250* mpu);
     void read_gyro(MPU9250* mpu);
@@ -254,8 +264,9 @@ typedef int bool;
     unsigned char get_CNTL1(MPU9250* mpu);
     void read_mag(MPU9250* mpu);
     void read_all(MPU9250* mpu);
-    void calibrate(MPU9250* mpu, float *dest1, float *dest2);
+    void calibrate(float *dest1, float *dest2);
     
     //dsPIC necessary functions
     void init_SPI();
+    void set_SPI_fast();
 #endif
@@ -0,0 +1,521 @@
+/*
+ * File:   NMEA.c
+ * Author: Michael Buchel
+ *
+ * NMEA receive and parsing, see NMEA.h
+ */
+
+#include "NMEA.h"
+#include "UBX.h"
+
+#define NMEA_RX_BUFFER_MASK (NMEA_RX_BUFFER_SIZE - 1)
+#define NMEA_VALUE_LIMIT 200000000L     //more digits than any field has
+
+//Parser states
+#define STATE_IDLE 0                    //waiting for $
+#define STATE_FIELDS 1
+#define STATE_CHECKSUM_HIGH 2
+#define STATE_CHECKSUM_LOW 3
+#define STATE_END 4                     //waiting for <CR> or <LF>
+
+//What a field holds
+#define FIELD_SKIP 0
+#define FIELD_TIME 1                    //hhmmss.sss
+#define FIELD_STATUS 2                  //A or V
+#define FIELD_LATITUDE 3                //ddmm.mmmmm
+#define FIELD_NS 4
+#define FIELD_LONGITUDE 5               //dddmm.mmmmm
+#define FIELD_EW 6
+#define FIELD_KNOTS 7
+#define FIELD_KMH 8
+#define FIELD_COURSE 9
+#define FIELD_DATE 10                   //ddmmyy
+#define FIELD_QUALITY 11
+#define FIELD_SATELLITES 12
+#define FIELD_HDOP 13
+#define FIELD_ALTITUDE 14
+
+//Fraction digits kept per field type, the rest are dropped
+static const unsigned char fieldDecimals[] = {
+    0, 3, 0, 5, 0, 5, 0, 3, 3, 2, 0, 0, 0, 2, 3
+};
+
+//Field layouts after the address field
+static const unsigned char rmcFields[] = {
+    FIELD_SKIP, FIELD_TIME, FIELD_STATUS, FIELD_LATITUDE, FIELD_NS,
+    FIELD_LONGITUDE, FIELD_EW, FIELD_KNOTS, FIELD_COURSE, FIELD_DATE
+};
+static const unsigned char ggaFields[] = {
+    FIELD_SKIP, FIELD_TIME, FIELD_LATITUDE, FIELD_NS, FIELD_LONGITUDE,
+    FIELD_EW, FIELD_QUALITY, FIELD_SATELLITES, FIELD_HDOP, FIELD_ALTITUDE
+};
+static const unsigned char vtgFields[] = {
+    FIELD_SKIP, FIELD_COURSE, FIELD_SKIP, FIELD_SKIP, FIELD_SKIP,
+    FIELD_SKIP, FIELD_SKIP, FIELD_KMH
+};
+
+//Sentence types, the last three letters of the address field
+#define TYPE_CODE(a, b, c) (((unsigned long) (a) << 16) | ((unsigned int) (b) << 8) | (c))
+#define TYPE_RMC TYPE_CODE('R', 'M', 'C')
+#define TYPE_GGA TYPE_CODE('G', 'G', 'A')
+#define TYPE_VTG TYPE_CODE('V', 'T', 'G')
+
+//Fields seen in the current sentence
+#define HAVE_TIME 0x0001
+#define HAVE_LATITUDE 0x0002
+#define HAVE_LONGITUDE 0x0004
+#define HAVE_SPEED 0x0008
+#define HAVE_COURSE 0x0010
+#define HAVE_DATE 0x0020
+#define HAVE_QUALITY 0x0040
+#define HAVE_SATELLITES 0x0080
+#define HAVE_HDOP 0x0100
+#define HAVE_ALTITUDE 0x0200
+
+volatile unsigned int NMEAOverrunCount = 0;
+unsigned int NMEAChecksumErrorCount = 0;
+unsigned int NMEASentenceCount = 0;
+
+/*Receive ring buffer. The head is only moved by the RX ISR and the tail
+ *only by NMEAProcess, so no locking is needed around either index.*/
+static volatile char rxBuffer[NMEA_RX_BUFFER_SIZE];
+static volatile unsigned int rxHead = 0;
+static volatile unsigned int rxTail = 0;
+
+//Parser state, only touched from the main loop
+static unsigned char state;
+static unsigned char length;            //characters since $
+static unsigned char checksum;          //XOR of everything between $ and *
+static unsigned char received;          //checksum after the *
+static unsigned char field;             //field number, 0 is the address
+static unsigned char fieldType;
+static const unsigned char* layout;     //field types of this sentence, 0 if skipped
+static unsigned char layoutLength;
+static unsigned char sentence;          //NMEA_ bit of this sentence
+static unsigned long address;           //last letters of the address field
+static unsigned char addressLength;
+
+//Current field
+static long value;
+static unsigned char decimals;          //fraction digits in value
+static unsigned char point;             //past the decimal point
+static unsigned char negative;
+static unsigned char digits;            //any digits at all
+static unsigned char bad;               //something that doesn't belong
+static char letter;                     //first character, for the one letter fields
+
+//Current sentence, copied to the fix once the checksum matches
+static NMEAFix scratch;
+static unsigned int have;
+static char status;
+static char northSouth, eastWest;
+
+static NMEAFix fix;
+
+void NMEAReset(void) {
+    state = STATE_IDLE;
+    fix.latitude = 0;
+    fix.longitude = 0;
+    fix.altitude = 0;
+    fix.time = 0;
+    fix.speed = 0;
+    fix.course = 0;
+    fix.hdop = 0;
+    fix.day = fix.month = fix.year = 0;
+    fix.quality = 0;
+    fix.satellites = 0;
+    fix.valid = 0;
+    fix.updated = 0;
+    NMEAOverrunCount = 0;
+    NMEAChecksumErrorCount = 0;
+    NMEASentenceCount = 0;
+}
+
+void NMEASetBaud(unsigned long baud) {
+    U1BRG = (unsigned int) ((NMEA_FCY / 4 + baud / 2) / baud - 1);
+}
+
+//UART1 from the GPS at baud, receive interrupt on every character
+void NMEA_init(unsigned long baud) {
+    RPINR18 = 0x003E; //Sets pin 48 as UART receiver
+
+    U1MODE = 0;
+    U1MODEbits.PDSEL = 0; //No parity 8 data bits
+    U1MODEbits.STSEL = 0; //1 stop bit
+    U1MODEbits.BRGH = 1; //4 clocks per bit, 0.2% error at 115200
+    NMEASetBaud(baud);
+    U1STA = 0;
+    U1STAbits.URXISEL = 0; //Interrupt on every character
+
+    rxHead = 0;
+    rxTail = 0;
+    NMEAReset();
+    UBXReset();
+
+    IPC2bits.U1RXIP = 5; //A character every 87us at 115200, with the MPU's INT1
+    IFS0bits.U1RXIF = 0;
+    IEC0bits.U1RXIE = 1;
+    U1MODEbits.UARTEN = 1; //Enable UART, receive only until UBXConfigure
+}
+
+//UART1 RX ISR, from the hardware FIFO into the ring buffer
+void __attribute__((__interrupt__, no_auto_psv)) _U1RXInterrupt(void) {
+    unsigned int head = rxHead;
+
+    while (U1STAbits.URXDA) {
+        char c = U1RXREG;
+        unsigned int next = (head + 1) & NMEA_RX_BUFFER_MASK;
+        if (next == rxTail) {
+            NMEAOverrunCount++; //Dropped, the checksum throws the sentence away
+        } else {
+            rxBuffer[head] = c;
+            head = next;
+        }
+    }
+    rxHead = head;
+    //The FIFO has been read, clearing OERR empties it
+    if (U1STAbits.OERR) {
+        NMEAOverrunCount++;
+        U1STAbits.OERR = 0;
+    }
+    IFS0bits.U1RXIF = 0;
+}
+
+unsigned char NMEAProcess(void) {
+    unsigned char done = 0;
+    unsigned int tail = rxTail;
+
+    while (tail != rxHead) {
+        char c = rxBuffer[tail];
+        done |= UBXParse((unsigned char) c);
+        if (!UBXInFrame()) { //Binary, a $ in there is not a sentence
+            done |= NMEAParse(c);
+        }
+        tail = (tail + 1) & NMEA_RX_BUFFER_MASK;
+        rxTail = tail;
+    }
+    return done;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static void startField(void) {
+    value = 0;
+    decimals = 0;
+    point = 0;
+    negative = 0;
+    digits = 0;
+    bad = 0;
+    letter = 0;
+    if (layout != 0 && field < layoutLength) {
+        fieldType = layout[field];
+    } else {
+        fieldType = FIELD_SKIP;
+    }
+}
+
+static void fieldChar(char c) {
+    if (field == 0) {
+        address = ((address << 8) | (unsigned char) c) & 0xFFFFFFUL;
+        addressLength++;
+        return;
+    }
+    if (fieldType == FIELD_SKIP) {
+        return;
+    }
+    if (letter == 0) {
+        letter = c;
+    }
+    if (c >= '0' && c <= '9') {
+        if (point && decimals >= fieldDecimals[fieldType]) {
+            return; //Past the resolution we keep
+        }
+        if (value >= NMEA_VALUE_LIMIT) {
+            bad = 1;
+            return;
+        }
+        value = value * 10 + (c - '0');
+        digits = 1;
+        if (point) {
+            decimals++;
+        }
+    } else if (c == '.' && !point) {
+        point = 1;
+    } else if (c == '-' && !digits && !negative) {
+        negative = 1;
+    } else {
+        bad = 1;
+    }
+}
+
+//value with exactly fieldDecimals fraction digits
+static long scaled(void) {
+    long v = value;
+    unsigned char d = decimals;
+
+    while (d < fieldDecimals[fieldType]) {
+        v *= 10;
+        d++;
+    }
+    return negative ? -v : v;
+}
+
+//ddmm.mmmmm or dddmm.mmmmm with 5 decimals to 1e-7 degrees
+static long toDegrees(long v) {
+    long degrees = v / 10000000L;
+    long minutes = v - degrees * 10000000L;
+
+    return degrees * 10000000L + (minutes * 5 + 1) / 3;
+}
+
+static unsigned int toSpeed(long v, long num, long den) {
+    v = (v * num + den / 2) / den;
+    if (v > 65535L) {
+        return 65535U;
+    }
+    return (unsigned int) v;
+}
+
+static void endField(void) {
+    long v;
+
+    if (field == 0) {
+        //Talker and type, proprietary $P sentences are skipped
+        layout = 0;
+        sentence = 0;
+        if (addressLength == 5) {
+            if (address == TYPE_RMC) {
+                layout = rmcFields;
+                layoutLength = sizeof (rmcFields);
+                sentence = NMEA_RMC;
+            } else if (address == TYPE_GGA) {
+                layout = ggaFields;
+                layoutLength = sizeof (ggaFields);
+                sentence = NMEA_GGA;
+            } else if (address == TYPE_VTG) {
+                layout = vtgFields;
+                layoutLength = sizeof (vtgFields);
+                sentence = NMEA_VTG;
+            }
+        }
+        have = 0;
+        status = 0;
+        northSouth = 0;
+        eastWest = 0;
+        return;
+    }
+    if (fieldType == FIELD_SKIP) {
+        return;
+    }
+    if (fieldType == FIELD_STATUS) {
+        status = letter;
+        return;
+    }
+    if (fieldType == FIELD_NS) {
+        northSouth = letter;
+        return;
+    }
+    if (fieldType == FIELD_EW) {
+        eastWest = letter;
+        return;
+    }
+    if (!digits || bad) {
+        return; //Empty, e.g. no fix yet, or garbled
+    }
+    v = scaled();
+    switch (fieldType) {
+        case FIELD_TIME:
+            scratch.time = ((v / 10000000L) * 3600L + (v / 100000L % 100) * 60L) * 1000L + v % 100000L;
+            have |= HAVE_TIME;
+            break;
+        case FIELD_LATITUDE:
+            scratch.latitude = toDegrees(v);
+            have |= HAVE_LATITUDE;
+            break;
+        case FIELD_LONGITUDE:
+            scratch.longitude = toDegrees(v);
+            have |= HAVE_LONGITUDE;
+            break;
+        case FIELD_KNOTS:
+            scratch.speed = toSpeed(v, 1852L, 3600L); //1 knot = 1852 m/h
+            have |= HAVE_SPEED;
+            break;
+        case FIELD_KMH:
+            scratch.speed = toSpeed(v, 10L, 36L);
+            have |= HAVE_SPEED;
+            break;
+        case FIELD_COURSE:
+            scratch.course = (unsigned int) v;
+            have |= HAVE_COURSE;
+            break;
+        case FIELD_DATE:
+            scratch.day = (unsigned char) (v / 10000L);
+            scratch.month = (unsigned char) (v / 100 % 100);
+            scratch.year = (unsigned char) (v % 100);
+            have |= HAVE_DATE;
+            break;
+        case FIELD_QUALITY:
+            scratch.quality = (unsigned char) v;
+            have |= HAVE_QUALITY;
+            break;
+        case FIELD_SATELLITES:
+            scratch.satellites = (unsigned char) v;
+            have |= HAVE_SATELLITES;
+            break;
+        case FIELD_HDOP:
+            scratch.hdop = (unsigned int) v;
+            have |= HAVE_HDOP;
+            break;
+        case FIELD_ALTITUDE:
+            scratch.altitude = v;
+            have |= HAVE_ALTITUDE;
+            break;
+    }
+}
+
+//Checksum matched, the sentence's fields go into the fix
+static unsigned char commit(void) {
+    unsigned char position = 0;
+
+    NMEASentenceCount++;
+    if (sentence == NMEA_RMC) {
+        fix.valid = status == 'A';
+        position = fix.valid;
+    } else if (sentence == NMEA_GGA && (have & HAVE_QUALITY)) {
+        fix.quality = scratch.quality;
+        fix.valid = scratch.quality > 0;
+        position = fix.valid;
+    }
+    if (position && (have & HAVE_LATITUDE) && (have & HAVE_LONGITUDE)
+            && (northSouth == 'N' || northSouth == 'S') && (eastWest == 'E' || eastWest == 'W')) {
+        fix.latitude = northSouth == 'S' ? -scratch.latitude : scratch.latitude;
+        fix.longitude = eastWest == 'W' ? -scratch.longitude : scratch.longitude;
+    }
+    if (have & HAVE_TIME) {
+        fix.time = scratch.time;
+    }
+    if (have & HAVE_SPEED) {
+        fix.speed = scratch.speed;
+    }
+    if (have & HAVE_COURSE) {
+        fix.course = scratch.course;
+    }
+    if (have & HAVE_DATE) {
+        fix.day = scratch.day;
+        fix.month = scratch.month;
+        fix.year = scratch.year;
+    }
+    if (have & HAVE_SATELLITES) {
+        fix.satellites = scratch.satellites;
+    }
+    if (have & HAVE_HDOP) {
+        fix.hdop = scratch.hdop;
+    }
+    if (have & HAVE_ALTITUDE) {
+        fix.altitude = scratch.altitude;
+    }
+    fix.updated |= sentence;
+    return sentence;
+}
+
+unsigned char NMEAParse(char c) {
+    int nibble;
+
+    //$ always starts over, whatever came before was cut short
+    if (c == '$') {
+        state = STATE_FIELDS;
+        length = 1;
+        checksum = 0;
+        field = 0;
+        layout = 0;
+        address = 0;
+        addressLength = 0;
+        startField();
+        return 0;
+    }
+    if (state == STATE_IDLE) {
+        return 0;
+    }
+    if (++length > NMEA_MAX_SENTENCE) {
+        state = STATE_IDLE;
+        return 0;
+    }
+
+    switch (state) {
+        case STATE_FIELDS:
+            if (c == '*') {
+                endField();
+                state = STATE_CHECKSUM_HIGH;
+            } else if (c == '\r' || c == '\n') {
+                state = STATE_IDLE; //No checksum, not trusted
+            } else {
+                checksum ^= (unsigned char) c;
+                if (c == ',') {
+                    endField();
+                    field++;
+                    startField();
+                } else {
+                    fieldChar(c);
+                }
+            }
+            break;
+        case STATE_CHECKSUM_HIGH:
+        case STATE_CHECKSUM_LOW:
+            nibble = hexDigit(c);
+            if (nibble < 0) {
+                state = STATE_IDLE;
+            } else if (state == STATE_CHECKSUM_HIGH) {
+                received = (unsigned char) (nibble << 4);
+                state = STATE_CHECKSUM_LOW;
+            } else {
+                received |= (unsigned char) nibble;
+                state = STATE_END;
+            }
+            break;
+        case STATE_END:
+            state = STATE_IDLE;
+            if (c == '\r' || c == '\n') {
+                if (received != checksum) {
+                    NMEAChecksumErrorCount++;
+                } else if (sentence) {
+                    return commit();
+                } else {
+                    NMEASentenceCount++;
+                }
+            }
+            break;
+    }
+    return 0;
+}
+
+//A whole fix from another protocol
+void NMEAUpdateFix(const NMEAFix* from, unsigned char source) {
+    unsigned char updated = fix.updated;
+
+    fix = *from;
+    fix.updated = updated | source;
+}
+
+void NMEAGetFix(NMEAFix* result) {
+    *result = fix;
+    fix.updated = 0;
+}
+
+//CANMSG_NAVLONLAT payload, see NMEA.h
+void NMEAGetFrame(unsigned int* data) {
+    data[0] = (unsigned int) fix.latitude;
+    data[1] = (unsigned int) ((unsigned long) fix.latitude >> 16);
+    data[2] = (unsigned int) fix.longitude;
+    data[3] = (unsigned int) ((unsigned long) fix.longitude >> 16);
+}
@@ -0,0 +1,84 @@
+/*
+ * File:   NMEA.h
+ * Author: Michael Buchel
+ *
+ * NMEA 0183 from the GPS on UART1. The receive interrupt only moves bytes
+ * from the UART into a ring buffer; NMEAProcess, called from the main loop,
+ * runs them through a state machine one character at a time. Fields are
+ * converted to integers as they arrive, nothing is copied as a string, and
+ * a sentence only changes the fix once its checksum has matched.
+ *
+ * RMC, GGA and VTG are decoded from any talker (GP, GN, GL...), everything
+ * else is checked and skipped. At 10 Hz with all three sentences the GPS
+ * sends about 2200 characters a second, so it has to be set to 38400 baud
+ * or more. UBX binary frames on the same UART go to UBXParse, see UBX.h.
+ */
+
+#ifndef NMEA_H
+#define	NMEA_H
+
+#include <xc.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define NMEA_FCY 60000000UL         //instruction clock after init_SPI
+
+//Receive ring buffer size, must be a power of 2. 100ms of 115200 baud.
+#define NMEA_RX_BUFFER_SIZE 1024
+
+//Longest sentence the standard allows, $ to <LF>
+#define NMEA_MAX_SENTENCE 82
+
+//NMEAProcess and NMEAFix.updated bits
+#define NMEA_RMC 0x01
+#define NMEA_GGA 0x02
+#define NMEA_VTG 0x04
+#define NMEA_PVT 0x08               //UBX NAV-PVT, see UBX.h
+
+typedef struct NMEAFix {
+    long latitude;                  //1e-7 degrees, north positive
+    long longitude;                 //1e-7 degrees, east positive
+    long altitude;                  //mm above mean sea level, GGA
+    long time;                      //ms since midnight UTC
+    unsigned int speed;             //mm/s over ground
+    unsigned int course;            //0.01 degrees from true north
+    unsigned int hdop;              //0.01, GGA, PDOP from NAV-PVT
+    unsigned char day, month, year; //RMC, year from 2000
+    unsigned char quality;          //GGA: 0 no fix, 1 GPS, 2 DGPS...
+    unsigned char satellites;       //GGA, in use
+    unsigned char valid;            //RMC status A, GGA quality above 0
+    unsigned char updated;          //NMEA_ bits of the sentences since NMEAGetFix
+} NMEAFix;
+
+extern volatile unsigned int NMEAOverrunCount;  //UART or ring buffer overruns
+extern unsigned int NMEAChecksumErrorCount;
+extern unsigned int NMEASentenceCount;          //good sentences, any type
+
+void NMEA_init(unsigned long baud);
+void NMEAReset(void);
+void NMEASetBaud(unsigned long baud);
+
+//Parses everything received so far, returns the NMEA_ bits of the sentences it completed
+unsigned char NMEAProcess(void);
+
+//One character through the parser, split out of NMEAProcess for testing
+unsigned char NMEAParse(char c);
+
+//Replaces the fix with one decoded elsewhere, adding source to its updated bits
+void NMEAUpdateFix(const NMEAFix* from, unsigned char source);
+
+//Copies the fix and clears its updated bits
+void NMEAGetFix(NMEAFix* fix);
+
+//CANMSG_NAVLONLAT payload: latitude then longitude, little endian int32 1e-7 degrees
+void NMEAGetFrame(unsigned int* data);
+
+void __attribute__((__interrupt__, no_auto_psv)) _U1RXInterrupt(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* NMEA_H */
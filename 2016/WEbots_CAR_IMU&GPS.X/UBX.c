@@ -0,0 +1,293 @@
+/*
+ * File:   UBX.c
+ * Author: Michael Buchel
+ *
+ * UBX decoding and receiver setup, see UBX.h
+ */
+
+#define FCY NMEA_FCY
+#include "UBX.h"
+#include <libpic30.h>
+
+#define UBX_SYNC1 0xB5
+#define UBX_SYNC2 0x62
+#define UBX_PVT_LENGTH 92
+
+//Decoder states
+#define STATE_SYNC1 0
+#define STATE_SYNC2 1
+#define STATE_CLASS 2
+#define STATE_ID 3
+#define STATE_LENGTH_LOW 4
+#define STATE_LENGTH_HIGH 5
+#define STATE_PAYLOAD 6
+#define STATE_CK_A 7
+#define STATE_CK_B 8
+
+//The overlay has to match the receiver's byte offsets
+typedef char UBXNavPvtSizeCheck[(sizeof (UBXNavPvt) == UBX_PVT_LENGTH) ? 1 : -1];
+
+unsigned int UBXChecksumErrorCount = 0;
+unsigned int UBXAckCount = 0;
+unsigned int UBXNakCount = 0;
+unsigned int UBXPvtCount = 0;
+
+static unsigned char state = STATE_SYNC1;
+static unsigned char msgClass, msgId;
+static unsigned int length;
+static unsigned int received;           //payload bytes so far
+static unsigned char ckA, ckB;          //8-bit Fletcher over class to payload
+
+//Payload, word aligned for the struct overlay
+static union {
+    unsigned char bytes[UBX_MAX_PAYLOAD];
+    UBXNavPvt pvt;
+} payload;
+
+static UBXNavPvt lastPvt;
+
+//CFG message UBXConfigure is waiting on, and its answer
+static unsigned char waitClass, waitId;
+static unsigned char waitResult;
+#define WAIT_PENDING 0xFF
+
+void UBXReset(void) {
+    state = STATE_SYNC1;
+    UBXChecksumErrorCount = 0;
+    UBXAckCount = 0;
+    UBXNakCount = 0;
+    UBXPvtCount = 0;
+}
+
+unsigned char UBXInFrame(void) {
+    return state != STATE_SYNC1;
+}
+
+//NAV-PVT into the shared fix
+static unsigned char decodePvt(void) {
+    const UBXNavPvt* pvt = &payload.pvt;
+    NMEAFix fix;
+    long time;
+
+    lastPvt = *pvt;
+    UBXPvtCount++;
+
+    fix.latitude = pvt->lat;
+    fix.longitude = pvt->lon;
+    fix.altitude = pvt->hMSL;
+    //UTC time of day, nano can take it back into the previous second
+    time = ((long) pvt->hour * 3600L + (long) pvt->min * 60L + pvt->sec) * 1000L;
+    time += pvt->nano / 1000000L;
+    if (time < 0) {
+        time += 86400000L;
+    }
+    fix.time = time;
+    if (pvt->gSpeed > 65535L) {
+        fix.speed = 65535U;
+    } else if (pvt->gSpeed < 0) {
+        fix.speed = 0;
+    } else {
+        fix.speed = (unsigned int) pvt->gSpeed;
+    }
+    fix.course = (unsigned int) ((pvt->headMot + 500) / 1000);
+    if (fix.course >= 36000U) {
+        fix.course -= 36000U;
+    }
+    fix.hdop = pvt->pDOP;                //Position DOP, NAV-PVT has no HDOP
+    fix.day = pvt->day;
+    fix.month = pvt->month;
+    fix.year = (unsigned char) (pvt->year - 2000);
+    fix.satellites = pvt->numSV;
+    fix.valid = (pvt->flags & UBX_PVT_GNSS_FIX_OK) && pvt->fixType >= 2 && pvt->fixType <= 4;
+    if (!fix.valid) {
+        fix.quality = 0;
+    } else if (pvt->flags & UBX_PVT_DIFF_SOLN) {
+        fix.quality = 2;
+    } else {
+        fix.quality = 1;
+    }
+    NMEAUpdateFix(&fix, NMEA_PVT);
+    return NMEA_PVT;
+}
+
+//Checksum matched
+static unsigned char decode(void) {
+    if (msgClass == UBX_CLASS_NAV && msgId == UBX_NAV_PVT && length == UBX_PVT_LENGTH) {
+        return decodePvt();
+    }
+    if (msgClass != UBX_CLASS_ACK || (msgId != UBX_ACK_ACK && msgId != UBX_ACK_NAK)) {
+        return 0;
+    }
+    if (msgId == UBX_ACK_ACK) {
+        UBXAckCount++;
+    } else {
+        UBXNakCount++;
+    }
+    //Payload is the class and ID answered
+    if (length == 2 && payload.bytes[0] == waitClass && payload.bytes[1] == waitId) {
+        waitResult = msgId == UBX_ACK_ACK ? UBX_CONFIG_OK : UBX_CONFIG_NAK;
+    }
+    return 0;
+}
+
+unsigned char UBXParse(unsigned char c) {
+    switch (state) {
+        case STATE_SYNC1:
+            if (c == UBX_SYNC1) {
+                state = STATE_SYNC2;
+            }
+            break;
+        case STATE_SYNC2:
+            state = c == UBX_SYNC2 ? STATE_CLASS : STATE_SYNC1;
+            ckA = 0;
+            ckB = 0;
+            break;
+        default:
+            if (state < STATE_CK_A) {
+                ckA += c;
+                ckB += ckA;
+            }
+            switch (state) {
+                case STATE_CLASS:
+                    msgClass = c;
+                    state = STATE_ID;
+                    break;
+                case STATE_ID:
+                    msgId = c;
+                    state = STATE_LENGTH_LOW;
+                    break;
+                case STATE_LENGTH_LOW:
+                    length = c;
+                    state = STATE_LENGTH_HIGH;
+                    break;
+                case STATE_LENGTH_HIGH:
+                    length |= (unsigned int) c << 8;
+                    received = 0;
+                    if (length > UBX_MAX_LENGTH) {
+                        state = STATE_SYNC1;
+                    } else {
+                        state = length > 0 ? STATE_PAYLOAD : STATE_CK_A;
+                    }
+                    break;
+                case STATE_PAYLOAD:
+                    if (received < UBX_MAX_PAYLOAD) {
+                        payload.bytes[received] = c;
+                    }
+                    if (++received >= length) {
+                        state = STATE_CK_A;
+                    }
+                    break;
+                case STATE_CK_A:
+                    state = c == ckA ? STATE_CK_B : STATE_SYNC1;
+                    if (state == STATE_SYNC1) {
+                        UBXChecksumErrorCount++;
+                    }
+                    break;
+                case STATE_CK_B:
+                    state = STATE_SYNC1;
+                    if (c != ckB) {
+                        UBXChecksumErrorCount++;
+                        break;
+                    }
+                    return decode();
+            }
+            break;
+    }
+    return 0;
+}
+
+void UBXGetPvt(UBXNavPvt* pvt) {
+    *pvt = lastPvt;
+}
+
+static void sendByte(unsigned char c) {
+    while (U1STAbits.UTXBF); //Wait for room in the TX FIFO
+    U1TXREG = c;
+}
+
+void UBXSend(unsigned char cls, unsigned char id, const unsigned char* data, unsigned int count) {
+    unsigned char a = 0, b = 0;
+    unsigned char header[4];
+    unsigned int n;
+
+    header[0] = cls;
+    header[1] = id;
+    header[2] = (unsigned char) count;
+    header[3] = (unsigned char) (count >> 8);
+    sendByte(UBX_SYNC1);
+    sendByte(UBX_SYNC2);
+    for (n = 0; n < 4; n++) {
+        sendByte(header[n]);
+        a += header[n];
+        b += a;
+    }
+    for (n = 0; n < count; n++) {
+        sendByte(data[n]);
+        a += data[n];
+        b += a;
+    }
+    sendByte(a);
+    sendByte(b);
+}
+
+static void put16(unsigned char* p, unsigned int v) {
+    p[0] = (unsigned char) v;
+    p[1] = (unsigned char) (v >> 8);
+}
+
+static void put32(unsigned char* p, unsigned long v) {
+    put16(p, (unsigned int) v);
+    put16(p + 2, (unsigned int) (v >> 16));
+}
+
+//Sends a CFG message and waits for the receiver to answer it
+static unsigned char sendConfig(unsigned char id, const unsigned char* data, unsigned int count) {
+    unsigned int ms;
+
+    waitClass = UBX_CLASS_CFG;
+    waitId = id;
+    waitResult = WAIT_PENDING;
+    UBXSend(UBX_CLASS_CFG, id, data, count);
+    for (ms = 0; ms < UBX_ACK_TIMEOUT_MS; ms++) {
+        NMEAProcess();
+        if (waitResult != WAIT_PENDING) {
+            return waitResult;
+        }
+        __delay_ms(1);
+    }
+    return UBX_CONFIG_NO_ACK;
+}
+
+unsigned char UBXConfigure(unsigned long baud, unsigned int rate_hz) {
+    unsigned char prt[20] = {0};
+    unsigned char rate[6];
+    unsigned char msg[3] = {UBX_CLASS_NAV, UBX_NAV_PVT, 1};
+    unsigned char result, msgResult;
+
+    RPOR1bits.RP67R = 1; //U1TX to the GPS, check against the board
+    U1STAbits.UTXEN = 1; //Enable transmit, after UARTEN
+
+    //CFG-PRT on UART1: 8N1 at baud, UBX and NMEA in, UBX out
+    prt[0] = 1;
+    put32(&prt[4], 0x000008D0UL);
+    put32(&prt[8], baud);
+    put16(&prt[12], 0x0003);
+    put16(&prt[14], 0x0001);
+    UBXSend(UBX_CLASS_CFG, UBX_CFG_PRT, prt, sizeof (prt));
+    while (!U1STAbits.TRMT); //All out at the old baud rate
+    __delay_ms(100); //Receiver switches over
+    NMEASetBaud(baud);
+
+    //CFG-RATE: measurement every 1000 / rate_hz ms, a fix per measurement, GPS time
+    put16(&rate[0], 1000 / rate_hz);
+    put16(&rate[2], 1);
+    put16(&rate[4], 1);
+    result = sendConfig(UBX_CFG_RATE, rate, sizeof (rate));
+    if (result == UBX_CONFIG_NO_ACK) {
+        return result;
+    }
+
+    //CFG-MSG: NAV-PVT every fix on this port, even if the rate was refused
+    msgResult = sendConfig(UBX_CFG_MSG, msg, sizeof (msg));
+    return msgResult != UBX_CONFIG_OK ? msgResult : result;
+}
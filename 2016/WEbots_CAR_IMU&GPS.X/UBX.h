@@ -0,0 +1,110 @@
+/*
+ * File:   UBX.h
+ * Author: Michael Buchel
+ *
+ * u-blox UBX binary protocol on the GPS UART. UBXConfigure switches the
+ * receiver to UBX only output at a higher baud rate and fix rate, with
+ * NAV-PVT every fix; NMEAProcess hands UBXParse every received byte. A
+ * NAV-PVT is 100 bytes with the whole fix in it, decoded by laying a
+ * struct over the payload once the checksum matches, and goes into the
+ * same NMEAFix as the NMEA sentences.
+ */
+
+#ifndef UBX_H
+#define	UBX_H
+
+#include <stdint.h>
+#include "NMEA.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+//Message classes and IDs
+#define UBX_CLASS_NAV 0x01
+#define UBX_NAV_PVT 0x07
+#define UBX_CLASS_ACK 0x05
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+#define UBX_CLASS_CFG 0x06
+#define UBX_CFG_PRT 0x00
+#define UBX_CFG_MSG 0x01
+#define UBX_CFG_RATE 0x08
+
+//Largest payload kept, longer messages are checked and skipped
+#define UBX_MAX_PAYLOAD 92
+//Longer than any message the receiver sends, treated as a false sync
+#define UBX_MAX_LENGTH 1024
+
+//NAV-PVT payload, little endian like the dsPIC, every field naturally aligned
+typedef struct UBXNavPvt {
+    uint32_t iTOW;                  //ms, GPS time of week
+    uint16_t year;                  //UTC
+    uint8_t month, day, hour, min, sec;
+    uint8_t valid;                  //0x01 date, 0x02 time
+    uint32_t tAcc;                  //ns
+    int32_t nano;                   //ns, -1e9..1e9 on top of sec
+    uint8_t fixType;                //0 none, 1 DR, 2 2D, 3 3D, 4 GNSS+DR, 5 time
+    uint8_t flags;                  //0x01 gnssFixOK, 0x02 diffSoln
+    uint8_t flags2;
+    uint8_t numSV;
+    int32_t lon;                    //1e-7 degrees
+    int32_t lat;                    //1e-7 degrees
+    int32_t height;                 //mm above the ellipsoid
+    int32_t hMSL;                   //mm above mean sea level
+    uint32_t hAcc, vAcc;            //mm
+    int32_t velN, velE, velD;       //mm/s
+    int32_t gSpeed;                 //mm/s
+    int32_t headMot;                //1e-5 degrees
+    uint32_t sAcc;                  //mm/s
+    uint32_t headAcc;               //1e-5 degrees
+    uint16_t pDOP;                  //0.01
+    uint8_t flags3;
+    uint8_t reserved1[5];
+    int32_t headVeh;                //1e-5 degrees
+    int16_t magDec;                 //1e-2 degrees
+    uint16_t magAcc;
+} UBXNavPvt;
+
+#define UBX_PVT_GNSS_FIX_OK 0x01
+#define UBX_PVT_DIFF_SOLN 0x02
+
+extern unsigned int UBXChecksumErrorCount;
+extern unsigned int UBXAckCount;
+extern unsigned int UBXNakCount;
+extern unsigned int UBXPvtCount;
+
+void UBXReset(void);
+
+//One received byte, returns NMEA_PVT once a NAV-PVT has gone into the fix
+unsigned char UBXParse(unsigned char c);
+
+//Inside a frame, the bytes are not NMEA
+unsigned char UBXInFrame(void);
+
+//Latest NAV-PVT as received
+void UBXGetPvt(UBXNavPvt* pvt);
+
+//Sends one message, waiting on the UART
+void UBXSend(unsigned char msgClass, unsigned char msgId, const unsigned char* payload, unsigned int length);
+
+//UBXConfigure results
+#define UBX_CONFIG_OK 0
+#define UBX_CONFIG_NAK 1            //the receiver refused CFG-RATE or CFG-MSG
+#define UBX_CONFIG_NO_ACK 2         //no answer at the new baud rate
+
+#define UBX_ACK_TIMEOUT_MS 1000     //u-blox answers a CFG message within a second
+
+/*From NMEA at the current baud rate to UBX NAV-PVT only at baud and rate_hz
+ *(10 to 25). Call after NMEA_init, it maps U1TX to RP67 and moves UART1 to
+ *the new baud rate. Each CFG message waits for its ACK or NAK, parsing
+ *whatever else comes in meanwhile; CFG-PRT's own answer is lost in the baud
+ *change, so the CFG-RATE ACK is what shows the new rate took. Stops at the
+ *first message not answered.*/
+unsigned char UBXConfigure(unsigned long baud, unsigned int rate_hz);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* UBX_H */
@@ -0,0 +1,193 @@
+/* 
+ * File:   fixedPoint.c
+ * Author: Michael Buchel
+ *
+ * Fixed point helpers, see fixedPoint.h
+ */
+
+#include "fixedPoint.h"
+
+#ifdef __XC16__
+//Single cycle 16x16 multiplies on the dsPIC33E
+#define MUL_SS(a, b) __builtin_mulss((a), (b))
+#define MUL_SU(a, b) __builtin_mulsu((a), (b))
+#define MUL_UU(a, b) __builtin_muluu((a), (b))
+#else
+#define MUL_SS(a, b) ((int32_t) (int16_t) (a) * (int16_t) (b))
+#define MUL_SU(a, b) ((int32_t) (int16_t) (a) * (uint16_t) (b))
+#define MUL_UU(a, b) ((uint32_t) (uint16_t) (a) * (uint16_t) (b))
+#endif
+
+#define CORDIC_STEPS 24
+#define RSQRT_STEPS 3
+
+//atan(2^-i) in Q3.29 radians
+static const int32_t cordicAngles[CORDIC_STEPS] = {
+    421657428, 248918915, 131521918, 66762579, 33510843, 16771758, 8387925,
+    4194219, 2097141, 1048575, 524288, 262144, 131072, 65536, 32768, 16384,
+    8192, 4096, 2048, 1024, 512, 256, 128, 64
+};
+#define CORDIC_HALF_PI 843314857L   //pi/2 in Q3.29
+
+//1/sqrt(x) in Q2.28 at the middle of each 1/32 wide step of x from 0.25 to 1
+static const int32_t rsqrtSeed[24] = {
+    520841289, 492666537, 468619351, 447781295, 429496730, 413283421,
+    398777702, 385699449, 373828920, 362990988, 353044137, 343872592,
+    335380600, 327488186, 320127961, 313242684, 306783378, 300707858,
+    294979565, 289566636, 284441158, 279578557, 274957106, 270557508
+};
+
+//The full 64 bit product from four 16x16 products, then shifted
+int32_t fixedMul(int32_t a, int32_t b, unsigned int shift) {
+    int16_t ah = (int16_t) (a >> 16);
+    int16_t bh = (int16_t) (b >> 16);
+    uint16_t al = (uint16_t) a;
+    uint16_t bl = (uint16_t) b;
+    uint32_t lo = MUL_UU(al, bl);
+    int32_t m1 = MUL_SU(ah, bl);
+    int32_t m2 = MUL_SU(bh, al);
+    uint32_t t = (lo >> 16) + (uint16_t) m1 + (uint16_t) m2;
+    int32_t upper = MUL_SS(ah, bh) + (m1 >> 16) + (m2 >> 16) + (int32_t) (t >> 16);
+    uint32_t lower = (t << 16) | (lo & 0xFFFF);
+    
+    return (int32_t) (((uint32_t) upper << (32 - shift)) | (lower >> shift));
+}
+
+//Shift left for positive counts, right for negative
+static int32_t shiftBy(int32_t v, int shift) {
+    if (shift >= 0) {
+        return v << shift;
+    }
+    if (shift <= -32) {
+        return v < 0 ? -1 : 0;
+    }
+    return v >> -shift;
+}
+
+int fixedTopBit(uint32_t v) {
+    int bit = 0;
+    
+    if (v >> 16) { v >>= 16; bit += 16; }
+    if (v >> 8) { v >>= 8; bit += 8; }
+    if (v >> 4) { v >>= 4; bit += 4; }
+    if (v >> 2) { v >>= 2; bit += 2; }
+    if (v >> 1) { bit += 1; }
+    return bit;
+}
+
+//Brings v into 0.25..1 (Q30), *power is set so v * 2^-frac = m * 2^-30 * 2^(*power)
+static uint32_t rsqrtRange(uint32_t v, int frac, int* power) {
+    int shift = fixedTopBit(v) - 29;
+    uint32_t m;
+    
+    //Keep the power even so its square root is a shift
+    if ((30 + shift - frac) & 1) {
+        shift++;
+    }
+    m = shift >= 0 ? v >> shift : v << -shift;
+    *power = 30 + shift - frac;
+    return m;
+}
+
+static int32_t rsqrtMantissa(uint32_t m) {
+    int32_t r = rsqrtSeed[(m >> 25) - 8];
+    int i;
+    
+    //Newton: r = r * (3 - m * r^2) / 2
+    for (i = 0; i < RSQRT_STEPS; i++) {
+        int32_t r2 = fixedMul(r, r, 28);
+        int32_t mr2 = fixedMul((int32_t) m, r2, 30);
+        r = fixedMul(r, (3L << 28) - mr2, 29);
+    }
+    return r;
+}
+
+int32_t fixedRsqrt(uint32_t v, int frac, int* exponent) {
+    int power;
+    uint32_t m = rsqrtRange(v, frac, &power);
+    
+    *exponent = -power / 2;
+    return rsqrtMantissa(m);
+}
+
+//sqrt(v * 2^-frac) with outFrac fraction bits, sqrt(x) = x / sqrt(x)
+static int32_t sqrtScaled(uint32_t v, int frac, int outFrac) {
+    int power;
+    int shift;
+    uint32_t m;
+    int32_t root;
+    
+    if (v == 0) {
+        return 0;
+    }
+    m = rsqrtRange(v, frac, &power);
+    //m * 2^-30 * r * 2^-28 * 2^(power/2)
+    root = fixedMul((int32_t) m, rsqrtMantissa(m), 30);
+    shift = power / 2 + outFrac - 28;
+    //Round, the Newton steps come in from below
+    if (shift < 0 && shift > -32) {
+        root += 1L << (-shift - 1);
+    }
+    return shiftBy(root, shift);
+}
+
+q16_t fixedSqrt(uint32_t v, int frac) {
+    return sqrtScaled(v, frac, 16);
+}
+
+//CORDIC in vectoring mode, no divide needed
+q16_t fixedAtan2(int32_t y, int32_t x) {
+    int32_t angle = 0;
+    int32_t xn;
+    uint32_t largest;
+    int shift;
+    int i;
+    
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    //Scale up or down to 2^27..2^28 to leave room for the CORDIC gain
+    largest = (uint32_t) (x < 0 ? -x : x) | (uint32_t) (y < 0 ? -y : y);
+    shift = 27 - fixedTopBit(largest);
+    x = shiftBy(x, shift);
+    y = shiftBy(y, shift);
+    //Rotate into the right half plane
+    if (x < 0) {
+        xn = x;
+        if (y >= 0) {
+            x = y;
+            y = -xn;
+            angle = CORDIC_HALF_PI;
+        } else {
+            x = -y;
+            y = xn;
+            angle = -CORDIC_HALF_PI;
+        }
+    }
+    for (i = 0; i < CORDIC_STEPS; i++) {
+        xn = x;
+        if (y > 0) {
+            x += y >> i;
+            y -= xn >> i;
+            angle += cordicAngles[i];
+        } else {
+            x -= y >> i;
+            y += xn >> i;
+            angle -= cordicAngles[i];
+        }
+    }
+    //Q3.29 to Q16.16, rounded
+    return (angle + (1L << 12)) >> 13;
+}
+
+q16_t fixedAsin(q30_t s) {
+    q30_t c;
+    
+    if (s > Q30_ONE) {
+        s = Q30_ONE;
+    } else if (s < -Q30_ONE) {
+        s = -Q30_ONE;
+    }
+    c = sqrtScaled((uint32_t) (Q30_ONE - mulQ30(s, s)), 30, 30);
+    return fixedAtan2(s, c);
+}
@@ -0,0 +1,60 @@
+/* 
+ * File:   fixedPoint.h
+ * Author: Michael Buchel
+ *
+ * Fixed point helpers for the quaternion and vector3d code, so attitude
+ * math doesn't go through software floating point. Unit quaternion parts
+ * are Q1.30 (range -2 to 2), vectors and angles Q16.16.
+ *
+ * Products use the 17x17 multiplier through the XC16 mul builtins (one
+ * cycle each on the dsPIC33E) to build the 32x32 product, instead of the
+ * long long library call. The same partial product code runs on the host.
+ */
+
+#ifndef FIXEDPOINT_H
+#define	FIXEDPOINT_H
+
+#include <stdint.h>
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef int32_t q30_t;  //Q1.30, quaternion parts
+typedef int32_t q16_t;  //Q16.16, vectors, angles in radians
+
+#define Q30_ONE         ((q30_t) 0x40000000L)
+#define Q16_ONE         ((q16_t) 0x00010000L)
+#define Q16_PI          ((q16_t) 205887L)       //pi in Q16.16
+
+//Conversions, host side and constants only
+#define Q30_FROM_DOUBLE(d) ((q30_t) ((d) * 1073741824.0 + ((d) < 0 ? -0.5 : 0.5)))
+#define Q16_FROM_DOUBLE(d) ((q16_t) ((d) * 65536.0 + ((d) < 0 ? -0.5 : 0.5)))
+#define Q30_TO_DOUBLE(q) ((double) (q) / 1073741824.0)
+#define Q16_TO_DOUBLE(q) ((double) (q) / 65536.0)
+
+//(a * b) >> shift, shift from 1 to 31, rounded down
+int32_t fixedMul(int32_t a, int32_t b, unsigned int shift);
+#define mulQ30(a, b) fixedMul((a), (b), 30)
+#define mulQ16(a, b) fixedMul((a), (b), 16)
+
+//Index of the highest set bit of v, v > 0
+int fixedTopBit(uint32_t v);
+
+//1/sqrt(v * 2^-frac) as a Q2.28 mantissa times 2^exponent, v > 0
+int32_t fixedRsqrt(uint32_t v, int frac, int* exponent);
+
+//sqrt(v * 2^-frac) in Q16.16, v >= 0
+q16_t fixedSqrt(uint32_t v, int frac);
+
+//atan2(y, x) in Q16.16 radians, any common scale for x and y
+q16_t fixedAtan2(int32_t y, int32_t x);
+
+//asin(s) in Q16.16 radians, s in Q1.30 clamped to -1..1
+q16_t fixedAsin(q30_t s);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FIXEDPOINT_H */
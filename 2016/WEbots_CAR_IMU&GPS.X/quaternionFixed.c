@@ -0,0 +1,153 @@
+/* 
+ * File:   quaternionFixed.c
+ * Author: Michael Buchel
+ *
+ * Fixed point quaternion, see quaternionFixed.h
+ */
+
+#include "quaternionFixed.h"
+
+//Scales 4 parts of any size to a unit Q1.30 quaternion, zero gives identity
+static void normalizeParts(const int32_t* in, quaternionFixed* address) {
+    int32_t parts[4];
+    uint32_t largest = 0;
+    uint32_t sumSquares = 0;
+    int32_t r;
+    int exponent;
+    int shift;
+    int i;
+    
+    for (i = 0; i < 4; i++) {
+        largest |= (uint32_t) (in[i] < 0 ? -in[i] : in[i]);
+    }
+    if (largest == 0) {
+        init1Fixed(address);
+        return;
+    }
+    //Largest part to 2^28..2^29, the squares * 2^-31 then sum to under 2^30
+    shift = 28 - fixedTopBit(largest);
+    for (i = 0; i < 4; i++) {
+        parts[i] = shift >= 0 ? in[i] << shift : in[i] >> -shift;
+        sumSquares += (uint32_t) fixedMul(parts[i], parts[i], 31);
+    }
+    //parts / sqrt(sum * 2^31) = parts * r * 2^-28 * 2^exponent
+    r = fixedRsqrt(sumSquares, -31, &exponent);
+    shift = exponent + 30;
+    for (i = 0; i < 4; i++) {
+        int32_t v = fixedMul(parts[i], r, 28);
+        parts[i] = shift >= 0 ? v << shift : v >> -shift;
+    }
+    init2Fixed(address, parts[0], parts[1], parts[2], parts[3]);
+}
+
+//Init with only address
+void init1Fixed(quaternionFixed* address) {
+    address->w = Q30_ONE;
+    address->x = 0;
+    address->y = 0;
+    address->z = 0;
+}
+
+//Init with a value
+void init2Fixed(quaternionFixed* address, q30_t a, q30_t b, q30_t c, q30_t d) {
+    address->w = a;
+    address->x = b;
+    address->y = c;
+    address->z = d;
+}
+
+//Init with another quaternion
+void init3Fixed(quaternionFixed* address, const quaternionFixed* other) {
+    *address = *other;
+}
+
+//Init with 2 vectors, same as init4 but works in Q1.30 unit vectors so
+//nearly opposite vectors keep their precision
+void init4Fixed(quaternionFixed* address, const vectorFixed* start, const vectorFixed* end) {
+    q30_t s[3], e[3];
+    int32_t parts[4];
+    
+    normalizeQ30Fixed(start, &s[0], &s[1], &s[2]);
+    normalizeQ30Fixed(end, &e[0], &e[1], &e[2]);
+    parts[0] = Q30_ONE + mulQ30(s[0], e[0]) + mulQ30(s[1], e[1]) + mulQ30(s[2], e[2]);
+    parts[1] = mulQ30(s[1], e[2]) - mulQ30(s[2], e[1]);
+    parts[2] = mulQ30(s[2], e[0]) - mulQ30(s[0], e[2]);
+    parts[3] = mulQ30(s[0], e[1]) - mulQ30(s[1], e[0]);
+    normalizeParts(parts, address);
+}
+
+//Conjugate of the quaternion
+void conjugateQuatFixed(const quaternionFixed* start, quaternionFixed* result) {
+    init2Fixed(result, start->w, -start->x, -start->y, -start->z);
+}
+
+//Magnitude of a quaternion, Q16.16
+q16_t magnitudeQuatFixed(const quaternionFixed* address) {
+    //Squares in Q4.28
+    uint32_t sumSquares = (uint32_t) (fixedMul(address->w, address->w, 31) >> 1)
+            + (uint32_t) (fixedMul(address->x, address->x, 31) >> 1)
+            + (uint32_t) (fixedMul(address->y, address->y, 31) >> 1)
+            + (uint32_t) (fixedMul(address->z, address->z, 31) >> 1);
+    return fixedSqrt(sumSquares, 28);
+}
+
+//Normalizes the quaternion, a reciprocal square root and 4 multiplies
+void normalizeQuatFixed(quaternionFixed* address) {
+    int32_t parts[4];
+    parts[0] = address->w;
+    parts[1] = address->x;
+    parts[2] = address->y;
+    parts[3] = address->z;
+    normalizeParts(parts, address);
+}
+
+//Exports to vector form
+void exportVectorFixed(const quaternionFixed* start, vectorFixed* result) {
+    result->x = start->x >> 14;
+    result->y = start->y >> 14;
+    result->z = start->z >> 14;
+}
+
+//Rotates vector, v + 2w(u x v) + 2u x (u x v) is the same as q v q* for a
+//unit quaternion with 15 multiplies instead of 32
+void rotateVectorFixed(const quaternionFixed* axis, const vectorFixed* start, vectorFixed* result) {
+    vectorFixed t;
+    vectorFixed temp;
+    
+    //t = 2(u x v), Q1.30 * Q16.16 >> 29 gives Q16.16 doubled
+    t.x = fixedMul(axis->y, start->z, 29) - fixedMul(axis->z, start->y, 29);
+    t.y = fixedMul(axis->z, start->x, 29) - fixedMul(axis->x, start->z, 29);
+    t.z = fixedMul(axis->x, start->y, 29) - fixedMul(axis->y, start->x, 29);
+    
+    temp.x = start->x + fixedMul(axis->w, t.x, 30) + fixedMul(axis->y, t.z, 30) - fixedMul(axis->z, t.y, 30);
+    temp.y = start->y + fixedMul(axis->w, t.y, 30) + fixedMul(axis->z, t.x, 30) - fixedMul(axis->x, t.z, 30);
+    temp.z = start->z + fixedMul(axis->w, t.z, 30) + fixedMul(axis->x, t.y, 30) - fixedMul(axis->y, t.x, 30);
+    *result = temp;
+}
+
+//Euler representation, Q16.16 radians
+//https://en.wikipedia.org/wiki/Conversion_between_quaternions_and_Euler_angles
+void getEulerRepresentationFixed(const quaternionFixed* start, vectorFixed* result) {
+    //atan2 only needs the ratio, so both sides go in as Q2.29
+    q30_t xx = mulQ30(start->x, start->x);
+    q30_t yy = mulQ30(start->y, start->y);
+    q30_t zz = mulQ30(start->z, start->z);
+    
+    result->x = fixedAtan2(mulQ30(start->w, start->x) + mulQ30(start->y, start->z),
+            (1L << 29) - xx - yy);
+    result->y = fixedAsin(fixedMul(start->w, start->y, 29) - fixedMul(start->z, start->x, 29));
+    result->z = fixedAtan2(mulQ30(start->w, start->z) + mulQ30(start->x, start->y),
+            (1L << 29) - yy - zz);
+}
+
+//Multiplying quaternions
+//http://www.cprogramming.com/tutorial/3d/quaternions.html
+void multiplyQuatFixed(const quaternionFixed* start, const quaternionFixed* end, quaternionFixed* result) {
+    quaternionFixed temp;
+    
+    temp.w = mulQ30(start->w, end->w) - mulQ30(start->x, end->x) - mulQ30(start->y, end->y) - mulQ30(start->z, end->z);
+    temp.x = mulQ30(start->w, end->x) + mulQ30(start->x, end->w) + mulQ30(start->y, end->z) - mulQ30(start->z, end->y);
+    temp.y = mulQ30(start->w, end->y) - mulQ30(start->x, end->z) + mulQ30(start->y, end->w) + mulQ30(start->z, end->x);
+    temp.z = mulQ30(start->w, end->z) + mulQ30(start->x, end->y) - mulQ30(start->y, end->x) + mulQ30(start->z, end->w);
+    *result = temp;
+}
@@ -0,0 +1,50 @@
+/* 
+ * File:   quaternionFixed.h
+ * Author: Michael Buchel
+ *
+ * Fixed point version of quaternion.h, Q1.30 parts. Same functions with a
+ * Fixed suffix, taking pointers instead of passing structs by value.
+ * rotateVectorFixed and getEulerRepresentationFixed assume a unit
+ * quaternion, keep it normalized.
+ */
+
+#ifndef QUATERNIONFIXED_H
+#define	QUATERNIONFIXED_H
+
+#include "vector3dFixed.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+struct quaternionFixedStorage {
+    q30_t w, x, y, z;
+};
+
+typedef struct quaternionFixedStorage quaternionFixed;
+
+//Constructor
+void init1Fixed(quaternionFixed* address);
+void init2Fixed(quaternionFixed* address, q30_t a, q30_t b, q30_t c, q30_t d);
+void init3Fixed(quaternionFixed* address, const quaternionFixed* other);
+void init4Fixed(quaternionFixed* address, const vectorFixed* start, const vectorFixed* end);
+
+//Helpful functions
+void conjugateQuatFixed(const quaternionFixed* start, quaternionFixed* result);
+q16_t magnitudeQuatFixed(const quaternionFixed* address);
+void normalizeQuatFixed(quaternionFixed* address);
+
+//Export function
+void exportVectorFixed(const quaternionFixed* start, vectorFixed* result);
+
+//Utility functions
+void rotateVectorFixed(const quaternionFixed* axis, const vectorFixed* start, vectorFixed* result);
+void getEulerRepresentationFixed(const quaternionFixed* start, vectorFixed* result);
+
+void multiplyQuatFixed(const quaternionFixed* start, const quaternionFixed* end, quaternionFixed* result);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* QUATERNIONFIXED_H */
@@ -0,0 +1,126 @@
+/*
+ * File:   vector3dFixed.c
+ * Author: Michael Buchel
+ *
+ * Fixed point vector3d, see vector3dFixed.h
+ */
+
+#include "vector3dFixed.h"
+
+//Adding 2 vectors together
+void addFixed(const vectorFixed* start, const vectorFixed* end, vectorFixed* result) {
+    result->x = start->x + end->x;
+    result->y = start->y + end->y;
+    result->z = start->z + end->z;
+}
+
+//Subtracting 2 vectors
+void subFixed(const vectorFixed* start, const vectorFixed* end, vectorFixed* result) {
+    result->x = start->x - end->x;
+    result->y = start->y - end->y;
+    result->z = start->z - end->z;
+}
+
+//Multiplying a vector by a scalar
+void multiplyFixed(const vectorFixed* start, q16_t scalar, vectorFixed* result) {
+    result->x = mulQ16(start->x, scalar);
+    result->y = mulQ16(start->y, scalar);
+    result->z = mulQ16(start->z, scalar);
+}
+
+//Dividing a vector by a scalar, one divide for the reciprocal
+void divideFixed(const vectorFixed* start, q16_t scalar, vectorFixed* result) {
+    int bits = fixedTopBit((uint32_t) (scalar < 0 ? -scalar : scalar));
+    //2^(30 + bits) / scalar is between 2^29 and 2^30
+    int32_t reciprocal = (int32_t) ((1LL << (30 + bits)) / scalar);
+    //start * 2^16 / scalar = start * reciprocal * 2^-(14 + bits)
+    int shift = bits + 14 > 31 ? 31 : bits + 14;
+    int rest = bits + 14 - shift;
+    
+    result->x = fixedMul(start->x, reciprocal, shift) >> rest;
+    result->y = fixedMul(start->y, reciprocal, shift) >> rest;
+    result->z = fixedMul(start->z, reciprocal, shift) >> rest;
+}
+
+/*Scales the parts so the largest is 2^28 to 2^29, returns the scale as a
+ *power of 2, and the sum of squares of the scaled parts * 2^-31*/
+static int scaleParts(const vectorFixed* start, int32_t* parts, uint32_t* sumSquares) {
+    uint32_t largest = (uint32_t) (start->x < 0 ? -start->x : start->x)
+            | (uint32_t) (start->y < 0 ? -start->y : start->y)
+            | (uint32_t) (start->z < 0 ? -start->z : start->z);
+    int shift = largest ? 28 - fixedTopBit(largest) : 0;
+    int i;
+    
+    parts[0] = start->x;
+    parts[1] = start->y;
+    parts[2] = start->z;
+    *sumSquares = 0;
+    for (i = 0; i < 3; i++) {
+        parts[i] = shift >= 0 ? parts[i] << shift : parts[i] >> -shift;
+        *sumSquares += (uint32_t) fixedMul(parts[i], parts[i], 31);
+    }
+    return shift;
+}
+
+//Magnitude of a vector
+q16_t magnitudeFixed(const vectorFixed* start) {
+    int32_t parts[3];
+    uint32_t sumSquares;
+    int shift = scaleParts(start, parts, &sumSquares);
+    
+    //sqrt(sum * 2^31) * 2^-shift * 2^-16 = sqrt(sum * 2^-(2 * shift + 1))
+    return fixedSqrt(sumSquares, 2 * shift + 1);
+}
+
+/*Unit vector with frac fraction bits. The zero vector stays zero.*/
+static void normalizeParts(const vectorFixed* start, int32_t* unit, int frac) {
+    int32_t parts[3];
+    uint32_t sumSquares;
+    int32_t r;
+    int exponent;
+    int i;
+    
+    scaleParts(start, parts, &sumSquares);
+    if (sumSquares == 0) {
+        unit[0] = unit[1] = unit[2] = 0;
+        return;
+    }
+    //parts / sqrt(sum * 2^31) = parts * r * 2^-28 * 2^exponent
+    r = fixedRsqrt(sumSquares, -31, &exponent);
+    for (i = 0; i < 3; i++) {
+        int32_t v = fixedMul(parts[i], r, 28);
+        int shift = exponent + frac;
+        unit[i] = shift >= 0 ? v << shift : v >> -shift;
+    }
+}
+
+//Normalizes the vector
+void normalizeFixed(const vectorFixed* start, vectorFixed* result) {
+    int32_t unit[3];
+    normalizeParts(start, unit, 16);
+    result->x = unit[0];
+    result->y = unit[1];
+    result->z = unit[2];
+}
+
+void normalizeQ30Fixed(const vectorFixed* start, q30_t* x, q30_t* y, q30_t* z) {
+    int32_t unit[3];
+    normalizeParts(start, unit, 30);
+    *x = unit[0];
+    *y = unit[1];
+    *z = unit[2];
+}
+
+//Dot product of 2 vectors
+q16_t dotFixed(const vectorFixed* start, const vectorFixed* end) {
+    return mulQ16(start->x, end->x) + mulQ16(start->y, end->y) + mulQ16(start->z, end->z);
+}
+
+//Cross product of 2 vectors
+void crossFixed(const vectorFixed* start, const vectorFixed* end, vectorFixed* result) {
+    vectorFixed temp;
+    temp.x = mulQ16(start->y, end->z) - mulQ16(start->z, end->y);
+    temp.y = mulQ16(start->z, end->x) - mulQ16(start->x, end->z);
+    temp.z = mulQ16(start->x, end->y) - mulQ16(start->y, end->x);
+    *result = temp;
+}
@@ -0,0 +1,42 @@
+/* 
+ * File:   vector3dFixed.h
+ * Author: Michael Buchel
+ *
+ * Fixed point version of vector3d.h, Q16.16 parts. Same functions with a
+ * Fixed suffix, taking pointers instead of passing structs by value.
+ */
+
+#ifndef VECTOR3DFIXED_H
+#define	VECTOR3DFIXED_H
+
+#include "fixedPoint.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+struct Vector3dFixed {
+    q16_t x;
+    q16_t y;
+    q16_t z;
+};
+
+typedef struct Vector3dFixed vectorFixed;
+
+void addFixed(const vectorFixed* start, const vectorFixed* end, vectorFixed* result);
+void subFixed(const vectorFixed* start, const vectorFixed* end, vectorFixed* result);
+void multiplyFixed(const vectorFixed* start, q16_t scalar, vectorFixed* result);
+void divideFixed(const vectorFixed* start, q16_t scalar, vectorFixed* result);
+q16_t magnitudeFixed(const vectorFixed* start);
+void normalizeFixed(const vectorFixed* start, vectorFixed* result);
+q16_t dotFixed(const vectorFixed* start, const vectorFixed* end);
+void crossFixed(const vectorFixed* start, const vectorFixed* end, vectorFixed* result);
+
+//Unit vector to Q1.30 parts, for building quaternions
+void normalizeQ30Fixed(const vectorFixed* start, q30_t* x, q30_t* y, q30_t* z);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* VECTOR3DFIXED_H */
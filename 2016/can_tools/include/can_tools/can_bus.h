@@ -0,0 +1,53 @@
+/*
+ * @brief: CAR CAN bus description shared by the host CAN tools: message names
+ *         and classes from the firmware headers, on-wire frame length, and
+ *         candump log lines.
+ */
+
+#ifndef CAN_TOOLS_CAN_BUS_H
+#define CAN_TOOLS_CAN_BUS_H
+
+#include <linux/can.h>
+#include <stddef.h>
+#include <string>
+
+namespace can_bus
+{
+
+// Bit rate set up by CAN1Init(): 8 TQ of 2/Fcy at Fcy = 3.685MHz
+const double DEFAULT_BITRATE = 230312.5;
+
+/*
+ * message_class - class letter from CAN_Msg_Priorities.h ('A'..'D'), or '-'
+ * for IDs outside the assigned range.
+ */
+char message_class(canid_t id);
+
+/*
+ * message_name - CANMSG_ name from CAN.h if the ID has one, otherwise the
+ * CLx_PRTYnn name from CAN_Msg_Priorities.h, otherwise the hex ID.
+ */
+std::string message_name(canid_t id);
+
+/*
+ * frame_bits - length of the frame on the wire in bit times, including the
+ * stuff bits for its actual contents and the 3 bit interframe space.
+ */
+unsigned frame_bits(const struct can_frame &frame);
+
+/*
+ * parse_candump - read one `candump -l` line: "(sec.usec) iface ID#DATA".
+ * @return: false if the line is not a frame
+ */
+bool parse_candump(const char *line, double &timestamp, std::string &iface,
+  struct can_frame &frame);
+
+/*
+ * format_candump - write a frame in the same format, newline included.
+ */
+std::string format_candump(double timestamp, const std::string &iface,
+  const struct can_frame &frame);
+
+} // namespace can_bus
+
+#endif // CAN_TOOLS_CAN_BUS_H
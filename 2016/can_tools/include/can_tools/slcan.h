@@ -0,0 +1,57 @@
+/*
+ * @brief: Lawicel/slcan line encoding shared by the host CAN tools.
+ *         The CAN to USB tranciever speaks this over its serial link.
+ */
+
+#ifndef CAN_TOOLS_SLCAN_H
+#define CAN_TOOLS_SLCAN_H
+
+#include <linux/can.h>
+#include <stddef.h>
+
+namespace slcan
+{
+
+// Longest line: 'T' + 8 id + dlc + 16 data + 4 timestamp + '\r'
+const size_t MAX_LINE = 31;
+
+/*
+ * encode - write frame as one slcan line, '\r' included.
+ * @out: at least MAX_LINE bytes
+ * @return: number of bytes written
+ */
+size_t encode(const struct can_frame &frame, char *out);
+
+/*
+ * decode - parse one line (without the '\r') into a frame.
+ * @timestamp_ms: set to the trailing timestamp if there is one, else -1
+ * @return: false if the line is not a t/T/r/R frame or is malformed
+ */
+bool decode(const char *line, size_t length, struct can_frame &frame,
+  int *timestamp_ms = NULL);
+
+/*
+ * LineSplitter - collects serial bytes and hands back complete lines.
+ * Bridge acknowledgements ('\r' alone, 'z', BEL) come out as empty or short
+ * lines and can be ignored by the caller.
+ */
+class LineSplitter
+{
+private:
+  char line_[MAX_LINE + 1];
+  size_t length_;
+  bool overflow_;
+
+public:
+  LineSplitter() : length_(0), overflow_(false), errors(0) {}
+
+  // Feed one byte; returns true and sets line/length when a line completes
+  bool push(char c, const char *&line, size_t &length);
+
+  // Number of BEL error replies seen from the bridge
+  unsigned long errors;
+};
+
+} // namespace slcan
+
+#endif // CAN_TOOLS_SLCAN_H
@@ -0,0 +1,208 @@
+#include "can_tools/can_bus.h"
+
+#include "CAN.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace can_bus
+{
+
+#define MESSAGE_NAME(id) {id, #id}
+static const struct
+{
+  canid_t id;
+  const char *name;
+} MESSAGE_NAMES[] = {
+  MESSAGE_NAME(CANMSG_ESTOP),
+  MESSAGE_NAME(CANMSG_COLLEMERG),
+  MESSAGE_NAME(CANMSG_BRNOUTWARN),
+  MESSAGE_NAME(CANMSG_TEMPWARN),
+  MESSAGE_NAME(CANMSG_WHEELSPD),
+  MESSAGE_NAME(CANMSG_WHEELANG),
+  MESSAGE_NAME(CANMSG_ODOMETRY),
+  MESSAGE_NAME(CANMSG_OBSDIST),
+  MESSAGE_NAME(CANMSG_DESTRAJ),
+  MESSAGE_NAME(CANMSG_BATTWARN),
+  MESSAGE_NAME(CANMSG_NAVRPY),
+  MESSAGE_NAME(CANMSG_NAVLONLAT),
+  MESSAGE_NAME(CANMSG_START),
+  MESSAGE_NAME(CANMSG_BATTSTATUS),
+};
+
+char message_class(canid_t id)
+{
+  if ((id & CAN_EFF_FLAG) || (id & CAN_SFF_MASK) > CLD_PRTY16)
+    return '-';
+  return 'A' + CAN_MSG_CLASS(id & CAN_SFF_MASK);
+}
+
+std::string message_name(canid_t id)
+{
+  char name[16];
+  canid_t sid = id & CAN_SFF_MASK;
+  for (size_t i = 0; i < sizeof(MESSAGE_NAMES) / sizeof(MESSAGE_NAMES[0]); i++)
+  {
+    if (!(id & CAN_EFF_FLAG) && MESSAGE_NAMES[i].id == sid)
+      return MESSAGE_NAMES[i].name;
+  }
+  char cls = message_class(id);
+  if (cls != '-')
+    snprintf(name, sizeof(name), "CL%c_PRTY%02u", cls, (sid & 0xF) + 1);
+  else if (id & CAN_EFF_FLAG)
+    snprintf(name, sizeof(name), "%08X", id & CAN_EFF_MASK);
+  else
+    snprintf(name, sizeof(name), "%03X", sid);
+  return name;
+}
+
+// Bit writer that tracks the CRC and stuff bits as a controller would
+struct BitStream
+{
+  unsigned bits;
+  unsigned short crc;
+  int last;
+  int run;
+
+  BitStream() : bits(0), crc(0), last(-1), run(0) {}
+
+  void stuff(int b)
+  {
+    bits++;
+    if (b == last)
+      run++;
+    else
+    {
+      last = b;
+      run = 1;
+    }
+    if (run == 5)
+    {
+      // Complement bit goes in and starts the next run
+      bits++;
+      last = !b;
+      run = 1;
+    }
+  }
+
+  void put(int b, bool with_crc = true)
+  {
+    if (with_crc)
+    {
+      int crcnxt = b ^ ((crc >> 14) & 1);
+      crc = (crc << 1) & 0x7FFF;
+      if (crcnxt)
+        crc ^= 0x4599;
+    }
+    stuff(b);
+  }
+
+  void put_bits(unsigned long value, int count)
+  {
+    for (int i = count - 1; i >= 0; i--)
+      put((int)((value >> i) & 1));
+  }
+};
+
+unsigned frame_bits(const struct can_frame &frame)
+{
+  BitStream s;
+  bool extended = frame.can_id & CAN_EFF_FLAG;
+  bool remote = frame.can_id & CAN_RTR_FLAG;
+  unsigned dlc = frame.can_dlc > 8 ? 8 : frame.can_dlc;
+
+  s.put(0);                                     // SOF
+  if (extended)
+  {
+    canid_t id = frame.can_id & CAN_EFF_MASK;
+    s.put_bits(id >> 18, 11);                     // base ID
+    s.put(1);                                     // SRR
+    s.put(1);                                     // IDE
+    s.put_bits(id & 0x3FFFF, 18);                 // extended ID
+    s.put(remote ? 1 : 0);                        // RTR
+    s.put_bits(0UL, 2);                           // r1, r0
+  }
+  else
+  {
+    s.put_bits(frame.can_id & CAN_SFF_MASK, 11);
+    s.put(remote ? 1 : 0);                        // RTR
+    s.put_bits(0UL, 2);                           // IDE, r0
+  }
+  s.put_bits(dlc, 4);
+  if (!remote)
+  {
+    for (unsigned i = 0; i < dlc; i++)
+      s.put_bits(frame.data[i], 8);
+  }
+  unsigned short crc = s.crc;
+  for (int i = 14; i >= 0; i--)
+    s.put((crc >> i) & 1, false);
+
+  // CRC delimiter, ACK slot + delimiter, EOF, interframe space: never stuffed
+  return s.bits + 1 + 2 + 7 + 3;
+}
+
+bool parse_candump(const char *line, double &timestamp, std::string &iface,
+  struct can_frame &frame)
+{
+  char name[16];
+  char body[64];
+  if (sscanf(line, " (%lf) %15s %63s", &timestamp, name, body) != 3)
+    return false;
+  iface = name;
+
+  char *hash = strchr(body, '#');
+  if (!hash)
+    return false;
+  size_t id_len = hash - body;
+  frame = can_frame();
+  frame.can_id = strtoul(body, NULL, 16);
+  if (id_len == 8)
+    frame.can_id |= CAN_EFF_FLAG;
+  else if (id_len != 3)
+    return false;
+
+  const char *data = hash + 1;
+  if (*data == 'R')
+  {
+    frame.can_id |= CAN_RTR_FLAG;
+    frame.can_dlc = (data[1] >= '0' && data[1] <= '8') ? data[1] - '0' : 0;
+    return true;
+  }
+  size_t n = strlen(data);
+  if (n % 2 || n > 16)
+    return false;
+  for (size_t i = 0; i < n / 2; i++)
+  {
+    char byte[3] = {data[2 * i], data[2 * i + 1], 0};
+    char *end;
+    frame.data[i] = strtoul(byte, &end, 16);
+    if (*end)
+      return false;
+  }
+  frame.can_dlc = n / 2;
+  return true;
+}
+
+std::string format_candump(double timestamp, const std::string &iface,
+  const struct can_frame &frame)
+{
+  char line[80];
+  int n = snprintf(line, sizeof(line), "(%.6f) %s ", timestamp, iface.c_str());
+  if (frame.can_id & CAN_EFF_FLAG)
+    n += snprintf(line + n, sizeof(line) - n, "%08X#", frame.can_id & CAN_EFF_MASK);
+  else
+    n += snprintf(line + n, sizeof(line) - n, "%03X#", frame.can_id & CAN_SFF_MASK);
+  if (frame.can_id & CAN_RTR_FLAG)
+    n += snprintf(line + n, sizeof(line) - n, "R");
+  else
+  {
+    for (unsigned i = 0; i < frame.can_dlc && i < 8; i++)
+      n += snprintf(line + n, sizeof(line) - n, "%02X", frame.data[i]);
+  }
+  snprintf(line + n, sizeof(line) - n, "\n");
+  return line;
+}
+
+} // namespace can_bus
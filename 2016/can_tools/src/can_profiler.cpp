@@ -0,0 +1,490 @@
+/*
+ * @brief: CAN bus load and per-ID timing profiler.
+ *
+ * Reads frames live from a SocketCAN interface (slcan_bridged or a vcan,
+ * timestamped by the kernel) or from a `candump -l` log and reports:
+ *  - bus utilisation, mean and worst window, from the real on-wire length
+ *    of each frame including stuff bits
+ *  - per-ID rate, period, jitter and inter-arrival histogram
+ *  - late frames and priority inversions: a frame arriving well after its
+ *    usual period while lower priority traffic went out in the meantime
+ *  - trigger -> response latency for chosen ID pairs (-l)
+ * grouped by the message classes of CAN_Msg_Priorities.h.
+ *
+ * usage: can_profiler (-i interface | -f log) [options]
+ */
+
+#include "can_tools/can_bus.h"
+
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#define HIST_BUCKETS 22     // log2 microsecond buckets, 1us .. 2s+
+#define MIN_PERIOD_SAMPLES 8
+#define LATE_FACTOR 1.5     // "late" is this many usual periods after the last
+#define HISTORY_SECONDS 2.0
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int)
+{
+  running = 0;
+}
+
+struct IdStats
+{
+  unsigned long count;
+  unsigned long long bits;
+  double first, last;
+  // Inter-arrival time, Welford running mean/variance
+  double mean, m2, min_gap, max_gap;
+  unsigned long hist[HIST_BUCKETS];
+  unsigned long late;
+  double max_late;
+  unsigned long inversions;
+
+  IdStats() : count(0), bits(0), first(0), last(0), mean(0), m2(0),
+    min_gap(1e9), max_gap(0), late(0), max_late(0), inversions(0)
+  {
+    memset(hist, 0, sizeof(hist));
+  }
+};
+
+struct LatencyPair
+{
+  canid_t trigger, response;
+  double pending;           // time of the unanswered trigger, <0 if none
+  unsigned long count;
+  double sum, min, max;
+
+  LatencyPair(canid_t t, canid_t r) : trigger(t), response(r), pending(-1),
+    count(0), sum(0), min(1e9), max(0) {}
+};
+
+class Profiler
+{
+private:
+  double bitrate_;
+  double window_;
+  std::map<canid_t, IdStats> ids_;
+  std::vector<LatencyPair> pairs_;
+  std::deque<std::pair<double, canid_t> > history_;
+
+  unsigned long frames_;
+  unsigned long long bits_;
+  double first_, last_;
+  double window_start_;
+  unsigned long long window_bits_;
+  double peak_load_;
+
+  static canid_t key(const struct can_frame &frame)
+  {
+    return frame.can_id & (CAN_EFF_FLAG | CAN_EFF_MASK);
+  }
+
+  // Arbitration order, lower wins
+  static canid_t priority(canid_t id)
+  {
+    return (id & CAN_EFF_FLAG) ? (id & CAN_EFF_MASK) : ((id & CAN_SFF_MASK) << 18);
+  }
+
+  void close_windows(double t)
+  {
+    while (t >= window_start_ + window_)
+    {
+      double load = window_bits_ / (bitrate_ * window_);
+      if (load > peak_load_)
+        peak_load_ = load;
+      window_bits_ = 0;
+      window_start_ += window_;
+    }
+  }
+
+public:
+  Profiler(double bitrate, double window) : bitrate_(bitrate), window_(window),
+    frames_(0), bits_(0), first_(0), last_(0), window_start_(0),
+    window_bits_(0), peak_load_(0) {}
+
+  void add_pair(canid_t trigger, canid_t response)
+  {
+    pairs_.push_back(LatencyPair(trigger, response));
+  }
+
+  void add(double t, const struct can_frame &frame)
+  {
+    canid_t id = key(frame);
+    unsigned bits = can_bus::frame_bits(frame);
+
+    if (frames_ == 0)
+    {
+      first_ = t;
+      window_start_ = t;
+    }
+    frames_++;
+    bits_ += bits;
+    last_ = t;
+    close_windows(t);
+    window_bits_ += bits;
+
+    IdStats &s = ids_[id];
+    if (s.count == 0)
+      s.first = t;
+    else
+    {
+      double gap = t - s.last;
+      if (s.count >= MIN_PERIOD_SAMPLES && gap > LATE_FACTOR * s.mean)
+      {
+        double expected = s.last + s.mean;
+        s.late++;
+        if (gap - s.mean > s.max_late)
+          s.max_late = gap - s.mean;
+        // Lower priority frames sent while this one was overdue
+        for (size_t i = 0; i < history_.size(); i++)
+        {
+          if (history_[i].first > expected &&
+            priority(history_[i].second) > priority(id))
+          {
+            s.inversions++;
+            break;
+          }
+        }
+      }
+      unsigned long n = s.count;   // number of gaps including this one
+      double delta = gap - s.mean;
+      s.mean += delta / n;
+      s.m2 += delta * (gap - s.mean);
+      if (gap < s.min_gap)
+        s.min_gap = gap;
+      if (gap > s.max_gap)
+        s.max_gap = gap;
+      int bucket = 0;
+      for (double us = gap * 1e6; us >= 2 && bucket < HIST_BUCKETS - 1; us /= 2)
+        bucket++;
+      s.hist[bucket]++;
+    }
+    s.count++;
+    s.bits += bits;
+    s.last = t;
+
+    history_.push_back(std::make_pair(t, id));
+    while (!history_.empty() && history_.front().first < t - HISTORY_SECONDS)
+      history_.pop_front();
+
+    for (size_t i = 0; i < pairs_.size(); i++)
+    {
+      LatencyPair &p = pairs_[i];
+      if (id == p.trigger && p.pending < 0)
+        p.pending = t;
+      else if (id == p.response && p.pending >= 0)
+      {
+        double latency = t - p.pending;
+        p.count++;
+        p.sum += latency;
+        if (latency < p.min)
+          p.min = latency;
+        if (latency > p.max)
+          p.max = latency;
+        p.pending = -1;
+      }
+    }
+  }
+
+  void report(FILE *out, bool histograms)
+  {
+    double duration = last_ - first_;
+    if (frames_ == 0 || duration <= 0)
+    {
+      fprintf(out, "%lu frames, nothing to report\n", frames_);
+      return;
+    }
+    // Count the last, partial window if it covers at least half a window
+    double tail = last_ - window_start_;
+    if (tail >= window_ / 2 && window_bits_ / (bitrate_ * tail) > peak_load_)
+      peak_load_ = window_bits_ / (bitrate_ * tail);
+
+    fprintf(out, "bus: %lu frames in %.3f s at %.0f bit/s, utilisation "
+      "%.1f%% mean, %.1f%% peak (%.3f s windows)\n", frames_, duration,
+      bitrate_, 100.0 * bits_ / (bitrate_ * duration), 100.0 * peak_load_,
+      window_);
+
+    // Per class summary
+    unsigned long class_frames[5] = {0};
+    unsigned long long class_bits[5] = {0};
+    unsigned long class_inversions[5] = {0};
+    std::map<canid_t, IdStats>::iterator it;
+    for (it = ids_.begin(); it != ids_.end(); ++it)
+    {
+      char cls = can_bus::message_class(it->first);
+      int c = cls == '-' ? 4 : cls - 'A';
+      class_frames[c] += it->second.count;
+      class_bits[c] += it->second.bits;
+      class_inversions[c] += it->second.inversions;
+    }
+    fprintf(out, "\nclass    frames   bus%%  inversions\n");
+    for (int c = 0; c < 5; c++)
+    {
+      if (!class_frames[c])
+        continue;
+      fprintf(out, "  %c  %10lu %6.2f %11lu\n", c < 4 ? 'A' + c : '-',
+        class_frames[c], 100.0 * class_bits[c] / (bitrate_ * duration),
+        class_inversions[c]);
+    }
+
+    fprintf(out, "\n%-18s cls %8s %8s %9s %9s %9s %9s %6s %9s %5s\n",
+      "id", "count", "rate/s", "period ms", "jitter ms", "min ms", "max ms",
+      "late", "late ms", "inv");
+    for (it = ids_.begin(); it != ids_.end(); ++it)
+    {
+      IdStats &s = it->second;
+      double span = s.last - s.first;
+      double jitter = s.count > 2 ? sqrt(s.m2 / (s.count - 2)) : 0;
+      fprintf(out, "%-18s  %c  %8lu %8.1f %9.3f %9.3f %9.3f %9.3f %6lu %9.3f %5lu\n",
+        can_bus::message_name(it->first).c_str(),
+        can_bus::message_class(it->first), s.count,
+        span > 0 ? (s.count - 1) / span : 0.0, s.mean * 1e3, jitter * 1e3,
+        s.count > 1 ? s.min_gap * 1e3 : 0.0, s.max_gap * 1e3, s.late,
+        s.max_late * 1e3, s.inversions);
+    }
+
+    if (histograms)
+    {
+      fprintf(out, "\ninter-arrival histograms (bucket = up to 2^n us)\n");
+      for (it = ids_.begin(); it != ids_.end(); ++it)
+      {
+        fprintf(out, "%-18s", can_bus::message_name(it->first).c_str());
+        for (int b = 0; b < HIST_BUCKETS; b++)
+        {
+          if (it->second.hist[b])
+            fprintf(out, " %d:%lu", b + 1, it->second.hist[b]);
+        }
+        fprintf(out, "\n");
+      }
+    }
+
+    for (size_t i = 0; i < pairs_.size(); i++)
+    {
+      LatencyPair &p = pairs_[i];
+      fprintf(out, "\nlatency %s -> %s: ",
+        can_bus::message_name(p.trigger).c_str(),
+        can_bus::message_name(p.response).c_str());
+      if (p.count)
+        fprintf(out, "%lu samples, min %.3f ms, mean %.3f ms, max %.3f ms\n",
+          p.count, p.min * 1e3, p.sum / p.count * 1e3, p.max * 1e3);
+      else
+        fprintf(out, "no samples\n");
+    }
+  }
+};
+
+static int open_can(const char *ifname)
+{
+  int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (fd < 0)
+  {
+    perror("socket");
+    return -1;
+  }
+  struct ifreq ifr;
+  memset(&ifr, 0, sizeof(ifr));
+  strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    close(fd);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+  struct sockaddr_can addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Receive one frame with its kernel timestamp
+static bool read_frame(int fd, struct can_frame &frame, double &t)
+{
+  struct iovec iov = {&frame, sizeof(frame)};
+  char control[CMSG_SPACE(sizeof(struct timeval))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  if (recvmsg(fd, &msg, 0) != sizeof(frame))
+    return false;
+
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+  {
+    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMP)
+      memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+  }
+  t = tv.tv_sec + tv.tv_usec * 1e-6;
+  return true;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: can_profiler (-i interface | -f log) [options]\n"
+    "  -i iface    profile live traffic, kernel timestamps\n"
+    "  -f log      profile a candump -l log (- for stdin)\n"
+    "  -o log      also record live traffic as a candump log for can_replay\n"
+    "  -b bitrate  bus bit rate, default %.1f\n"
+    "  -w seconds  utilisation window, default 1\n"
+    "  -d seconds  stop after this long (live)\n"
+    "  -l T:R      trigger -> response latency for hex IDs T and R\n"
+    "  -H          print inter-arrival histograms\n", can_bus::DEFAULT_BITRATE);
+}
+
+int main(int argc, char **argv)
+{
+  const char *iface = NULL, *log = NULL, *record = NULL;
+  double bitrate = can_bus::DEFAULT_BITRATE, window = 1.0, duration = 0;
+  bool histograms = false;
+  std::vector<std::pair<canid_t, canid_t> > pairs;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "i:f:o:b:w:d:l:Hh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'i': iface = optarg; break;
+      case 'f': log = optarg; break;
+      case 'o': record = optarg; break;
+      case 'b': bitrate = atof(optarg); break;
+      case 'w': window = atof(optarg); break;
+      case 'd': duration = atof(optarg); break;
+      case 'H': histograms = true; break;
+      case 'l':
+      {
+        char *end;
+        canid_t t = strtoul(optarg, &end, 16);
+        if (*end != ':')
+        {
+          usage();
+          return 1;
+        }
+        pairs.push_back(std::make_pair(t, (canid_t)strtoul(end + 1, NULL, 16)));
+        break;
+      }
+      default: usage(); return 1;
+    }
+  }
+  if ((iface == NULL) == (log == NULL) || bitrate <= 0 || window <= 0)
+  {
+    usage();
+    return 1;
+  }
+
+  Profiler profiler(bitrate, window);
+  for (size_t i = 0; i < pairs.size(); i++)
+    profiler.add_pair(pairs[i].first, pairs[i].second);
+
+  // No SA_RESTART, signal() sets it and recvmsg would then block on through
+  // a ^C on an idle bus. EINTR brings the loop below round to check running.
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handle_signal;
+  sigemptyset(&sa.sa_mask);
+  sa.sa_flags = 0;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  struct can_frame frame;
+  double t;
+  if (log)
+  {
+    FILE *in = strcmp(log, "-") ? fopen(log, "r") : stdin;
+    if (!in)
+    {
+      perror(log);
+      return 1;
+    }
+    char line[128];
+    std::string name;
+    while (running && fgets(line, sizeof(line), in))
+    {
+      if (can_bus::parse_candump(line, t, name, frame))
+        profiler.add(t, frame);
+    }
+    if (in != stdin)
+      fclose(in);
+  }
+  else
+  {
+    int fd = open_can(iface);
+    if (fd < 0)
+      return 1;
+    FILE *out = record ? fopen(record, "w") : NULL;
+    if (record && !out)
+    {
+      perror(record);
+      return 1;
+    }
+    if (duration > 0)
+    {
+      // At least 1us, {0, 0} would block for good
+      struct timeval tv;
+      tv.tv_sec = (time_t)duration;
+      tv.tv_usec = (suseconds_t)((duration - tv.tv_sec) * 1e6);
+      if (tv.tv_sec == 0 && tv.tv_usec == 0)
+        tv.tv_usec = 1;
+      setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    double start = -1;
+    while (running)
+    {
+      if (!read_frame(fd, frame, t))
+      {
+        if (errno == EINTR || errno == EAGAIN)
+        {
+          if (duration > 0 && errno == EAGAIN)
+            break;
+          continue;
+        }
+        perror("recvmsg");
+        break;
+      }
+      if (start < 0)
+        start = t;
+      if (duration > 0 && t - start > duration)
+        break;
+      profiler.add(t, frame);
+      if (out)
+        fputs(can_bus::format_candump(t, iface, frame).c_str(), out);
+    }
+    if (out)
+      fclose(out);
+    close(fd);
+  }
+
+  profiler.report(stdout, histograms);
+  return 0;
+}
@@ -0,0 +1,244 @@
+/*
+ * @brief: Synthetic CAN load generator.
+ *
+ * Replays a recorded `candump -l` log (for example from can_profiler -o)
+ * onto an interface at N times its recorded speed, keeping the original
+ * inter-frame spacing scaled down. With -r the speed is raised after every
+ * pass until the interface starts refusing frames, which gives the speed-up
+ * and offered bus load at which the bus saturates. A vcan never refuses a
+ * frame, so the ramp also stops at -m times.
+ *
+ * usage: can_replay [-s speed] [-n loops] [-r step] [-m max] [-b bitrate] <log> <interface>
+ */
+
+#include "can_tools/can_bus.h"
+
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+// Where -r gives up, a vcan takes anything
+static const double DEFAULT_MAX_SPEED = 100.0;
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int)
+{
+  running = 0;
+}
+
+struct Recorded
+{
+  double offset;            // seconds from the first frame in the log
+  struct can_frame frame;
+};
+
+static int open_can(const char *ifname)
+{
+  int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (fd < 0)
+  {
+    perror("socket");
+    return -1;
+  }
+  struct ifreq ifr;
+  memset(&ifr, 0, sizeof(ifr));
+  strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    close(fd);
+    return -1;
+  }
+  // Nothing to read, only send
+  setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, NULL, 0);
+  struct sockaddr_can addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void add_seconds(struct timespec &ts, double seconds)
+{
+  long long ns = ts.tv_nsec + (long long)(seconds * 1e9);
+  ts.tv_sec += ns / 1000000000LL;
+  ts.tv_nsec = ns % 1000000000LL;
+}
+
+static double elapsed(const struct timespec &from)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - from.tv_sec) + (now.tv_nsec - from.tv_nsec) * 1e-9;
+}
+
+/*
+ * replay - one pass over the log at the given speed.
+ * @sent: frames the interface took
+ * @return: frames the interface refused (tx queue full for over 10ms)
+ */
+static unsigned long replay(int fd, const std::vector<Recorded> &log,
+  double speed, unsigned long &sent)
+{
+  unsigned long dropped = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (size_t i = 0; i < log.size() && running; i++)
+  {
+    struct timespec due = start;
+    add_seconds(due, log[i].offset / speed);
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL);
+
+    bool written = false;
+    while (running)
+    {
+      if (write(fd, &log[i].frame, sizeof(struct can_frame)) >= 0)
+      {
+        written = true;
+        break;
+      }
+      if (errno != ENOBUFS && errno != EAGAIN && errno != EINTR)
+      {
+        perror("write");
+        running = 0;
+        break;
+      }
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      if (errno != EINTR && poll(&pfd, 1, 10) <= 0)
+      {
+        dropped++;
+        break;
+      }
+    }
+    if (written)
+      sent++;
+  }
+  return dropped;
+}
+
+static void usage()
+{
+  fprintf(stderr,
+    "usage: can_replay [options] <log> <interface>\n"
+    "  -s speed    replay speed-up, default 1\n"
+    "  -n loops    passes over the log, 0 = until stopped, default 1\n"
+    "  -r step     add step to the speed after each pass, stop at the first\n"
+    "              pass with refused frames\n"
+    "  -m max      highest speed -r goes to, default %.0f\n"
+    "  -b bitrate  bus bit rate for the offered load figure, default %.1f\n",
+    DEFAULT_MAX_SPEED, can_bus::DEFAULT_BITRATE);
+}
+
+int main(int argc, char **argv)
+{
+  double speed = 1.0, step = 0, max_speed = DEFAULT_MAX_SPEED;
+  double bitrate = can_bus::DEFAULT_BITRATE;
+  long loops = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:n:r:m:b:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 's': speed = atof(optarg); break;
+      case 'n': loops = strtol(optarg, NULL, 10); break;
+      case 'r': step = atof(optarg); loops = 0; break;
+      case 'm': max_speed = atof(optarg); break;
+      case 'b': bitrate = atof(optarg); break;
+      default: usage(); return 1;
+    }
+  }
+  if (argc - optind != 2 || speed <= 0 || bitrate <= 0 || max_speed <= 0)
+  {
+    usage();
+    return 1;
+  }
+
+  FILE *in = fopen(argv[optind], "r");
+  if (!in)
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  std::vector<Recorded> log;
+  unsigned long long log_bits = 0;
+  char line[128];
+  std::string name;
+  double first = 0;
+  while (fgets(line, sizeof(line), in))
+  {
+    Recorded r;
+    double t;
+    if (!can_bus::parse_candump(line, t, name, r.frame))
+      continue;
+    if (log.empty())
+      first = t;
+    r.offset = t - first;
+    log_bits += can_bus::frame_bits(r.frame);
+    log.push_back(r);
+  }
+  fclose(in);
+  if (log.size() < 2 || log.back().offset <= 0)
+  {
+    fprintf(stderr, "%s: need at least two timestamped frames\n", argv[optind]);
+    return 1;
+  }
+  double log_span = log.back().offset;
+
+  int fd = open_can(argv[optind + 1]);
+  if (fd < 0)
+    return 1;
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+
+  printf("%zu frames over %.3f s, %.1f%% load at 1x\n", log.size(), log_span,
+    100.0 * log_bits / (bitrate * log_span));
+  for (long pass = 0; running && (loops == 0 || pass < loops); pass++)
+  {
+    unsigned long sent = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long dropped = replay(fd, log, speed, sent);
+    double took = elapsed(start);
+    printf("pass %ld: %.2fx, offered %.1f%% load, %lu sent, %lu refused, "
+      "%.0f frames/s\n", pass + 1, speed,
+      100.0 * log_bits * speed / (bitrate * log_span), sent, dropped,
+      took > 0 ? sent / took : 0.0);
+    fflush(stdout);
+    if (step > 0)
+    {
+      if (dropped)
+      {
+        printf("saturated at %.2fx\n", speed);
+        break;
+      }
+      if (speed + step > max_speed)
+      {
+        printf("not saturated up to %.2fx\n", speed);
+        break;
+      }
+      speed += step;
+    }
+  }
+  close(fd);
+  return 0;
+}
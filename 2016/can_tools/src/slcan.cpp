@@ -0,0 +1,147 @@
+#include "can_tools/slcan.h"
+
+namespace slcan
+{
+
+static const char HEX[] = "0123456789ABCDEF";
+
+static int hex_value(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// Read count hex digits from str, false on a bad digit
+static bool read_hex(const char *str, size_t count, unsigned long &value)
+{
+  value = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    int digit = hex_value(str[i]);
+    if (digit < 0)
+      return false;
+    value = (value << 4) | digit;
+  }
+  return true;
+}
+
+size_t encode(const struct can_frame &frame, char *out)
+{
+  size_t n = 0;
+  bool extended = frame.can_id & CAN_EFF_FLAG;
+  bool remote = frame.can_id & CAN_RTR_FLAG;
+  canid_t id = frame.can_id & (extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+  int id_digits = extended ? 8 : 3;
+  unsigned dlc = frame.can_dlc > 8 ? 8 : frame.can_dlc;
+
+  out[n++] = remote ? (extended ? 'R' : 'r') : (extended ? 'T' : 't');
+  for (int shift = (id_digits - 1) * 4; shift >= 0; shift -= 4)
+    out[n++] = HEX[(id >> shift) & 0xF];
+  out[n++] = HEX[dlc];
+  if (!remote)
+  {
+    for (unsigned i = 0; i < dlc; i++)
+    {
+      out[n++] = HEX[frame.data[i] >> 4];
+      out[n++] = HEX[frame.data[i] & 0xF];
+    }
+  }
+  out[n++] = '\r';
+  return n;
+}
+
+bool decode(const char *line, size_t length, struct can_frame &frame,
+  int *timestamp_ms)
+{
+  size_t id_digits;
+  bool remote;
+  unsigned long value;
+
+  if (length < 1)
+    return false;
+  switch (line[0])
+  {
+    case 't': id_digits = 3; remote = false; break;
+    case 'T': id_digits = 8; remote = false; break;
+    case 'r': id_digits = 3; remote = true; break;
+    case 'R': id_digits = 8; remote = true; break;
+    default: return false;
+  }
+  if (length < 2 + id_digits)
+    return false;
+
+  frame = can_frame();
+  if (!read_hex(&line[1], id_digits, value))
+    return false;
+  frame.can_id = value;
+  if (id_digits == 8)
+    frame.can_id = (frame.can_id & CAN_EFF_MASK) | CAN_EFF_FLAG;
+  else if (value > CAN_SFF_MASK)
+    return false;
+  if (remote)
+    frame.can_id |= CAN_RTR_FLAG;
+
+  int dlc = hex_value(line[1 + id_digits]);
+  if (dlc < 0 || dlc > 8)
+    return false;
+  frame.can_dlc = dlc;
+
+  size_t idx = 2 + id_digits;
+  if (!remote)
+  {
+    if (length < idx + 2 * dlc)
+      return false;
+    for (int i = 0; i < dlc; i++, idx += 2)
+    {
+      if (!read_hex(&line[idx], 2, value))
+        return false;
+      frame.data[i] = value;
+    }
+  }
+
+  // Optional 16-bit millisecond timestamp (Z1)
+  if (timestamp_ms)
+    *timestamp_ms = -1;
+  if (length == idx + 4)
+  {
+    if (!read_hex(&line[idx], 4, value))
+      return false;
+    if (timestamp_ms)
+      *timestamp_ms = value;
+  }
+  else if (length != idx)
+    return false;
+  return true;
+}
+
+bool LineSplitter::push(char c, const char *&line, size_t &length)
+{
+  if (c == '\a')
+  {
+    errors++;
+    return false;
+  }
+  if (c == '\n')
+    return false;
+  if (c == '\r')
+  {
+    bool complete = !overflow_;
+    line = line_;
+    length = length_;
+    length_ = 0;
+    overflow_ = false;
+    return complete;
+  }
+  if (length_ < MAX_LINE)
+    line_[length_++] = c;
+  else
+    overflow_ = true;
+  return false;
+}
+
+} // namespace slcan
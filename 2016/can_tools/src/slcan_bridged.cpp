@@ -0,0 +1,262 @@
+/*
+ * @brief: Expose the CAN to USB tranciever as a Linux SocketCAN interface.
+ *
+ * Frames read from the bridge's serial port are written to a CAN_RAW socket
+ * and frames sent on the interface go back out to the bridge, so candump,
+ * cansend and any number of nodes can share the bus without parsing the
+ * serial stream themselves. The interface can be a vcan for testing without
+ * hardware, see README.md.
+ *
+ * usage: slcan_bridged [-b baud] [-r] <tty> <interface>
+ */
+
+#include "can_tools/slcan.h"
+
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define READ_CHUNK 4096
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int)
+{
+  running = 0;
+}
+
+static speed_t to_speed(long baud)
+{
+  switch (baud)
+  {
+    case 9600: return B9600;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+  }
+}
+
+/*
+ * open_serial - raw 8N1 at the given baud, optional RTS/CTS.
+ */
+static int open_serial(const char *path, long baud, bool flow_control)
+{
+  speed_t speed = to_speed(baud);
+  if (!speed)
+  {
+    fprintf(stderr, "unsupported baud %ld\n", baud);
+    return -1;
+  }
+  int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0)
+  {
+    perror(path);
+    return -1;
+  }
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cflag |= CLOCAL | CREAD;
+    if (flow_control)
+      tio.c_cflag |= CRTSCTS;
+    else
+      tio.c_cflag &= ~CRTSCTS;
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  // A pty (vcan testing) has no termios speed, carry on regardless
+  tcflush(fd, TCIOFLUSH);
+  return fd;
+}
+
+static int open_can(const char *ifname)
+{
+  int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  if (fd < 0)
+  {
+    perror("socket");
+    return -1;
+  }
+  struct ifreq ifr;
+  memset(&ifr, 0, sizeof(ifr));
+  strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+  if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+  {
+    perror(ifname);
+    close(fd);
+    return -1;
+  }
+  struct sockaddr_can addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = ifr.ifr_ifindex;
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    perror("bind");
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  return fd;
+}
+
+// Blocking-ish write of a whole command, the tty is non-blocking
+static bool write_all(int fd, const char *data, size_t length)
+{
+  while (length > 0)
+  {
+    ssize_t n = write(fd, data, length);
+    if (n < 0)
+    {
+      if (errno == EAGAIN || errno == EINTR)
+      {
+        struct pollfd pfd = {fd, POLLOUT, 0};
+        poll(&pfd, 1, 100);
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    length -= n;
+  }
+  return true;
+}
+
+static void usage()
+{
+  fprintf(stderr, "usage: slcan_bridged [-b baud] [-r] <tty> <interface>\n"
+                  "  -b baud  serial rate, default 460800\n"
+                  "  -r       RTS/CTS flow control\n");
+}
+
+int main(int argc, char **argv)
+{
+  long baud = 460800;
+  bool flow_control = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "b:rh")) != -1)
+  {
+    switch (opt)
+    {
+      case 'b': baud = strtol(optarg, NULL, 10); break;
+      case 'r': flow_control = true; break;
+      default: usage(); return 1;
+    }
+  }
+  if (argc - optind != 2)
+  {
+    usage();
+    return 1;
+  }
+
+  int tty = open_serial(argv[optind], baud, flow_control);
+  if (tty < 0)
+    return 1;
+  int can = open_can(argv[optind + 1]);
+  if (can < 0)
+    return 1;
+
+  signal(SIGINT, handle_signal);
+  signal(SIGTERM, handle_signal);
+
+  // Flush any half line on the bridge, then open the channel
+  const char open_cmd[] = "\r\r\rC\rO\r";
+  write_all(tty, open_cmd, sizeof(open_cmd) - 1);
+
+  slcan::LineSplitter splitter;
+  unsigned long to_can = 0, to_serial = 0, dropped = 0;
+  char rx[READ_CHUNK];
+  struct can_frame frames[64];
+
+  struct pollfd fds[2] = {{tty, POLLIN, 0}, {can, POLLIN, 0}};
+  while (running)
+  {
+    if (poll(fds, 2, 500) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      perror("poll");
+      break;
+    }
+
+    // Serial -> CAN, one read can carry many lines
+    if (fds[0].revents & POLLIN)
+    {
+      ssize_t n = read(tty, rx, sizeof(rx));
+      if (n == 0)
+      {
+        fprintf(stderr, "serial port closed\n");
+        break;
+      }
+      if (n < 0)
+      {
+        if (errno != EAGAIN && errno != EINTR)
+        {
+          perror("serial read");
+          break;
+        }
+        n = 0;
+      }
+      for (ssize_t i = 0; i < n; i++)
+      {
+        const char *line;
+        size_t length;
+        struct can_frame frame;
+        if (!splitter.push(rx[i], line, length))
+          continue;
+        if (!slcan::decode(line, length, frame))
+          continue; // ack or status reply
+        if (write(can, &frame, sizeof(frame)) == sizeof(frame))
+          to_can++;
+        else
+          dropped++;
+      }
+    }
+    if (fds[0].revents & (POLLHUP | POLLERR))
+    {
+      fprintf(stderr, "serial port closed\n");
+      break;
+    }
+
+    // CAN -> serial, drain everything queued on the socket in one go
+    if (fds[1].revents & POLLIN)
+    {
+      char tx[sizeof(frames) / sizeof(frames[0]) * slcan::MAX_LINE];
+      size_t tx_length = 0;
+      int count = 0;
+      while (count < (int)(sizeof(frames) / sizeof(frames[0])) &&
+        read(can, &frames[count], sizeof(struct can_frame)) ==
+          sizeof(struct can_frame))
+      {
+        tx_length += slcan::encode(frames[count], &tx[tx_length]);
+        count++;
+      }
+      if (count && write_all(tty, tx, tx_length))
+        to_serial += count;
+    }
+  }
+
+  const char close_cmd[] = "C\r";
+  write_all(tty, close_cmd, sizeof(close_cmd) - 1);
+  fprintf(stderr, "%lu frames to CAN, %lu to serial, %lu dropped, "
+    "%lu bridge errors\n", to_can, to_serial, dropped, splitter.errors);
+  close(can);
+  close(tty);
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * File:   bench.h
+ * Author: Kevin
+ *
+ * Description: Timing for the host ISR benchmarks. Each ISR is run many
+ *              times on a worst case state and the mean wall time and, where
+ *              the kernel allows perf counters, retired host instructions
+ *              per call are printed. Host figures only track changes between
+ *              builds; the dsPIC cycle counts come from tools/isr_budget.py.
+ */
+
+#ifndef BENCH_H
+#define	BENCH_H
+
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_ITERATIONS 100000
+
+typedef void (*BenchSetup)(void);
+typedef void (*BenchRun)(void);
+
+static int BenchOpenCounter(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/*setup puts the firmware in the state to measure before every call*/
+static void Bench(const char* name, BenchSetup setup, BenchRun run)
+{
+    static int counter = -2;
+    struct timespec start, end;
+    double total = 0;
+    long long instructions = 0;
+    unsigned long i;
+
+    if (counter == -2)
+        counter = BenchOpenCounter();
+
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        if (setup)
+            setup();
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        run();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        total += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    }
+    /*Counted separately so the clock reads are not included*/
+    for (i = 0; counter >= 0 && i < BENCH_ITERATIONS; i++)
+    {
+        long long count = 0;
+        if (setup)
+            setup();
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+        run();
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &count, sizeof(count)) == sizeof(count))
+            instructions += count;
+    }
+    if (counter >= 0)
+        printf("%-28s %8.1f ns %8.1f host instructions\n", name,
+            total / BENCH_ITERATIONS, (double) instructions / BENCH_ITERATIONS);
+    else
+        printf("%-28s %8.1f ns\n", name, total / BENCH_ITERATIONS);
+}
+
+#endif	/* BENCH_H */
@@ -0,0 +1,93 @@
+/*
+ * File:   bench_can_bridge.c
+ * Author: Kevin
+ *
+ * Description: Host timing of the CAN to USB tranciever ISRs and the per
+ *              frame main loop work, see bench.h.
+ */
+
+#include <string.h>
+
+#include "bench.h"
+#include "CAN.h"
+#include "SLCAN.h"
+#include "UART.h"
+
+static unsigned int data[4] = {0x1111, 0x2222, 0x3333, 0x4444};
+static char sink[HAL_UART_QUEUE_SIZE];
+
+/*Every class has a frame queued behind a finished buffer*/
+static void SetupRefill(void)
+{
+    C1TR01CONbits.TXREQ0 = 1;
+    C1TR01CONbits.TXREQ1 = 1;
+    C1TR23CONbits.TXREQ2 = 1;
+    C1TR23CONbits.TXREQ3 = 1;
+    CAN1Transmit(0x001, 8, data);
+    CAN1Transmit(0x011, 8, data);
+    CAN1Transmit(0x021, 8, data);
+    CAN1Transmit(0x031, 8, data);
+    C1TR01CONbits.TXREQ0 = 0;
+    C1TR01CONbits.TXREQ1 = 0;
+    C1TR23CONbits.TXREQ2 = 0;
+    C1TR23CONbits.TXREQ3 = 0;
+    C1INTFbits.TBIF = 1;
+}
+
+/*A full 8 byte frame with timestamp waiting in the UART ring*/
+static void SetupUartTx(void)
+{
+    hal_uart_take(1, sink, sizeof(sink));
+    SLCANForwardFrame(ecan1MsgBuffer[4]);
+}
+
+static void RunUartTx(void)
+{
+    while (IEC0bits.U1TXIE)
+        _U1TXInterrupt();
+}
+
+static void SetupForward(void)
+{
+    UART1Init(UART1_BAUD);
+}
+
+static void RunForward(void)
+{
+    SLCANForwardFrame(ecan1MsgBuffer[4]);
+}
+
+static void RunCommand(void)
+{
+    const char* line = "t0318112233445566778\r";
+    while (*line)
+        SLCANReceiveChar(*line++);
+}
+
+static void SetupCommand(void)
+{
+    UART1Init(UART1_BAUD);
+    C1TR23CONbits.TXREQ3 = 0;
+}
+
+int main(void)
+{
+    hal_reset();
+    UART1Init(UART1_BAUD);
+    SLCANInit();
+    ecan1MsgBuffer[4][0] = 0x031 << 2;
+    ecan1MsgBuffer[4][2] = 8;
+    memcpy(&ecan1MsgBuffer[4][3], data, sizeof(data));
+    SLCANReceiveChar('O');
+    SLCANReceiveChar('\r');
+    SLCANReceiveChar('Z');
+    SLCANReceiveChar('1');
+    SLCANReceiveChar('\r');
+
+    Bench("_C1Interrupt (4 refills)", SetupRefill, _C1Interrupt);
+    Bench("_U1TXInterrupt (one frame)", SetupUartTx, RunUartTx);
+    Bench("_T1Interrupt", NULL, _T1Interrupt);
+    Bench("SLCANForwardFrame", SetupForward, RunForward);
+    Bench("slcan t command", SetupCommand, RunCommand);
+    return 0;
+}
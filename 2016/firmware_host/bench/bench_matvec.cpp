@@ -0,0 +1,165 @@
+/*
+ * File:   bench_matvec.cpp
+ * Author: Michael Buchel
+ *
+ * Description: Host timing of MatVec.h and matvec_c.h against the loops
+ *              they replace: Matrix_Multiply and Vector_Dot_Product as the
+ *              SF9DOF_AHRS sketch had them, and vector3d and vector3dFixed
+ *              from the IMU board. See bench.h.
+ */
+
+#include "bench.h"
+#include "MatVec.h"
+#include "matvec_c.h"
+#include "vector3dFixed.h"
+extern "C" {
+#include "vector3d.h"
+}
+
+using namespace matvec;
+
+static float a[3][3], b[3][3], mat[3][3];
+static float u[3], v[3];
+static vector ud, vd;
+static vectorFixed uf, vf;
+/*Results go somewhere the compiler can't drop them*/
+static volatile float sink;
+static volatile double sinkDouble;
+static volatile int32_t sinkFixed;
+
+/*As in SF9DOF_AHRS/matrix.ino before MatVec*/
+static void LoopMatrixMultiply(float a[3][3], float b[3][3], float mat[3][3])
+{
+    float op[3];
+    for (int x = 0; x < 3; x++)
+    {
+        for (int y = 0; y < 3; y++)
+        {
+            for (int w = 0; w < 3; w++)
+            {
+                op[w] = a[x][w] * b[w][y];
+            }
+            mat[x][y] = 0;
+            mat[x][y] = op[0] + op[1] + op[2];
+        }
+    }
+}
+
+/*As in SF9DOF_AHRS/Vector.ino before MatVec*/
+static float LoopDot(float vector1[3], float vector2[3])
+{
+    float op = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        op += vector1[c] * vector2[c];
+    }
+    return op;
+}
+
+static void Setup(void)
+{
+    for (int i = 0; i < 9; i++)
+    {
+        a[i / 3][i % 3] = 0.1f * i - 0.4f;
+        b[i / 3][i % 3] = 0.7f - 0.05f * i;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        u[i] = 0.3f * i - 0.2f;
+        v[i] = 1.1f - 0.4f * i;
+    }
+    ud.x = u[0];
+    ud.y = u[1];
+    ud.z = u[2];
+    vd.x = v[0];
+    vd.y = v[1];
+    vd.z = v[2];
+    uf.x = Q16_FROM_DOUBLE(u[0]);
+    uf.y = Q16_FROM_DOUBLE(u[1]);
+    uf.z = Q16_FROM_DOUBLE(u[2]);
+    vf.x = Q16_FROM_DOUBLE(v[0]);
+    vf.y = Q16_FROM_DOUBLE(v[1]);
+    vf.z = Q16_FROM_DOUBLE(v[2]);
+}
+
+static void RunLoopMultiply(void)
+{
+    LoopMatrixMultiply(a, b, mat);
+    sink = mat[2][2];
+}
+
+static void RunMatMultiply(void)
+{
+    const Mat3f r = loadMat<3, 3>(&a[0][0]) * loadMat<3, 3>(&b[0][0]);
+    store(r, &mat[0][0]);
+    sink = mat[2][2];
+}
+
+static void RunShimMultiply(void)
+{
+    mm33_mul_f(&mat[0][0], &a[0][0], &b[0][0]);
+    sink = mat[2][2];
+}
+
+static void RunLoopDot(void)
+{
+    sink = LoopDot(u, v);
+}
+
+static void RunVecDot(void)
+{
+    sink = dot(load<3>(u), load<3>(v));
+}
+
+static void RunVector3dCross(void)
+{
+    sinkDouble = cross(ud, vd).z;
+}
+
+static void RunVecCrossDouble(void)
+{
+    const Vec<3, double> x = {{ud.x, ud.y, ud.z}}, y = {{vd.x, vd.y, vd.z}};
+    sinkDouble = cross(x, y)[2];
+}
+
+static void RunCrossFixed(void)
+{
+    vectorFixed r;
+    crossFixed(&uf, &vf, &r);
+    sinkFixed = r.z;
+}
+
+static void RunVecCrossQ16(void)
+{
+    const Vec3q x = {{Q16::fromRaw(uf.x), Q16::fromRaw(uf.y), Q16::fromRaw(uf.z)}};
+    const Vec3q y = {{Q16::fromRaw(vf.x), Q16::fromRaw(vf.y), Q16::fromRaw(vf.z)}};
+    sinkFixed = cross(x, y)[2].raw;
+}
+
+static void RunDotFixed(void)
+{
+    sinkFixed = dotFixed(&uf, &vf);
+}
+
+static void RunShimDotQ16(void)
+{
+    const int32_t x[3] = {uf.x, uf.y, uf.z}, y[3] = {vf.x, vf.y, vf.z};
+    sinkFixed = mv3_dot_q16(x, y);
+}
+
+int main(void)
+{
+    Setup();
+    Bench("Matrix_Multiply loops", Setup, RunLoopMultiply);
+    Bench("Mat3f operator*", Setup, RunMatMultiply);
+    Bench("mm33_mul_f", Setup, RunShimMultiply);
+    Bench("Vector_Dot_Product loop", Setup, RunLoopDot);
+    Bench("dot(Vec3f)", Setup, RunVecDot);
+    Bench("vector3d cross", Setup, RunVector3dCross);
+    Bench("cross(Vec<3, double>)", Setup, RunVecCrossDouble);
+    Bench("crossFixed", Setup, RunCrossFixed);
+    Bench("cross(Vec3q)", Setup, RunVecCrossQ16);
+    Bench("dotFixed", Setup, RunDotFixed);
+    Bench("mv3_dot_q16", Setup, RunShimDotQ16);
+    return 0;
+}
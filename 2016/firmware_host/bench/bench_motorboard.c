@@ -0,0 +1,60 @@
+/*
+ * File:   bench_motorboard.c
+ * Author: Jacob
+ *
+ * Description: Host timing of the motorboard.X ISRs, see bench.h.
+ */
+
+#include "bench.h"
+#include "motorboard_sim.h"
+#include "control.h"
+
+/*All four wheels in the median regime, the slow path of _T3Interrupt*/
+static void SetupWheelsSlow(void)
+{
+    unsigned int i;
+    wheelSpeed_init();
+    for (i = 0; i < WHEEL_MEDIAN_TAPS + 1; i++)
+    {
+        SimAdvance(SimPeriod(100) / 2);
+        SimEdge(WHEEL_FL);
+        SimEdge(WHEEL_FR);
+        SimEdge(WHEEL_BL);
+        SimEdge(WHEEL_BR);
+    }
+    _T3Interrupt();
+    SimAdvance(SimPeriod(100) / 2);
+    SimEdge(WHEEL_FL);
+    SimEdge(WHEEL_FR);
+    SimEdge(WHEEL_BL);
+    SimEdge(WHEEL_BR);
+}
+
+static void SetupCapture(void)
+{
+    SimAdvance(100);
+    IC1BUF = TMR2;
+}
+
+/*Speed loop active and steering slewing*/
+static void SetupControl(void)
+{
+    static int toggle = 0;
+    WheelSpeed[WHEEL_FL] = 500;
+    WheelSpeed[WHEEL_FR] = 500;
+    WheelSpeed[WHEEL_BL] = 500;
+    WheelSpeed[WHEEL_BR] = 500;
+    ControlSetTarget(1000, (toggle ^= 1) ? 1000 : 2000);
+    SimAdvance(CONTROL_PERIOD_TICKS);
+}
+
+int main(void)
+{
+    SimReset();
+    control_init();
+    Bench("_IC1Interrupt", SetupCapture, _IC1Interrupt);
+    Bench("_T2Interrupt", NULL, _T2Interrupt);
+    Bench("_T3Interrupt (median)", SetupWheelsSlow, _T3Interrupt);
+    Bench("_T1Interrupt (control)", SetupControl, _T1Interrupt);
+    return 0;
+}
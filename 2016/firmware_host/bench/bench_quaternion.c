@@ -0,0 +1,129 @@
+/*
+ * File:   bench_quaternion.c
+ * Author: Michael Buchel
+ *
+ * Description: Host timing of the WEbots_CAR_IMU&GPS.X attitude math, double
+ *              against fixed point, see bench.h. On the host the double
+ *              versions have an FPU, on the dsPIC they don't: budgets/imu.budget
+ *              gives the target comparison.
+ */
+
+#include "bench.h"
+#include "quaternion.h"
+#include "quaternionFixed.h"
+
+static quaternion q, p;
+static quaternionFixed qf, pf;
+static vector v;
+static vectorFixed vf;
+/*Results go somewhere the compiler can't drop them*/
+static volatile double sink;
+static volatile int32_t sinkFixed;
+
+static void Setup(void)
+{
+    init2(&q, 0.5, -0.5, 0.5, 0.5);
+    init2(&p, 0.9, 0.1, -0.3, 0.3);
+    normalizeQuat(&p);
+    init2Fixed(&qf, Q30_FROM_DOUBLE(q.w), Q30_FROM_DOUBLE(q.x), Q30_FROM_DOUBLE(q.y), Q30_FROM_DOUBLE(q.z));
+    init2Fixed(&pf, Q30_FROM_DOUBLE(p.w), Q30_FROM_DOUBLE(p.x), Q30_FROM_DOUBLE(p.y), Q30_FROM_DOUBLE(p.z));
+    v.x = 0.3;
+    v.y = -9.7;
+    v.z = 1.2;
+    vf.x = Q16_FROM_DOUBLE(v.x);
+    vf.y = Q16_FROM_DOUBLE(v.y);
+    vf.z = Q16_FROM_DOUBLE(v.z);
+}
+
+static void RunMultiply(void)
+{
+    sink = multiplyQuat(q, p).w;
+}
+
+static void RunMultiplyFixed(void)
+{
+    quaternionFixed r;
+    multiplyQuatFixed(&qf, &pf, &r);
+    sinkFixed = r.w;
+}
+
+static void RunNormalize(void)
+{
+    normalizeQuat(&p);
+    sink = p.w;
+}
+
+static void RunNormalizeFixed(void)
+{
+    normalizeQuatFixed(&pf);
+    sinkFixed = pf.w;
+}
+
+static void RunRotate(void)
+{
+    sink = rotateVector(q, v).x;
+}
+
+static void RunRotateFixed(void)
+{
+    vectorFixed r;
+    rotateVectorFixed(&qf, &vf, &r);
+    sinkFixed = r.x;
+}
+
+static void RunEuler(void)
+{
+    sink = getEulerRepresentation(p).x;
+}
+
+static void RunEulerFixed(void)
+{
+    vectorFixed r;
+    getEulerRepresentationFixed(&pf, &r);
+    sinkFixed = r.x;
+}
+
+/*Largest difference from the double version over a sweep of rotations*/
+static void Accuracy(void)
+{
+    double quatErr = 0, rotateErr = 0, eulerErr = 0;
+    int i;
+    for (i = 0; i < 1000; i++)
+    {
+        quaternion a, r;
+        quaternionFixed af, rf;
+        vector e;
+        vectorFixed ef;
+        init2(&a, cos(i * 0.0031), sin(i * 0.0131), cos(i * 0.0071), sin(i * 0.0191));
+        normalizeQuat(&a);
+        init2Fixed(&af, Q30_FROM_DOUBLE(a.w), Q30_FROM_DOUBLE(a.x), Q30_FROM_DOUBLE(a.y), Q30_FROM_DOUBLE(a.z));
+
+        r = multiplyQuat(a, p);
+        multiplyQuatFixed(&af, &pf, &rf);
+        quatErr = fmax(quatErr, fabs(Q30_TO_DOUBLE(rf.x) - r.x));
+
+        e = rotateVector(a, v);
+        rotateVectorFixed(&af, &vf, &ef);
+        rotateErr = fmax(rotateErr, fabs(Q16_TO_DOUBLE(ef.y) - e.y));
+
+        e = getEulerRepresentation(a);
+        getEulerRepresentationFixed(&af, &ef);
+        eulerErr = fmax(eulerErr, fabs(Q16_TO_DOUBLE(ef.z) - e.z));
+    }
+    printf("max error: multiply %.2g, rotate %.2g, euler %.2g rad\n", quatErr, rotateErr, eulerErr);
+}
+
+int main(void)
+{
+    Setup();
+    Bench("multiplyQuat", Setup, RunMultiply);
+    Bench("multiplyQuatFixed", Setup, RunMultiplyFixed);
+    Bench("normalizeQuat", Setup, RunNormalize);
+    Bench("normalizeQuatFixed", Setup, RunNormalizeFixed);
+    Bench("rotateVector", Setup, RunRotate);
+    Bench("rotateVectorFixed", Setup, RunRotateFixed);
+    Bench("getEulerRepresentation", Setup, RunEuler);
+    Bench("getEulerRepresentationFixed", Setup, RunEulerFixed);
+    Accuracy();
+    return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * File:   bench_tinygps.cpp
+ * Author: Kevin
+ *
+ * Description: Replays NMEA logs through the 2014 IMU-GPS TinyGPS++ and
+ *              prints bytes per second for encode(char) and the buffer
+ *              encode, then the cost of each sentence type. Give recorded
+ *              logs as arguments (raw receiver output, CR LF or LF); with
+ *              none, a generated 10 Hz drive of RMC, GGA, GSA, GSV and VTG
+ *              is used. The custom fields of the UsingCustomFields example
+ *              are registered, as a sketch would.
+ */
+
+#include <TinyGPS++.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+#define MIN_SECONDS 0.5
+
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void Append(std::string& log, const char* body)
+{
+    unsigned char cs = 0;
+    char line[128];
+    for (const char* p = body; *p; p++)
+        cs ^= (unsigned char) *p;
+    snprintf(line, sizeof(line), "$%s*%02X\r\n", body, cs);
+    log += line;
+}
+
+/*Ten minutes at 10 Hz, 2 m/s north east from the Queen's campus*/
+static std::string GenerateLog(void)
+{
+    std::string log;
+    char body[128];
+    for (int i = 0; i < 6000; i++)
+    {
+        double minutes = 13.1234 + i * 0.2 / 1852.0;
+        int s = i / 10, cs = (i % 10) * 10;
+        snprintf(body, sizeof(body), "GPRMC,%02d%02d%02d.%02d,A,44%07.4f,N,076%07.4f,W,003.9,045.0,190916,,,A",
+                 14, s / 60 % 60, s % 60, cs, minutes, 29.8765 - (minutes - 13.1234));
+        Append(log, body);
+        snprintf(body, sizeof(body), "GPGGA,%02d%02d%02d.%02d,44%07.4f,N,076%07.4f,W,1,09,0.9,92.%d,M,-34.2,M,,",
+                 14, s / 60 % 60, s % 60, cs, minutes, 29.8765 - (minutes - 13.1234), i % 10);
+        Append(log, body);
+        Append(log, "GPGSA,A,3,02,05,06,09,12,17,19,24,25,,,,1.7,0.9,1.4");
+        if (i % 10 == 0)
+        {
+            Append(log, "GPGSV,3,1,11,02,48,291,44,05,31,071,41,06,21,187,38,09,12,320,33");
+            Append(log, "GPGSV,3,2,11,12,67,103,45,17,08,255,29,19,44,144,42,24,15,047,36");
+            Append(log, "GPGSV,3,3,11,25,57,211,43,29,03,012,,31,02,330,");
+        }
+        Append(log, "GPVTG,045.0,T,057.8,M,003.9,N,007.2,K,A");
+    }
+    return log;
+}
+
+static bool ReadLog(const char* path, std::string& log)
+{
+    FILE* f = fopen(path, "rb");
+    char chunk[4096];
+    size_t n;
+    if (!f)
+        return false;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        log.append(chunk, n);
+    fclose(f);
+    return true;
+}
+
+/*Seconds per pass over log, fed in UART sized buffers or one character at
+ *a time*/
+static double Replay(const std::string& log, size_t chunk, unsigned long* sentences)
+{
+    double start = Now(), elapsed;
+    unsigned long passes = 0;
+    do
+    {
+        TinyGPSPlus gps;
+        TinyGPSCustom pdop(gps, "GPGSA", 15), hdop(gps, "GPGSA", 16), vdop(gps, "GPGSA", 17);
+        const char* p = log.data();
+        const char* end = p + log.size();
+        if (chunk == 0)
+        {
+            for (; p != end; p++)
+                gps.encode(*p);
+        }
+        else
+        {
+            for (; p < end; p += chunk)
+                gps.encode(p, (size_t) (end - p) < chunk ? (size_t) (end - p) : chunk);
+        }
+        *sentences = gps.passedChecksum() + gps.failedChecksum();
+        passes++;
+        elapsed = Now() - start;
+    } while (elapsed < MIN_SECONDS);
+    return elapsed / passes;
+}
+
+int main(int argc, char** argv)
+{
+    std::string log;
+    unsigned long sentences;
+
+    if (argc < 2)
+    {
+        log = GenerateLog();
+        printf("generated log, ");
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        if (!ReadLog(argv[i], log))
+        {
+            fprintf(stderr, "can't read %s\n", argv[i]);
+            return 1;
+        }
+    }
+    printf("%lu bytes\n", (unsigned long) log.size());
+
+    {
+        static const size_t chunks[] = {0, 16, 64, 4096};
+        for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+        {
+            double t = Replay(log, chunks[i], &sentences);
+            char name[32];
+            if (chunks[i] == 0)
+                snprintf(name, sizeof(name), "encode(char)");
+            else
+                snprintf(name, sizeof(name), "encode(buf, %lu)", (unsigned long) chunks[i]);
+            printf("%-24s %8.1f MB/s %8.1f ns/sentence\n", name,
+                   log.size() / t * 1e-6, t * 1e9 / sentences);
+        }
+    }
+
+    /*Each sentence type on its own, by the name after '$'*/
+    {
+        std::vector<std::string> names, logs;
+        size_t pos = 0;
+        while ((pos = log.find('$', pos)) != std::string::npos)
+        {
+            size_t end = log.find('$', pos + 1);
+            std::string sentence = log.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+            std::string name = sentence.substr(1, sentence.find(',') - 1);
+            size_t k;
+            for (k = 0; k < names.size() && names[k] != name; k++);
+            if (k == names.size())
+            {
+                names.push_back(name);
+                logs.push_back(std::string());
+            }
+            logs[k] += sentence;
+            pos = end;
+        }
+        for (size_t k = 0; k < names.size(); k++)
+        {
+            double t = Replay(logs[k], 64, &sentences);
+            printf("%-24s %8.1f ns/sentence (%lu)\n", names[k].c_str(), t * 1e9 / sentences, sentences);
+        }
+    }
+    return 0;
+}
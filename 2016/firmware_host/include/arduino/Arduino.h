@@ -0,0 +1,105 @@
+/*
+ * File:   Arduino.h
+ * Author: Kevin
+ *
+ * Description: Host stand in for the Arduino core, for building the 2014
+ *              and 2015 Arduino libraries with the host g++. Only what
+ *              those libraries use is here. millis() and micros() read
+ *              hostMicros, which a test or benchmark moves itself, and
+ *              noInterrupts() just counts so a test can see it balanced.
+ *              Pins are levels in hostPinLevel; a test drives an input
+ *              with hostPinSet(), which runs its attached interrupt, and
+ *              sees output pulses too short to sample in hostPinRises.
+ *              Analog inputs read hostAnalog.
+ */
+
+#ifndef ARDUINO_H
+#define	ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+#define sq(x) ((x)*(x))
+
+/*src/arduino_host.cpp*/
+extern uint32_t hostMicros;
+
+static inline uint32_t millis(void)
+{
+    return hostMicros / 1000;
+}
+
+static inline uint32_t micros(void)
+{
+    return hostMicros;
+}
+
+static inline void delayMicroseconds(uint32_t us)
+{
+    hostMicros += us;
+}
+
+static inline void delay(uint32_t ms)
+{
+    hostMicros += ms * 1000;
+}
+
+/*Interrupts are never taken on the host, so only the nesting is kept*/
+extern int hostInterruptsOff;
+
+static inline void noInterrupts(void)
+{
+    hostInterruptsOff++;
+}
+
+static inline void interrupts(void)
+{
+    hostInterruptsOff--;
+}
+
+/*Pins, src/arduino_host.cpp*/
+#define HOST_PINS 64
+extern uint8_t hostPinLevel[HOST_PINS];
+extern uint8_t hostPinMode[HOST_PINS];
+extern unsigned int hostPinRises[HOST_PINS];
+extern int hostAnalog[HOST_PINS];
+
+#define digitalPinToInterrupt(pin) (pin)
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+int analogRead(uint8_t pin);
+
+/*Nothing drives a pulse on its own on the host, so this always times out*/
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000);
+
+/*Test side: sets an input's level, running its interrupt on a matching edge*/
+void hostPinSet(uint8_t pin, uint8_t level);
+
+#endif	/* ARDUINO_H */
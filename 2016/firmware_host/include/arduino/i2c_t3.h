@@ -0,0 +1,94 @@
+/*
+ * File:   i2c_t3.h
+ * Author: Kevin
+ *
+ * Description: Host stand in for the Teensy i2c_t3 library: the
+ *              non-blocking master calls on a simulated bus. A transfer
+ *              started with sendTransmission() or sendRequest() stays on
+ *              the bus until the test calls i2c_sim_step(), which finishes
+ *              it against the simulated devices and makes the
+ *              onMasterDone() callback, as the ISR does. The blocking
+ *              endTransmission() and requestFrom() step the bus themselves.
+ *              Wire1 is a slave whose onReceive() and onRequest() callbacks
+ *              are driven by i2c_sim_slave_transfer(), or by Wire when it
+ *              addresses i2c_sim_slave().
+ */
+
+#ifndef I2C_T3_H
+#define	I2C_T3_H
+
+#include <Arduino.h>
+
+enum i2c_stop   {I2C_NOSTOP, I2C_STOP};
+enum i2c_status {I2C_WAITING,
+                 I2C_SENDING,
+                 I2C_SEND_ADDR,
+                 I2C_RECEIVING,
+                 I2C_TIMEOUT,
+                 I2C_ADDR_NAK,
+                 I2C_DATA_NAK,
+                 I2C_ARB_LOST,
+                 I2C_SLAVE_TX,
+                 I2C_SLAVE_RX};
+
+#define I2C_SIM_BUFFER_LENGTH 259
+
+class i2c_t3
+{
+public:
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t quantity);
+    void sendTransmission(i2c_stop sendStop);
+    void sendRequest(uint8_t addr, size_t len, i2c_stop sendStop);
+    uint8_t endTransmission(i2c_stop sendStop = I2C_STOP, uint32_t timeout = 0);
+    size_t requestFrom(uint8_t addr, size_t len, i2c_stop sendStop = I2C_STOP, uint32_t timeout = 0);
+    i2c_status status(void) { return currentStatus; }
+    int available(void) { return (int) (rxLength - rxIndex); }
+    uint8_t readByte(void) { return rxIndex < rxLength ? rxBuffer[rxIndex++] : 0; }
+    int read(void) { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+    uint8_t finish(uint32_t timeout);
+    void onMasterDone(void (*function)(void)) { user_onMasterDone = function; }
+    void onReceive(void (*function)(size_t len)) { user_onReceive = function; }
+    void onRequest(void (*function)(void)) { user_onRequest = function; }
+
+    /*Simulation state, for i2c_sim_* */
+    volatile i2c_status currentStatus;
+    void (*user_onMasterDone)(void);
+    void (*user_onReceive)(size_t len);
+    void (*user_onRequest)(void);
+    uint8_t txAddress, txBuffer[I2C_SIM_BUFFER_LENGTH];
+    size_t txLength;
+    uint8_t rxAddress, rxBuffer[I2C_SIM_BUFFER_LENGTH];
+    size_t rxLength, rxIndex, reqCount;
+    i2c_stop stop;
+};
+
+extern i2c_t3 Wire;
+extern i2c_t3 Wire1;
+
+/*Test side*/
+
+/*Idle buses, no devices, no callbacks*/
+void i2c_sim_reset(void);
+/*A device at address with 256 registers; a register write sets the
+ *pointer to reg & regMask and each byte read moves it on by one*/
+void i2c_sim_device(uint8_t address, uint8_t* registers, uint8_t regMask);
+/*The device at address stops acknowledging (or starts again)*/
+void i2c_sim_nak(uint8_t address, int nak);
+/*Wire1 answers Wire at address, through its slave callbacks; a read past
+ *what onRequest queued gets 0xFF*/
+void i2c_sim_slave(uint8_t address);
+/*A device holds the bus: i2c_sim_step() does nothing*/
+void i2c_sim_hang(int hang);
+/*Finishes the transfer on the bus and calls back; 0 if the bus was idle*/
+int i2c_sim_step(void);
+/*Transfers started, and how many began with a repeated start*/
+unsigned int i2c_sim_transfers(void);
+unsigned int i2c_sim_repeated_starts(void);
+/*A master writes wlen bytes to Wire1, then with a repeated start reads len
+ *(if len isn't 0). Returns how many bytes the onRequest callback queued, of
+ *which up to len are copied to read*/
+size_t i2c_sim_slave_transfer(const uint8_t* write, size_t wlen, uint8_t* read, size_t len);
+
+#endif	/* I2C_T3_H */
@@ -0,0 +1,47 @@
+/*
+ * File:   hal_host.h
+ * Author: Kevin
+ *
+ * Description: Test side of the host device stubs. The UART data registers
+ *              are backed by queues so a test can feed received characters
+ *              and collect everything the firmware transmitted; everything
+ *              else is a plain variable the test sets or checks directly.
+ */
+
+#ifndef HAL_HOST_H
+#define	HAL_HOST_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define HAL_UART_COUNT      2
+#define HAL_UART_QUEUE_SIZE 4096
+
+    /*UxTXREG writes append to the TX capture, UxRXREG reads take the next
+     *injected character and keep UxSTAbits.URXDA up to date*/
+    volatile unsigned int* hal_uart_txreg(unsigned int uart);
+    volatile unsigned int* hal_uart_rxreg(unsigned int uart);
+#define U1TXREG (*hal_uart_txreg(1))
+#define U1RXREG (*hal_uart_rxreg(1))
+#define U2TXREG (*hal_uart_txreg(2))
+#define U2RXREG (*hal_uart_rxreg(2))
+
+    /*Zero every SFR and empty the UART queues*/
+    void hal_reset(void);
+
+    /*Queue characters as if they arrived on the given UART*/
+    void hal_uart_inject(unsigned int uart, const char* data, unsigned int length);
+
+    /*Move up to max transmitted characters out, returns the count*/
+    unsigned int hal_uart_take(unsigned int uart, char* data, unsigned int max);
+
+    /*Called from __delay_ms with its argument, NULL for none. hal_reset()
+     *clears it.*/
+    void hal_set_delay_hook(void (*hook)(unsigned long ms));
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HAL_HOST_H */
@@ -0,0 +1,20 @@
+/*
+ * File:   libpic30.h
+ * Author: Kevin
+ *
+ * Description: Host stand-in for the XC16 libpic30.h. The delays return
+ *              straight away, the tests step time themselves. __delay_ms
+ *              calls the hook from hal_set_delay_hook(), if any, so a test
+ *              can answer the firmware while it waits.
+ */
+
+#ifndef LIBPIC30_HOST_H
+#define	LIBPIC30_HOST_H
+
+void hal_delay_ms(unsigned long ms);
+
+#define __delay_ms(d) hal_delay_ms(d)
+#define __delay_us(d)
+#define __delay32(d)
+
+#endif	/* LIBPIC30_HOST_H */
@@ -0,0 +1,13 @@
+/*
+ * File:   p33EP256MU806.h
+ * Author: Kevin
+ *
+ * Description: Host stand-in for the XC16 p33EP256MU806.h, see p33Exxxx.h.
+ */
+
+#ifndef P33EP256MU806_HOST_H
+#define	P33EP256MU806_HOST_H
+
+#include <p33Exxxx.h>
+
+#endif	/* P33EP256MU806_HOST_H */
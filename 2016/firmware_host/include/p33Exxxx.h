@@ -0,0 +1,49 @@
+/*
+ * File:   p33Exxxx.h
+ * Author: Kevin
+ *
+ * Description: Host (gcc/Linux) stand-in for the XC16 device header, so the
+ *              board sources build unchanged for the unit tests and
+ *              benchmarks. Every SFR is an ordinary variable with its bits
+ *              view aliased onto it, as the real header does with the linker
+ *              script. See hal_host.h for the registers with side effects.
+ */
+
+#ifndef P33EXXXX_HOST_H
+#define	P33EXXXX_HOST_H
+
+#ifndef __HOST_SIM__
+#error "host build only, use the XC16 device header on the target"
+#endif
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+/*XC16 attributes and builtins with no meaning on the host. __interrupt__
+ *would make gcc emit an x86 interrupt handler, keep the ISRs plain calls*/
+#define __interrupt__ __used__
+#define no_auto_psv __used__
+#define auto_psv __used__
+#define Nop()
+#define ClrWdt()
+#define Idle()
+#define Sleep()
+
+#define SFR(name, fields) \
+    extern volatile unsigned int name; \
+    typedef struct tag##name##BITS { fields } name##BITS; \
+    extern volatile name##BITS name##bits;
+#define SFR_PLAIN(name) \
+    extern volatile unsigned int name;
+#include "sfr_list.h"
+#undef SFR
+#undef SFR_PLAIN
+
+#ifdef	__cplusplus
+}
+#endif
+
+#include "hal_host.h"
+
+#endif	/* P33EXXXX_HOST_H */
@@ -0,0 +1,266 @@
+/*
+ * File:   sfr_list.h
+ * Author: Kevin
+ *
+ * Description: The dsPIC33EP256MU806 SFRs the firmware uses, as an X-macro
+ *              list for p33Exxxx.h and hal_host.c. SFR(name, bits) is a
+ *              register with a namebits view, SFR_PLAIN(name) one without.
+ *              Bit positions follow the datasheet where a register is used
+ *              both whole and by field. Add to it as firmware needs more.
+ */
+
+/*No include guard, included once per expansion of SFR/SFR_PLAIN*/
+
+/*Interrupt controller*/
+SFR(IFS0, unsigned INT0IF:1; unsigned IC1IF:1; unsigned OC1IF:1; unsigned T1IF:1;
+    unsigned DMA0IF:1; unsigned IC2IF:1; unsigned OC2IF:1; unsigned T2IF:1;
+    unsigned T3IF:1; unsigned SPI1EIF:1; unsigned SPI1IF:1; unsigned U1RXIF:1;
+    unsigned U1TXIF:1; unsigned AD1IF:1; unsigned DMA1IF:1; unsigned NVMIF:1;)
+SFR(IEC0, unsigned INT0IE:1; unsigned IC1IE:1; unsigned OC1IE:1; unsigned T1IE:1;
+    unsigned DMA0IE:1; unsigned IC2IE:1; unsigned OC2IE:1; unsigned T2IE:1;
+    unsigned T3IE:1; unsigned SPI1EIE:1; unsigned SPI1IE:1; unsigned U1RXIE:1;
+    unsigned U1TXIE:1; unsigned AD1IE:1; unsigned DMA1IE:1; unsigned NVMIE:1;)
+SFR(IFS1, unsigned SI2C1IF:1; unsigned MI2C1IF:1; unsigned CMIF:1; unsigned CNIF:1;
+    unsigned INT1IF:1; unsigned AD2IF:1; unsigned IC7IF:1; unsigned IC8IF:1;
+    unsigned DMA2IF:1; unsigned OC3IF:1; unsigned OC4IF:1; unsigned T4IF:1;
+    unsigned T5IF:1; unsigned INT2IF:1; unsigned U2RXIF:1; unsigned U2TXIF:1;)
+SFR(IEC1, unsigned SI2C1IE:1; unsigned MI2C1IE:1; unsigned CMIE:1; unsigned CNIE:1;
+    unsigned INT1IE:1; unsigned AD2IE:1; unsigned IC7IE:1; unsigned IC8IE:1;
+    unsigned DMA2IE:1; unsigned OC3IE:1; unsigned OC4IE:1; unsigned T4IE:1;
+    unsigned T5IE:1; unsigned INT2IE:1; unsigned U2RXIE:1; unsigned U2TXIE:1;)
+SFR(IFS2, unsigned SPI2EIF:1; unsigned SPI2IF:1; unsigned C1RXIF:1; unsigned C1IF:1;
+    unsigned DMA3IF:1; unsigned IC3IF:1; unsigned IC4IF:1; unsigned IC5IF:1;
+    unsigned IC6IF:1; unsigned OC5IF:1; unsigned OC6IF:1; unsigned OC7IF:1;
+    unsigned OC8IF:1; unsigned PMPIF:1; unsigned DMA4IF:1; unsigned T6IF:1;)
+SFR(IEC2, unsigned SPI2EIE:1; unsigned SPI2IE:1; unsigned C1RXIE:1; unsigned C1IE:1;
+    unsigned DMA3IE:1; unsigned IC3IE:1; unsigned IC4IE:1; unsigned IC5IE:1;
+    unsigned IC6IE:1; unsigned OC5IE:1; unsigned OC6IE:1; unsigned OC7IE:1;
+    unsigned OC8IE:1; unsigned PMPIE:1; unsigned DMA4IE:1; unsigned T6IE:1;)
+SFR(IPC0, unsigned INT0IP:3; unsigned :1; unsigned IC1IP:3; unsigned :1;
+    unsigned OC1IP:3; unsigned :1; unsigned T1IP:3;)
+SFR(IPC1, unsigned DMA0IP:3; unsigned :1; unsigned IC2IP:3; unsigned :1;
+    unsigned OC2IP:3; unsigned :1; unsigned T2IP:3;)
+SFR(IPC2, unsigned T3IP:3; unsigned :1; unsigned SPI1EIP:3; unsigned :1;
+    unsigned SPI1IP:3; unsigned :1; unsigned U1RXIP:3;)
+SFR(IPC3, unsigned U1TXIP:3; unsigned :1; unsigned AD1IP:3; unsigned :1;
+    unsigned DMA1IP:3; unsigned :1; unsigned NVMIP:3;)
+SFR(IPC5, unsigned INT1IP:3; unsigned :1; unsigned AD2IP:3; unsigned :1;
+    unsigned IC7IP:3; unsigned :1; unsigned IC8IP:3;)
+SFR(IPC6, unsigned DMA2IP:3; unsigned :1; unsigned OC3IP:3; unsigned :1;
+    unsigned OC4IP:3; unsigned :1; unsigned T4IP:3;)
+SFR(IPC7, unsigned T5IP:3; unsigned :1; unsigned INT2IP:3; unsigned :1;
+    unsigned U2RXIP:3; unsigned :1; unsigned U2TXIP:3;)
+SFR(IPC8, unsigned SPI2EIP:3; unsigned :1; unsigned SPI2IP:3; unsigned :1;
+    unsigned C1RXIP:3; unsigned :1; unsigned C1IP:3;)
+SFR(IPC9, unsigned DMA3IP:3; unsigned :1; unsigned IC3IP:3; unsigned :1;
+    unsigned IC4IP:3; unsigned :1; unsigned IC5IP:3;)
+SFR(INTCON2, unsigned INT0EP:1; unsigned INT1EP:1; unsigned INT2EP:1;
+    unsigned INT3EP:1; unsigned INT4EP:1; unsigned :8; unsigned DISI:1;
+    unsigned SWTRAP:1; unsigned GIE:1;)
+
+/*Timers*/
+SFR(T1CON, unsigned :1; unsigned TCS:1; unsigned TSYNC:1; unsigned :1;
+    unsigned TCKPS:2; unsigned TGATE:1; unsigned :6; unsigned TSIDL:1;
+    unsigned :1; unsigned TON:1;)
+SFR(T2CON, unsigned :1; unsigned TCS:1; unsigned :1; unsigned T32:1;
+    unsigned TCKPS:2; unsigned TGATE:1; unsigned :6; unsigned TSIDL:1;
+    unsigned :1; unsigned TON:1;)
+SFR(T3CON, unsigned :1; unsigned TCS:1; unsigned :2;
+    unsigned TCKPS:2; unsigned TGATE:1; unsigned :6; unsigned TSIDL:1;
+    unsigned :1; unsigned TON:1;)
+SFR(T4CON, unsigned :1; unsigned TCS:1; unsigned :1; unsigned T32:1;
+    unsigned TCKPS:2; unsigned TGATE:1; unsigned :6; unsigned TSIDL:1;
+    unsigned :1; unsigned TON:1;)
+SFR(T5CON, unsigned :1; unsigned TCS:1; unsigned :2;
+    unsigned TCKPS:2; unsigned TGATE:1; unsigned :6; unsigned TSIDL:1;
+    unsigned :1; unsigned TON:1;)
+SFR_PLAIN(TMR1)
+SFR_PLAIN(TMR2)
+SFR_PLAIN(TMR3)
+SFR_PLAIN(TMR4)
+SFR_PLAIN(TMR5)
+SFR_PLAIN(PR1)
+SFR_PLAIN(PR2)
+SFR_PLAIN(PR3)
+SFR_PLAIN(PR4)
+SFR_PLAIN(PR5)
+
+/*Input capture*/
+#define SFR_IC(n) \
+SFR(IC##n##CON1, unsigned ICM:3; unsigned ICBNE:1; unsigned ICOV:1; unsigned ICI:2; \
+    unsigned :3; unsigned ICTSEL:3; unsigned ICSIDL:1;) \
+SFR(IC##n##CON2, unsigned SYNCSEL:5; unsigned :1; unsigned TRIGSTAT:1; \
+    unsigned ICTRIG:1; unsigned IC32:1;) \
+SFR_PLAIN(IC##n##BUF) \
+SFR_PLAIN(IC##n##TMR)
+SFR_IC(1)
+SFR_IC(2)
+SFR_IC(3)
+SFR_IC(4)
+#undef SFR_IC
+
+/*UARTs, UxTXREG and UxRXREG are in hal_host.h*/
+#define SFR_UART(n) \
+SFR(U##n##MODE, unsigned STSEL:1; unsigned PDSEL:2; unsigned BRGH:1; \
+    unsigned URXINV:1; unsigned ABAUD:1; unsigned LPBACK:1; unsigned WAKE:1; \
+    unsigned UEN:2; unsigned :1; unsigned RTSMD:1; unsigned IREN:1; \
+    unsigned USIDL:1; unsigned :1; unsigned UARTEN:1;) \
+SFR(U##n##STA, unsigned URXDA:1; unsigned OERR:1; unsigned FERR:1; \
+    unsigned PERR:1; unsigned RIDLE:1; unsigned ADDEN:1; unsigned URXISEL:2; \
+    unsigned TRMT:1; unsigned UTXBF:1; unsigned UTXEN:1; unsigned UTXBRK:1; \
+    unsigned :1; unsigned UTXISEL0:1; unsigned UTXINV:1; unsigned UTXISEL1:1;) \
+SFR_PLAIN(U##n##BRG)
+SFR_UART(1)
+SFR_UART(2)
+#undef SFR_UART
+
+/*Peripheral pin select*/
+SFR(RPINR0, unsigned :8; unsigned INT1R:7;)
+SFR(RPINR7, unsigned IC1R:7; unsigned :1; unsigned IC2R:7;)
+SFR(RPINR8, unsigned IC3R:7; unsigned :1; unsigned IC4R:7;)
+SFR(RPINR18, unsigned U1RXR:7; unsigned :1; unsigned U1CTSR:7;)
+SFR(RPINR19, unsigned U2RXR:7; unsigned :1; unsigned U2CTSR:7;)
+SFR(RPINR26, unsigned C1RXR:7; unsigned :1; unsigned C2RXR:7;)
+SFR(RPOR0, unsigned RP64R:6; unsigned :2; unsigned RP65R:6;)
+SFR(RPOR1, unsigned RP66R:6; unsigned :2; unsigned RP67R:6;)
+SFR(RPOR4, unsigned RP79R:6; unsigned :2; unsigned RP80R:6;)
+SFR(RPOR5, unsigned RP82R:6; unsigned :2; unsigned RP84R:6;)
+SFR(RPOR6, unsigned RP85R:6; unsigned :2; unsigned RP87R:6;)
+
+/*IO ports*/
+#define SFR_PORT(p) \
+SFR(TRIS##p, unsigned TRIS##p##0:1; unsigned TRIS##p##1:1; unsigned TRIS##p##2:1; \
+    unsigned TRIS##p##3:1; unsigned TRIS##p##4:1; unsigned TRIS##p##5:1; \
+    unsigned TRIS##p##6:1; unsigned TRIS##p##7:1; unsigned TRIS##p##8:1; \
+    unsigned TRIS##p##9:1; unsigned TRIS##p##10:1; unsigned TRIS##p##11:1; \
+    unsigned TRIS##p##12:1; unsigned TRIS##p##13:1; unsigned TRIS##p##14:1; \
+    unsigned TRIS##p##15:1;) \
+SFR(LAT##p, unsigned LAT##p##0:1; unsigned LAT##p##1:1; unsigned LAT##p##2:1; \
+    unsigned LAT##p##3:1; unsigned LAT##p##4:1; unsigned LAT##p##5:1; \
+    unsigned LAT##p##6:1; unsigned LAT##p##7:1; unsigned LAT##p##8:1; \
+    unsigned LAT##p##9:1; unsigned LAT##p##10:1; unsigned LAT##p##11:1; \
+    unsigned LAT##p##12:1; unsigned LAT##p##13:1; unsigned LAT##p##14:1; \
+    unsigned LAT##p##15:1;) \
+SFR(PORT##p, unsigned R##p##0:1; unsigned R##p##1:1; unsigned R##p##2:1; \
+    unsigned R##p##3:1; unsigned R##p##4:1; unsigned R##p##5:1; \
+    unsigned R##p##6:1; unsigned R##p##7:1; unsigned R##p##8:1; \
+    unsigned R##p##9:1; unsigned R##p##10:1; unsigned R##p##11:1; \
+    unsigned R##p##12:1; unsigned R##p##13:1; unsigned R##p##14:1; \
+    unsigned R##p##15:1;) \
+SFR(ANSEL##p, unsigned ANS##p##0:1; unsigned ANS##p##1:1; unsigned ANS##p##2:1; \
+    unsigned ANS##p##3:1; unsigned ANS##p##4:1; unsigned ANS##p##5:1; \
+    unsigned ANS##p##6:1; unsigned ANS##p##7:1; unsigned ANS##p##8:1; \
+    unsigned ANS##p##9:1; unsigned ANS##p##10:1; unsigned ANS##p##11:1; \
+    unsigned ANS##p##12:1; unsigned ANS##p##13:1; unsigned ANS##p##14:1; \
+    unsigned ANS##p##15:1;)
+SFR_PORT(B)
+SFR_PORT(C)
+SFR_PORT(D)
+SFR_PORT(E)
+SFR_PORT(F)
+SFR_PORT(G)
+#undef SFR_PORT
+
+/*PWM*/
+SFR(PTCON, unsigned SEVTPS:4; unsigned SYNCSRC:3; unsigned SYNCEN:1;
+    unsigned SYNCOEN:1; unsigned SYNCPOL:1; unsigned EIPU:1; unsigned SEIEN:1;
+    unsigned SESTAT:1; unsigned PTSIDL:1; unsigned :1; unsigned PTEN:1;)
+SFR(PTCON2, unsigned PCLKDIV:3;)
+SFR_PLAIN(PTPER)
+#define SFR_PWM(n) \
+SFR(IOCON##n, unsigned OSYNC:1; unsigned SWAP:1; unsigned CLDAT:2; \
+    unsigned FLTDAT:2; unsigned OVRDAT:2; unsigned OVRENL:1; unsigned OVRENH:1; \
+    unsigned PMOD:2; unsigned POLL:1; unsigned POLH:1; unsigned PENL:1; \
+    unsigned PENH:1;) \
+SFR(PWMCON##n, unsigned IUE:1; unsigned XPRES:1; unsigned CAM:1; \
+    unsigned MTBS:1; unsigned :2; unsigned DTC:2; unsigned MDCS:1; \
+    unsigned ITB:1; unsigned TRGIEN:1; unsigned CLIEN:1; unsigned FLTIEN:1; \
+    unsigned TRGSTAT:1; unsigned CLSTAT:1; unsigned FLTSTAT:1;) \
+SFR(FCLCON##n, unsigned FLTMOD:2; unsigned FLTPOL:1; unsigned FLTSRC:5; \
+    unsigned CLMOD:1; unsigned CLPOL:1; unsigned CLSRC:5; unsigned IFLTMOD:1;) \
+SFR_PLAIN(PHASE##n) \
+SFR_PLAIN(PDC##n) \
+SFR_PLAIN(DTR##n) \
+SFR_PLAIN(ALTDTR##n)
+SFR_PWM(1)
+SFR_PWM(2)
+#undef SFR_PWM
+
+/*DMA*/
+#define SFR_DMA(n) \
+SFR(DMA##n##CON, unsigned MODE:2; unsigned :2; unsigned AMODE:2; unsigned :5; \
+    unsigned NULLW:1; unsigned HALF:1; unsigned DIR:1; unsigned SIZE:1; \
+    unsigned CHEN:1;) \
+SFR_PLAIN(DMA##n##REQ) \
+SFR_PLAIN(DMA##n##STAL) \
+SFR_PLAIN(DMA##n##STAH) \
+SFR_PLAIN(DMA##n##PAD) \
+SFR_PLAIN(DMA##n##CNT)
+SFR_DMA(0)
+SFR_DMA(1)
+SFR_DMA(2)
+SFR_DMA(3)
+#undef SFR_DMA
+
+/*ECAN1*/
+SFR(C1CTRL1, unsigned WIN:1; unsigned :2; unsigned CANCAP:1; unsigned :1;
+    unsigned OPMODE:3; unsigned REQOP:3; unsigned CANCKS:1; unsigned ABAT:1;
+    unsigned CSIDL:1;)
+SFR(C1CTRL2, unsigned DNCNT:5;)
+SFR(C1CFG1, unsigned BRP:6; unsigned SJW:2;)
+SFR(C1CFG2, unsigned PRSEG:3; unsigned SEG1PH:3; unsigned SAM:1;
+    unsigned SEG2PHTS:1; unsigned SEG2PH:3; unsigned :3; unsigned WAKFIL:1;)
+SFR(C1FCTRL, unsigned FSA:5; unsigned :8; unsigned DMABS:3;)
+SFR(C1FIFO, unsigned FNRB:6; unsigned :2; unsigned FBP:6;)
+SFR(C1INTF, unsigned TBIF:1; unsigned RBIF:1; unsigned RBOVIF:1;
+    unsigned FIFOIF:1; unsigned :1; unsigned ERRIF:1; unsigned WAKIF:1;
+    unsigned IVRIF:1; unsigned EWARN:1; unsigned RXWAR:1; unsigned TXWAR:1;
+    unsigned RXBP:1; unsigned TXBP:1; unsigned TXBO:1;)
+SFR(C1INTE, unsigned TBIE:1; unsigned RBIE:1; unsigned RBOVIE:1;
+    unsigned FIFOIE:1; unsigned :1; unsigned ERRIE:1; unsigned WAKIE:1;
+    unsigned IVRIE:1;)
+#define SFR_CAN_TR(a, b) \
+SFR(C1TR##a##b##CON, unsigned TX##a##PRI:2; unsigned RTREN##a:1; \
+    unsigned TXREQ##a:1; unsigned TXERR##a:1; unsigned TXLARB##a:1; \
+    unsigned TXABT##a:1; unsigned TXEN##a:1; unsigned TX##b##PRI:2; \
+    unsigned RTREN##b:1; unsigned TXREQ##b:1; unsigned TXERR##b:1; \
+    unsigned TXLARB##b:1; unsigned TXABT##b:1; unsigned TXEN##b:1;)
+SFR_CAN_TR(0, 1)
+SFR_CAN_TR(2, 3)
+SFR_CAN_TR(4, 5)
+SFR_CAN_TR(6, 7)
+#undef SFR_CAN_TR
+#define SFR_CAN_SID(name, ide) \
+SFR(name, unsigned EID:2; unsigned :1; unsigned ide:1; unsigned :1; unsigned SID:11;)
+SFR_CAN_SID(C1RXM0SID, MIDE)
+SFR_CAN_SID(C1RXM1SID, MIDE)
+SFR_CAN_SID(C1RXF0SID, EXIDE)
+SFR_CAN_SID(C1RXF1SID, EXIDE)
+SFR_CAN_SID(C1RXF2SID, EXIDE)
+SFR_CAN_SID(C1RXF3SID, EXIDE)
+SFR_CAN_SID(C1RXF4SID, EXIDE)
+SFR_CAN_SID(C1RXF5SID, EXIDE)
+SFR_CAN_SID(C1RXF6SID, EXIDE)
+SFR_CAN_SID(C1RXF7SID, EXIDE)
+SFR_CAN_SID(C1RXF8SID, EXIDE)
+SFR_CAN_SID(C1RXF9SID, EXIDE)
+SFR_CAN_SID(C1RXF10SID, EXIDE)
+SFR_CAN_SID(C1RXF11SID, EXIDE)
+SFR_CAN_SID(C1RXF12SID, EXIDE)
+SFR_CAN_SID(C1RXF13SID, EXIDE)
+SFR_CAN_SID(C1RXF14SID, EXIDE)
+SFR_CAN_SID(C1RXF15SID, EXIDE)
+#undef SFR_CAN_SID
+SFR_PLAIN(C1FEN1)
+SFR_PLAIN(C1FMSKSEL1)
+SFR_PLAIN(C1FMSKSEL2)
+SFR_PLAIN(C1BUFPNT1)
+SFR_PLAIN(C1BUFPNT2)
+SFR_PLAIN(C1BUFPNT3)
+SFR_PLAIN(C1BUFPNT4)
+SFR_PLAIN(C1RXFUL1)
+SFR_PLAIN(C1RXFUL2)
+SFR_PLAIN(C1RXOVF1)
+SFR_PLAIN(C1RXOVF2)
+SFR_PLAIN(C1TXD)
+SFR_PLAIN(C1RXD)
@@ -0,0 +1,13 @@
+/*
+ * File:   xc.h
+ * Author: Kevin
+ *
+ * Description: Host stand-in for the XC16 xc.h, see p33Exxxx.h.
+ */
+
+#ifndef XC_HOST_H
+#define	XC_HOST_H
+
+#include <p33Exxxx.h>
+
+#endif	/* XC_HOST_H */
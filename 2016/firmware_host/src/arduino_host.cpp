@@ -0,0 +1,75 @@
+/*
+ * File:   arduino_host.cpp
+ * Author: Kevin
+ *
+ * Description: Storage behind include/arduino/Arduino.h.
+ */
+
+#include <Arduino.h>
+
+uint32_t hostMicros = 0;
+int hostInterruptsOff = 0;
+
+uint8_t hostPinLevel[HOST_PINS];
+uint8_t hostPinMode[HOST_PINS];
+unsigned int hostPinRises[HOST_PINS];
+int hostAnalog[HOST_PINS];
+
+static void (*pinIsr[HOST_PINS])(void);
+static int pinIsrMode[HOST_PINS];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    hostPinMode[pin] = mode;
+    if (mode == INPUT_PULLUP)
+        hostPinLevel[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    if (value && !hostPinLevel[pin])
+        hostPinRises[pin]++;
+    hostPinLevel[pin] = value ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return hostPinLevel[pin];
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode)
+{
+    pinIsr[pin] = isr;
+    pinIsrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin)
+{
+    pinIsr[pin] = NULL;
+}
+
+int analogRead(uint8_t pin)
+{
+    return hostAnalog[pin];
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout)
+{
+    (void) pin;
+    (void) state;
+    hostMicros += timeout;
+    return 0;
+}
+
+void hostPinSet(uint8_t pin, uint8_t level)
+{
+    uint8_t was = hostPinLevel[pin];
+    int mode = pinIsrMode[pin];
+
+    level = level ? HIGH : LOW;
+    hostPinLevel[pin] = level;
+    if (pinIsr[pin] == NULL || was == level)
+        return;
+    if (mode == CHANGE || (mode == RISING && level) || (mode == FALLING && !level))
+        pinIsr[pin]();
+}
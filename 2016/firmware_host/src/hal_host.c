@@ -0,0 +1,136 @@
+/*
+ * File:   hal_host.c
+ * Author: Kevin
+ *
+ * Description: SFR storage and the UART queues behind hal_host.h.
+ */
+
+#include <p33Exxxx.h>
+#include <string.h>
+
+/*Each register and its bits view share storage, like the SFR space does*/
+#define SFR(name, fields) \
+    volatile unsigned int name; \
+    extern volatile name##BITS name##bits __attribute__((alias(#name)));
+#define SFR_PLAIN(name) \
+    volatile unsigned int name;
+#include "sfr_list.h"
+#undef SFR
+#undef SFR_PLAIN
+
+typedef struct
+{
+    char data[HAL_UART_QUEUE_SIZE];
+    unsigned int head;
+    unsigned int tail;
+} HalQueue;
+
+static HalQueue uartTx[HAL_UART_COUNT];
+static HalQueue uartRx[HAL_UART_COUNT];
+
+/*UxTXREG/UxRXREG storage. A store through UxTXREG only happens after
+ *hal_uart_txreg() returns, so it is moved to the capture on the next access*/
+static volatile unsigned int txRegs[HAL_UART_COUNT];
+static volatile unsigned int rxRegs[HAL_UART_COUNT];
+static unsigned int txPending[HAL_UART_COUNT];
+
+static void (*delayHook)(unsigned long ms);
+
+static void HalQueuePush(HalQueue* q, char c)
+{
+    unsigned int next = (q->head + 1) % HAL_UART_QUEUE_SIZE;
+    if (next != q->tail)
+    {
+        q->data[q->head] = c;
+        q->head = next;
+    }
+}
+
+static int HalQueuePop(HalQueue* q, char* c)
+{
+    if (q->head == q->tail)
+        return 0;
+    *c = q->data[q->tail];
+    q->tail = (q->tail + 1) % HAL_UART_QUEUE_SIZE;
+    return 1;
+}
+
+static void HalUpdateStatus(unsigned int uart)
+{
+    unsigned int ready = uartRx[uart - 1].head != uartRx[uart - 1].tail;
+    if (uart == 1)
+        U1STAbits.URXDA = ready;
+    else
+        U2STAbits.URXDA = ready;
+}
+
+static void HalFlushTx(unsigned int uart)
+{
+    if (txPending[uart - 1])
+    {
+        HalQueuePush(&uartTx[uart - 1], (char) txRegs[uart - 1]);
+        txPending[uart - 1] = 0;
+    }
+}
+
+volatile unsigned int* hal_uart_txreg(unsigned int uart)
+{
+    HalFlushTx(uart);
+    txPending[uart - 1] = 1;
+    /*Sent as soon as it is written, the shift register is never busy*/
+    if (uart == 1)
+        U1STAbits.TRMT = 1;
+    else
+        U2STAbits.TRMT = 1;
+    return &txRegs[uart - 1];
+}
+
+volatile unsigned int* hal_uart_rxreg(unsigned int uart)
+{
+    char c;
+    if (HalQueuePop(&uartRx[uart - 1], &c))
+        rxRegs[uart - 1] = (unsigned char) c;
+    HalUpdateStatus(uart);
+    return &rxRegs[uart - 1];
+}
+
+void hal_reset(void)
+{
+#define SFR(name, fields) name = 0;
+#define SFR_PLAIN(name) name = 0;
+#include "sfr_list.h"
+#undef SFR
+#undef SFR_PLAIN
+    memset(uartTx, 0, sizeof(uartTx));
+    memset(uartRx, 0, sizeof(uartRx));
+    memset(txPending, 0, sizeof(txPending));
+    delayHook = NULL;
+}
+
+void hal_uart_inject(unsigned int uart, const char* data, unsigned int length)
+{
+    unsigned int i;
+    for (i = 0; i < length; i++)
+        HalQueuePush(&uartRx[uart - 1], data[i]);
+    HalUpdateStatus(uart);
+}
+
+unsigned int hal_uart_take(unsigned int uart, char* data, unsigned int max)
+{
+    unsigned int n = 0;
+    HalFlushTx(uart);
+    while (n < max && HalQueuePop(&uartTx[uart - 1], &data[n]))
+        n++;
+    return n;
+}
+
+void hal_set_delay_hook(void (*hook)(unsigned long ms))
+{
+    delayHook = hook;
+}
+
+void hal_delay_ms(unsigned long ms)
+{
+    if (delayHook)
+        delayHook(ms);
+}
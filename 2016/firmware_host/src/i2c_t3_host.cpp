@@ -0,0 +1,270 @@
+/*
+ * File:   i2c_t3_host.cpp
+ * Author: Kevin
+ *
+ * Description: The simulated bus behind include/arduino/i2c_t3.h.
+ */
+
+#include <i2c_t3.h>
+
+#define SIM_DEVICES 8
+
+typedef struct
+{
+    uint8_t address;
+    uint8_t* registers;
+    uint8_t regMask;
+    uint8_t pointer;
+    int nak;
+} SimDevice;
+
+i2c_t3 Wire;
+i2c_t3 Wire1;
+
+static SimDevice devices[SIM_DEVICES];
+static int deviceCount;
+static int busBusy;       /*a transfer is waiting for i2c_sim_step()*/
+static int holdingBus;    /*last transfer ended without STOP*/
+static int hung;
+static int slaveAddress = -1;
+static unsigned int transfers, repeatedStarts;
+
+static SimDevice* Find(uint8_t address)
+{
+    int i;
+    for (i = 0; i < deviceCount; i++)
+        if (devices[i].address == address)
+            return &devices[i];
+    return NULL;
+}
+
+static void Start(i2c_status status, i2c_stop stop)
+{
+    transfers++;
+    if (holdingBus)
+        repeatedStarts++;
+    Wire.currentStatus = status;
+    Wire.stop = stop;
+    busBusy = 1;
+}
+
+void i2c_t3::beginTransmission(uint8_t address)
+{
+    txAddress = address;
+    txLength = 0;
+    currentStatus = I2C_WAITING;
+}
+
+size_t i2c_t3::write(uint8_t data)
+{
+    if (txLength >= sizeof(txBuffer))
+        return 0;
+    txBuffer[txLength++] = data;
+    return 1;
+}
+
+size_t i2c_t3::write(const uint8_t* data, size_t quantity)
+{
+    size_t i;
+    for (i = 0; i < quantity && write(data[i]); i++);
+    return i;
+}
+
+void i2c_t3::sendTransmission(i2c_stop sendStop)
+{
+    Start(I2C_SENDING, sendStop);
+}
+
+void i2c_t3::sendRequest(uint8_t addr, size_t len, i2c_stop sendStop)
+{
+    rxAddress = addr;
+    rxLength = rxIndex = 0;
+    reqCount = len;
+    Start(I2C_SEND_ADDR, sendStop);
+}
+
+/*Blocking calls: as the real ones, a hung bus times out*/
+static void Complete(void)
+{
+    if (!i2c_sim_step())
+    {
+        Wire.finish(1);
+        i2c_sim_step();
+    }
+}
+
+uint8_t i2c_t3::endTransmission(i2c_stop sendStop, uint32_t timeout)
+{
+    (void) timeout;
+    sendTransmission(sendStop);
+    Complete();
+    switch (currentStatus)
+    {
+        case I2C_WAITING: return 0;
+        case I2C_ADDR_NAK: return 2;
+        case I2C_DATA_NAK: return 3;
+        default: return 4;
+    }
+}
+
+size_t i2c_t3::requestFrom(uint8_t addr, size_t len, i2c_stop sendStop, uint32_t timeout)
+{
+    (void) timeout;
+    sendRequest(addr, len, sendStop);
+    Complete();
+    return currentStatus == I2C_WAITING ? rxLength : 0;
+}
+
+uint8_t i2c_t3::finish(uint32_t timeout)
+{
+    (void) timeout;
+    if (busBusy)
+        currentStatus = I2C_TIMEOUT;
+    return currentStatus == I2C_WAITING;
+}
+
+void i2c_sim_reset(void)
+{
+    deviceCount = 0;
+    busBusy = holdingBus = hung = 0;
+    transfers = repeatedStarts = 0;
+    slaveAddress = -1;
+    Wire.currentStatus = I2C_WAITING;
+    Wire.user_onMasterDone = NULL;
+    Wire.txLength = Wire.rxLength = Wire.rxIndex = 0;
+    Wire1.user_onReceive = NULL;
+    Wire1.user_onRequest = NULL;
+    Wire1.txLength = Wire1.rxLength = Wire1.rxIndex = 0;
+}
+
+void i2c_sim_device(uint8_t address, uint8_t* registers, uint8_t regMask)
+{
+    SimDevice* d = &devices[deviceCount++];
+    d->address = address;
+    d->registers = registers;
+    d->regMask = regMask;
+    d->pointer = 0;
+    d->nak = 0;
+}
+
+void i2c_sim_nak(uint8_t address, int nak)
+{
+    SimDevice* d = Find(address);
+    if (d)
+        d->nak = nak;
+}
+
+void i2c_sim_slave(uint8_t address)
+{
+    slaveAddress = address;
+}
+
+/*Wire1's side of a master write, then of a master read*/
+static void SlaveReceive(const uint8_t* write, size_t wlen)
+{
+    size_t i;
+
+    /*The slave ISR calls onReceive on the repeated start, or the STOP*/
+    Wire1.rxLength = Wire1.rxIndex = 0;
+    for (i = 0; i < wlen && i < sizeof(Wire1.rxBuffer); i++)
+        Wire1.rxBuffer[Wire1.rxLength++] = write[i];
+    Wire1.currentStatus = I2C_SLAVE_RX;
+    if (wlen > 0 && Wire1.user_onReceive)
+        Wire1.user_onReceive(Wire1.rxLength);
+}
+
+static size_t SlaveRequest(uint8_t* read, size_t len)
+{
+    size_t i;
+
+    /*and onRequest when addressed for a read, to fill the Tx buffer*/
+    Wire1.txLength = 0;
+    Wire1.currentStatus = I2C_SLAVE_TX;
+    if (Wire1.user_onRequest)
+        Wire1.user_onRequest();
+    for (i = 0; i < len; i++)
+        read[i] = i < Wire1.txLength ? Wire1.txBuffer[i] : 0xFF;
+    return Wire1.txLength;
+}
+
+void i2c_sim_hang(int hang)
+{
+    hung = hang;
+}
+
+int i2c_sim_step(void)
+{
+    SimDevice* d;
+
+    if (!busBusy || (hung && Wire.currentStatus != I2C_TIMEOUT))
+        return 0;
+    busBusy = 0;
+
+    if (Wire.currentStatus == I2C_TIMEOUT)
+    {
+        /*The ISR sends STOP and calls back with the timeout status*/
+        holdingBus = 0;
+    }
+    else if (Wire.currentStatus == I2C_SENDING)
+    {
+        d = Find(Wire.txAddress);
+        if (!d && Wire.txAddress == slaveAddress)
+        {
+            SlaveReceive(Wire.txBuffer, Wire.txLength);
+            Wire.currentStatus = I2C_WAITING;
+        }
+        else if (!d || d->nak)
+            Wire.currentStatus = I2C_ADDR_NAK;
+        else
+        {
+            size_t i;
+            if (Wire.txLength > 0)
+                d->pointer = Wire.txBuffer[0] & d->regMask;
+            for (i = 1; i < Wire.txLength; i++)
+                d->registers[d->pointer++] = Wire.txBuffer[i];
+            Wire.currentStatus = I2C_WAITING;
+        }
+        holdingBus = Wire.currentStatus == I2C_WAITING && Wire.stop == I2C_NOSTOP;
+    }
+    else
+    {
+        d = Find(Wire.rxAddress);
+        if (!d && Wire.rxAddress == slaveAddress)
+        {
+            Wire.rxLength = Wire.reqCount < sizeof(Wire.rxBuffer) ? Wire.reqCount : sizeof(Wire.rxBuffer);
+            SlaveRequest(Wire.rxBuffer, Wire.rxLength);
+            Wire.currentStatus = I2C_WAITING;
+        }
+        else if (!d || d->nak)
+            Wire.currentStatus = I2C_ADDR_NAK;
+        else
+        {
+            while (Wire.rxLength < Wire.reqCount && Wire.rxLength < sizeof(Wire.rxBuffer))
+                Wire.rxBuffer[Wire.rxLength++] = d->registers[d->pointer++];
+            Wire.currentStatus = I2C_WAITING;
+        }
+        holdingBus = Wire.currentStatus == I2C_WAITING && Wire.stop == I2C_NOSTOP;
+    }
+
+    if (Wire.user_onMasterDone)
+        Wire.user_onMasterDone();
+    return 1;
+}
+
+unsigned int i2c_sim_transfers(void)
+{
+    return transfers;
+}
+
+unsigned int i2c_sim_repeated_starts(void)
+{
+    return repeatedStarts;
+}
+
+size_t i2c_sim_slave_transfer(const uint8_t* write, size_t wlen, uint8_t* read, size_t len)
+{
+    SlaveReceive(write, wlen);
+    if (len == 0)
+        return 0;
+    return SlaveRequest(read, len);
+}
@@ -0,0 +1,45 @@
+/*
+ * File:   check.h
+ * Author: Kevin
+ *
+ * Description: Minimal test macros for the host firmware tests. Each test
+ *              program runs its checks from main() and returns
+ *              CHECK_RESULT() so ctest sees the failures.
+ */
+
+#ifndef CHECK_H
+#define	CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned int checkCount = 0;
+static unsigned int checkFailures = 0;
+
+#define CHECK(cond) \
+    do { \
+        checkCount++; \
+        if (!(cond)) \
+        { \
+            checkFailures++; \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+/*a within tol of b*/
+#define CHECK_NEAR(a, b, tol) \
+    do { \
+        long checkA = (long) (a), checkB = (long) (b); \
+        checkCount++; \
+        if (labs(checkA - checkB) > (long) (tol)) \
+        { \
+            checkFailures++; \
+            fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %ld vs %ld\n", \
+                __FILE__, __LINE__, #a, #b, checkA, checkB); \
+        } \
+    } while (0)
+
+#define CHECK_RESULT() \
+    (printf("%u checks, %u failed\n", checkCount, checkFailures), checkFailures != 0)
+
+#endif	/* CHECK_H */
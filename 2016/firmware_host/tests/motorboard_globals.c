@@ -0,0 +1,15 @@
+/*
+ * File:   motorboard_globals.c
+ * Author: Jacob
+ *
+ * Description: The globals motorboard.X/main.c owns, for the host builds
+ *              that link the board's modules without its main().
+ */
+
+int motorDuty = 1500;
+int servoDuty = 1500;
+
+float desMotor = 0;
+float desServo = 1500;
+
+char EStopRemote = 0;
@@ -0,0 +1,57 @@
+/*
+ * File:   motorboard_sim.h
+ * Author: Jacob
+ *
+ * Description: Drives the motorboard timebase for the host tests and
+ *              benchmarks: Timer 2 is advanced by hand, with _T2Interrupt
+ *              called for each overflow, and hall effect edges go in through
+ *              the input capture ISRs.
+ */
+
+#ifndef MOTORBOARD_SIM_H
+#define	MOTORBOARD_SIM_H
+
+#include <p33Exxxx.h>
+#include "inputCapture.h"
+#include "wheelSpeed.h"
+
+static unsigned long simTicks = 0;     //Timer 2 ticks since reset
+
+static inline void SimReset(void)
+{
+    hal_reset();
+    simTicks = 0;
+    wheelSpeed_init();
+}
+
+static inline void SimAdvance(unsigned long ticks)
+{
+    unsigned long overflows = ((simTicks + ticks) >> 16) - (simTicks >> 16);
+    simTicks += ticks;
+    while (overflows--)
+    {
+        _T2Interrupt();
+    }
+    TMR2 = (unsigned int) (simTicks & 0xFFFF);
+}
+
+/*Hall effect edge on one wheel, captured now*/
+static inline void SimEdge(unsigned int wheel)
+{
+    unsigned int capture = (unsigned int) (simTicks & 0xFFFF);
+    switch (wheel)
+    {
+        case WHEEL_FL: IC1BUF = capture; _IC1Interrupt(); break;
+        case WHEEL_FR: IC2BUF = capture; _IC2Interrupt(); break;
+        case WHEEL_BL: IC3BUF = capture; _IC3Interrupt(); break;
+        default: IC4BUF = capture; _IC4Interrupt(); break;
+    }
+}
+
+/*Timer 2 ticks between edges at a speed in mm/s*/
+static inline unsigned long SimPeriod(unsigned long speed)
+{
+    return WHEEL_SPEED_K / speed;
+}
+
+#endif	/* MOTORBOARD_SIM_H */
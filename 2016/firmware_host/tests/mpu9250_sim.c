@@ -0,0 +1,200 @@
+/*
+ * File:   mpu9250_sim.c
+ * Author: Michael Buchel
+ *
+ * Description: See mpu9250_sim.h. Scales match AHRS_init: +-4g, +-500 dps
+ *              and the AK8963 in 16 bit mode.
+ */
+
+#include <math.h>
+#include "MPU9250.h"
+#include "mpu9250_sim.h"
+
+#define SIM_ACCEL_LSB_PER_G 8192.0
+#define SIM_GYRO_LSB_PER_DPS 65.5
+#define SIM_MAG_UT_PER_LSB 0.15
+
+static unsigned char regs[128];
+static unsigned char mag[7];
+static unsigned char asa[3] = {128, 128, 128};
+static unsigned int bursts = 0;
+static unsigned char fifo[MPU_FIFO_SIZE];
+static unsigned int fifoHead = 0;   //oldest byte
+static unsigned int fifoCount = 0;
+static unsigned int lastDmaBytes = 0;
+
+static int SimRound(double v)
+{
+    v = floor(v + 0.5);
+    if (v > 32767)
+        return 32767;
+    if (v < -32768)
+        return -32768;
+    return (int) v;
+}
+
+static void SimBigEndian(unsigned char reg, double v)
+{
+    int raw = SimRound(v);
+    regs[reg] = (unsigned char) (raw >> 8);
+    regs[reg + 1] = (unsigned char) raw;
+}
+
+static void SimLittleEndian(unsigned char* out, double v)
+{
+    int raw = SimRound(v);
+    out[0] = (unsigned char) raw;
+    out[1] = (unsigned char) (raw >> 8);
+}
+
+void MpuSimSet(const double* accel, const double* gyro, const double* mag_uT)
+{
+    int i;
+    for (i = 0; i < 3; i++)
+    {
+        SimBigEndian(MPUREG_ACCEL_XOUT_H + 2 * i, accel[i] * SIM_ACCEL_LSB_PER_G);
+        SimBigEndian(MPUREG_GYRO_XOUT_H + 2 * i, gyro[i] * SIM_GYRO_LSB_PER_DPS);
+    }
+    /*AK8963 axes: X is the MPU's Y, Y the MPU's X, Z the other way, before the
+     *sensitivity adjustment*/
+    SimLittleEndian(&mag[0], mag_uT[1] / SIM_MAG_UT_PER_LSB / (1 + (asa[0] - 128) / 256.0));
+    SimLittleEndian(&mag[2], mag_uT[0] / SIM_MAG_UT_PER_LSB / (1 + (asa[1] - 128) / 256.0));
+    SimLittleEndian(&mag[4], -mag_uT[2] / SIM_MAG_UT_PER_LSB / (1 + (asa[2] - 128) / 256.0));
+}
+
+void MpuSimSetAdjust(unsigned char x, unsigned char y, unsigned char z)
+{
+    asa[0] = x;
+    asa[1] = y;
+    asa[2] = z;
+}
+
+void MpuSimSetOverflow(int overflow)
+{
+    mag[6] = overflow ? 0x08 : 0x00;
+}
+
+/*EXT_SENS_DATA holds whatever SLV0 was last set up to copy*/
+static void SimExtSens(void)
+{
+    unsigned int i;
+    if (regs[MPUREG_I2C_SLV0_REG] == AK8963_ASAX)
+    {
+        for (i = 0; i < 3; i++)
+            regs[MPUREG_EXT_SENS_DATA_00 + i] = asa[i];
+    }
+    else
+    {
+        for (i = 0; i < 7; i++)
+            regs[MPUREG_EXT_SENS_DATA_00 + i] = mag[i];
+    }
+}
+
+static void SimFifoPush(unsigned char byte)
+{
+    if (fifoCount == MPU_FIFO_SIZE)
+    {
+        fifoHead = (fifoHead + 1) % MPU_FIFO_SIZE;
+        fifoCount--;
+    }
+    fifo[(fifoHead + fifoCount) % MPU_FIFO_SIZE] = byte;
+    fifoCount++;
+}
+
+static unsigned char SimFifoPop(void)
+{
+    unsigned char byte;
+    if (fifoCount == 0)
+        return 0xFF;
+    byte = fifo[fifoHead];
+    fifoHead = (fifoHead + 1) % MPU_FIFO_SIZE;
+    fifoCount--;
+    return byte;
+}
+
+void MpuSimSample(void)
+{
+    unsigned char enabled = regs[MPUREG_FIFO_EN];
+    unsigned int i;
+    if (!(regs[MPUREG_USER_CTRL] & BIT_FIFO_EN))
+        return;
+    SimExtSens();
+    /*Register order, only what is enabled*/
+    for (i = 0; i < 6 && (enabled & 0x08); i++)
+        SimFifoPush(regs[MPUREG_ACCEL_XOUT_H + i]);
+    for (i = 0; i < 2 && (enabled & 0x80); i++)
+        SimFifoPush(regs[MPUREG_TEMP_OUT_H + i]);
+    for (i = 0; i < 6; i++)
+    {
+        if (enabled & (0x40 >> (i / 2)))
+            SimFifoPush(regs[MPUREG_GYRO_XOUT_H + i]);
+    }
+    for (i = 0; i < 7 && (enabled & BIT_FIFO_SLV0); i++)
+        SimFifoPush(regs[MPUREG_EXT_SENS_DATA_00 + i]);
+}
+
+unsigned int MpuSimFifoCount(void)
+{
+    return fifoCount;
+}
+
+unsigned int MpuSimLastDmaBytes(void)
+{
+    return lastDmaBytes;
+}
+
+unsigned char MpuSimRegister(unsigned char reg)
+{
+    return regs[reg & 0x7F];
+}
+
+unsigned int MpuSimBurstCount(void)
+{
+    return bursts;
+}
+
+unsigned int WriteReg(signed int WriteAddr, signed int WriteData)
+{
+    if (WriteAddr & READ_FLAG)
+        return regs[WriteAddr & 0x7F];
+    regs[WriteAddr & 0x7F] = (unsigned char) WriteData;
+    if ((WriteAddr & 0x7F) == MPUREG_USER_CTRL && (WriteData & BIT_FIFO_RST))
+    {
+        fifoCount = 0;
+        regs[MPUREG_USER_CTRL] &= ~BIT_FIFO_RST;
+    }
+    return 0;
+}
+
+unsigned int ReadReg(signed int WriteAddr, signed int WriteData)
+{
+    return WriteReg(WriteAddr | READ_FLAG, WriteData);
+}
+
+/*FIFO_R_W doesn't auto increment, it pops the FIFO*/
+void ReadRegs(unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes)
+{
+    unsigned int i;
+    SimExtSens();
+    regs[MPUREG_FIFO_COUNTH] = (unsigned char) (fifoCount >> 8);
+    regs[MPUREG_FIFO_COUNTL] = (unsigned char) fifoCount;
+    for (i = 0; i < Bytes; i++)
+    {
+        if (ReadAddr == MPUREG_FIFO_R_W)
+            ReadBuf[i] = SimFifoPop();
+        else
+            ReadBuf[i] = regs[(ReadAddr + i) & 0x7F];
+    }
+    bursts++;
+}
+
+void ReadRegsDMA(unsigned char ReadAddr, unsigned char *ReadBuf, unsigned int Bytes)
+{
+    ReadRegs(ReadAddr, ReadBuf, Bytes);
+    lastDmaBytes = Bytes;
+    IFS2bits.DMA3IF = 1;
+}
+
+void set_SPI_fast(void)
+{
+}
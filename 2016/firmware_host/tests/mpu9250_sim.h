@@ -0,0 +1,30 @@
+/*
+ * File:   mpu9250_sim.h
+ * Author: Michael Buchel
+ *
+ * Description: A simulated MPU9250 behind WriteReg/ReadRegs/ReadRegsDMA,
+ *              for the host builds that link the IMU board's modules
+ *              without MPU9250.c and its SPI port. The DMA read completes
+ *              at once and sets the DMA3 interrupt flag.
+ */
+
+#ifndef MPU9250_SIM_H
+#define	MPU9250_SIM_H
+
+/*Register contents for the next burst: g, deg/s and uT in the MPU's axes*/
+void MpuSimSet(const double* accel, const double* gyro, const double* mag);
+
+/*AK8963 fuse ROM sensitivity adjustment and the ST2 overflow flag*/
+void MpuSimSetAdjust(unsigned char x, unsigned char y, unsigned char z);
+void MpuSimSetOverflow(int overflow);
+
+/*One sample into the FIFO, if USER_CTRL and FIFO_EN have it on. A full
+ *FIFO drops its oldest bytes like the real one.*/
+void MpuSimSample(void);
+unsigned int MpuSimFifoCount(void);
+
+unsigned char MpuSimRegister(unsigned char reg);
+unsigned int MpuSimBurstCount(void);
+unsigned int MpuSimLastDmaBytes(void);
+
+#endif	/* MPU9250_SIM_H */
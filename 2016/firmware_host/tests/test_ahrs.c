@@ -0,0 +1,277 @@
+/*
+ * File:   test_ahrs.c
+ * Author: Michael Buchel
+ *
+ * Description: WEbots_CAR_IMU&GPS.X attitude filter on the host, fed by the
+ *              simulated MPU9250 through its FIFO and the INT1 and DMA3
+ *              ISRs when built with AHRS_INT_SAMPLING, or through the
+ *              Timer 1 ISR.
+ */
+
+#include "check.h"
+#include "AHRS.h"
+#include "MPU9250.h"
+#include "quaternion.h"
+#include "mpu9250_sim.h"
+
+#define DEG (3.14159265358979 / 180.0)
+
+/*Field near London, Ontario in uT, x north, z up*/
+static const vector earthMag = {18.0, 0.0, -52.0};
+static const vector earthGravity = {0.0, 0.0, 1.0};
+
+static quaternion truth;
+#ifndef AHRS_TIMER_SAMPLING
+static int intMissed = 0;   /*INT1 not serviced, the FIFO fills up*/
+#endif
+
+/*One MPU sample: Timer 1 reads and runs it, or it goes into the FIFO and the
+ *INT pulse and any drain it starts are serviced*/
+static void Sample(void)
+{
+#ifdef AHRS_TIMER_SAMPLING
+    _T1Interrupt();
+#else
+    unsigned long ticks = (unsigned long) TMR1 + AHRS_TIMER_HZ / AHRS_SAMPLE_HZ;
+    TMR1 = (unsigned int) (ticks & 0xFFFF);
+    if (ticks > 0xFFFF)
+    {
+        IFS0bits.T1IF = 1;
+        _T1Interrupt();
+    }
+    MpuSimSample();
+    if (intMissed)
+        return;
+    _INT1Interrupt();
+    if (IFS2bits.DMA3IF)
+        _DMA3Interrupt();
+#endif
+}
+
+/*Attitude from yaw, pitch and roll in degrees*/
+static quaternion FromEuler(double yaw, double pitch, double roll)
+{
+    quaternion q;
+    double cy = cos(yaw * DEG / 2), sy = sin(yaw * DEG / 2);
+    double cp = cos(pitch * DEG / 2), sp = sin(pitch * DEG / 2);
+    double cr = cos(roll * DEG / 2), sr = sin(roll * DEG / 2);
+    init2(&q, cr * cp * cy + sr * sp * sy, sr * cp * cy - cr * sp * sy,
+        cr * sp * cy + sr * cp * sy, cr * cp * sy - sr * sp * cy);
+    return q;
+}
+
+/*Run the filter for a while, a whole number of AHRS_FIFO_BATCH samples so
+ *the estimate is up to date at the end, with the car turning at rate deg/s (body
+ *frame) and the gyro reading bias deg/s too much*/
+static void Run(double seconds, const double* rate, double bias)
+{
+    long samples = (long) (seconds * AHRS_SAMPLE_HZ);
+    long n;
+    for (n = 0; n < samples; n++)
+    {
+        quaternion step;
+        vector g = rotateVector(conjugateQuat(truth), earthGravity);
+        vector m = rotateVector(conjugateQuat(truth), earthMag);
+        double accel[3] = {g.x, g.y, g.z};
+        double mag[3] = {m.x, m.y, m.z};
+        double gyro[3] = {rate[0] + bias, rate[1] + bias, rate[2] + bias};
+        double angle = sqrt(rate[0] * rate[0] + rate[1] * rate[1] + rate[2] * rate[2]) * DEG / AHRS_SAMPLE_HZ;
+
+        MpuSimSet(accel, gyro, mag);
+        Sample();
+
+        if (angle > 0)
+        {
+            double s = sin(angle / 2) / (angle / (DEG / AHRS_SAMPLE_HZ));
+            init2(&step, cos(angle / 2), rate[0] * s, rate[1] * s, rate[2] * s);
+            truth = multiplyQuat(truth, step);
+            normalizeQuat(&truth);
+        }
+    }
+}
+
+/*Angle between the estimate and the truth in degrees*/
+static double ErrorDeg(void)
+{
+    quaternionFixed f;
+    double d;
+    AHRSGetQuaternion(&f);
+    d = fabs(Q30_TO_DOUBLE(f.w) * truth.w + Q30_TO_DOUBLE(f.x) * truth.x
+        + Q30_TO_DOUBLE(f.y) * truth.y + Q30_TO_DOUBLE(f.z) * truth.z);
+    return 2 * acos(d > 1 ? 1 : d) / DEG;
+}
+
+static void Start(double yaw, double pitch, double roll)
+{
+    truth = FromEuler(yaw, pitch, roll);
+    AHRSReset();
+}
+
+static void TestInit(void)
+{
+    MpuSimSetAdjust(128, 128, 128);
+    AHRS_init();
+    CHECK(MpuSimRegister(MPUREG_SMPLRT_DIV) == 1000 / AHRS_SAMPLE_HZ - 1);
+    CHECK(MpuSimRegister(MPUREG_GYRO_CONFIG) == BITS_FS_500DPS);
+    CHECK(MpuSimRegister(MPUREG_I2C_SLV0_REG) == AK8963_HXL);
+    CHECK(MpuSimRegister(MPUREG_I2C_SLV0_CTRL) == 0x87);
+    CHECK(T1CONbits.TON && IEC0bits.T1IE);
+#ifdef AHRS_TIMER_SAMPLING
+    CHECK(PR1 == AHRS_FCY / 64 / AHRS_SAMPLE_HZ - 1);
+#else
+    CHECK(PR1 == 0xFFFF);
+    CHECK(MpuSimRegister(MPUREG_FIFO_EN) == 0xF9);
+    CHECK(MpuSimRegister(MPUREG_INT_ENABLE) == BIT_RAW_RDY_EN);
+    CHECK(MpuSimRegister(MPUREG_USER_CTRL) == (BIT_FIFO_EN | BIT_I2C_MST_EN));
+    CHECK(RPINR0bits.INT1R == AHRS_INT_RP);
+    CHECK(IEC1bits.INT1IE && IEC2bits.DMA3IE);
+    CHECK(IPC0bits.T1IP > IPC5bits.INT1IP && IPC5bits.INT1IP > IPC9bits.DMA3IP);
+#endif
+}
+
+static void TestConverges(void)
+{
+    static const double still[3] = {0, 0, 0};
+    static const double attitudes[][3] = {
+        {0, 0, 0}, {90, 0, 0}, {-135, 20, -10}, {170, -30, 45}, {45, 60, 0}
+    };
+    unsigned int i;
+    for (i = 0; i < sizeof(attitudes) / sizeof(attitudes[0]); i++)
+    {
+        Start(attitudes[i][0], attitudes[i][1], attitudes[i][2]);
+        Run(4, still, 0);
+        CHECK(ErrorDeg() < 0.2);
+    }
+}
+
+static void TestTracksTurn(void)
+{
+    static const double still[3] = {0, 0, 0};
+    static const double turn[3] = {0, 0, 90};
+    static const double roll[3] = {60, -20, 30};
+    Start(30, 5, -5);
+    Run(4, still, 0);
+    Run(4, turn, 0);
+    CHECK(ErrorDeg() < 0.5);
+    Run(2, roll, 0);
+    CHECK(ErrorDeg() < 1.0);
+}
+
+static void TestGyroBias(void)
+{
+    static const double still[3] = {0, 0, 0};
+    Start(-60, 0, 0);
+    /*Proportional only leaves bias / KP of error, about 2 degrees, the
+     *integral takes it out with a time constant of KP / KI = 10s*/
+    Run(5, still, 2.0);
+    CHECK(ErrorDeg() > 0.5);
+    Run(40, still, 2.0);
+    CHECK(ErrorDeg() < 0.2);
+}
+
+static void TestMagAdjustAndOverflow(void)
+{
+    static const double still[3] = {0, 0, 0};
+    MpuSimSetAdjust(100, 150, 176);
+    AHRS_init();
+    Start(120, 10, 10);
+    Run(4, still, 0);
+    CHECK(ErrorDeg() < 0.2);
+    CHECK(AHRSMagSkipCount == 0);
+
+    MpuSimSetOverflow(1);
+    Run(0.2, still, 0);
+    CHECK(AHRSMagSkipCount == AHRS_SAMPLE_HZ / 5);
+    CHECK(ErrorDeg() < 0.2);
+    MpuSimSetOverflow(0);
+    MpuSimSetAdjust(128, 128, 128);
+    AHRS_init();
+}
+
+static void TestFrame(void)
+{
+    static const double still[3] = {0, 0, 0};
+    unsigned int data[4];
+    unsigned int ready = 0;
+    unsigned int n;
+    unsigned long last = 0;
+    int evenlySpaced = 1;
+    vector euler;
+
+    Start(-100, 15, 25);
+    for (n = 0; n < 4 * AHRS_SAMPLE_HZ; n++)
+    {
+        Run(1.0 / AHRS_SAMPLE_HZ, still, 0);
+        if (AHRSReady())
+        {
+            unsigned long t = AHRSGetTimestamp();
+            if (ready > 0 && t - last != AHRS_PUBLISH_DIVIDER * (AHRS_TIMER_HZ / AHRS_SAMPLE_HZ))
+                evenlySpaced = 0;
+            last = t;
+            ready++;
+        }
+    }
+    /*After AHRS_init the first FIFO drain is thrown away*/
+    CHECK(AHRSSampleCount >= 4 * AHRS_SAMPLE_HZ - AHRS_FIFO_BATCH);
+    CHECK(ready == AHRSSampleCount / AHRS_PUBLISH_DIVIDER);
+    CHECK(!AHRSReady());
+    /*Frames are latched every AHRS_PUBLISH_DIVIDER samples, batched or not*/
+    CHECK(evenlySpaced);
+    CHECK(AHRSTimeNow() - last < AHRS_PUBLISH_DIVIDER * (AHRS_TIMER_HZ / AHRS_SAMPLE_HZ));
+
+    AHRSGetFrame(data);
+    euler = getEulerRepresentation(truth);
+    /*The truth may be the -q one, the frame always has w >= 0*/
+    if (truth.w < 0)
+        init2(&truth, -truth.w, -truth.x, -truth.y, -truth.z);
+    CHECK_NEAR((int16_t) data[0], truth.x * 32768, 100);
+    CHECK_NEAR((int16_t) data[1], truth.y * 32768, 100);
+    CHECK_NEAR((int16_t) data[2], truth.z * 32768, 100);
+    CHECK_NEAR((int16_t) data[3], euler.z / DEG * 100, 20);
+    CHECK_NEAR((int16_t) data[3], -10000, 20);
+}
+
+#ifndef AHRS_TIMER_SAMPLING
+static void TestFifoBatches(void)
+{
+    static const double still[3] = {0, 0, 0};
+    unsigned int bursts;
+
+    Start(40, -10, 5);
+    bursts = MpuSimBurstCount();
+    Run(1, still, 0);
+    /*A FIFO count read and one DMA drain per batch*/
+    CHECK(MpuSimBurstCount() - bursts == 2 * AHRS_SAMPLE_HZ / AHRS_FIFO_BATCH);
+    CHECK(MpuSimLastDmaBytes() == AHRS_FIFO_BATCH * AHRS_BURST_BYTES);
+    CHECK(AHRSSampleCount == AHRS_SAMPLE_HZ);
+    CHECK(MpuSimFifoCount() == 0);
+    CHECK(ErrorDeg() < 0.2);
+
+    /*INT1 held off long enough for the FIFO to overflow: one drain is thrown
+     *away, then the packets line up again*/
+    intMissed = 1;
+    Run(0.1, still, 0);
+    intMissed = 0;
+    CHECK(MpuSimFifoCount() == MPU_FIFO_SIZE);
+    Run(0.2, still, 0);
+    CHECK(AHRSFifoDropCount == 1);
+    CHECK(MpuSimFifoCount() == 0);
+    CHECK(AHRSSampleCount == AHRS_SAMPLE_HZ + AHRS_SAMPLE_HZ / 5 - AHRS_FIFO_BATCH);
+    CHECK(ErrorDeg() < 0.2);
+}
+#endif
+
+int main(void)
+{
+    hal_reset();
+    TestInit();
+    TestConverges();
+    TestTracksTurn();
+    TestGyroBias();
+    TestMagAdjustAndOverflow();
+    TestFrame();
+#ifndef AHRS_TIMER_SAMPLING
+    TestFifoBatches();
+#endif
+    return CHECK_RESULT();
+}
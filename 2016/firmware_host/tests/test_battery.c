@@ -0,0 +1,235 @@
+/*
+ * File:   test_battery.c
+ * Author: Kevin
+ *
+ * Description: 2016 power board battery monitor, fed ADC scan results as the
+ *              ADC interrupt would: decimation, the resolution oversampling
+ *              adds, tap voltages against the band gap, the starting charge
+ *              from the resting voltage, charge counting, the cell flags,
+ *              both halves of the ADC buffer and the CANMSG_BATTSTATUS
+ *              frame.
+ */
+
+#include <xc.h>
+#include "check.h"
+#include "battery.h"
+
+#define IRQ_MS 6
+#define VBG_RAW 1489    /*1.2V on a 3.3V AVDD*/
+
+static uint32_t nowMs;
+
+/*12 bit counts for a voltage at a tap*/
+static double TapRaw(double mv, double divider)
+{
+    return mv / divider / BATT_VBG_MV * VBG_RAW;
+}
+
+/*One reading's worth of interrupts. Values are in counts and may have a
+ *fraction, which alternating samples make up*/
+static void Feed(double current, double lower, double pack)
+{
+    unsigned int results[BATT_IRQ_RESULTS];
+    const double values[BATT_SCAN_CHANNELS] = {current, lower, pack, VBG_RAW};
+    unsigned int irq, sweep, ch, n = 0;
+
+    for (irq = 0; irq < BATT_DECIMATE; irq++)
+    {
+        for (sweep = 0; sweep < BATT_SWEEPS_PER_IRQ; sweep++, n++)
+        {
+            for (ch = 0; ch < BATT_SCAN_CHANNELS; ch++)
+            {
+                unsigned int whole = (unsigned int) values[ch];
+                double fraction = values[ch] - whole;
+                /*every other sample rounds up for a half, and so on*/
+                results[sweep * BATT_SCAN_CHANNELS + ch] = whole + ((n % 8) < fraction * 8 ? 1 : 0);
+            }
+        }
+        nowMs += IRQ_MS;
+        BatterySweep(results, nowMs);
+    }
+}
+
+/*Counts for a current*/
+static double CurrentRaw(double ma)
+{
+    return (BATT_CURRENT_ZERO + ma * BATT_CURRENT_MA_DEN / BATT_CURRENT_MA_NUM) / 16.0;
+}
+
+static void FeedCells(double ma, double lowerCellMv, double upperCellMv)
+{
+    double lower = lowerCellMv * 3, pack = lower + upperCellMv * 3;
+    Feed(CurrentRaw(ma), TapRaw(lower, BATT_LOWER_DIV_NUM), TapRaw(pack, BATT_PACK_DIV_NUM));
+}
+
+static void TestReadings(void)
+{
+    BatteryStatus status;
+    unsigned int results[BATT_IRQ_RESULTS] = {0};
+    unsigned int i;
+
+    BatteryInit();
+    BatteryGetStatus(&status);
+    CHECK(status.flags == BATT_FLAG_NO_DATA);
+    CHECK(status.readings == 0);
+
+    /*Nothing until BATT_DECIMATE interrupts*/
+    for (i = 0; i < BATT_DECIMATE - 1; i++)
+        BatterySweep(results, nowMs);
+    BatteryGetStatus(&status);
+    CHECK(status.readings == 0);
+
+    BatteryInit();
+    FeedCells(0, 4200, 4150);
+    BatteryGetStatus(&status);
+    CHECK(status.readings == 1);
+    CHECK(status.flags == 0);
+    CHECK_NEAR(status.lowerMv, 12600, 12);
+    CHECK_NEAR(status.packMv, 25050, 20);
+    CHECK_NEAR(status.upperMv, 12450, 25);
+    /*2047.5 counts: half a count only shows up oversampled*/
+    CHECK(status.currentMa == 0);
+    /*BatteryInit leaves the ADC interrupt on*/
+    CHECK(IEC0bits.AD1IE == 1);
+}
+
+static void TestStartingCharge(void)
+{
+    BatteryStatus status;
+
+    /*Full*/
+    BatteryInit();
+    FeedCells(0, 4200, 4200);
+    BatteryGetStatus(&status);
+    CHECK(status.socPermille == 1000);
+    CHECK(status.usedMas == 0);
+
+    /*Half, resting at 3.82V a cell*/
+    BatteryInit();
+    FeedCells(0, 3820, 3820);
+    BatteryGetStatus(&status);
+    CHECK_NEAR(status.socPermille, 500, 5);
+
+    /*Flat*/
+    BatteryInit();
+    FeedCells(0, 3200, 3200);
+    BatteryGetStatus(&status);
+    CHECK(status.socPermille == 0);
+}
+
+static void TestChargeCount(void)
+{
+    BatteryStatus status;
+    unsigned int i, n;
+
+    BatteryInit();
+    FeedCells(0, 4200, 4200);
+
+    /*10A for 36s is 100mAh, 2% of 5000mAh*/
+    n = 36000 / (IRQ_MS * BATT_DECIMATE);
+    for (i = 0; i < n; i++)
+        FeedCells(10000, 4000, 4000);
+    BatteryGetStatus(&status);
+    CHECK(status.currentMa == 10000);
+    CHECK(status.usedMas == 360000);
+    CHECK(status.socPermille == 980);
+
+    /*Charging at half that runs it halfway back*/
+    for (i = 0; i < n; i++)
+        FeedCells(-5000, 4100, 4100);
+    BatteryGetStatus(&status);
+    CHECK(status.currentMa == -5000);
+    CHECK(status.usedMas == 180000);
+    CHECK(status.socPermille == 990);
+
+    /*Past full stays at full*/
+    for (i = 0; i < n; i++)
+        FeedCells(-10000, 4200, 4200);
+    BatteryGetStatus(&status);
+    CHECK(status.usedMas < 0);
+    CHECK(status.socPermille == 1000);
+}
+
+static void TestFlags(void)
+{
+    BatteryStatus status;
+
+    BatteryInit();
+    FeedCells(0, 3900, 3300);
+    BatteryGetStatus(&status);
+    CHECK(status.flags == BATT_FLAG_LOW);
+
+    FeedCells(0, 3100, 3900);
+    BatteryGetStatus(&status);
+    CHECK(status.flags == (BATT_FLAG_LOW | BATT_FLAG_CRITICAL));
+}
+
+/*The whole ADC buffer, as the interrupt sees it: alternate halves filled*/
+static void TestBufferHalves(void)
+{
+    unsigned int buf[BATT_ADC_BUF_WORDS];
+    const unsigned int values[BATT_SCAN_CHANNELS] = {2048, 1200, 1300, VBG_RAW};
+    BatteryStatus status;
+    unsigned int irq, i;
+
+    BatteryInit();
+    for (irq = 0; irq < BATT_DECIMATE; irq++)
+    {
+        /*BUFS set: the ADC is filling the second half, the first is done*/
+        int bufs = !(irq & 1);
+        unsigned int* done = bufs ? buf : buf + BATT_ADC_HALF_WORDS;
+        unsigned int* filling = bufs ? buf + BATT_ADC_HALF_WORDS : buf;
+        for (i = 0; i < BATT_ADC_HALF_WORDS; i++)
+        {
+            done[i] = i < BATT_IRQ_RESULTS ? values[i % BATT_SCAN_CHANNELS] : 0xFFFF;
+            filling[i] = 0xFFFF;
+        }
+        nowMs += IRQ_MS;
+        BatterySweep(BATT_ADC_DONE_HALF(buf, bufs), nowMs);
+    }
+    BatteryGetStatus(&status);
+    CHECK(status.readings == 1);
+    CHECK(status.currentMa == (2048L * 16 - BATT_CURRENT_ZERO) * BATT_CURRENT_MA_NUM / BATT_CURRENT_MA_DEN);
+    CHECK_NEAR(status.lowerMv, (long) 1200 * BATT_VBG_MV * BATT_LOWER_DIV_NUM / VBG_RAW, 2);
+    CHECK_NEAR(status.packMv, (long) 1300 * BATT_VBG_MV * BATT_PACK_DIV_NUM / VBG_RAW, 2);
+
+    /*The second half starts at ADC1BUF9*/
+    CHECK(BATT_ADC_DONE_HALF(buf, 0) == &buf[9]);
+    CHECK(BATT_ADC_DONE_HALF(buf, 1) == &buf[0]);
+}
+
+static void TestFrame(void)
+{
+    unsigned int data[4];
+
+    BatteryInit();
+    BatteryGetFrame(data, BATT_FLAG_ESTOP);
+    CHECK((data[3] >> 8) == (BATT_FLAG_NO_DATA | BATT_FLAG_ESTOP));
+
+    FeedCells(0, 4200, 4200);
+    FeedCells(-2500, 4200, 4200);
+    BatteryGetFrame(data, 0);
+    CHECK_NEAR(data[0], 25200, 20);
+    CHECK((int) data[1] == -250);
+    CHECK(data[2] == 0);
+    CHECK(data[3] == 100);
+
+    /*Full scale current still fits*/
+    BatteryInit();
+    FeedCells(0, 3300, 3300);
+    Feed(4095, TapRaw(9900, BATT_LOWER_DIV_NUM), TapRaw(19800, BATT_PACK_DIV_NUM));
+    BatteryGetFrame(data, 0);
+    CHECK(data[1] == 20475);
+    CHECK(data[3] == (BATT_FLAG_LOW << 8));
+}
+
+int main(void)
+{
+    TestReadings();
+    TestStartingCharge();
+    TestChargeCount();
+    TestFlags();
+    TestBufferHalves();
+    TestFrame();
+    return CHECK_RESULT();
+}
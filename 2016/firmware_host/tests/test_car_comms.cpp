@@ -0,0 +1,122 @@
+/*
+ * File:   test_car_comms.cpp
+ * Author: Kevin
+ *
+ * Description: 2015 car_motor_driver binary frames (car_comms.h), as used
+ *              by the sketch and the pi's serial node: encode and parse,
+ *              bad CRCs, picking up again after noise and text lines, and
+ *              the pi node's MessageParser fed in any split.
+ */
+
+#include "check.h"
+#include <car_comms.h>
+#include <car_serial_comms/MessageParser.h>
+
+#include <string.h>
+
+static void TestCrc(void)
+{
+    /*CRC-8/SMBUS check value*/
+    const uint8_t check[] = "123456789";
+    CHECK(Car_Comms::crc8(check, 9) == 0xF4);
+}
+
+static void TestRoundTrip(void)
+{
+    static const int16_t values[][2] = {{0, 0}, {-30, 1500}, {40, -1}, {32767, -32768}};
+    Car_Comms parser;
+    uint8_t frame[CAR_COMMS_FRAME];
+    unsigned int i, k;
+
+    for (i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        CHECK(Car_Comms::encode(frame, CAR_COMMS_DRIVE, values[i][0], values[i][1]) == CAR_COMMS_FRAME);
+        CHECK(frame[0] == CAR_COMMS_SYNC);
+        for (k = 0; k < CAR_COMMS_FRAME - 1; k++)
+            CHECK(!parser.parse(frame[k]));
+        CHECK(parser.parse(frame[k]));
+        CHECK(parser.message().id == CAR_COMMS_DRIVE);
+        CHECK(parser.message().a == values[i][0]);
+        CHECK(parser.message().b == values[i][1]);
+    }
+
+    /*Little endian on the wire*/
+    Car_Comms::encode(frame, CAR_COMMS_STATUS, 0x1234, -2);
+    CHECK(frame[1] == CAR_COMMS_STATUS);
+    CHECK(frame[2] == 0x34 && frame[3] == 0x12);
+    CHECK(frame[4] == 0xFE && frame[5] == 0xFF);
+    CHECK(parser.crc_errors() == 0);
+}
+
+/*A stream with noise, a report line, a corrupted frame whose payload
+ *holds a sync byte, and frames back to back*/
+static void TestResync(void)
+{
+    uint8_t stream[128];
+    size_t n = 0;
+    int16_t got[8];
+    int frames = 0;
+    size_t i;
+    Car_Comms parser;
+
+    memcpy(stream + n, "# control jitter 12us\r\n", 23);
+    n += 23;
+    n += Car_Comms::encode(stream + n, CAR_COMMS_DRIVE, 1, 10);
+    stream[n++] = 0x00;
+    stream[n++] = CAR_COMMS_SYNC;
+    /*Corrupt: a = 0x00A5 puts a sync byte in the middle*/
+    n += Car_Comms::encode(stream + n, CAR_COMMS_DRIVE, 0x00A5, 20);
+    stream[n - 1] ^= 0x55;
+    n += Car_Comms::encode(stream + n, CAR_COMMS_DRIVE, 3, 30);
+    n += Car_Comms::encode(stream + n, CAR_COMMS_STOP, 1, 0);
+    n += Car_Comms::encode(stream + n, CAR_COMMS_DRIVE, 4, 40);
+
+    for (i = 0; i < n; i++)
+    {
+        if (parser.parse(stream[i]) && frames < 8)
+            got[frames++] = parser.message().id == CAR_COMMS_DRIVE ? parser.message().a : -1;
+    }
+    CHECK(frames == 4);
+    CHECK(got[0] == 1 && got[1] == 3 && got[2] == -1 && got[3] == 4);
+    CHECK(parser.crc_errors() > 0);
+}
+
+/*The pi's serial node: drive commands it encodes go through the sketch's
+ *parser, and its MessageParser takes the sketch's frames in any split*/
+static void TestPiSide(void)
+{
+    uint8_t stream[64];
+    size_t n = 0, split, i;
+    int differ = 0;
+    Car_Comms sketch;
+
+    n = MessageParser::encode_drive(stream, -25, 1600);
+    for (i = 0; i < n; i++)
+        sketch.parse(stream[i]);
+    CHECK(sketch.message().id == CAR_COMMS_DRIVE);
+    CHECK(sketch.message().a == -25 && sketch.message().b == 1600);
+
+    n = 0;
+    stream[n++] = 0x7E;
+    n += Car_Comms::encode(stream + n, CAR_COMMS_DRIVE, -12, 345);
+    n += Car_Comms::encode(stream + n, CAR_COMMS_STATUS, 11, 50);
+    n += Car_Comms::encode(stream + n, CAR_COMMS_DRIVE, 67, -890);
+    for (split = 0; split <= n; split++)
+    {
+        MessageParser mp;
+        bool first = mp.parse_message(stream, split);
+        bool second = mp.parse_message(stream + split, n - split);
+        differ += !(first || second);
+        differ += mp.get_steering() != 67 || mp.get_throttle() != -890;
+    }
+    CHECK(differ == 0);
+}
+
+int main(void)
+{
+    TestCrc();
+    TestRoundTrip();
+    TestResync();
+    TestPiSide();
+    return CHECK_RESULT();
+}
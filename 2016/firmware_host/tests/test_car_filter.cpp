@@ -0,0 +1,179 @@
+/*
+ * File:   test_car_filter.cpp
+ * Author: Kevin
+ *
+ * Description: 2016 car_localization's CarFilter, the ROS-free EKF behind the
+ *              localization node, fed measurements as the node would: dead
+ *              reckoning from speed and heading, out of order and late
+ *              measurements, a full queue, the GPS gate and heading wrap.
+ */
+
+#include <cmath>
+
+#include "check.h"
+#include "car_localization/car_filter.h"
+
+using car_localization::CarFilter;
+using car_localization::Measurement;
+
+// CHECK_NEAR compares longs, so compare in thousandths
+#define MILLI(x) ((x) * 1000.0)
+
+static Measurement Velocity(double stamp, double v, double w)
+{
+    Measurement m;
+    m.stamp = stamp;
+    m.type = car_localization::MEAS_VELOCITY;
+    m.z[0] = v;
+    m.z[1] = w;
+    m.variance[0] = m.variance[1] = 0.01;
+    return m;
+}
+
+static Measurement Heading(double stamp, double yaw)
+{
+    Measurement m;
+    m.stamp = stamp;
+    m.type = car_localization::MEAS_HEADING;
+    m.z[0] = yaw;
+    m.variance[0] = 0.0025;
+    return m;
+}
+
+static Measurement Position(double stamp, double x, double y)
+{
+    Measurement m;
+    m.stamp = stamp;
+    m.type = car_localization::MEAS_POSITION;
+    m.z[0] = x;
+    m.z[1] = y;
+    m.variance[0] = m.variance[1] = 1.0;
+    return m;
+}
+
+static void TestDeadReckoning(void)
+{
+    CarFilter filter;
+    CarFilter::Filter::State x;
+    CarFilter::Filter::Covariance P;
+
+    CHECK(!filter.started());
+    CHECK(filter.process(1.0) == 0);
+    CHECK(!filter.started());
+
+    // 2m/s north for 5s, wheels at 50Hz and the IMU at 100Hz
+    for (int i = 0; i <= 500; i++)
+    {
+        const double t = 10.0 + i * 0.01;
+        filter.add(Heading(t, M_PI / 2));
+        if (i % 2 == 0)
+            filter.add(Velocity(t, 2.0, 0.0));
+        filter.process(t);
+    }
+    CHECK(filter.started());
+    filter.extrapolate(filter.time(), x, P);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_X)), 0, 10);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_Y)), 10000, 50);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_YAW)), MILLI(M_PI / 2), 5);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_V)), 2000, 5);
+    CHECK(filter.late == 0 && filter.overflow == 0 && filter.rejected == 0);
+
+    // Extrapolating moves the copy on, not the filter
+    filter.extrapolate(filter.time() + 0.5, x, P);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_Y)), 11000, 50);
+    CHECK_NEAR(MILLI(filter.time()), 15000, 1);
+}
+
+static void TestOrdering(void)
+{
+    CarFilter filter;
+    CarFilter::Filter::State x;
+    CarFilter::Filter::Covariance P;
+
+    // Queued newest first, fused oldest first: the first velocity sets the
+    // state outright, so the order shows in what is left
+    CHECK(filter.add(Heading(1.02, 0.0)));
+    CHECK(filter.add(Velocity(1.01, 3.0, 0.0)));
+    CHECK(filter.add(Heading(1.00, 0.0)));
+    CHECK(filter.process(1.005) == 1);
+    CHECK_NEAR(MILLI(filter.time()), 1005, 1);
+    CHECK(filter.process(1.02) == 2);
+    filter.extrapolate(filter.time(), x, P);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_V)), 3000, 1);
+
+    // Behind what has been fused already
+    CHECK(!filter.add(Velocity(1.015, 1.0, 0.0)));
+    CHECK(filter.late == 1);
+    CHECK(filter.process(1.03) == 0);
+}
+
+static void TestOverflow(void)
+{
+    CarFilter filter;
+
+    for (int i = 0; i < MEASUREMENT_QUEUE_SIZE; i++)
+        CHECK(filter.add(Heading(i * 0.001, 0.0)));
+    CHECK(filter.overflow == 0);
+    CHECK(!filter.add(Heading(1.0, 0.0)));
+    CHECK(filter.overflow == 1);
+    CHECK(filter.process(2.0) == MEASUREMENT_QUEUE_SIZE);
+}
+
+static void TestGate(void)
+{
+    CarFilter filter;
+    CarFilter::Filter::State x;
+    CarFilter::Filter::Covariance P;
+
+    // Parked 1.5m east and 1m south of the origin the node took from an
+    // earlier fix
+    filter.add(Heading(0.0, 0.0));
+    filter.add(Velocity(0.0, 0.0, 0.0));
+    for (int i = 1; i <= 20; i++)
+    {
+        filter.add(Velocity(i * 0.1, 0.0, 0.0));
+        filter.add(Position(i * 0.1, 1.5, -1.0));
+    }
+    filter.process(2.0);
+    filter.extrapolate(filter.time(), x, P);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_X)), 1500, 100);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_Y)), -1000, 100);
+    CHECK(filter.rejected == 0);
+
+    // A fix 100m out is thrown away, the state stays put
+    filter.add(Position(2.1, 101.5, -1.0));
+    filter.process(2.1);
+    CHECK(filter.rejected == 1);
+    filter.extrapolate(filter.time(), x, P);
+    CHECK_NEAR(MILLI(x(car_localization::STATE_X)), 1500, 100);
+}
+
+static void TestHeadingWrap(void)
+{
+    CarFilter filter;
+    CarFilter::Filter::State x;
+    CarFilter::Filter::Covariance P;
+
+    // Either side of pi: the innovation is 0.08, not 2pi - 0.08
+    filter.add(Heading(0.0, 3.10));
+    for (int i = 1; i <= 10; i++)
+        filter.add(Heading(i * 0.01, -3.10));
+    filter.process(0.1);
+    CHECK(filter.rejected == 0);
+    filter.extrapolate(filter.time(), x, P);
+    CHECK_NEAR(MILLI(car_localization::wrapAngle(x(car_localization::STATE_YAW) + 3.10)), 0, 5);
+    CHECK(std::fabs(x(car_localization::STATE_YAW)) <= M_PI);
+
+    CHECK_NEAR(MILLI(car_localization::wrapAngle(3 * M_PI)), MILLI(M_PI), 1);
+    CHECK_NEAR(MILLI(car_localization::wrapAngle(-M_PI / 2 - 2 * M_PI)), MILLI(-M_PI / 2), 1);
+}
+
+int main(void)
+{
+    TestDeadReckoning();
+    TestOrdering();
+    TestOverflow();
+    TestGate();
+    TestHeadingWrap();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,189 @@
+/*
+ * File:   test_car_wire.cpp
+ * Author: Kevin
+ *
+ * Description: 2014 car-wire on the simulated i2c_t3: a master polling
+ *              blocks from two slaves in one bus pass, sequence numbers and
+ *              unchanged blocks, CRC-8 failures, a missing slave, and
+ *              writes acknowledged by CRC read back. Wire1 is a
+ *              slave_car_wire; the second slave is a plain register device
+ *              holding a frame written in by the test.
+ */
+
+#include "check.h"
+#include <master_car_wire.h>
+#include <slave_car_wire.h>
+
+#include <string.h>
+
+#define SLAVE   0x20   /*slave_car_wire on Wire1*/
+#define DEVICE  0x21   /*register device*/
+#define MISSING 0x22
+
+#define REG_ENCODER 0x10
+#define REG_POWER   0x20
+#define REG_COMMAND 0x30
+#define REG_DEVICE  0x40
+
+typedef struct
+{
+    int32_t left, right;
+} Encoders;
+
+static unsigned char encoderFrame[CAR_WIRE_FRAME(sizeof(Encoders))];
+static unsigned char powerFrame[CAR_WIRE_FRAME(4)];
+static unsigned char commandFrame[CAR_WIRE_FRAME(2)];
+static car_wire_register slaveRegisters[] = {
+    {REG_ENCODER, sizeof(Encoders), encoderFrame, false, false},
+    {REG_POWER, 4, powerFrame, false, false},
+    {REG_COMMAND, 2, commandFrame, true, false},
+};
+static slave_car_wire slave(Wire1, slaveRegisters, 3);
+static uint8_t deviceRegs[256];
+
+static void receiveEvent(size_t len)
+{
+    slave.receiveEvent(len);
+}
+
+static void requestEvent(void)
+{
+    slave.requestEvent();
+}
+
+static void Setup(void)
+{
+    i2c_sim_reset();
+    Wire1.onReceive(receiveEvent);
+    Wire1.onRequest(requestEvent);
+    i2c_sim_slave(SLAVE);
+    memset(deviceRegs, 0, sizeof(deviceRegs));
+    i2c_sim_device(DEVICE, deviceRegs, 0xFF);
+}
+
+/*A 2 byte frame for the register device, as a slave_car_wire would send*/
+static void DeviceFrame(uint8_t sequence, uint16_t value)
+{
+    uint8_t reg = REG_DEVICE;
+    uint8_t* frame = &deviceRegs[REG_DEVICE];
+    frame[0] = sequence;
+    memcpy(&frame[1], &value, 2);
+    frame[3] = car_crc8(car_crc8(0, &reg, 1), frame, 3);
+}
+
+static void TestCrc(void)
+{
+    /*CRC-8/SMBUS check value*/
+    const unsigned char check[] = "123456789";
+    CHECK(car_crc8(0, check, 9) == 0xF4);
+}
+
+static void TestPoll(void)
+{
+    master_car_wire master(Wire);
+    Encoders encoders = {1000, -2000}, got;
+    uint8_t power[4] = {1, 2, 3, 4}, gotPower[4];
+    uint16_t gotDevice;
+    car_wire_block blocks[] = {
+        car_wire_block(SLAVE, REG_ENCODER, &got, sizeof(got)),
+        car_wire_block(SLAVE, REG_POWER, gotPower, 4),
+        car_wire_block(DEVICE, REG_DEVICE, &gotDevice, 2),
+    };
+
+    Setup();
+    slave.publish(REG_ENCODER, &encoders);
+    slave.publish(REG_POWER, power);
+    DeviceFrame(7, 0xBEEF);
+
+    /*One pass: a START, repeated starts between every transfer, one STOP*/
+    CHECK(master.poll(blocks, 3) == 3);
+    CHECK(i2c_sim_transfers() == 6);
+    CHECK(i2c_sim_repeated_starts() == 5);
+    CHECK(blocks[0].status == CAR_WIRE_FRESH && blocks[1].status == CAR_WIRE_FRESH && blocks[2].status == CAR_WIRE_FRESH);
+    CHECK(got.left == 1000 && got.right == -2000);
+    CHECK(memcmp(gotPower, power, 4) == 0);
+    CHECK(gotDevice == 0xBEEF);
+    CHECK(blocks[2].sequence == 7);
+
+    /*Nothing new: the buffers are left alone*/
+    memset(&got, 0, sizeof(got));
+    CHECK(master.poll(blocks, 3) == 0);
+    CHECK(blocks[0].status == CAR_WIRE_UNCHANGED && blocks[2].status == CAR_WIRE_UNCHANGED);
+    CHECK(got.left == 0);
+    CHECK(blocks[0].unchanged == 1);
+
+    /*New encoder counts only*/
+    encoders.left = 1010;
+    slave.publish(REG_ENCODER, &encoders);
+    CHECK(master.poll(blocks, 3) == 1);
+    CHECK(blocks[0].status == CAR_WIRE_FRESH && blocks[1].status == CAR_WIRE_UNCHANGED);
+    CHECK(got.left == 1010 && got.right == -2000);
+    CHECK(blocks[0].unchanged == 0 && blocks[1].unchanged == 2);
+    CHECK(hostInterruptsOff == 0);
+}
+
+static void TestErrors(void)
+{
+    master_car_wire master(Wire);
+    Encoders got;
+    uint16_t gotDevice = 0, missing;
+    uint8_t unknown[4];
+    car_wire_block blocks[] = {
+        car_wire_block(DEVICE, REG_DEVICE, &gotDevice, 2),
+        car_wire_block(MISSING, REG_DEVICE, &missing, 2),
+        car_wire_block(SLAVE, 0x55, unknown, 4),
+        car_wire_block(SLAVE, REG_ENCODER, &got, sizeof(got)),
+    };
+
+    Setup();
+    DeviceFrame(1, 0x1234);
+    deviceRegs[REG_DEVICE + 1] ^= 0x01;
+
+    /*A bad block or a missing slave doesn't stop the pass*/
+    CHECK(master.poll(blocks, 4) == 1);
+    CHECK(blocks[0].status == CAR_WIRE_BAD_CRC);
+    CHECK(gotDevice == 0);
+    CHECK(blocks[1].status == CAR_WIRE_NAK);
+    CHECK(blocks[2].status == CAR_WIRE_BAD_CRC);
+    CHECK(blocks[3].status == CAR_WIRE_FRESH);
+
+    /*Asked for the wrong length, the CRC lands on the wrong byte*/
+    CHECK(!master.request(&got, 4, SLAVE, REG_ENCODER));
+    CHECK(master.request(&got, sizeof(got), SLAVE, REG_ENCODER));
+}
+
+static void TestWrite(void)
+{
+    master_car_wire master(Wire);
+    uint8_t command[2] = {0x5A, 0xA5}, taken[2] = {0, 0};
+    uint8_t bad[4] = {REG_COMMAND, 1, 2, 0};
+    Encoders encoders = {1, 2};
+
+    Setup();
+    CHECK(!slave.take(REG_COMMAND, taken));
+    CHECK(master.write(command, 2, SLAVE, REG_COMMAND));
+    CHECK(slave.take(REG_COMMAND, taken));
+    CHECK(taken[0] == 0x5A && taken[1] == 0xA5);
+    CHECK(!slave.take(REG_COMMAND, taken));
+
+    /*Bad CRC, wrong length and read only registers are refused*/
+    Wire.beginTransmission(SLAVE);
+    Wire.write(bad, 4);
+    Wire.endTransmission();
+    CHECK(slave.crcErrors() == 1);
+    CHECK(!master.write(command, 1, SLAVE, REG_COMMAND));
+    CHECK(!master.write(&encoders, sizeof(encoders), SLAVE, REG_ENCODER));
+    CHECK(slave.crcErrors() == 3);
+    CHECK(!slave.take(REG_COMMAND, taken));
+    CHECK(!master.write(command, 2, MISSING, REG_COMMAND));
+    CHECK(hostInterruptsOff == 0);
+}
+
+int main(void)
+{
+    TestCrc();
+    TestPoll();
+    TestErrors();
+    TestWrite();
+    return CHECK_RESULT();
+}
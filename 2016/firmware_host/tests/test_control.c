@@ -0,0 +1,149 @@
+/*
+ * File:   test_control.c
+ * Author: Jacob
+ *
+ * Description: motorboard.X speed and steering control on the host.
+ */
+
+#include "check.h"
+#include "motorboard_sim.h"
+#include "control.h"
+#include "userVariables.h"
+
+static void ControlReset(void)
+{
+    int i;
+    SimReset();
+    for (i = 0; i < WHEEL_COUNT; i++)
+        WheelSpeed[i] = 0;
+    EStopRemote = 0;
+    control_init();
+    ControlSetTarget(0, SERVO_CENTER_US);
+    ControlJitterMax = 0;
+    ControlJitterCount = 0;
+    ControlOverrunCount = 0;
+}
+
+/*Run the loop on time with all wheels reading speed*/
+static void Step(int speed, unsigned int count)
+{
+    int i;
+    while (count--)
+    {
+        for (i = 0; i < WHEEL_COUNT; i++)
+            WheelSpeed[i] = speed;
+        SimAdvance(CONTROL_PERIOD_TICKS);
+        _T1Interrupt();
+    }
+}
+
+static void TestNeutralAtRest(void)
+{
+    ControlReset();
+    Step(0, 10);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US);
+    CHECK(servoDuty == SERVO_CENTER_US);
+    CHECK(T1CONbits.TON == 1);
+}
+
+static void TestSpeedLoop(void)
+{
+    ControlReset();
+    ControlSetTarget(1000, SERVO_CENTER_US);
+    Step(0, 1);
+    CHECK(motorDuty > MOTOR_NEUTRAL_US);
+    /*Stalled: the output pins at full throttle*/
+    Step(0, 500);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US + MOTOR_RANGE_US);
+    /*On target: proportional term gone, integral holds the throttle*/
+    Step(1000, 1);
+    CHECK(motorDuty > MOTOR_NEUTRAL_US);
+    CHECK(motorDuty <= MOTOR_NEUTRAL_US + MOTOR_RANGE_US);
+
+    /*Reverse drives the other way and never forward*/
+    ControlReset();
+    ControlSetTarget(-500, SERVO_CENTER_US);
+    Step(0, 50);
+    CHECK(motorDuty < MOTOR_NEUTRAL_US);
+    Step(2000, 50);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US);
+}
+
+static void TestAntiWindup(void)
+{
+    int i;
+    ControlReset();
+    ControlSetTarget(1000, SERVO_CENTER_US);
+    /*Long stall; without anti-windup the integrator would keep growing*/
+    Step(0, 5000);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US + MOTOR_RANGE_US);
+    /*Overshoot: the throttle has to come off within a few periods*/
+    for (i = 0; i < 20 && motorDuty >= MOTOR_NEUTRAL_US + MOTOR_RANGE_US; i++)
+        Step(1500, 1);
+    CHECK(i < 20);
+}
+
+static void TestOverrides(void)
+{
+    ControlReset();
+    ControlSetTarget(1000, SERVO_CENTER_US);
+    Step(0, 100);
+    CHECK(motorDuty > MOTOR_NEUTRAL_US);
+
+    EStopRemote = 1;
+    Step(0, 1);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US);
+    /*The integrator was cleared, no lurch when released*/
+    EStopRemote = 2;
+    Step(1000, 1);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US);
+
+    Step(0, 100);
+    PORTDbits.RD8 = 1;
+    Step(0, 1);
+    CHECK(motorDuty == MOTOR_NEUTRAL_US);
+    PORTDbits.RD8 = 0;
+}
+
+static void TestSteeringSlew(void)
+{
+    ControlReset();
+    ControlSetTarget(0, 2000);
+    Step(0, 1);
+    CHECK(servoDuty == SERVO_CENTER_US + SERVO_SLEW_US);
+    Step(0, 48);
+    CHECK(servoDuty == 1990);
+    Step(0, 1);
+    CHECK(servoDuty == 2000);
+    Step(0, 10);
+    CHECK(servoDuty == 2000);
+    /*Out of range targets are clamped*/
+    ControlSetTarget(0, 500);
+    Step(0, 200);
+    CHECK(servoDuty == SERVO_CENTER_US - SERVO_RANGE_US);
+}
+
+static void TestJitter(void)
+{
+    ControlReset();
+    Step(0, 10);
+    CHECK(ControlJitterCount == 0);
+    CHECK(ControlJitterMax == 0);
+    /*One entry held off by a higher priority ISR*/
+    SimAdvance(CONTROL_PERIOD_TICKS + CONTROL_JITTER_LIMIT + 10);
+    _T1Interrupt();
+    CHECK(ControlJitterCount == 1);
+    CHECK(ControlJitterMax == CONTROL_JITTER_LIMIT + 10);
+    CHECK(ControlOverrunCount == 0);
+}
+
+int main(void)
+{
+    TestNeutralAtRest();
+    TestSpeedLoop();
+    TestAntiWindup();
+    TestOverrides();
+    TestSteeringSlew();
+    TestJitter();
+    return CHECK_RESULT();
+}
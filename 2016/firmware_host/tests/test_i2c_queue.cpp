@@ -0,0 +1,206 @@
+/*
+ * File:   test_i2c_queue.cpp
+ * Author: Kevin
+ *
+ * Description: 2014 SF9DOF_AHRS sensor bus queue (I2CQueue) on the
+ *              simulated i2c_t3: reads chained from the interrupt callback
+ *              with a repeated start, completion callbacks, a full queue,
+ *              NAKs and a read stuck on the bus.
+ */
+
+#include "check.h"
+#include <I2CQueue.h>
+
+#define GYRO  0x69
+#define ACCEL 0x53
+#define MAG   0x1E
+
+static uint8_t gyroRegs[256], accelRegs[256], magRegs[256];
+static I2CRead* doneOrder[16];
+static int doneCount;
+
+static void Record(I2CRead* read)
+{
+    doneOrder[doneCount++] = read;
+}
+
+static void Setup(void)
+{
+    int i;
+    i2c_sim_reset();
+    for (i = 0; i < 256; i++)
+    {
+        gyroRegs[i] = (uint8_t) i;
+        accelRegs[i] = (uint8_t) (i + 100);
+        magRegs[i] = (uint8_t) (200 - i);
+    }
+    i2c_sim_device(GYRO, gyroRegs, 0x7F);
+    i2c_sim_device(ACCEL, accelRegs, 0xFF);
+    i2c_sim_device(MAG, magRegs, 0xFF);
+    sensorBus.begin();
+    doneCount = 0;
+    hostMicros = 0;
+}
+
+static void Describe(I2CRead* read, uint8_t address, uint8_t reg, uint8_t* data)
+{
+    read->address = address;
+    read->reg = reg;
+    read->length = 6;
+    read->data = data;
+    read->done = Record;
+    read->context = NULL;
+    read->status = I2C_READ_IDLE;
+}
+
+static void TestChain(void)
+{
+    I2CRead gyro, accel, mag;
+    uint8_t gyroData[6], accelData[6], magData[6];
+    int steps = 0;
+
+    Setup();
+    Describe(&gyro, GYRO, 0x28 | 0x80, gyroData);
+    Describe(&accel, ACCEL, 0x32, accelData);
+    Describe(&mag, MAG, 0x03, magData);
+
+    CHECK(sensorBus.submit(&gyro));
+    CHECK(sensorBus.submit(&accel));
+    CHECK(sensorBus.submit(&mag));
+    CHECK(!sensorBus.idle());
+    /*Only the first is on the bus, and resubmitting it is refused*/
+    CHECK(i2c_sim_transfers() == 1);
+    CHECK(!sensorBus.submit(&gyro));
+    CHECK(gyro.status == I2C_READ_QUEUED);
+
+    /*Each read is an address write and a repeated start read, and each
+     *transfer is started from the previous one's callback*/
+    while (i2c_sim_step())
+        steps++;
+    CHECK(steps == 6);
+    CHECK(i2c_sim_transfers() == 6);
+    CHECK(i2c_sim_repeated_starts() == 3);
+    CHECK(sensorBus.idle());
+
+    CHECK(doneCount == 3);
+    CHECK(doneOrder[0] == &gyro && doneOrder[1] == &accel && doneOrder[2] == &mag);
+    CHECK(gyro.status == I2C_READ_DONE && accel.status == I2C_READ_DONE && mag.status == I2C_READ_DONE);
+    CHECK(gyroData[0] == 0x28 && gyroData[5] == 0x2D);
+    CHECK(accelData[0] == 0x32 + 100 && accelData[5] == 0x37 + 100);
+    CHECK(magData[0] == 200 - 3 && magData[5] == 200 - 8);
+    CHECK(sensorBus.failures() == 0);
+    CHECK(hostInterruptsOff == 0);
+}
+
+/*A done callback that queues its read again, up to 5 times*/
+static int again;
+
+static void Again(I2CRead* read)
+{
+    Record(read);
+    if (++again < 5)
+        CHECK(sensorBus.submit(read));
+}
+
+static void TestResubmit(void)
+{
+    I2CRead gyro;
+    uint8_t gyroData[6];
+
+    Setup();
+    Describe(&gyro, GYRO, 0x28 | 0x80, gyroData);
+    gyro.done = Again;
+    again = 0;
+    CHECK(sensorBus.submit(&gyro));
+    while (i2c_sim_step());
+    CHECK(again == 5);
+    CHECK(doneCount == 5);
+    CHECK(i2c_sim_transfers() == 10);
+    CHECK(sensorBus.idle());
+}
+
+static void TestFull(void)
+{
+    I2CRead reads[I2C_QUEUE_SIZE + 1];
+    uint8_t data[6];
+    int i;
+
+    Setup();
+    for (i = 0; i <= I2C_QUEUE_SIZE; i++)
+    {
+        Describe(&reads[i], ACCEL, (uint8_t) i, data);
+        CHECK(sensorBus.submit(&reads[i]) == (i < I2C_QUEUE_SIZE));
+    }
+    CHECK(reads[I2C_QUEUE_SIZE].status == I2C_READ_IDLE);
+    while (i2c_sim_step());
+    CHECK(doneCount == I2C_QUEUE_SIZE);
+    CHECK(sensorBus.submit(&reads[I2C_QUEUE_SIZE]));
+    while (i2c_sim_step());
+    CHECK(reads[I2C_QUEUE_SIZE].status == I2C_READ_DONE);
+    CHECK(data[0] == I2C_QUEUE_SIZE + 100);
+}
+
+static void TestNak(void)
+{
+    I2CRead gyro, accel;
+    uint8_t gyroData[6], accelData[6] = {0};
+
+    Setup();
+    Describe(&accel, ACCEL, 0x32, accelData);
+    Describe(&gyro, GYRO, 0x28 | 0x80, gyroData);
+    i2c_sim_nak(ACCEL, 1);
+    sensorBus.submit(&accel);
+    sensorBus.submit(&gyro);
+    while (i2c_sim_step());
+
+    /*The missing accelerometer doesn't hold up the gyro*/
+    CHECK(accel.status == I2C_READ_FAILED);
+    CHECK(accelData[0] == 0);
+    CHECK(gyro.status == I2C_READ_DONE);
+    CHECK(doneCount == 2);
+    CHECK(sensorBus.failures() == 1);
+    CHECK(sensorBus.idle());
+}
+
+static void TestStuck(void)
+{
+    I2CRead gyro, accel;
+    uint8_t gyroData[6], accelData[6];
+    unsigned int failuresBefore;
+
+    Setup();
+    failuresBefore = sensorBus.failures();
+    Describe(&gyro, GYRO, 0x28 | 0x80, gyroData);
+    Describe(&accel, ACCEL, 0x32, accelData);
+    i2c_sim_hang(1);
+    sensorBus.submit(&gyro);
+    sensorBus.submit(&accel);
+    CHECK(!i2c_sim_step());
+
+    hostMicros += I2C_QUEUE_TIMEOUT_US;
+    sensorBus.service();
+    CHECK(gyro.status == I2C_READ_QUEUED);
+
+    /*Past the timeout the gyro read is failed and the next one started*/
+    hostMicros += 1;
+    sensorBus.service();
+    CHECK(gyro.status == I2C_READ_FAILED);
+    CHECK(sensorBus.failures() == failuresBefore + 1);
+    CHECK(accel.status == I2C_READ_QUEUED);
+
+    i2c_sim_hang(0);
+    while (i2c_sim_step());
+    CHECK(accel.status == I2C_READ_DONE);
+    CHECK(sensorBus.idle());
+    CHECK(hostInterruptsOff == 0);
+}
+
+int main(void)
+{
+    TestChain();
+    TestResubmit();
+    TestFull();
+    TestNak();
+    TestStuck();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,159 @@
+/*
+ * File:   test_matvec.cpp
+ * Author: Michael Buchel
+ *
+ * Description: MatVec.h and matvec_c.h (2014/IMU-GPS/libraries/MatVec)
+ *              against the loops they replace in the SF9DOF_AHRS sketch and
+ *              against vector3dFixed, plus compile time evaluation.
+ */
+
+#include "check.h"
+#include "MatVec.h"
+#include "matvec_c.h"
+#include "vector3dFixed.h"
+
+#include <string.h>
+
+using namespace matvec;
+
+/*Worked out by the compiler, or this file doesn't build*/
+constexpr Mat3f A = {{1, 2, 3, 4, 5, 6, 7, 8, 10}};
+static_assert((A * identity<3>(1.0f))(2, 2) == 10, "identity");
+static_assert((A * A)(2, 2) == 169, "multiply");
+static_assert(transpose(A)(0, 2) == 7, "transpose");
+static_assert((A * Vec3f{{1, 1, 1}})[1] == 15, "matrix vector");
+static_assert(dot(Vec3f{{1, 2, 3}}, Vec3f{{4, 5, 6}}) == 32, "dot");
+static_assert(cross(Vec3f{{1, 0, 0}}, Vec3f{{0, 1, 0}})[2] == 1, "cross");
+static_assert((Mat<2, 3, float>{{1, 2, 3, 4, 5, 6}} * Mat<3, 2, float>{{1, 0, 0, 1, 1, 1}})(1, 1) == 11, "2x3 3x2");
+static_assert((Vec3q{{Q16::fromDouble(1.5), Q16(), Q16()}} * Q16::fromDouble(0.5))[0].raw == 49152, "fixed");
+
+static double RandomUnit(void)
+{
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+/*Matrix_Multiply and Vector_Dot_Product as the sketch had them*/
+static void LoopMatrixMultiply(float a[3][3], float b[3][3], float mat[3][3])
+{
+    float op[3];
+    for (int x = 0; x < 3; x++)
+        for (int y = 0; y < 3; y++)
+        {
+            for (int w = 0; w < 3; w++)
+                op[w] = a[x][w] * b[w][y];
+            mat[x][y] = op[0] + op[1] + op[2];
+        }
+}
+
+static float LoopDot(float vector1[3], float vector2[3])
+{
+    float op = 0;
+    for (int c = 0; c < 3; c++)
+        op += vector1[c] * vector2[c];
+    return op;
+}
+
+static void TestFloat(void)
+{
+    int run, differ = 0;
+
+    for (run = 0; run < 1000; run++)
+    {
+        float a[3][3], b[3][3], loop[3][3], shim[9];
+        float u[3], v[3], c[3];
+        int i;
+        for (i = 0; i < 9; i++)
+        {
+            a[i / 3][i % 3] = (float) RandomUnit();
+            b[i / 3][i % 3] = (float) RandomUnit();
+        }
+        for (i = 0; i < 3; i++)
+        {
+            u[i] = (float) RandomUnit();
+            v[i] = (float) RandomUnit();
+        }
+
+        /*Same products summed in the same order: bit for bit the same*/
+        LoopMatrixMultiply(a, b, loop);
+        const Mat3f product = loadMat<3, 3>(&a[0][0]) * loadMat<3, 3>(&b[0][0]);
+        mm33_mul_f(shim, &a[0][0], &b[0][0]);
+        differ += memcmp(product.m, &loop[0][0], sizeof(shim)) != 0;
+        differ += memcmp(shim, &loop[0][0], sizeof(shim)) != 0;
+
+        differ += dot(load<3>(u), load<3>(v)) != LoopDot(u, v);
+        differ += mv3_dot_f(u, v) != LoopDot(u, v);
+
+        const Vec3f cr = cross(load<3>(u), load<3>(v));
+        mv3_cross_f(c, u, v);
+        differ += memcmp(cr.v, c, sizeof(c)) != 0;
+
+        const Vec3f mv = transpose(product) * load<3>(u);
+        float t[9], mvShim[3];
+        mm33_transpose_f(t, shim);
+        mm33_mulv_f(mvShim, t, u);
+        differ += memcmp(mv.v, mvShim, sizeof(mvShim)) != 0;
+    }
+    CHECK(differ == 0);
+
+    /*Output over an input*/
+    {
+        float u[3] = {1, 2, 3}, v[3] = {4, 5, 6};
+        mv3_cross_f(u, u, v);
+        CHECK(u[0] == -3 && u[1] == 6 && u[2] == -3);
+        mv3_add_f(v, v, v);
+        CHECK(v[2] == 12);
+    }
+}
+
+static void TestFixed(void)
+{
+    int run, differ = 0;
+
+    for (run = 0; run < 1000; run++)
+    {
+        vectorFixed a, b, r;
+        a.x = Q16_FROM_DOUBLE(100 * RandomUnit());
+        a.y = Q16_FROM_DOUBLE(100 * RandomUnit());
+        a.z = Q16_FROM_DOUBLE(100 * RandomUnit());
+        b.x = Q16_FROM_DOUBLE(RandomUnit());
+        b.y = Q16_FROM_DOUBLE(RandomUnit());
+        b.z = Q16_FROM_DOUBLE(RandomUnit());
+        const Vec3q av = {{Q16::fromRaw(a.x), Q16::fromRaw(a.y), Q16::fromRaw(a.z)}};
+        const Vec3q bv = {{Q16::fromRaw(b.x), Q16::fromRaw(b.y), Q16::fromRaw(b.z)}};
+        const int32_t as[3] = {a.x, a.y, a.z}, bs[3] = {b.x, b.y, b.z};
+        int32_t out[3];
+
+        /*Rounds down like mulQ16, so it matches vector3dFixed exactly*/
+        differ += dot(av, bv).raw != dotFixed(&a, &b);
+        differ += mv3_dot_q16(as, bs) != dotFixed(&a, &b);
+
+        crossFixed(&a, &b, &r);
+        const Vec3q c = cross(av, bv);
+        mv3_cross_q16(out, as, bs);
+        differ += c[0].raw != r.x || c[1].raw != r.y || c[2].raw != r.z;
+        differ += out[0] != r.x || out[1] != r.y || out[2] != r.z;
+
+        multiplyFixed(&a, b.y, &r);
+        const Vec3q s = av * bv[1];
+        differ += s[0].raw != r.x || s[1].raw != r.y || s[2].raw != r.z;
+    }
+    CHECK(differ == 0);
+
+    /*Q30 rotation about z by 90 degrees*/
+    {
+        const Q30 one = Q30::fromRaw(Q30_ONE), zero = Q30();
+        const Mat<3, 3, Q30> rz = {{zero, -one, zero, one, zero, zero, zero, zero, one}};
+        const Mat<3, 3, Q30> back = rz * transpose(rz);
+        const Vec<3, Q30> x = rz * Vec<3, Q30>{{Q30::fromDouble(0.5), zero, zero}};
+        CHECK_NEAR(back(0, 0).raw, Q30_ONE, 1);
+        CHECK(back(0, 1).raw == 0);
+        CHECK(x[0].raw == 0 && x[1].raw == Q30_FROM_DOUBLE(0.5));
+    }
+}
+
+int main(void)
+{
+    TestFloat();
+    TestFixed();
+    return CHECK_RESULT();
+}
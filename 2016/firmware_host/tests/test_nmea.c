@@ -0,0 +1,257 @@
+/*
+ * File:   test_nmea.c
+ * Author: Michael Buchel
+ *
+ * Description: WEbots_CAR_IMU&GPS.X NMEA receive ring buffer and parser on
+ *              the host, fed through the UART1 queue and RX ISR.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "check.h"
+#include "NMEA.h"
+
+static const char rmc[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+static const char gga[] = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+static const char vtg[] = "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n";
+
+/*Characters arrive on the UART and the ISR moves them to the ring buffer*/
+static void Receive(const char* data, unsigned int length)
+{
+    hal_uart_inject(1, data, length);
+    _U1RXInterrupt();
+}
+
+static unsigned char Send(const char* sentence)
+{
+    Receive(sentence, strlen(sentence));
+    return NMEAProcess();
+}
+
+/*$body*XX<CR><LF> with the right checksum*/
+static unsigned char SendBody(const char* body)
+{
+    char sentence[128];
+    unsigned char sum = 0;
+    unsigned int i;
+    for (i = 0; body[i] != '\0'; i++)
+        sum ^= (unsigned char) body[i];
+    snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, sum);
+    return Send(sentence);
+}
+
+static void Reset(void)
+{
+    hal_reset();
+    NMEA_init(115200);
+}
+
+static void TestInit(void)
+{
+    Reset();
+    CHECK(U1MODEbits.BRGH && U1MODEbits.UARTEN);
+    CHECK(U1BRG == 129);
+    CHECK(IEC0bits.U1RXIE && U1STAbits.URXISEL == 0);
+}
+
+static void TestSentences(void)
+{
+    NMEAFix fix;
+
+    Reset();
+    CHECK(Send(rmc) == NMEA_RMC);
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == NMEA_RMC);
+    CHECK(fix.valid);
+    CHECK(fix.latitude == 481173000L);      //48 07.038'
+    CHECK(fix.longitude == 115166667L);     //11 31.000'
+    CHECK(fix.time == (12 * 3600L + 35 * 60 + 19) * 1000);
+    CHECK(fix.speed == 11524);              //22.4 knots
+    CHECK(fix.course == 8440);
+    CHECK(fix.day == 23 && fix.month == 3 && fix.year == 94);
+
+    CHECK(Send(gga) == NMEA_GGA);
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == NMEA_GGA);
+    CHECK(fix.quality == 1 && fix.satellites == 8);
+    CHECK(fix.hdop == 90);
+    CHECK(fix.altitude == 545400L);
+    CHECK(fix.latitude == 481173000L);
+
+    CHECK(Send(vtg) == NMEA_VTG);
+    NMEAGetFix(&fix);
+    CHECK(fix.course == 5470);
+    CHECK(fix.speed == 2833);               //10.2 km/h
+    CHECK(NMEASentenceCount == 3 && NMEAChecksumErrorCount == 0);
+
+    /*Fractions of a second, fraction digits past what is kept*/
+    SendBody("GPRMC,235959.250,A,4259.1234567,S,08115.9876543,W,0.5,359.99,010116,,,A");
+    NMEAGetFix(&fix);
+    CHECK(fix.time == 86399250L);
+    CHECK(fix.latitude == -429853908L);     //42 59.12345'
+    CHECK(fix.longitude == -812664608L);    //81 15.98765'
+    CHECK(fix.speed == 257);
+    CHECK(fix.course == 35999);
+    CHECK(fix.day == 1 && fix.month == 1 && fix.year == 16);
+}
+
+static void TestRejects(void)
+{
+    NMEAFix fix;
+    char corrupt[sizeof(rmc)];
+
+    Reset();
+    Send(rmc);
+    NMEAGetFix(&fix);
+
+    /*One character off*/
+    strcpy(corrupt, rmc);
+    corrupt[20] = '8';
+    CHECK(Send(corrupt) == 0);
+    CHECK(NMEAChecksumErrorCount == 1);
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == 0 && fix.latitude == 481173000L);
+
+    /*No checksum, bad hex, too long*/
+    CHECK(Send("$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W\r\n") == 0);
+    CHECK(Send("$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*4G\r\n") == 0);
+    CHECK(SendBody("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,,,,,,,,,,,,,,,,,,,,,,,,") == 0);
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == 0);
+
+    /*Cut short by the next sentence*/
+    CHECK(Send("$GPRMC,123519,A,48") == 0);
+    CHECK(Send(vtg) == NMEA_VTG);
+
+    /*Other talkers decode, other sentences are checked and skipped*/
+    CHECK(SendBody("GNRMC,010203,A,0100.000,N,00200.000,E,0,0,010116,,") == NMEA_RMC);
+    NMEAGetFix(&fix);
+    CHECK(fix.latitude == 10000000L && fix.longitude == 20000000L);
+    CHECK(SendBody("GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00") == 0);
+    CHECK(SendBody("PUBX,00,081350.00,4717.113210,N") == 0);
+    CHECK(NMEAChecksumErrorCount == 1);
+}
+
+static void TestNoFix(void)
+{
+    NMEAFix fix;
+
+    Reset();
+    Send(rmc);
+    Send(gga);
+    NMEAGetFix(&fix);
+
+    /*Lost the fix: empty fields, status V and quality 0 keep the last position*/
+    CHECK(SendBody("GPRMC,123520,V,,,,,,,230394,,") == NMEA_RMC);
+    NMEAGetFix(&fix);
+    CHECK(!fix.valid);
+    CHECK(fix.latitude == 481173000L && fix.longitude == 115166667L);
+    CHECK(fix.time == (12 * 3600L + 35 * 60 + 20) * 1000);
+    CHECK(SendBody("GPGGA,123521,,,,,0,00,99.99,,,,,,") == NMEA_GGA);
+    NMEAGetFix(&fix);
+    CHECK(!fix.valid && fix.quality == 0 && fix.satellites == 0);
+    CHECK(fix.latitude == 481173000L);
+    CHECK(fix.altitude == 545400L);
+}
+
+static void TestPieces(void)
+{
+    NMEAFix fix;
+    unsigned char done = 0;
+    unsigned int i;
+
+    /*One character per interrupt, parsed whenever the main loop gets to it*/
+    Reset();
+    for (i = 0; gga[i] != '\0'; i++)
+    {
+        Receive(&gga[i], 1);
+        if (i % 7 == 0)
+            done |= NMEAProcess();
+    }
+    done |= NMEAProcess();
+    CHECK(done == NMEA_GGA);
+    NMEAGetFix(&fix);
+    CHECK(fix.altitude == 545400L);
+}
+
+static void TestTenHertz(void)
+{
+    NMEAFix fix;
+    unsigned int epoch;
+    unsigned int positions = 0;
+
+    /*10s of RMC, GGA and VTG at 10Hz, the main loop parsing every 50ms*/
+    Reset();
+    for (epoch = 0; epoch < 100; epoch++)
+    {
+        char body[100];
+        snprintf(body, sizeof(body), "GPRMC,1200%02u.%u0,A,4807.%03u,N,01131.000,E,022.4,084.4,230394,,",
+            epoch / 10, epoch % 10, epoch);
+        SendBody(body);
+        snprintf(body, sizeof(body), "GPGGA,1200%02u.%u0,4807.%03u,N,01131.000,E,2,11,0.8,545.4,M,46.9,M,,",
+            epoch / 10, epoch % 10, epoch);
+        SendBody(body);
+        Send(vtg);
+        NMEAGetFix(&fix);
+        if (fix.updated == (NMEA_RMC | NMEA_GGA | NMEA_VTG)
+                && fix.time == 12 * 3600000L + epoch * 100L
+                && fix.latitude == 480000000L + ((700000L + epoch * 100L) * 5 + 1) / 3)
+            positions++;
+    }
+    CHECK(positions == 100);
+    CHECK(NMEASentenceCount == 300 && NMEAOverrunCount == 0);
+}
+
+static void TestOverrun(void)
+{
+    NMEAFix fix;
+    unsigned int i;
+
+    /*Main loop held up for longer than the ring buffer lasts*/
+    Reset();
+    for (i = 0; i < NMEA_RX_BUFFER_SIZE / (sizeof(rmc) - 1) + 2; i++)
+        Receive(rmc, sizeof(rmc) - 1);
+    CHECK(NMEAOverrunCount > 0);
+    NMEAProcess();
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == NMEA_RMC);
+    /*Whatever was cut in half doesn't pass, and the next sentence is fine*/
+    CHECK(NMEASentenceCount == NMEA_RX_BUFFER_SIZE / (sizeof(rmc) - 1));
+    CHECK(Send(gga) == NMEA_GGA);
+
+    /*Hardware FIFO overrun*/
+    U1STAbits.OERR = 1;
+    _U1RXInterrupt();
+    CHECK(!U1STAbits.OERR);
+}
+
+/*Two little endian int16 words of the frame back to an int32*/
+static long FrameWord(const unsigned int* data)
+{
+    return (int32_t) (((uint32_t) (data[1] & 0xFFFF) << 16) | (data[0] & 0xFFFF));
+}
+
+static void TestFrame(void)
+{
+    unsigned int data[4];
+
+    Reset();
+    SendBody("GPRMC,123519,A,4807.038,S,01131.000,W,,,230394,,");
+    NMEAGetFrame(data);
+    CHECK(FrameWord(&data[0]) == -481173000L);
+    CHECK(FrameWord(&data[2]) == -115166667L);
+}
+
+int main(void)
+{
+    TestInit();
+    TestSentences();
+    TestRejects();
+    TestNoFix();
+    TestPieces();
+    TestTenHertz();
+    TestOverrun();
+    TestFrame();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,170 @@
+/*
+ * File:   test_quadrature.c
+ * Author: Kevin
+ *
+ * Description: 2015 odometer board quadrature decoding, fed pin states and
+ *              timestamps as the change notification interrupt would:
+ *              counting both ways, missed edges, the period over a cycle
+ *              and a long run of it, and the I2C snapshot frame.
+ */
+
+#include <xc.h>
+#include "check.h"
+#include "Quadrature.h"
+
+//forward, A leading B
+static const unsigned int forward[4] = {0, 2, 3, 1};
+
+static unsigned int phase;
+static uint32_t ticks;
+
+static void Step(int dir, uint32_t dt)
+{
+    phase = (phase + (dir > 0 ? 1 : 3)) % 4;
+    ticks += dt;
+    QuadEdge(forward[phase], ticks);
+}
+
+static void Start(void)
+{
+    phase = 0;
+    ticks = 1000;
+    QuadInit(forward[phase]);
+}
+
+static void TestCount(void)
+{
+    QuadSnapshot s;
+    unsigned int i;
+
+    Start();
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == 0);
+    CHECK(s.period == 0);
+    CHECK(s.errors == 0);
+    CHECK(IEC1bits.CNIE == 1);
+
+    //all four edges of a cycle count
+    for (i = 0; i < 40; i++)
+        Step(1, 100);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == 40);
+
+    for (i = 0; i < 50; i++)
+        Step(-1, 100);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == -10);
+
+    //no change, or a glitch the interrupt didn't see, counts nothing
+    QuadEdge(forward[phase], ticks);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == -10);
+    CHECK(s.errors == 0);
+
+    //past where an 8 bit count wrapped
+    for (i = 0; i < 100000; i++)
+        Step(1, 10);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == 99990);
+}
+
+static void TestMissedEdge(void)
+{
+    QuadSnapshot s;
+    unsigned int i;
+
+    Start();
+    for (i = 0; i < 8; i++)
+        Step(1, 100);
+
+    //both pins changed between interrupts: taken as two more the same way
+    phase = (phase + 2) % 4;
+    ticks += 100;
+    QuadEdge(forward[phase], ticks);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == 10);
+    CHECK(s.errors == 1);
+    CHECK(s.period == 0);
+
+    Step(1, 100);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.count == 11);
+}
+
+static void TestPeriod(void)
+{
+    QuadSnapshot s;
+    unsigned int i;
+
+    Start();
+    //not a whole cycle the same way yet
+    for (i = 0; i < QUAD_PERIOD_EDGES; i++)
+        Step(1, 250);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.period == 0);
+
+    Step(1, 250);
+    QuadGetSnapshot(&s, ticks + 30);
+    CHECK(s.period == 1000);
+    CHECK(s.lastEdge == ticks);
+    CHECK(s.now == ticks + 30);
+
+    //uneven edges from the channels' phase still make an exact cycle
+    for (i = 0; i < 8; i++)
+        Step(1, i % 2 ? 700 : 300);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.period == 2000);
+
+    //turning round starts over
+    Step(-1, 300);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.period == 0);
+    for (i = 0; i < QUAD_PERIOD_EDGES; i++)
+        Step(-1, 400);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.period == 1600);
+
+    //a long steady run, past where a 16 bit edge count would wrap
+    for (i = 0; i < 0x10000UL; i++)
+        Step(-1, 400);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.period == 1600);
+
+    //across the timer's 32 bit wrap
+    ticks = 0xFFFFFF00UL;
+    for (i = 0; i < 8; i++)
+        Step(-1, 0x80);
+    QuadGetSnapshot(&s, ticks);
+    CHECK(s.lastEdge == 0x300);
+    CHECK(s.period == 0x200);
+}
+
+static void TestFrame(void)
+{
+    QuadSnapshot s;
+    unsigned char frame[QUAD_FRAME_SIZE + 1];
+
+    s.count = -2;
+    s.lastEdge = 0x12345678UL;
+    s.period = 0x0000ABCDUL;
+    s.now = 0xCAFEF00DUL;
+    s.errors = 7;
+    frame[QUAD_FRAME_SIZE] = 0x5A;
+    QuadPackSnapshot(&s, frame);
+
+    CHECK(frame[0] == 0xFE && frame[1] == 0xFF && frame[2] == 0xFF && frame[3] == 0xFF);
+    CHECK(frame[4] == 0x78 && frame[5] == 0x56 && frame[6] == 0x34 && frame[7] == 0x12);
+    CHECK(frame[8] == 0xCD && frame[9] == 0xAB && frame[10] == 0 && frame[11] == 0);
+    CHECK(frame[12] == 0x0D && frame[13] == 0xF0 && frame[14] == 0xFE && frame[15] == 0xCA);
+    CHECK(frame[16] == 7);
+    CHECK(frame[QUAD_FRAME_SIZE] == 0x5A);
+}
+
+int main(void)
+{
+    TestCount();
+    TestMissedEdge();
+    TestPeriod();
+    TestFrame();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,213 @@
+/*
+ * File:   test_quaternion_fixed.c
+ * Author: Michael Buchel
+ *
+ * Description: WEbots_CAR_IMU&GPS.X fixed point quaternion and vector3d
+ *              against the double versions on the host.
+ */
+
+#include "check.h"
+#include "quaternion.h"
+#include "quaternionFixed.h"
+
+#define RANDOM_RUNS 2000
+
+/*Errors in the last bit of Q1.30 and Q16.16*/
+#define Q30_TOL 64          //6e-8
+#define Q16_TOL 4           //6e-5
+#define ANGLE_TOL 8         //1.2e-4 rad
+
+static double RandomUnit(void)
+{
+    return 2.0 * rand() / RAND_MAX - 1.0;
+}
+
+static void RandomQuat(quaternion* q, quaternionFixed* f)
+{
+    init2(q, RandomUnit(), RandomUnit(), RandomUnit(), RandomUnit());
+    normalizeQuat(q);
+    init2Fixed(f, Q30_FROM_DOUBLE(q->w), Q30_FROM_DOUBLE(q->x),
+        Q30_FROM_DOUBLE(q->y), Q30_FROM_DOUBLE(q->z));
+}
+
+static void RandomVector(vector* v, vectorFixed* f, double scale)
+{
+    v->x = scale * RandomUnit();
+    v->y = scale * RandomUnit();
+    v->z = scale * RandomUnit();
+    f->x = Q16_FROM_DOUBLE(v->x);
+    f->y = Q16_FROM_DOUBLE(v->y);
+    f->z = Q16_FROM_DOUBLE(v->z);
+}
+
+static void CheckQuat(const quaternionFixed* f, const quaternion* q, long tol)
+{
+    CHECK_NEAR(f->w, Q30_FROM_DOUBLE(q->w), tol);
+    CHECK_NEAR(f->x, Q30_FROM_DOUBLE(q->x), tol);
+    CHECK_NEAR(f->y, Q30_FROM_DOUBLE(q->y), tol);
+    CHECK_NEAR(f->z, Q30_FROM_DOUBLE(q->z), tol);
+}
+
+static void CheckVector(const vectorFixed* f, const vector* v, long tol)
+{
+    CHECK_NEAR(f->x, Q16_FROM_DOUBLE(v->x), tol);
+    CHECK_NEAR(f->y, Q16_FROM_DOUBLE(v->y), tol);
+    CHECK_NEAR(f->z, Q16_FROM_DOUBLE(v->z), tol);
+}
+
+static void TestMul(void)
+{
+    int i;
+    CHECK(fixedMul(Q30_ONE, Q30_ONE, 30) == Q30_ONE);
+    CHECK(fixedMul(-Q30_ONE, Q30_ONE, 30) == -Q30_ONE);
+    CHECK(fixedMul(-1, 1, 1) == -1);    //rounds down like >>
+    for (i = 0; i < RANDOM_RUNS; i++)
+    {
+        int32_t a = (int32_t) ((uint32_t) rand() << 16 ^ (uint32_t) rand());
+        int32_t b = (int32_t) ((uint32_t) rand() << 16 ^ (uint32_t) rand());
+        unsigned int shift = 1 + i % 31;
+        int64_t product = ((int64_t) a * b) >> shift;
+        if (product >= INT32_MIN && product <= INT32_MAX)
+            CHECK(fixedMul(a, b, shift) == (int32_t) product);
+    }
+}
+
+static void TestSqrt(void)
+{
+    int i;
+    int exponent;
+    CHECK(fixedSqrt(0, 16) == 0);
+    CHECK(fixedSqrt(4UL << 16, 16) == 2 * Q16_ONE);
+    CHECK_NEAR(fixedSqrt(2, 0), Q16_FROM_DOUBLE(1.41421356), 1);
+    CHECK_NEAR(fixedSqrt(1, 30), Q16_FROM_DOUBLE(3.0517578e-5), 1);
+    for (i = 0; i < RANDOM_RUNS; i++)
+    {
+        uint32_t v = (uint32_t) rand() >> (i % 24);
+        int frac = i % 40 - 10;
+        double x = ldexp(v ? v : 1, -frac);
+        int32_t r = fixedRsqrt(v ? v : 1, frac, &exponent);
+        double rx = ldexp(r, exponent - 28);
+        CHECK(fabs(rx * sqrt(x) - 1.0) < 1e-7);
+        /*28 bit mantissa*/
+        if (sqrt(x) < 30000)
+            CHECK_NEAR(fixedSqrt(v ? v : 1, frac), Q16_FROM_DOUBLE(sqrt(x)), 1 + sqrt(x) * 65536 / (1 << 27));
+    }
+}
+
+static void TestAngles(void)
+{
+    int i;
+    CHECK_NEAR(fixedAtan2(0, 1), 0, 1);
+    CHECK_NEAR(fixedAtan2(1, 0), Q16_PI / 2, 1);
+    CHECK_NEAR(fixedAtan2(-1, 0), -Q16_PI / 2, 1);
+    CHECK_NEAR(fixedAtan2(0, -1), Q16_PI, 1);
+    CHECK_NEAR(fixedAtan2(-5, -5), Q16_FROM_DOUBLE(-0.75 * 3.14159265), 1);
+    CHECK_NEAR(fixedAsin(Q30_ONE), Q16_PI / 2, 1);
+    CHECK_NEAR(fixedAsin(-Q30_ONE - 10), -Q16_PI / 2, 1);
+    for (i = 0; i < RANDOM_RUNS; i++)
+    {
+        double y = RandomUnit(), x = RandomUnit();
+        double scale = ldexp(1, i % 40 - 10);
+        CHECK_NEAR(fixedAtan2((int32_t) (y * scale * 65536), (int32_t) (x * scale * 65536)),
+            Q16_FROM_DOUBLE(atan2((int32_t) (y * scale * 65536), (int32_t) (x * scale * 65536))),
+            scale < 1 ? ANGLE_TOL * 4 : ANGLE_TOL);
+        CHECK_NEAR(fixedAsin(Q30_FROM_DOUBLE(y)), Q16_FROM_DOUBLE(asin(y)), ANGLE_TOL);
+    }
+}
+
+static void TestVector(void)
+{
+    int i;
+    for (i = 0; i < RANDOM_RUNS; i++)
+    {
+        vector a, b, r;
+        vectorFixed af, bf, rf;
+        double s = 0.1 + fabs(RandomUnit()) * 50;
+        RandomVector(&a, &af, 100);
+        RandomVector(&b, &bf, 100);
+
+        a.x = Q16_TO_DOUBLE(af.x); a.y = Q16_TO_DOUBLE(af.y); a.z = Q16_TO_DOUBLE(af.z);
+        b.x = Q16_TO_DOUBLE(bf.x); b.y = Q16_TO_DOUBLE(bf.y); b.z = Q16_TO_DOUBLE(bf.z);
+
+        crossFixed(&af, &bf, &rf);
+        r = cross(a, b);
+        CheckVector(&rf, &r, 4);
+        CHECK_NEAR(dotFixed(&af, &bf), Q16_FROM_DOUBLE(dot(a, b)), 4);
+        CHECK_NEAR(magnitudeFixed(&af), Q16_FROM_DOUBLE(magnitude(a)), 2);
+
+        divideFixed(&af, Q16_FROM_DOUBLE(s), &rf);
+        r = divide(a, Q16_TO_DOUBLE(Q16_FROM_DOUBLE(s)));
+        CheckVector(&rf, &r, 2 + (long) (100 / s) / 64);
+
+        normalizeFixed(&af, &rf);
+        r = normalize(a);
+        CheckVector(&rf, &r, 1);
+    }
+}
+
+static void TestQuaternion(void)
+{
+    quaternion q, p, r;
+    quaternionFixed qf, pf, rf;
+    vector v, e, ev;
+    vectorFixed vf, ef;
+    int i;
+
+    /*Identity, zero and an unnormalized quaternion*/
+    init1Fixed(&qf);
+    CHECK(qf.w == Q30_ONE && qf.x == 0);
+    init2Fixed(&qf, 0, 0, 0, 0);
+    normalizeQuatFixed(&qf);
+    CHECK(qf.w == Q30_ONE);
+    init2Fixed(&qf, Q30_ONE, Q30_ONE, Q30_ONE, Q30_ONE);
+    CHECK_NEAR(magnitudeQuatFixed(&qf), 2 * Q16_ONE, 1);
+    normalizeQuatFixed(&qf);
+    CHECK_NEAR(qf.w, Q30_ONE / 2, Q30_TOL);
+
+    for (i = 0; i < RANDOM_RUNS; i++)
+    {
+        RandomQuat(&q, &qf);
+        RandomQuat(&p, &pf);
+
+        multiplyQuatFixed(&qf, &pf, &rf);
+        r = multiplyQuat(q, p);
+        CheckQuat(&rf, &r, Q30_TOL);
+
+        /*Drift a little off unit length and back*/
+        rf.w += rf.w >> 8;
+        rf.y -= rf.y >> 7;
+        init2(&r, Q30_TO_DOUBLE(rf.w), Q30_TO_DOUBLE(rf.x), Q30_TO_DOUBLE(rf.y), Q30_TO_DOUBLE(rf.z));
+        normalizeQuatFixed(&rf);
+        normalizeQuat(&r);
+        CheckQuat(&rf, &r, Q30_TOL);
+
+        RandomVector(&v, &vf, 20);
+        rotateVectorFixed(&qf, &vf, &ef);
+        e = rotateVector(q, v);
+        CheckVector(&ef, &e, Q16_TOL);
+
+        getEulerRepresentationFixed(&qf, &ef);
+        e = getEulerRepresentation(q);
+        CheckVector(&ef, &e, ANGLE_TOL);
+
+        /*Rotation between two vectors takes the first onto the second*/
+        RandomVector(&e, &ef, 10);
+        init4Fixed(&rf, &vf, &ef);
+        rotateVectorFixed(&rf, &vf, &vf);
+        ev.x = e.x * magnitude(v) / magnitude(e);
+        ev.y = e.y * magnitude(v) / magnitude(e);
+        ev.z = e.z * magnitude(v) / magnitude(e);
+        CheckVector(&vf, &ev, 64);
+    }
+}
+
+int main(void)
+{
+    srand(33);
+    TestMul();
+    TestSqrt();
+    TestAngles();
+    TestVector();
+    TestQuaternion();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,279 @@
+/*
+ * File:   test_ranging.cpp
+ * Author: Kevin
+ *
+ * Description: 2015 Collision_Avoidance ranging against simulated
+ *              sensors: each ultrasonic sensor answers its trigger with an
+ *              echo pulse on its pin, through hostPinSet(), so the echo is
+ *              timed by the pin interrupt as on the board. Checks one
+ *              sensor per slot, the ranges, the median and majority
+ *              filters, alerts one slot after an obstacle shows up, no
+ *              echo, and the report frame.
+ */
+
+#include "check.h"
+#include <Ranging.h>
+
+#define TICK_US 10
+
+typedef struct
+{
+    uint8_t trig;
+    uint8_t echo;
+    uint32_t width;         /*echo pulse, us; 0 for none*/
+    uint8_t lastTrig;
+    bool pending;
+    bool high;
+    uint32_t riseAt;
+    uint32_t fallAt;
+    unsigned int triggers;
+} Sensor;
+
+static Sensor sensors[2];
+static unsigned int sensorCount;
+static unsigned int rounds;
+static unsigned int overlaps;
+
+static void Reset(void)
+{
+    memset(hostPinLevel, 0, sizeof(hostPinLevel));
+    memset(sensors, 0, sizeof(sensors));
+    sensorCount = 0;
+    rounds = 0;
+    overlaps = 0;
+}
+
+static void AddSensor(uint8_t trig, uint8_t echo)
+{
+    Sensor* s = &sensors[sensorCount++];
+    s->trig = trig;
+    s->echo = echo;
+    s->lastTrig = HIGH;
+}
+
+/*Echo width for a range, in the middle of its 58 us so a tick either way
+ *still reads the same*/
+static uint32_t Width(uint32_t cm)
+{
+    return cm * 58 + 29;
+}
+
+/*loop() at TICK_US, with the sensors answering their triggers*/
+static void RunFor(uint32_t us)
+{
+    uint32_t until = hostMicros + us;
+    unsigned int i;
+
+    while ((int32_t) (hostMicros - until) < 0)
+    {
+        unsigned int low = 0;
+        hostMicros += TICK_US;
+        for (i = 0; i < sensorCount; i++)
+        {
+            Sensor* s = &sensors[i];
+            uint8_t trig = hostPinLevel[s->trig];
+            low += !trig;
+            if (!s->lastTrig && trig)
+            {
+                s->triggers++;
+                if (s->width && !s->pending)
+                {
+                    s->pending = true;
+                    s->riseAt = hostMicros + 200;
+                    s->fallAt = s->riseAt + s->width;
+                }
+            }
+            s->lastTrig = trig;
+
+            if (s->pending && !s->high && (int32_t) (hostMicros - s->riseAt) >= 0)
+            {
+                s->high = true;
+                hostPinSet(s->echo, HIGH);
+            }
+            if (s->high && (int32_t) (hostMicros - s->fallAt) >= 0)
+            {
+                s->high = false;
+                s->pending = false;
+                hostPinSet(s->echo, LOW);
+            }
+        }
+        overlaps += low > 1;
+        rounds += ranging_update();
+    }
+}
+
+static void TestSlots(void)
+{
+    UltrasonicChannel us[] = {
+        ULTRASONIC(8, 7, 16, 25),
+        ULTRASONIC(9, 6, 17, 25)
+    };
+
+    Reset();
+    AddSensor(8, 7);
+    AddSensor(9, 6);
+    sensors[0].width = Width(100);
+    sensors[1].width = Width(20);
+    ranging_begin(us, 2, NULL, 0);
+
+    /*A round is both slots*/
+    RunFor(10 * 2 * RANGE_SLOT_US);
+    CHECK(overlaps == 0);
+    CHECK(sensors[0].triggers == 10);
+    CHECK(sensors[1].triggers == 10);
+    CHECK(rounds == 10);
+    CHECK(us[0].range == 100);
+    CHECK(us[1].range == 20);
+    CHECK(!us[0].alert && hostPinLevel[16] == LOW);
+    CHECK(us[1].alert && hostPinLevel[17] == HIGH);
+
+    /*Something moves in front of the first: flagged in its next slot, the
+     *range follows once the median has it*/
+    sensors[0].width = Width(12);
+    RunFor(RANGE_SLOT_US);
+    CHECK(us[0].alert && hostPinLevel[16] == HIGH);
+    CHECK(us[0].range == 100);
+    RunFor(RANGE_SLOT_US + 2 * 2 * RANGE_SLOT_US);
+    CHECK(us[0].range == 12);
+    CHECK(us[0].alert);
+
+    /*A missed echo doesn't drop it, moving away clears it with the median*/
+    sensors[0].width = 0;
+    RunFor(2 * RANGE_SLOT_US);
+    CHECK(us[0].alert);
+    sensors[0].width = Width(100);
+    RunFor(2 * RANGE_SLOT_US);
+    CHECK(us[0].alert);
+    RunFor(2 * RANGE_SLOT_US);
+    CHECK(us[0].range == 100);
+    CHECK(!us[0].alert && hostPinLevel[16] == LOW);
+}
+
+static void TestFilter(void)
+{
+    UltrasonicChannel us[] = {ULTRASONIC(8, 7, 16, 25)};
+
+    Reset();
+    AddSensor(8, 7);
+    sensors[0].width = Width(80);
+    ranging_begin(us, 1, NULL, 0);
+    RunFor(5 * RANGE_SLOT_US);
+    CHECK(us[0].range == 80);
+
+    /*One stray short echo, flagged for its slot, then one missed*/
+    sensors[0].width = Width(5);
+    RunFor(RANGE_SLOT_US);
+    CHECK(us[0].alert);
+    sensors[0].width = 0;
+    RunFor(RANGE_SLOT_US);
+    sensors[0].width = Width(80);
+    CHECK(us[0].range == 80);
+    CHECK(!us[0].alert && hostPinLevel[16] == LOW);
+    RunFor(5 * RANGE_SLOT_US);
+    CHECK(us[0].range == 80);
+    CHECK(rounds == 12);
+}
+
+static void TestNoEcho(void)
+{
+    UltrasonicChannel us[] = {ULTRASONIC(8, 7, 16, 25)};
+
+    /*Nothing comes back: the old pulseIn() read that as 0 cm, an alert*/
+    Reset();
+    AddSensor(8, 7);
+    ranging_begin(us, 1, NULL, 0);
+    RunFor(5 * RANGE_SLOT_US);
+    CHECK(rounds == 5);
+    CHECK(us[0].range == RANGE_NO_ECHO);
+    CHECK(!us[0].alert);
+
+    /*A sensor that holds the echo high past the slot, then drops it in the
+     *next slot: neither is a reading*/
+    sensors[0].width = 38000;
+    RunFor(10 * RANGE_SLOT_US);
+    CHECK(rounds == 15);
+    CHECK(us[0].range == RANGE_NO_ECHO);
+    CHECK(!us[0].alert);
+}
+
+static void TestDigital(void)
+{
+    DigitalChannel ir[] = {DIGITAL(14, 17), DIGITAL(15, 18)};
+
+    Reset();
+    ranging_begin(NULL, 0, ir, 2);
+    RunFor(10 * RANGE_DIGITAL_US);
+    CHECK(!ir[0].alert && !ir[1].alert);
+
+    /*A one sample glitch on the first*/
+    hostPinSet(14, HIGH);
+    RunFor(RANGE_DIGITAL_US);
+    hostPinSet(14, LOW);
+    RunFor(5 * RANGE_DIGITAL_US);
+    CHECK(!ir[0].alert && hostPinLevel[17] == LOW);
+    CHECK(rounds == 0);
+
+    /*Held: seen within three samples, and clears the same way*/
+    hostPinSet(15, HIGH);
+    RunFor(3 * RANGE_DIGITAL_US);
+    CHECK(ir[1].alert && hostPinLevel[18] == HIGH);
+    CHECK(!ir[0].alert);
+    hostPinSet(15, LOW);
+    RunFor(3 * RANGE_DIGITAL_US);
+    CHECK(!ir[1].alert && hostPinLevel[18] == LOW);
+}
+
+static uint8_t Crc8(const uint8_t* data, unsigned int length)
+{
+    uint8_t crc = 0;
+    unsigned int i, bit;
+    for (i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+    }
+    return crc;
+}
+
+static void TestFrame(void)
+{
+    UltrasonicChannel us[] = {
+        ULTRASONIC(8, 7, 16, 25),
+        ULTRASONIC(9, 6, 19, 25)
+    };
+    DigitalChannel ir[] = {DIGITAL(14, 17), DIGITAL(15, 18)};
+    uint8_t frame[RANGE_FRAME_MAX];
+    uint8_t n;
+
+    CHECK(Crc8((const uint8_t*) "123456789", 9) == 0xF4);
+
+    Reset();
+    AddSensor(8, 7);
+    AddSensor(9, 6);
+    sensors[0].width = Width(300);
+    sensors[1].width = Width(10);
+    ranging_begin(us, 2, ir, 2);
+    hostPinSet(15, HIGH);
+    RunFor(3 * 2 * RANGE_SLOT_US);
+
+    n = ranging_frame(frame);
+    CHECK(n == 9);
+    CHECK(frame[0] == RANGE_FRAME_SYNC);
+    CHECK(frame[1] == RANGE_FRAME_ID);
+    CHECK(frame[2] == 2);
+    CHECK((frame[3] | (frame[4] << 8)) == 300);
+    CHECK((frame[5] | (frame[6] << 8)) == 10);
+    CHECK(frame[7] == ((1 << 1) | (1 << 5)));
+    CHECK(frame[8] == Crc8(&frame[1], 7));
+}
+
+int main(void)
+{
+    TestSlots();
+    TestFilter();
+    TestNoEcho();
+    TestDigital();
+    TestFrame();
+    return CHECK_RESULT();
+}
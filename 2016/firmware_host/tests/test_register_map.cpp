@@ -0,0 +1,194 @@
+/*
+ * File:   test_register_map.cpp
+ * Author: Kevin
+ *
+ * Description: 2014 SF9DOF_AHRS slave register map (RegisterMap) on the
+ *              simulated Wire1: the layout the master reads, a burst read
+ *              of the whole map, reads from a register, that a read
+ *              between field writes still sees the last published sample,
+ *              and the map read as a car-wire block by master_car_wire.
+ */
+
+#include "check.h"
+#include <RegisterMap.h>
+#include <master_car_wire.h>
+
+#include <stddef.h>
+#include <string.h>
+
+/*As in SF9DOF_AHRS.ino*/
+static void receiveEvent(size_t len)
+{
+    (void) len;
+    if (Wire1.available())
+        registers.select(Wire1.readByte());
+}
+
+static void requestEvent(void)
+{
+    registers.serve();
+}
+
+static void Setup(void)
+{
+    i2c_sim_reset();
+    Wire1.onReceive(receiveEvent);
+    Wire1.onRequest(requestEvent);
+}
+
+/*Master side: register 0 and the whole map in one transaction*/
+static AHRSMap ReadAll(void)
+{
+    uint8_t reg = 0;
+    AHRSMap map;
+    CHECK(i2c_sim_slave_transfer(&reg, 1, (uint8_t*) &map, sizeof(map)) == sizeof(map));
+    return map;
+}
+
+static void TestLayout(void)
+{
+    /*Documented in RegisterMap.h and the IMU-GPS README*/
+    CHECK(sizeof(AHRSMap) == 0x1C);
+    CHECK(offsetof(AHRSMap, sequence) == 0x02);
+    CHECK(offsetof(AHRSMap, roll) == 0x04);
+    CHECK(offsetof(AHRSMap, yaw) == 0x0C);
+    CHECK(offsetof(AHRSMap, latE7) == 0x10);
+    CHECK(offsetof(AHRSMap, lngE7) == 0x14);
+    CHECK(offsetof(AHRSMap, gpsAge) == 0x18);
+    CHECK(offsetof(AHRSMap, sensorFailures) == 0x1B);
+}
+
+static void TestPublish(void)
+{
+    AHRSMap map;
+    uint16_t sequence;
+
+    Setup();
+    map = ReadAll();
+    CHECK(map.version == AHRS_MAP_VERSION);
+    sequence = map.sequence;
+
+    registers.back().roll = 1.5f;
+    registers.back().pitch = -2.5f;
+    registers.back().yaw = 270.0f;
+    registers.back().latE7 = 442187234;
+    registers.back().lngE7 = -764979123;
+    registers.back().status = AHRS_STATUS_GPS_FIX;
+    registers.publish();
+
+    map = ReadAll();
+    CHECK(map.version == AHRS_MAP_VERSION);
+    CHECK(map.sequence == (uint16_t) (sequence + 1));
+    CHECK(map.roll == 1.5f && map.pitch == -2.5f && map.yaw == 270.0f);
+    CHECK(map.latE7 == 442187234 && map.lngE7 == -764979123);
+    CHECK(map.status == AHRS_STATUS_GPS_FIX);
+    CHECK(memcmp(&map, &registers.current(), sizeof(map)) == 0);
+
+    /*The back copy carries the published fields on: a tick that only sets
+     *the attitude keeps the GPS position*/
+    registers.back().yaw = 90.0f;
+    registers.publish();
+    map = ReadAll();
+    CHECK(map.sequence == (uint16_t) (sequence + 2));
+    CHECK(map.yaw == 90.0f && map.roll == 1.5f);
+    CHECK(map.latE7 == 442187234);
+}
+
+/*A request landing while loop() is part way through the fields*/
+static void TestTorn(void)
+{
+    AHRSMap map;
+
+    Setup();
+    registers.back().roll = 10.0f;
+    registers.back().pitch = 20.0f;
+    registers.back().latE7 = 1;
+    registers.publish();
+
+    registers.back().roll = 11.0f;
+    map = ReadAll();
+    CHECK(map.roll == 10.0f && map.pitch == 20.0f && map.latE7 == 1);
+    registers.back().pitch = 21.0f;
+    registers.back().latE7 = 2;
+    map = ReadAll();
+    CHECK(map.roll == 10.0f && map.pitch == 20.0f && map.latE7 == 1);
+
+    registers.publish();
+    map = ReadAll();
+    CHECK(map.roll == 11.0f && map.pitch == 21.0f && map.latE7 == 2);
+}
+
+static void TestRegister(void)
+{
+    uint8_t reg, bytes[sizeof(AHRSMap)];
+    int32_t lat;
+
+    Setup();
+    registers.back().latE7 = -123456789;
+    registers.publish();
+
+    /*From latE7 to the end*/
+    reg = 0x10;
+    CHECK(i2c_sim_slave_transfer(&reg, 1, bytes, 4) == sizeof(AHRSMap) - 0x10);
+    memcpy(&lat, bytes, 4);
+    CHECK(lat == -123456789);
+
+    /*A read with no register write starts where the last one did*/
+    CHECK(i2c_sim_slave_transfer(NULL, 0, bytes, 4) == sizeof(AHRSMap) - 0x10);
+    memcpy(&lat, bytes, 4);
+    CHECK(lat == -123456789);
+
+    /*Past the end is register 0*/
+    reg = 0xF0;
+    CHECK(i2c_sim_slave_transfer(&reg, 1, bytes, 1) == sizeof(AHRSMap));
+    CHECK(bytes[0] == AHRS_MAP_VERSION);
+}
+
+static void TestCarWire(void)
+{
+    master_car_wire master(Wire);
+    AHRSMap map;
+    uint8_t reg, frame[CAR_WIRE_FRAME(sizeof(AHRSMap))];
+    car_wire_block block(0x01, AHRS_CAR_WIRE_REG, &map, sizeof(map));
+
+    Setup();
+    i2c_sim_slave(0x01);
+    registers.back().yaw = 45.0f;
+    registers.back().lngE7 = -764979123;
+    registers.publish();
+
+    CHECK(master.poll(&block, 1) == 1);
+    CHECK(block.status == CAR_WIRE_FRESH);
+    CHECK(memcmp(&map, &registers.current(), sizeof(map)) == 0);
+    CHECK(block.sequence == (uint8_t) map.sequence);
+    CHECK(map.yaw == 45.0f && map.lngE7 == -764979123);
+
+    /*Nothing published since: unchanged, then fresh again*/
+    CHECK(master.poll(&block, 1) == 0);
+    CHECK(block.status == CAR_WIRE_UNCHANGED);
+    registers.back().yaw = 46.0f;
+    CHECK(master.poll(&block, 1) == 0);
+    registers.publish();
+    CHECK(master.poll(&block, 1) == 1);
+    CHECK(map.yaw == 46.0f);
+
+    /*The frame itself: sequence byte, map, CRC over the register too*/
+    reg = AHRS_CAR_WIRE_REG;
+    CHECK(i2c_sim_slave_transfer(&reg, 1, frame, sizeof(frame)) == sizeof(frame));
+    CHECK(frame[0] == (uint8_t) registers.current().sequence);
+    CHECK(memcmp(&frame[1], &registers.current(), sizeof(AHRSMap)) == 0);
+    CHECK(frame[sizeof(frame) - 1] == car_crc8(car_crc8(0, &reg, 1), frame, sizeof(frame) - 1));
+
+    /*The plain registers still work after it*/
+    CHECK(ReadAll().yaw == 46.0f);
+}
+
+int main(void)
+{
+    TestLayout();
+    TestPublish();
+    TestTorn();
+    TestRegister();
+    TestCarWire();
+    return CHECK_RESULT();
+}
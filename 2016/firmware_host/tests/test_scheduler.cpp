@@ -0,0 +1,135 @@
+/*
+ * File:   test_scheduler.cpp
+ * Author: Kevin
+ *
+ * Description: 2015 car_motor_driver cooperative scheduler against the
+ *              host micros(): rates and priority, start jitter and run
+ *              times, deadline misses, dropped releases after an overrun,
+ *              and micros() rolling over.
+ */
+
+#include "check.h"
+#include <scheduler.h>
+
+static unsigned long fastRuns, slowRuns, longRuns;
+static unsigned long longRunTime;
+
+static void Fast(void)
+{
+    fastRuns++;
+    hostMicros += 50;
+}
+
+static void Slow(void)
+{
+    slowRuns++;
+    hostMicros += 400;
+}
+
+static void Long(void)
+{
+    longRuns++;
+    hostMicros += longRunTime;
+}
+
+/*loop() for a while: a run, or a pass with nothing due*/
+static void RunFor(Task* tasks, uint8_t count, uint32_t us)
+{
+    uint32_t until = hostMicros + us;
+    while ((int32_t) (hostMicros - until) < 0)
+    {
+        if (scheduler_run(tasks, count) == NULL)
+            hostMicros += 10;
+    }
+}
+
+static void Reset(void)
+{
+    fastRuns = slowRuns = longRuns = 0;
+}
+
+static void TestRates(void)
+{
+    Task tasks[] =
+    {
+        TASK("fast", Fast, 1000, 1000),
+        TASK("slow", Slow, 20000, 2000),
+    };
+
+    Reset();
+    hostMicros = 12345;
+    scheduler_start(tasks, 2);
+    RunFor(tasks, 2, 1000000);
+
+    /*A second at 1 kHz and 50 Hz, nothing lost*/
+    CHECK(fastRuns == 1000);
+    CHECK(slowRuns == 50);
+    CHECK(tasks[0].missed == 0 && tasks[1].missed == 0);
+    CHECK(tasks[0].skipped == 0 && tasks[1].skipped == 0);
+    CHECK(tasks[0].max_run == 50 && tasks[1].max_run == 400);
+
+    /*Released together, the slow task waits for one fast run, and is done
+     *well before the fast task is due again*/
+    CHECK(tasks[0].max_jitter <= 10);
+    CHECK(tasks[1].max_jitter == 50);
+
+    scheduler_clear(tasks, 2);
+    CHECK(tasks[0].max_jitter == 0 && tasks[0].max_run == 0);
+}
+
+static void TestOverrun(void)
+{
+    Task tasks[] =
+    {
+        TASK("fast", Fast, 1000, 1000),
+        TASK("long", Long, 100000, 5000),
+    };
+
+    Reset();
+    hostMicros = 0;
+    longRunTime = 3500;
+    scheduler_start(tasks, 2);
+    RunFor(tasks, 2, 1000000);
+
+    /*Each long run makes the fast task late by 2.5 ms. It catches up on
+     *the period grid, dropping the release it lost entirely rather than
+     *running three times back to back*/
+    CHECK(longRuns == 10);
+    CHECK(tasks[0].max_jitter == 3500 + 50 - 1000);
+    CHECK(tasks[0].missed == 10);
+    CHECK(tasks[0].skipped == 10);
+    CHECK(fastRuns == 1000 - 10);
+    CHECK(tasks[1].missed == 0);
+
+    /*Past its own deadline*/
+    Reset();
+    longRunTime = 6000;
+    scheduler_clear(tasks, 2);
+    RunFor(tasks, 2, 1000000);
+    CHECK(tasks[1].missed == 10);
+    CHECK(tasks[1].max_run == 6000);
+}
+
+static void TestRollover(void)
+{
+    Task tasks[] =
+    {
+        TASK("fast", Fast, 1000, 1000),
+    };
+
+    Reset();
+    hostMicros = 0xFFFFFFFFu - 5000;
+    scheduler_start(tasks, 1);
+    RunFor(tasks, 1, 20000);
+    CHECK(fastRuns == 20);
+    CHECK(tasks[0].max_jitter <= 10);
+    CHECK(tasks[0].skipped == 0 && tasks[0].missed == 0);
+}
+
+int main(void)
+{
+    TestRates();
+    TestOverrun();
+    TestRollover();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,197 @@
+/*
+ * File:   test_sensor_manager.cpp
+ * Author: Kevin
+ *
+ * Description: 2015 robidouille SensorManager against simulated sensors.
+ *              Each sonar answers its trigger pulse with an echo on the
+ *              same pin, through hostPinSet(), so it is timed by the pin
+ *              interrupt as on the board; the test plays the free running
+ *              ADC's interrupt every 100 us. Checks the sonars taking
+ *              turns with the quiet interval between them, the readings
+ *              and their median, no echo, and the IR averages.
+ */
+
+#include "check.h"
+#include <SensorManager.h>
+
+#define TICK_US 10
+#define ADC_US 100
+#define ECHO_DELAY_US 700
+
+typedef struct
+{
+    uint8_t pin;
+    uint32_t width;         /*echo pulse, us; 0 for none*/
+    unsigned int rises;
+    bool pending;
+    bool high;
+    uint32_t riseAt;
+    uint32_t fallAt;
+    unsigned int triggers;
+} Sonar;
+
+static Sonar sonars[2];
+static unsigned int sonarCount;
+static uint32_t lastTrigger;
+static uint32_t minTriggerGap;
+static unsigned int updates;
+static int irPins[2];
+
+static void Reset(void)
+{
+    memset(hostPinLevel, 0, sizeof(hostPinLevel));
+    memset(hostPinRises, 0, sizeof(hostPinRises));
+    memset(sonars, 0, sizeof(sonars));
+    sonarCount = 0;
+    lastTrigger = 0;
+    minTriggerGap = 0xFFFFFFFF;
+    updates = 0;
+}
+
+static void AddSonar(SensorManager& manager, UltraSound1& sonar, uint8_t pin)
+{
+    sonar.Initialize(pin);
+    sonars[sonarCount].pin = pin;
+    sonars[sonarCount].rises = hostPinRises[pin];
+    sonarCount++;
+    manager.AddSonar(&sonar);
+}
+
+/*loop() at TICK_US, with the sonars answering and the ADC converting*/
+static void RunFor(SensorManager& manager, uint32_t us)
+{
+    uint32_t until = hostMicros + us;
+    unsigned int i;
+
+    while ((int32_t) (hostMicros - until) < 0)
+    {
+        hostMicros += TICK_US;
+        for (i = 0; i < sonarCount; i++)
+        {
+            Sonar* s = &sonars[i];
+            if (hostPinRises[s->pin] != s->rises)
+            {
+                s->rises = hostPinRises[s->pin];
+                s->triggers++;
+                if (lastTrigger && hostMicros - lastTrigger < minTriggerGap)
+                    minTriggerGap = hostMicros - lastTrigger;
+                lastTrigger = hostMicros;
+                if (s->width)
+                {
+                    s->pending = true;
+                    s->riseAt = hostMicros + ECHO_DELAY_US;
+                    s->fallAt = s->riseAt + s->width;
+                }
+            }
+            if (s->pending && !s->high && (int32_t) (hostMicros - s->riseAt) >= 0)
+            {
+                s->high = true;
+                hostPinSet(s->pin, HIGH);
+            }
+            if (s->high && (int32_t) (hostMicros - s->fallAt) >= 0)
+            {
+                s->high = false;
+                s->pending = false;
+                hostPinSet(s->pin, LOW);
+            }
+        }
+        if (hostMicros % ADC_US == 0)
+            manager.AdcSample(hostAnalog[irPins[manager.GetAdcSensor()]] + (hostMicros / ADC_US % 2 ? 6 : -6));
+        updates += manager.Update();
+    }
+}
+
+static void TestSonars(void)
+{
+    SensorManager manager;
+    UltraSound1 front, back;
+
+    Reset();
+    AddSonar(manager, front, 2);
+    AddSonar(manager, back, 3);
+    sonars[0].width = 1160;
+    sonars[1].width = 5800;
+    manager.Start();
+
+    RunFor(manager, 1000000);
+    /*About 32 ms quiet plus the echo per measure, taking turns. The quiet
+     *interval is counted in millis(), so it can be up to 1 ms short*/
+    CHECK(sonars[0].triggers >= 12 && sonars[0].triggers <= 15);
+    CHECK(sonars[1].triggers + 1 >= sonars[0].triggers && sonars[1].triggers <= sonars[0].triggers);
+    CHECK(minTriggerGap >= (uint32_t) (kMinMeasureInterval - 1) * 1000 + ECHO_DELAY_US + 1160);
+    CHECK_NEAR(manager.GetSnapshot().fSonarMicros[0], 1160, TICK_US);
+    CHECK_NEAR(manager.GetSnapshot().fSonarMicros[1], 5800, TICK_US);
+    CHECK(updates + 1 >= sonars[0].triggers + sonars[1].triggers);
+    CHECK(manager.GetSnapshot().fSequence == updates);
+}
+
+static void TestMedian(void)
+{
+    SensorManager manager;
+    UltraSound1 sonar;
+    unsigned int triggers;
+
+    Reset();
+    AddSonar(manager, sonar, 2);
+    sonars[0].width = 2900;
+    manager.Start();
+    RunFor(manager, 200000);
+    CHECK_NEAR(manager.GetSnapshot().fSonarMicros[0], 2900, TICK_US);
+
+    /*One missed echo: it times out, without holding up loop()*/
+    triggers = sonars[0].triggers;
+    sonars[0].width = 0;
+    while (sonars[0].triggers == triggers)
+        RunFor(manager, TICK_US);
+    sonars[0].width = 2900;
+    RunFor(manager, kEchoTimeoutMicros + TICK_US);
+    CHECK(sonar.GetLastMeasure() == 0);
+    CHECK_NEAR(manager.GetSnapshot().fSonarMicros[0], 2900, TICK_US);
+
+    /*Gone for good: no echo once the median has it*/
+    sonars[0].width = 0;
+    RunFor(manager, 300000);
+    CHECK(manager.GetSnapshot().fSonarMicros[0] == 0);
+}
+
+static void TestIR(void)
+{
+    SensorManager manager;
+    SharpIRSensor left, right;
+    int changes = 0;
+    unsigned int sequence;
+
+    Reset();
+    irPins[0] = 14;
+    irPins[1] = 15;
+    hostAnalog[14] = 400;
+    hostAnalog[15] = 40;
+    left.Initialize(14);
+    right.Initialize(15);
+    manager.AddIRSensor(&left);
+    manager.AddIRSensor(&right);
+    manager.Start();
+
+    /*kIRAverage conversions a reading, plus one dropped on each switch*/
+    RunFor(manager, 2 * (kIRAverage + 1) * ADC_US);
+    CHECK(manager.GetSnapshot().fIRDistance[0] == 400);
+    CHECK(manager.GetSnapshot().fIRDistance[1] == kIRInfinityThreshold);
+    CHECK(updates == 2);
+
+    /*Each new average goes through SharpIRSensor's filter*/
+    hostAnalog[14] = 250;
+    sequence = manager.GetSnapshot().fSequence;
+    RunFor(manager, 10 * (kIRAverage + 1) * ADC_US);
+    changes = manager.GetSnapshot().fSequence - sequence;
+    CHECK(changes == 10);
+    CHECK(manager.GetSnapshot().fIRDistance[0] == 250);
+    CHECK(left.GetDistance() == 250);
+}
+
+int main(void)
+{
+    TestSonars();
+    TestMedian();
+    TestIR();
+    return CHECK_RESULT();
+}
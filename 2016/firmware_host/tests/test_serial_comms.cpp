@@ -0,0 +1,75 @@
+/*
+ * File:   test_serial_comms.cpp
+ * Author: Kevin
+ *
+ * Description: 2016 car_serial_comms' MessageParser, the part of the Pi's
+ *              comms node without ROS: the start and wheel speed frames in
+ *              and the drive frame out, as the motorboard reads it.
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "car_serial_comms/MessageParser.h"
+
+static struct can_frame Frame(canid_t id, unsigned int dlc)
+{
+    struct can_frame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = id;
+    frame.can_dlc = dlc;
+    return frame;
+}
+
+static void TestStart(void)
+{
+    MessageParser mp;
+    CHECK(!mp.get_start());
+
+    //a remote request or another ID doesn't start it
+    CHECK(!mp.parse_frame(Frame(CANMSG_START | CAN_RTR_FLAG, 0)));
+    CHECK(!mp.parse_frame(Frame(CANMSG_ESTOP, 1)));
+    CHECK(!mp.get_start());
+
+    CHECK(mp.parse_frame(Frame(CANMSG_START, 0)));
+    CHECK(mp.get_start());
+}
+
+static void TestWheelSpeed(void)
+{
+    MessageParser mp;
+    struct can_frame frame = Frame(CANMSG_WHEELSPD, 8);
+    const short speeds[4] = {1000, 1200, -400, 2000};
+    for (int i = 0; i < 4; i++)
+    {
+        frame.data[2 * i] = speeds[i] & 0xFF;
+        frame.data[2 * i + 1] = (speeds[i] >> 8) & 0xFF;
+    }
+    CHECK(mp.parse_frame(frame));
+    CHECK(mp.get_wheel_speed() == 950);
+
+    //short frames are ignored
+    frame.can_dlc = 6;
+    frame.data[0] = 0;
+    CHECK(!mp.parse_frame(frame));
+    CHECK(mp.get_wheel_speed() == 950);
+}
+
+static void TestDriveFrame(void)
+{
+    struct can_frame frame;
+    MessageParser::make_drive_frame(9, -45, frame);
+    CHECK(frame.can_id == CANMSG_DESTRAJ);
+    CHECK(frame.can_dlc == 4);
+    //CAN1EmptyReceiveBuffer() takes data words 0 and 1
+    CHECK((frame.data[0] | (frame.data[1] << 8)) == 9);
+    CHECK((short) (frame.data[2] | (frame.data[3] << 8)) == -45);
+}
+
+int main(void)
+{
+    TestStart();
+    TestWheelSpeed();
+    TestDriveFrame();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,228 @@
+/*
+ * File:   test_slcan.c
+ * Author: Kevin
+ *
+ * Description: CAN to USB tranciever slcan protocol, UART ring buffer and
+ *              per class transmit queues on the host.
+ */
+
+#include <string.h>
+
+#include "check.h"
+#include "CAN.h"
+#include "SLCAN.h"
+#include "UART.h"
+
+static char reply[HAL_UART_QUEUE_SIZE];
+
+/*Everything the bridge sent to the host since the last call*/
+static const char* HostReceived(void)
+{
+    unsigned int n;
+    while (IEC0bits.U1TXIE)
+    {
+        _U1TXInterrupt();
+    }
+    n = hal_uart_take(1, reply, sizeof(reply) - 1);
+    reply[n] = '\0';
+    return reply;
+}
+
+static void HostSend(const char* line)
+{
+    hal_uart_inject(1, line, strlen(line));
+    _U1RXInterrupt();
+    UART1CheckReceiveBuffer();
+}
+
+static void Reset(void)
+{
+    hal_reset();
+    memset(ecan1MsgBuffer, 0, sizeof(ecan1MsgBuffer));
+    UART1Init(UART1_BAUD);
+    SLCANInit();
+}
+
+static void TestOpenClose(void)
+{
+    Reset();
+    HostSend("V\r");
+    CHECK(strcmp(HostReceived(), "V1016\r") == 0);
+    HostSend("t0102FFFF\r");
+    CHECK(strcmp(HostReceived(), "\a") == 0);   //not open yet
+    HostSend("S6\rO\r");
+    CHECK(strcmp(HostReceived(), "\r\r") == 0);
+    HostSend("O\r");
+    CHECK(strcmp(HostReceived(), "\a") == 0);   //already open
+    HostSend("C\r");
+    CHECK(strcmp(HostReceived(), "\r") == 0);
+}
+
+static void TestTransmit(void)
+{
+    Reset();
+    HostSend("O\r");
+    HostReceived();
+
+    /*Class B (0x010) goes into buffer 1*/
+    HostSend("t0102FF01\r");
+    CHECK(strcmp(HostReceived(), "z\r") == 0);
+    CHECK(ecan1MsgBuffer[1][0] == (0x010 << 2));
+    CHECK(ecan1MsgBuffer[1][2] == 2);
+    CHECK(ecan1MsgBuffer[1][3] == 0x01FF);
+    CHECK(C1TR01CONbits.TXREQ1 == 1);
+
+    HostSend("r0314\r");
+    CHECK(strcmp(HostReceived(), "z\r") == 0);
+    CHECK(ecan1MsgBuffer[3][0] == ((0x031 << 2) | 0x0002));
+
+    /*Malformed lines*/
+    HostSend("t01\r");
+    HostSend("t0102FF\r");
+    HostSend("t8000\r");
+    HostSend("t0101GG\r");
+    HostSend("T000000010\r");
+    CHECK(strcmp(HostReceived(), "\a\a\a\a\a") == 0);
+
+    /*Listen only refuses to transmit*/
+    HostSend("C\rL\rt0100\r");
+    CHECK(strcmp(HostReceived(), "\r\r\a") == 0);
+}
+
+static void TestTransmitQueue(void)
+{
+    unsigned int data[4] = {0x1111, 0, 0, 0};
+    int i;
+    Reset();
+    IEC2bits.C1IE = 1; //as CAN1Init leaves it
+
+    /*Buffer 0 busy: class A frames wait in its queue*/
+    C1TR01CONbits.TXREQ0 = 1;
+    CHECK(CAN1Transmit(0x001, 2, data));
+    data[0] = 0x2222;
+    CHECK(CAN1Transmit(0x002, 2, data));
+    CHECK(!CAN1IsTransmitComplete());
+
+    /*Sent: the ISR loads the next queued frame*/
+    C1TR01CONbits.TXREQ0 = 0;
+    C1INTFbits.TBIF = 1;
+    _C1Interrupt();
+    CHECK(ecan1MsgBuffer[0][3] == 0x1111);
+    CHECK(C1TR01CONbits.TXREQ0 == 1);
+    C1TR01CONbits.TXREQ0 = 0;
+    C1INTFbits.TBIF = 1;
+    _C1Interrupt();
+    CHECK(ecan1MsgBuffer[0][3] == 0x2222);
+    C1TR01CONbits.TXREQ0 = 0;
+    CHECK(CAN1IsTransmitComplete());
+
+    /*Full queue refuses and counts, other classes are unaffected*/
+    C1TR01CONbits.TXREQ0 = 1;
+    for (i = 0; i < CAN_TX_QUEUE_SIZE - 1; i++)
+        CHECK(CAN1Transmit(0x001, 0, data));
+    CHECK(!CAN1Transmit(0x001, 0, data));
+    CHECK(CANTxOverflowCount == 1);
+    CHECK(CAN1Transmit(0x030, 0, data));
+    CHECK(C1TR23CONbits.TXREQ3 == 1);
+    CHECK(IEC2bits.C1IE == 1);
+
+    /*Queueing leaves the CAN interrupt as it found it*/
+    IEC2bits.C1IE = 0;
+    CHECK(!CAN1Transmit(0x001, 0, data));
+    CHECK(IEC2bits.C1IE == 0);
+}
+
+static void TestForward(void)
+{
+    Reset();
+    /*Received frames are dropped until the channel is opened*/
+    ecan1MsgBuffer[4][0] = 0x031 << 2;
+    ecan1MsgBuffer[4][2] = 8;
+    ecan1MsgBuffer[4][3] = 0x2211;
+    ecan1MsgBuffer[4][4] = 0x4433;
+    ecan1MsgBuffer[4][5] = 0x6655;
+    ecan1MsgBuffer[4][6] = 0x8877;
+    C1FIFObits.FNRB = 4;
+    C1RXFUL1 = 1 << 4;
+    CAN1CheckReceiveBuffer();
+    CHECK(strcmp(HostReceived(), "") == 0);
+
+    HostSend("O\r");
+    HostReceived();
+    C1RXFUL1 = 1 << 4;
+    CAN1CheckReceiveBuffer();
+    CHECK(strcmp(HostReceived(), "t03181122334455667788\r") == 0);
+    CHECK((C1RXFUL1 & (1 << 4)) == 0);
+
+    /*Timestamps*/
+    HostSend("Z1\r");
+    HostReceived();
+    SLCANTimestamp = 0x1234;
+    SLCANForwardFrame(ecan1MsgBuffer[4]);
+    CHECK(strcmp(HostReceived(), "t031811223344556677881234\r") == 0);
+    SLCANTimestamp = 59999;
+    _T1Interrupt();
+    CHECK(SLCANTimestamp == 0);
+
+    /*Remote request*/
+    HostSend("Z0\r");
+    HostReceived();
+    ecan1MsgBuffer[5][0] = (0x022 << 2) | 0x0002;
+    ecan1MsgBuffer[5][2] = 2;
+    SLCANForwardFrame(ecan1MsgBuffer[5]);
+    CHECK(strcmp(HostReceived(), "r0222\r") == 0);
+}
+
+static void TestUartOverflow(void)
+{
+    char block[UART1_TX_BUFFER_SIZE];
+    Reset();
+    memset(block, 'x', sizeof(block));
+    /*A frame that does not fit is dropped whole*/
+    CHECK(UART1WriteStr(block, UART1_TX_BUFFER_SIZE - 1) == UART1_TX_BUFFER_SIZE - 1);
+    CHECK(UART1WriteStr(block, 1) == 0);
+    CHECK(UART1TxOverflowCount == 1);
+    CHECK(strlen(HostReceived()) == UART1_TX_BUFFER_SIZE - 1);
+    CHECK(IEC0bits.U1TXIE == 0);
+
+    HostSend("F\r");
+    CHECK(strcmp(HostReceived(), "F0A\r") == 0);   //and the CAN overflow above
+    HostSend("F\r");
+    CHECK(strcmp(HostReceived(), "F00\r") == 0);
+}
+
+static void TestUartReceive(void)
+{
+    char block[UART1_RX_BUFFER_SIZE + 8];
+    unsigned int overruns;
+    Reset();
+    overruns = UART1RxOverrunCount;
+
+    /*The main loop was busy for longer than the ring holds*/
+    memset(block, 'x', sizeof(block));
+    hal_uart_inject(1, block, sizeof(block));
+    _U1RXInterrupt();
+    CHECK(UART1RxOverrunCount - overruns == sizeof(block) - (UART1_RX_BUFFER_SIZE - 1));
+    UART1CheckReceiveBuffer();
+    HostSend("\r");
+    CHECK(strcmp(HostReceived(), "\a") == 0);   //the line overflowed
+
+    /*A hardware FIFO overrun is cleared so reception carries on*/
+    overruns = UART1RxOverrunCount;
+    U1STAbits.OERR = 1;
+    HostSend("V\r");
+    CHECK(!U1STAbits.OERR);
+    CHECK(UART1RxOverrunCount - overruns == 1);
+    CHECK(strcmp(HostReceived(), "V1016\r") == 0);
+}
+
+int main(void)
+{
+    TestOpenClose();
+    TestTransmit();
+    TestTransmitQueue();
+    TestForward();
+    TestUartOverflow();
+    TestUartReceive();
+    return CHECK_RESULT();
+}
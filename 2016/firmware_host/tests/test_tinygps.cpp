@@ -0,0 +1,226 @@
+/*
+ * File:   test_tinygps.cpp
+ * Author: Kevin
+ *
+ * Description: 2014 IMU-GPS TinyGPS++ library: the buffer encode against
+ *              the character one, split anywhere, sentence type and custom
+ *              field lookup through the hash tables, and the degrees * 10^7
+ *              coordinates.
+ */
+
+#include "check.h"
+#include <TinyGPS++.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/*Appends "$body*CS\r\n" to out*/
+static void Sentence(char* out, const char* body)
+{
+    unsigned char cs = 0;
+    const char* p;
+    for (p = body; *p; p++)
+        cs ^= (unsigned char) *p;
+    sprintf(out + strlen(out), "$%s*%02X\r\n", body, cs);
+}
+
+static const char* const RMC = "GPRMC,123519.50,A,4807.038123,N,01131.000456,E,022.4,084.4,230394,003.1,W";
+static const char* const GGA = "GPGGA,123520.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,";
+static const char* const GSA = "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1";
+
+static void TestHash(void)
+{
+    /*The sentence type table in TinyGPS++.cpp has these written in*/
+    CHECK(TinyGPSPlus::hashSentenceName("GPRMC") == 0x113e);
+    CHECK(TinyGPSPlus::hashSentenceName("GPGGA") == 0xe1ab);
+    CHECK(TinyGPSPlus::hashSentenceName("GNRMC") == 0xf87c);
+    CHECK(TinyGPSPlus::hashSentenceName("GNGGA") == 0xc8e9);
+}
+
+static void TestFields(void)
+{
+    TinyGPSPlus gps;
+    char log[512] = "";
+
+    Sentence(log, RMC);
+    Sentence(log, GGA);
+    CHECK(gps.encode(log, strlen(log)) == 2);
+    CHECK(gps.passedChecksum() == 2);
+    CHECK(gps.failedChecksum() == 0);
+    CHECK(gps.charsProcessed() == strlen(log));
+    CHECK(gps.sentencesWithFix() == 2);
+
+    /*GGA came last*/
+    CHECK(gps.location.isValid());
+    CHECK(gps.location.latE7() == 481173000);
+    CHECK(gps.location.lngE7() == 115166667);
+    CHECK_NEAR(gps.location.lat(), 48.1173, 1e-9);
+    CHECK(gps.time.value() == 12352000);
+    CHECK(gps.date.value() == 230394);
+    CHECK(gps.speed.value() == 2240);
+    CHECK(gps.course.value() == 8440);
+    CHECK(gps.satellites.value() == 8);
+    CHECK(gps.hdop.value() == 90);
+    CHECK(gps.altitude.value() == 54540);
+
+    /*Every digit of the RMC fix, south and west negative*/
+    log[0] = 0;
+    Sentence(log, "GPRMC,000000,A,8959.999999,S,17959.999999,W,0,0,010100,,");
+    gps.encode(log, strlen(log));
+    CHECK(gps.location.latE7() == -900000000);
+    CHECK(gps.location.lngE7() == -1800000000);
+    CHECK(gps.location.rawLat().negative);
+
+    /*No fix: time and date still, position kept*/
+    log[0] = 0;
+    Sentence(log, "GPRMC,000001,V,4807.0,N,01131.0,E,,,010100,,");
+    CHECK(gps.encode(log, strlen(log)) == 1);
+    CHECK(gps.time.value() == 100);
+    CHECK(gps.location.latE7() == -900000000);
+
+    /*GN talker from a multi-constellation receiver*/
+    log[0] = 0;
+    Sentence(log, "GNGGA,000002,0100.000,N,00200.000,W,1,12,0.6,1.0,M,,M,,");
+    gps.encode(log, strlen(log));
+    CHECK(gps.location.latE7() == 10000000);
+    CHECK(gps.location.lngE7() == -20000000);
+    CHECK(gps.satellites.value() == 12);
+}
+
+static void TestBadSentences(void)
+{
+    TinyGPSPlus gps;
+    char log[512] = "";
+    char* star;
+
+    Sentence(log, RMC);
+    star = strrchr(log, '*');
+    star[1] = star[1] == '0' ? '1' : '0';
+    CHECK(gps.encode(log, strlen(log)) == 0);
+    CHECK(gps.failedChecksum() == 1);
+    CHECK(!gps.location.isValid());
+
+    /*Cut off by the next sentence*/
+    log[0] = 0;
+    Sentence(log, GGA);
+    log[20] = 0;
+    Sentence(log, RMC);
+    CHECK(gps.encode(log, strlen(log)) == 1);
+    CHECK(gps.location.latE7() == 481173021);
+    CHECK(gps.time.value() == 12351950);
+
+    /*A longer name that starts with a known one matches nothing*/
+    {
+        TinyGPSPlus gps2;
+        TinyGPSCustom mode(gps2, "GPGSA", 2);
+        log[0] = 0;
+        Sentence(log, GSA);
+        Sentence(log, "GPGSAXXXXXXXXXXXXXXXXXXXX,B,9");
+        gps2.encode(log, strlen(log));
+        CHECK(strcmp(mode.value(), "3") == 0);
+        CHECK(!mode.isUpdated());
+    }
+}
+
+static void TestCustom(void)
+{
+    TinyGPSPlus gps;
+    /*Out of order, two of one term, and other sentences in the same
+     *buckets: 8 buckets and 12 sentence names*/
+    TinyGPSCustom vdop(gps, "GPGSA", 17);
+    TinyGPSCustom pdop(gps, "GPGSA", 15);
+    TinyGPSCustom hdop(gps, "GPGSA", 16);
+    TinyGPSCustom hdop2(gps, "GPGSA", 16);
+    TinyGPSCustom rmcMode(gps, "GPRMC", 2);
+    TinyGPSCustom ggaSats(gps, "GPGGA", 7);
+    TinyGPSCustom others[8];
+    char names[8][6];
+    char log[512] = "";
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        sprintf(names[i], "PX%03d", i);
+        others[i].begin(gps, names[i], 1);
+    }
+
+    Sentence(log, GSA);
+    Sentence(log, RMC);
+    Sentence(log, GGA);
+    Sentence(log, "PX003,three");
+    CHECK(gps.encode(log, strlen(log)) == 4);
+
+    CHECK(strcmp(pdop.value(), "2.5") == 0);
+    CHECK(strcmp(hdop.value(), "1.3") == 0);
+    CHECK(strcmp(hdop2.value(), "1.3") == 0);
+    CHECK(strcmp(vdop.value(), "2.1") == 0);
+    CHECK(strcmp(rmcMode.value(), "A") == 0);
+    CHECK(strcmp(ggaSats.value(), "08") == 0);
+    for (i = 0; i < 8; i++)
+    {
+        CHECK(others[i].isValid() == (i == 3));
+    }
+    CHECK(strcmp(others[3].value(), "three") == 0);
+
+    /*Names are compared as strings, not as pointers*/
+    {
+        char copy[] = "GPGSA";
+        TinyGPSCustom auto3(gps, copy, 3);
+        log[0] = 0;
+        Sentence(log, GSA);
+        gps.encode(log, strlen(log));
+        CHECK(strcmp(auto3.value(), "04") == 0);
+        CHECK(strcmp(vdop.value(), "2.1") == 0);
+    }
+}
+
+/*Every split of a stream into two buffers, and one character at a time,
+ *must leave the same state*/
+static void TestSplits(void)
+{
+    char log[1024] = "";
+    size_t len, split;
+    int differ = 0;
+
+    Sentence(log, RMC);
+    strcat(log, "garbage,*,\r\n$$");
+    Sentence(log, GSA);
+    Sentence(log, GGA);
+    Sentence(log, "GPVTG,054.7,T,034.4,M,005.5,N,010.2,K");
+    len = strlen(log);
+
+    for (split = 0; split <= len; split++)
+    {
+        TinyGPSPlus bulk, single;
+        TinyGPSCustom bulkPdop(bulk, "GPGSA", 15), singlePdop(single, "GPGSA", 15);
+        size_t sentences = 0, i;
+
+        sentences += bulk.encode(log, split);
+        sentences += bulk.encode(log + split, len - split);
+        for (i = 0; i < len; i++)
+        {
+            single.encode(log[i]);
+        }
+
+        differ += sentences != 4;
+        differ += bulk.passedChecksum() != single.passedChecksum();
+        differ += bulk.failedChecksum() != single.failedChecksum();
+        differ += bulk.charsProcessed() != single.charsProcessed();
+        differ += bulk.location.latE7() != single.location.latE7();
+        differ += bulk.location.lngE7() != single.location.lngE7();
+        differ += bulk.time.value() != single.time.value();
+        differ += bulk.speed.value() != single.speed.value();
+        differ += strcmp(bulkPdop.value(), singlePdop.value()) != 0;
+    }
+    CHECK(differ == 0);
+}
+
+int main(void)
+{
+    TestHash();
+    TestFields();
+    TestBadSentences();
+    TestCustom();
+    TestSplits();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,351 @@
+/*
+ * File:   test_ubx.c
+ * Author: Michael Buchel
+ *
+ * Description: WEbots_CAR_IMU&GPS.X UBX decoder and receiver configuration
+ *              on the host, through the same UART1 queue, RX ISR and
+ *              NMEAProcess as the NMEA sentences. The configuration is
+ *              answered by a simulated receiver run from __delay_ms.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "check.h"
+#include "UBX.h"
+
+static const char rmc[] = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+
+static void Receive(const unsigned char* data, unsigned int length)
+{
+    hal_uart_inject(1, (const char*) data, length);
+    _U1RXInterrupt();
+}
+
+/*Whole frame with the checksum, returns its length*/
+static unsigned int Frame(unsigned char* frame, unsigned char msgClass, unsigned char msgId,
+    const void* payload, unsigned int length)
+{
+    unsigned char a = 0, b = 0;
+    unsigned int i;
+
+    frame[0] = 0xB5;
+    frame[1] = 0x62;
+    frame[2] = msgClass;
+    frame[3] = msgId;
+    frame[4] = (unsigned char) length;
+    frame[5] = (unsigned char) (length >> 8);
+    memcpy(&frame[6], payload, length);
+    for (i = 2; i < length + 6; i++)
+    {
+        a += frame[i];
+        b += a;
+    }
+    frame[length + 6] = a;
+    frame[length + 7] = b;
+    return length + 8;
+}
+
+static unsigned char Send(unsigned char msgClass, unsigned char msgId, const void* payload, unsigned int length)
+{
+    unsigned char frame[300];
+    Receive(frame, Frame(frame, msgClass, msgId, payload, length));
+    return NMEAProcess();
+}
+
+/*3D fix, 48 07.038'N 11 31.000'E like the NMEA tests*/
+static UBXNavPvt Pvt(void)
+{
+    UBXNavPvt pvt;
+    memset(&pvt, 0, sizeof(pvt));
+    pvt.iTOW = 218137000UL;
+    pvt.year = 2016;
+    pvt.month = 7;
+    pvt.day = 23;
+    pvt.hour = 12;
+    pvt.min = 35;
+    pvt.sec = 19;
+    pvt.valid = 0x07;
+    pvt.nano = 250000000L;
+    pvt.fixType = 3;
+    pvt.flags = UBX_PVT_GNSS_FIX_OK;
+    pvt.numSV = 11;
+    pvt.lon = 115166667L;
+    pvt.lat = 481173000L;
+    pvt.height = 592300L;
+    pvt.hMSL = 545400L;
+    pvt.gSpeed = 11524L;
+    pvt.headMot = 8440000L;
+    pvt.pDOP = 135;
+    return pvt;
+}
+
+static void Reset(void)
+{
+    hal_reset();
+    NMEA_init(115200);
+}
+
+static void TestPvt(void)
+{
+    UBXNavPvt pvt = Pvt();
+    UBXNavPvt last;
+    NMEAFix fix;
+
+    Reset();
+    CHECK(sizeof(UBXNavPvt) == 92);
+    CHECK(Send(UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt)) == NMEA_PVT);
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == NMEA_PVT);
+    CHECK(fix.valid && fix.quality == 1);
+    CHECK(fix.latitude == 481173000L && fix.longitude == 115166667L);
+    CHECK(fix.altitude == 545400L);
+    CHECK(fix.time == (12 * 3600L + 35 * 60 + 19) * 1000 + 250);
+    CHECK(fix.speed == 11524);
+    CHECK(fix.course == 8440);
+    CHECK(fix.hdop == 135 && fix.satellites == 11);
+    CHECK(fix.day == 23 && fix.month == 7 && fix.year == 16);
+    CHECK(UBXPvtCount == 1 && UBXChecksumErrorCount == 0);
+    UBXGetPvt(&last);
+    CHECK(last.height == 592300L && last.iTOW == 218137000UL);
+
+    /*Southern and western, negative nano back into the previous second*/
+    pvt.lat = -429853908L;
+    pvt.lon = -812664608L;
+    pvt.sec = 0;
+    pvt.nano = -1000000L;
+    pvt.headMot = 35999600L;
+    pvt.flags = UBX_PVT_GNSS_FIX_OK | UBX_PVT_DIFF_SOLN;
+    Send(UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt));
+    NMEAGetFix(&fix);
+    CHECK(fix.latitude == -429853908L && fix.longitude == -812664608L);
+    CHECK(fix.time == (12 * 3600L + 34 * 60 + 59) * 1000 + 999);
+    CHECK(fix.course == 0);
+    CHECK(fix.quality == 2);
+
+    /*No fix, or only time*/
+    pvt.flags = 0;
+    Send(UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt));
+    NMEAGetFix(&fix);
+    CHECK(!fix.valid && fix.quality == 0);
+    pvt.flags = UBX_PVT_GNSS_FIX_OK;
+    pvt.fixType = 5;
+    Send(UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt));
+    NMEAGetFix(&fix);
+    CHECK(!fix.valid);
+}
+
+static void TestRejects(void)
+{
+    UBXNavPvt pvt = Pvt();
+    unsigned char frame[120];
+    unsigned char other[40];
+    unsigned int length;
+    NMEAFix fix;
+
+    Reset();
+    length = Frame(frame, UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt));
+
+    /*One bit off in the payload, then either checksum byte*/
+    frame[30] ^= 0x01;
+    Receive(frame, length);
+    CHECK(NMEAProcess() == 0);
+    frame[30] ^= 0x01;
+    frame[length - 1] ^= 0x01;
+    Receive(frame, length);
+    CHECK(NMEAProcess() == 0);
+    frame[length - 1] ^= 0x01;
+    frame[length - 2] ^= 0x01;
+    Receive(frame, length);
+    CHECK(NMEAProcess() == 0);
+    frame[length - 2] ^= 0x01;
+    CHECK(UBXChecksumErrorCount == 3);
+    NMEAGetFix(&fix);
+    CHECK(fix.updated == 0 && fix.latitude == 0);
+
+    /*Cut short, garbage and a false sync before a good frame*/
+    Receive(frame, 40);
+    Receive((const unsigned char*) "\xB5\x62\x01\x07\xFF\xFF", 6);
+    Receive((const unsigned char*) "\x00\xB5\x11\xB5", 4);
+    Receive(frame, length);
+    NMEAProcess();
+    Receive(frame, length);
+    CHECK(NMEAProcess() == NMEA_PVT);
+    NMEAGetFix(&fix);
+    CHECK(fix.latitude == 481173000L);
+
+    /*Other messages, longer than anything kept, are checked and skipped*/
+    memset(other, 0x24, sizeof(other));
+    CHECK(Send(0x01, 0x35, other, sizeof(other)) == 0);
+    CHECK(Send(0x0A, 0x04, other, 0) == 0);
+    CHECK(Send(UBX_CLASS_NAV, UBX_NAV_PVT, other, 28) == 0);
+    {
+        static unsigned char big[UBX_MAX_PAYLOAD * 2];
+        CHECK(Send(0x0D, 0x01, big, sizeof(big)) == 0);
+    }
+    CHECK(Send(UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt)) == NMEA_PVT);
+    CHECK(NMEAChecksumErrorCount == 0 && NMEASentenceCount == 0);
+}
+
+static void TestAck(void)
+{
+    unsigned char acked[2] = {UBX_CLASS_CFG, UBX_CFG_RATE};
+
+    Reset();
+    Send(UBX_CLASS_ACK, UBX_ACK_ACK, acked, 2);
+    Send(UBX_CLASS_ACK, UBX_ACK_ACK, acked, 2);
+    Send(UBX_CLASS_ACK, UBX_ACK_NAK, acked, 2);
+    CHECK(UBXAckCount == 2 && UBXNakCount == 1);
+}
+
+static void TestMixed(void)
+{
+    UBXNavPvt pvt = Pvt();
+    unsigned char frame[120];
+    unsigned int length;
+    unsigned char done = 0;
+    unsigned int i;
+
+    /*NMEA still coming while the receiver switches over, one byte at a time*/
+    Reset();
+    pvt.lat = 0x24242424L; //$ inside the frame
+    length = Frame(frame, UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt));
+    Receive((const unsigned char*) rmc, sizeof(rmc) - 1);
+    for (i = 0; i < length; i++)
+    {
+        Receive(&frame[i], 1);
+        done |= NMEAProcess();
+    }
+    Receive((const unsigned char*) rmc, sizeof(rmc) - 1);
+    done |= NMEAProcess();
+    CHECK(done == (NMEA_RMC | NMEA_PVT));
+    CHECK(NMEASentenceCount == 2 && NMEAChecksumErrorCount == 0);
+    CHECK(UBXPvtCount == 1);
+}
+
+static void TestRate(void)
+{
+    UBXNavPvt pvt = Pvt();
+    NMEAFix fix;
+    unsigned int epoch;
+    unsigned int positions = 0;
+
+    /*10s of NAV-PVT at 25Hz, the main loop parsing every 50ms*/
+    Reset();
+    for (epoch = 0; epoch < 250; epoch++)
+    {
+        unsigned char frame[120];
+        pvt.sec = (unsigned char) (epoch / 25);
+        pvt.nano = (long) (epoch % 25) * 40000000L;
+        pvt.lat = 481173000L + epoch;
+        Receive(frame, Frame(frame, UBX_CLASS_NAV, UBX_NAV_PVT, &pvt, sizeof(pvt)));
+        if (epoch % 2 == 0)
+            continue;
+        NMEAProcess();
+        NMEAGetFix(&fix);
+        if (fix.updated == NMEA_PVT && fix.latitude == 481173000L + (long) epoch
+                && fix.time == (12 * 3600L + 35 * 60) * 1000 + epoch * 40L)
+            positions++;
+    }
+    CHECK(positions == 125);
+    CHECK(UBXPvtCount == 250 && NMEAOverrunCount == 0);
+}
+
+/*The receiver end of UBXConfigure, run from its delays: keeps what was sent
+ *and answers each CFG message with an ACK, a NAK for nakId, or nothing*/
+static unsigned char sentLog[256];
+static unsigned int sentCount;
+static unsigned int answered;       /*sentLog bytes already looked at*/
+static int nakId;
+static int mute;
+static unsigned long waited;        /*ms*/
+
+static void Receiver(unsigned long ms)
+{
+    waited += ms;
+    sentCount += hal_uart_take(1, (char*) &sentLog[sentCount], sizeof(sentLog) - sentCount);
+    while (answered + 8 <= sentCount)
+    {
+        const unsigned char* f = &sentLog[answered];
+        unsigned int length = f[4] | (f[5] << 8);
+        unsigned char acked[2] = {f[2], f[3]};
+        unsigned char frame[16];
+
+        if (answered + length + 8 > sentCount)
+            break;
+        answered += length + 8;
+        /*CFG-PRT's answer goes out as the baud rate changes, and is lost*/
+        if (mute || f[3] == UBX_CFG_PRT)
+            continue;
+        Receive(frame, Frame(frame, UBX_CLASS_ACK, f[3] == nakId ? UBX_ACK_NAK : UBX_ACK_ACK, acked, 2));
+    }
+}
+
+static void ReceiverReset(void)
+{
+    hal_reset();
+    hal_set_delay_hook(Receiver);
+    sentCount = 0;
+    answered = 0;
+    nakId = -1;
+    mute = 0;
+    waited = 0;
+    NMEA_init(4800);
+}
+
+static void TestConfigure(void)
+{
+    static const unsigned char rate10[] = {0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0x64, 0x00, 0x01, 0x00, 0x01, 0x00, 0x7A, 0x12};
+    static const unsigned char msgPvt[] = {0xB5, 0x62, 0x06, 0x01, 0x03, 0x00, 0x01, 0x07, 0x01, 0x13, 0x51};
+    static const unsigned char prt[20] = {0x01, 0x00, 0x00, 0x00, 0xD0, 0x08, 0x00, 0x00,
+        0x00, 0xC2, 0x01, 0x00, 0x03, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00};
+    unsigned char expected[28];
+
+    /*Receive only until configured*/
+    ReceiverReset();
+    CHECK(!U1STAbits.UTXEN && RPOR1bits.RP67R == 0);
+    CHECK(U1BRG == 3124);
+    CHECK(UBXConfigure(115200, 10) == UBX_CONFIG_OK);
+    CHECK(U1STAbits.UTXEN && RPOR1bits.RP67R == 1);
+    CHECK(sentCount == 28 + sizeof(rate10) + sizeof(msgPvt));
+    CHECK(memcmp(sentLog, expected, Frame(expected, UBX_CLASS_CFG, UBX_CFG_PRT, prt, sizeof(prt))) == 0);
+    CHECK(memcmp(&sentLog[28], rate10, sizeof(rate10)) == 0);
+    CHECK(memcmp(&sentLog[28 + sizeof(rate10)], msgPvt, sizeof(msgPvt)) == 0);
+    CHECK(U1BRG == 129);
+    CHECK(UBXAckCount == 2 && UBXNakCount == 0);
+    /*The 100ms switch over, then an answer on the first 1ms wait each*/
+    CHECK(waited == 102);
+
+    /*25Hz, every 40ms*/
+    ReceiverReset();
+    CHECK(UBXConfigure(115200, 25) == UBX_CONFIG_OK);
+    CHECK(sentLog[28 + 6] == 40 && sentLog[28 + 7] == 0);
+
+    /*A rate the receiver can't do: NAV-PVT is still switched on*/
+    ReceiverReset();
+    nakId = UBX_CFG_RATE;
+    CHECK(UBXConfigure(115200, 25) == UBX_CONFIG_NAK);
+    CHECK(sentCount == 28 + sizeof(rate10) + sizeof(msgPvt));
+    CHECK(UBXAckCount == 1 && UBXNakCount == 1);
+    ReceiverReset();
+    nakId = UBX_CFG_MSG;
+    CHECK(UBXConfigure(115200, 10) == UBX_CONFIG_NAK);
+
+    /*Nothing back at the new rate: gives up after the timeout, sends no more*/
+    ReceiverReset();
+    mute = 1;
+    CHECK(UBXConfigure(115200, 10) == UBX_CONFIG_NO_ACK);
+    CHECK(sentCount == 28 + sizeof(rate10));
+    CHECK(waited == 100 + UBX_ACK_TIMEOUT_MS);
+}
+
+int main(void)
+{
+    TestPvt();
+    TestRejects();
+    TestAck();
+    TestMixed();
+    TestRate();
+    TestConfigure();
+    return CHECK_RESULT();
+}
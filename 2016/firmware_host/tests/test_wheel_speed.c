@@ -0,0 +1,189 @@
+/*
+ * File:   test_wheel_speed.c
+ * Author: Jacob
+ *
+ * Description: motorboard.X wheel speed estimation on the host.
+ */
+
+#include "check.h"
+#include "motorboard_sim.h"
+
+#define PUBLISH_TICKS (WHEEL_TIMER_HZ / WHEEL_PUBLISH_HZ)
+
+/*Run one wheel at a steady speed for a number of publish periods*/
+static void RunSteady(unsigned int wheel, unsigned long speed, unsigned int windows)
+{
+    unsigned long period = SimPeriod(speed);
+    unsigned long nextEdge = simTicks + period;
+    unsigned long nextPublish = simTicks + PUBLISH_TICKS;
+    unsigned long end = simTicks + windows * PUBLISH_TICKS;
+
+    while (simTicks < end)
+    {
+        if (nextEdge <= nextPublish)
+        {
+            SimAdvance(nextEdge - simTicks);
+            SimEdge(wheel);
+            nextEdge += period;
+        }
+        else
+        {
+            SimAdvance(nextPublish - simTicks);
+            _T3Interrupt();
+            nextPublish += PUBLISH_TICKS;
+        }
+    }
+}
+
+static void TestCountRegime(void)
+{
+    /*~8 edges per window, averaged over the window*/
+    SimReset();
+    RunSteady(WHEEL_FL, 2000, 20);
+    CHECK_NEAR(WheelSpeed[WHEEL_FL], 2000, 20);
+    CHECK(WheelSpeed[WHEEL_FR] == 0);
+}
+
+static void TestMedianRegime(void)
+{
+    /*Under one edge per window, median of the periods*/
+    SimReset();
+    RunSteady(WHEEL_BR, 150, 60);
+    CHECK_NEAR(WheelSpeed[WHEEL_BR], 150, 3);
+}
+
+static void TestMedianRejectsGlitch(void)
+{
+    unsigned long period = SimPeriod(150);
+    int i;
+    SimReset();
+    for (i = 0; i < 6; i++)
+    {
+        SimAdvance(period);
+        SimEdge(WHEEL_BL);
+        _T3Interrupt();
+    }
+    /*A noise edge in the middle of a period*/
+    SimAdvance(period / 3);
+    SimEdge(WHEEL_BL);
+    SimAdvance(period - period / 3);
+    SimEdge(WHEEL_BL);
+    _T3Interrupt();
+    CHECK_NEAR(WheelSpeed[WHEEL_BL], 150, 3);
+}
+
+static void TestTimerWrap(void)
+{
+    /*Each period spans several Timer 2 overflows*/
+    SimReset();
+    SimAdvance(0xFFF0);
+    RunSteady(WHEEL_FR, 60, 100);
+    CHECK(SimPeriod(60) > 0x10000);
+    CHECK_NEAR(WheelSpeed[WHEEL_FR], 60, 2);
+}
+
+static void TestPendingOverflow(void)
+{
+    unsigned long period = SimPeriod(1000);
+    SimReset();
+    SimAdvance(0x2FFF8);
+    CHECK(WheelTimeNow() == 0x2FFF8);
+
+    /*Timer 2 wraps with its interrupt held off, and the capture ISR for an
+     *edge just before the wrap only runs after it*/
+    simTicks = 0x30004;
+    TMR2 = 0x0004;
+    IFS0bits.T2IF = 1;
+    CHECK(WheelTimeNow() == 0x30004);
+    IC1BUF = 0xFFF8;
+    _IC1Interrupt();
+
+    _T2Interrupt();
+    CHECK(WheelTimeNow() == 0x30004);
+    SimAdvance(0x2FFF8 + period - simTicks);
+    SimEdge(WHEEL_FL);
+    _T3Interrupt();
+    CHECK_NEAR(WheelSpeed[WHEEL_FL], 1000, 2);
+}
+
+static void TestDecayAndStop(void)
+{
+    unsigned long period = SimPeriod(1000);
+    SimReset();
+    RunSteady(WHEEL_FL, 1000, 10);
+    CHECK_NEAR(WheelSpeed[WHEEL_FL], 1000, 10);
+
+    /*No more edges: the estimate can't stay above what the gap allows*/
+    SimAdvance(period * 4);
+    _T3Interrupt();
+    CHECK(WheelSpeed[WHEEL_FL] <= 250 + 1);
+    CHECK(WheelSpeed[WHEEL_FL] > 0);
+
+    /*Past the timeout it reads stopped*/
+    SimAdvance(WHEEL_STOP_TICKS);
+    _T3Interrupt();
+    CHECK(WheelSpeed[WHEEL_FL] == 0);
+
+    /*The first edge after a stop only restarts the timing*/
+    SimEdge(WHEEL_FL);
+    _T3Interrupt();
+    CHECK(WheelSpeed[WHEEL_FL] == 0);
+}
+
+static void TestRestart(void)
+{
+    unsigned long period = SimPeriod(150);
+    int i;
+
+    /*Stopped from speed, then off again slowly: the median mustn't pick up
+     *periods from before the stop*/
+    SimReset();
+    RunSteady(WHEEL_FR, 2000, 20);
+    CHECK_NEAR(WheelSpeed[WHEEL_FR], 2000, 20);
+    SimAdvance(WHEEL_STOP_TICKS + 1);
+    _T3Interrupt();
+    CHECK(WheelSpeed[WHEEL_FR] == 0);
+
+    for (i = 0; i < 3; i++)
+    {
+        SimEdge(WHEEL_FR);
+        SimAdvance(period);
+    }
+    SimEdge(WHEEL_FR);
+    _T3Interrupt();
+    CHECK_NEAR(WheelSpeed[WHEEL_FR], 150, 3);
+}
+
+static void TestFrameLayout(void)
+{
+    unsigned int frame[4];
+    SimReset();
+    CHECK(!WheelSpeedReady());
+    _T3Interrupt();
+    CHECK(WheelSpeedReady());
+    CHECK(!WheelSpeedReady());
+
+    WheelSpeed[WHEEL_FL] = 1;
+    WheelSpeed[WHEEL_FR] = 2;
+    WheelSpeed[WHEEL_BL] = 3;
+    WheelSpeed[WHEEL_BR] = -4;
+    WheelSpeedGetFrame(frame);
+    CHECK(frame[0] == 2);
+    CHECK(frame[1] == 1);
+    CHECK((frame[2] & 0xFFFF) == 0xFFFC);
+    CHECK(frame[3] == 3);
+    CHECK(IEC0bits.T3IE == 1);
+}
+
+int main(void)
+{
+    TestCountRegime();
+    TestMedianRegime();
+    TestMedianRejectsGlitch();
+    TestTimerWrap();
+    TestPendingOverflow();
+    TestDecayAndStop();
+    TestRestart();
+    TestFrameLayout();
+    return CHECK_RESULT();
+}
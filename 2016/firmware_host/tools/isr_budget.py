@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+Worst case cycle estimate for each ISR in a dsPIC33E build.
+
+Reads the disassembly of the production ELF (xc16-objdump -d), walks every
+_*Interrupt function and the functions it calls, and adds up instruction
+cycles along the longest path. Loops are counted once unless a bound is
+given in the budget file, so treat a function flagged with loops as a
+lower bound until it has one. The result is checked against a budget file:
+
+    # isr            rate_hz   max_cycles
+    _T3Interrupt     50        4000
+    loop WheelMedian 5         # loop bodies in this function run 5 times
+
+Names are as in the C source. A rate of 0 marks an event driven ISR,
+listed without a load figure. Plain functions can be listed the same way
+to compare implementations; their count includes the interrupt latency.
+Exits non-zero if any ISR is over its budget, so it can gate a flash.
+
+usage: xc16-objdump -d dist/default/production/*.elf | isr_budget.py budget
+"""
+
+import argparse
+import re
+import sys
+
+# dsPIC33E cycle counts (DS70000157): one cycle unless listed. Branches and
+# skips are counted taken, as the worst case.
+CYCLES = {
+    'bra': 4, 'goto': 4, 'call': 4, 'rcall': 4, 'call.l': 4,
+    'return': 6, 'retfie': 6, 'retlw': 6,
+    'btsc': 3, 'btss': 3, 'cpseq': 3, 'cpsne': 3, 'cpsgt': 3, 'cpslt': 3,
+    'cpbeq': 5, 'cpbne': 5, 'cpbgt': 5, 'cpblt': 5,
+    'tblrdl': 5, 'tblrdh': 5, 'tblwtl': 2, 'tblwth': 2,
+    'pop.s': 1, 'push.s': 1, 'lnk': 1, 'ulnk': 1,
+    'do': 2, 'repeat': 1,
+}
+INTERRUPT_LATENCY = 9   # entry, fixed on the dsPIC33E
+
+HEADER = re.compile(r'^([0-9a-f]+) <([^>]+)>:\s*$')
+INSN = re.compile(r'^\s*([0-9a-f]+):\s+(?:[0-9a-f]{2}\s)+\s*([a-z][\w.]*)\s*(.*)$')
+TARGET = re.compile(r'0x([0-9a-f]+)(?:\s*<([^>+]+)(?:\+0x([0-9a-f]+))?>)?')
+REPEAT = re.compile(r'#(0x[0-9a-f]+|\d+)')
+
+
+class Function:
+    def __init__(self, name, address):
+        self.name = name
+        self.address = address
+        self.insns = []         # (address, mnemonic, operands)
+        self.has_loop = False
+
+
+def parse(lines):
+    functions = {}
+    current = None
+    for line in lines:
+        m = HEADER.match(line)
+        if m:
+            current = Function(m.group(2), int(m.group(1), 16))
+            functions[current.name] = current
+            continue
+        m = INSN.match(line)
+        if m and current:
+            current.insns.append((int(m.group(1), 16), m.group(2), m.group(3)))
+    return functions
+
+
+def branch_target(operands):
+    m = TARGET.search(operands)
+    if not m:
+        return None, None
+    return int(m.group(1), 16), m.group(2)
+
+
+def is_branch(mnemonic):
+    return mnemonic == 'bra' or mnemonic.startswith('bra') or mnemonic == 'goto'
+
+
+def function_cycles(name, functions, bounds, cache, stack, notes):
+    """Longest path through a function, callees included"""
+    if name in cache:
+        return cache[name]
+    fn = functions.get(name)
+    if fn is None:
+        notes.add('%s: not in the listing, counted as 0' % name)
+        return 0
+    if name in stack:
+        notes.add('%s: recursive, counted once' % name)
+        return 0
+    stack.add(name)
+
+    insns = fn.insns
+    index = {addr: i for i, (addr, _, _) in enumerate(insns)}
+    n = len(insns)
+    # cost[i]: cycles from instruction i to the end of the function
+    cost = [0] * (n + 1)
+    loop_bound = bounds.get(name, 1)
+    repeat_count = [1] * n
+    for i, (addr, mnem, ops) in enumerate(insns):
+        if mnem == 'repeat' and i + 1 < n:
+            m = REPEAT.search(ops)
+            repeat_count[i + 1] = int(m.group(1), 0) + 1 if m else 1
+
+    # own[i]: cycles of instruction i by itself, repeats and callees included
+    own = [0] * n
+    for i, (addr, mnem, ops) in enumerate(insns):
+        own[i] = CYCLES.get(mnem, 1) * repeat_count[i]
+        if mnem in ('call', 'rcall', 'call.l'):
+            _, callee = branch_target(ops)
+            if callee:
+                own[i] += function_cycles(callee, functions, bounds, cache, stack, notes)
+            else:
+                notes.add('%s: indirect call at 0x%x not followed' % (name, addr))
+
+    # Walk backwards so forward branches are already costed; a backward
+    # branch is a loop, its body is counted loop_bound times
+    for i in range(n - 1, -1, -1):
+        addr, mnem, ops = insns[i]
+        rest = cost[i + 1] if i + 1 < n else 0
+        if mnem in ('call', 'rcall', 'call.l'):
+            cost[i] = own[i] + rest
+        elif mnem in ('return', 'retfie', 'retlw'):
+            cost[i] = own[i]
+        elif is_branch(mnem) or mnem.startswith('cpb'):
+            target, _ = branch_target(ops)
+            unconditional = mnem in ('bra', 'goto') and ',' not in ops
+            if target in index and index[target] > i:
+                taken = cost[index[target]]
+            elif target in index:
+                fn.has_loop = True
+                body = sum(own[index[target]:i + 1])
+                taken = body * (loop_bound - 1) + cost[i + 1] if loop_bound > 1 else 0
+            else:
+                taken = 0
+            cost[i] = own[i] + (taken if unconditional else max(taken, rest))
+        else:
+            cost[i] = own[i] + rest
+    if fn.has_loop and name not in bounds:
+        notes.add('%s: has loops with no bound, counted once' % name)
+
+    stack.discard(name)
+    cache[name] = cost[0] if n else 0
+    return cache[name]
+
+
+def read_budget(path):
+    budgets = []
+    bounds = {}
+    with open(path) as f:
+        for line in f:
+            line = line.split('#', 1)[0].split()
+            if not line:
+                continue
+            if line[0] == 'loop':
+                # One bound per function, a second one would silently win
+                if line[1] in bounds:
+                    sys.exit('%s: second loop bound for %s' % (path, line[1]))
+                bounds[line[1]] = int(line[2])
+                bounds['_' + line[1]] = int(line[2])
+            else:
+                budgets.append((line[0], float(line[1]), int(line[2])))
+    return budgets, bounds
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[1])
+    parser.add_argument('budget', help='budget file, see budgets/')
+    parser.add_argument('listing', nargs='?', help='objdump -d output, default stdin')
+    parser.add_argument('--fcy', type=float, default=3685000, help='instruction clock, Hz')
+    args = parser.parse_args()
+
+    budgets, bounds = read_budget(args.budget)
+    listing = open(args.listing) if args.listing else sys.stdin
+    functions = parse(listing)
+
+    cache = {}
+    notes = set()
+    over = 0
+    load = 0.0
+    print('%-24s %8s %8s %8s %7s' % ('ISR', 'cycles', 'budget', 'us', 'load'))
+    for name, rate, limit in budgets:
+        # XC16 adds a leading underscore to C names
+        if name not in functions and '_' + name in functions:
+            name = '_' + name
+        if name not in functions:
+            print('%-24s %8s %8d %8s %7s  not in the build' % (name, '-', limit, '-', '-'))
+            continue
+        cycles = INTERRUPT_LATENCY + function_cycles(name, functions, bounds, cache, set(), notes)
+        share = cycles * rate / args.fcy
+        load += share
+        status = 'OVER' if cycles > limit else ''
+        over += cycles > limit
+        print('%-24s %8d %8d %8.1f %6.2f%%  %s' % (name, cycles, limit,
+              cycles * 1e6 / args.fcy, 100 * share if rate else 0, status))
+    print('total periodic load %.2f%%' % (100 * load))
+    for note in sorted(notes):
+        print('note: ' + note)
+    return 1 if over else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
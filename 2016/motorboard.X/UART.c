@@ -100,6 +100,33 @@ void UART1WriteStrNT(char * data)
     }
 }
 
+/*Send a frame in the same slcan form as the CAN to USB tranciever, tIIILDD..\r,
+ *so the host reads this board's frames with the same tools*/
+void UART1WriteCANFrame(unsigned int SID, unsigned int length, unsigned int * data)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    char str[22];
+    unsigned int n = 0;
+    unsigned int i;
+    if (length > 8)
+    {
+        length = 8;
+    }
+    str[n++] = 't';
+    str[n++] = hexDigits[(SID >> 8) & 0x7];
+    str[n++] = hexDigits[(SID >> 4) & 0xF];
+    str[n++] = hexDigits[SID & 0xF];
+    str[n++] = hexDigits[length];
+    for (i = 0; i < length; i++)
+    {
+        unsigned int byte = (i & 1) ? data[i / 2] >> 8 : data[i / 2];
+        str[n++] = hexDigits[(byte >> 4) & 0xF];
+        str[n++] = hexDigits[byte & 0xF];
+    }
+    str[n++] = '\r';
+    UART1WriteStr(str, n);
+}
+
 void UART1EnableInterrupts()
 {
     IEC0bits.U1RXIE = 1;
@@ -272,6 +299,7 @@ void initWatchdog()
     IFS1bits.T4IF = 0; // Clear Timer 4 Interrupt Flag
     IPC6bits.T4IP = 0x04; // Set Timer 4 Interrupt Priority Level
     IEC1bits.T4IE = 1; // Enable Timer4 interrupt
+    T4CONbits.TON = 1;
 }
 
 void __attribute__((__interrupt__, no_auto_psv)) _T4Interrupt(void)
@@ -24,6 +24,7 @@ extern "C" {
     unsigned int UART1WriteReady();
     void UART1WriteStr(char * data, unsigned int length);
     void UART1WriteStrNT(char * data);
+    void UART1WriteCANFrame(unsigned int SID, unsigned int length, unsigned int * data);
     void UART1EnableInterrupts();
     void UART1DisableInterrupts();
     void UART2Init(unsigned int baud);
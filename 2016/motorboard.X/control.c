@@ -0,0 +1,167 @@
+/*
+ * File:   control.c
+ * Author: Jacob
+ *
+ * Description: Fixed rate speed and steering control, see control.h.
+ */
+
+#include "control.h"
+#include "PWM.h"
+#include "userVariables.h"
+
+volatile unsigned int ControlJitterMax = 0;
+volatile unsigned int ControlJitterCount = 0;
+volatile unsigned int ControlOverrunCount = 0;
+
+/*Targets, written with the Timer 1 interrupt masked*/
+static int targetSpeed = 0;                 //mm/s, negative is reverse
+static int targetServo = SERVO_CENTER_US;
+
+/*Loop state, only touched by the ISR*/
+static long speedIntegral = 0;              //Q8 us
+static int servoOut = SERVO_CENTER_US;
+static unsigned long lastEntry;
+static char firstEntry = 1;
+
+void control_init(void)
+{
+    targetSpeed = 0;
+    targetServo = SERVO_CENTER_US;
+    speedIntegral = 0;
+    servoOut = SERVO_CENTER_US;
+    firstEntry = 1;
+    PWM1SetDutyCycleUS(MOTOR_NEUTRAL_US);
+    PWM2SetDutyCycleUS(SERVO_CENTER_US);
+
+    //Timer 1: control rate, 1:8
+    T1CON = 0;
+    T1CONbits.TCKPS = 0b01;
+    TMR1 = 0;
+    PR1 = (unsigned int) (FCY / 8 / CONTROL_HZ - 1);
+    IPC0bits.T1IP = 3;      //below the captures, the wheel speed update and the watchdog
+    IFS0bits.T1IF = 0;
+    IEC0bits.T1IE = 1;
+    T1CONbits.TON = 1;
+}
+
+/*speed in mm/s, servoUS steering pulse width*/
+void ControlSetTarget(int speed, int servoUS)
+{
+    if (servoUS > SERVO_CENTER_US + SERVO_RANGE_US)
+        servoUS = SERVO_CENTER_US + SERVO_RANGE_US;
+    else if (servoUS < SERVO_CENTER_US - SERVO_RANGE_US)
+        servoUS = SERVO_CENTER_US - SERVO_RANGE_US;
+
+    IEC0bits.T1IE = 0;
+    targetSpeed = speed;
+    targetServo = servoUS;
+    IEC0bits.T1IE = 1;
+}
+
+/*Time the entry against the nominal period. Timer 1 itself never drifts,
+ *so any deviation is interrupt latency from higher priority ISRs*/
+static void ControlTiming(void)
+{
+    unsigned long now = WheelTimeNow();
+    unsigned long period = now - lastEntry;
+    unsigned int jitter;
+
+    lastEntry = now;
+    if (firstEntry)
+    {
+        firstEntry = 0;
+        return;
+    }
+    if (period > CONTROL_PERIOD_TICKS)
+        period -= CONTROL_PERIOD_TICKS;
+    else
+        period = CONTROL_PERIOD_TICKS - period;
+    jitter = period > 0xFFFF ? 0xFFFF : (unsigned int) period;
+
+    if (jitter > ControlJitterMax)
+        ControlJitterMax = jitter;
+    if (jitter > CONTROL_JITTER_LIMIT)
+        ControlJitterCount++;
+}
+
+/*PI on the mean wheel speed, returns the ESC offset from neutral in us*/
+static int ControlSpeed(int target)
+{
+    long measured;
+    long error;
+    long out;
+
+    if (target == 0)
+    {
+        speedIntegral = 0;
+        return 0;
+    }
+
+    /*The hall sensors don't give direction, assume the commanded one*/
+    measured = ((long) WheelSpeed[WHEEL_FL] + WheelSpeed[WHEEL_FR]
+            + WheelSpeed[WHEEL_BL] + WheelSpeed[WHEEL_BR]) / 4;
+    if (target < 0)
+        measured = -measured;
+    error = (long) target - measured;
+
+    out = (SPEED_KP * error + speedIntegral) >> 8;
+    if (out > MOTOR_RANGE_US)
+    {
+        out = MOTOR_RANGE_US;
+    }
+    else if (out < -MOTOR_RANGE_US)
+    {
+        out = -MOTOR_RANGE_US;
+    }
+
+    /*Anti-windup: stop integrating once the output is pinned in the
+     *direction the error is pushing it*/
+    if (!(out == MOTOR_RANGE_US && error > 0) && !(out == -MOTOR_RANGE_US && error < 0))
+    {
+        speedIntegral += SPEED_KI * error;
+        if (speedIntegral > SPEED_I_LIMIT)
+            speedIntegral = SPEED_I_LIMIT;
+        else if (speedIntegral < -SPEED_I_LIMIT)
+            speedIntegral = -SPEED_I_LIMIT;
+    }
+
+    /*Never drive against the commanded direction, let the car coast down*/
+    if ((target > 0 && out < 0) || (target < 0 && out > 0))
+        out = 0;
+    return (int) out;
+}
+
+/*Timer 1 ISR, the control loop*/
+void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void)
+{
+    int motorOut;
+
+    IFS0bits.T1IF = 0;
+    ControlTiming();
+
+    /*Hard overrides: remote e-stop (or its watchdog) and the collision flag*/
+    if ((EStopRemote & 0x1) || PORTDbits.RD8)
+    {
+        speedIntegral = 0;
+        motorOut = 0;
+    }
+    else
+    {
+        motorOut = ControlSpeed(targetSpeed);
+    }
+    motorDuty = MOTOR_NEUTRAL_US + motorOut;
+    PWM1SetDutyCycleUS(motorDuty);
+
+    if (servoOut < targetServo - SERVO_SLEW_US)
+        servoOut += SERVO_SLEW_US;
+    else if (servoOut > targetServo + SERVO_SLEW_US)
+        servoOut -= SERVO_SLEW_US;
+    else
+        servoOut = targetServo;
+    servoDuty = servoOut;
+    PWM2SetDutyCycleUS(servoDuty);
+
+    /*Took longer than a period*/
+    if (IFS0bits.T1IF)
+        ControlOverrunCount++;
+}
@@ -0,0 +1,55 @@
+/*
+ * File:   control.h
+ * Author: Jacob
+ *
+ * Description: Fixed rate speed and steering control. Timer 1 runs the loop
+ *              at CONTROL_HZ: a fixed-point PI on the measured wheel speed
+ *              drives the ESC, the steering servo follows its target at a
+ *              limited slew rate, and the remote e-stop and the collision
+ *              flag on RD8 force the ESC to neutral whatever the targets are.
+ */
+
+#ifndef CONTROL_H
+#define	CONTROL_H
+
+#include <p33Exxxx.h>
+#include "wheelSpeed.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define CONTROL_HZ              100
+#define CONTROL_PERIOD_TICKS    (WHEEL_TIMER_HZ / CONTROL_HZ)   //in Timer 2 ticks
+
+    /*Pulse widths in us*/
+#define MOTOR_NEUTRAL_US        1500
+#define MOTOR_RANGE_US          300     //max throttle either side of neutral
+#define SERVO_CENTER_US         1500
+#define SERVO_RANGE_US          500
+#define SERVO_SLEW_US           10      //per control period, 1000us/s
+
+    /*PI gains in us per mm/s, Q8*/
+#define SPEED_KP                32      //0.125
+#define SPEED_KI                4       //0.0156 per period
+#define SPEED_I_LIMIT           ((long) MOTOR_RANGE_US << 8)
+
+    /*Control ISR entries further than this from their nominal time are counted*/
+#define CONTROL_JITTER_LIMIT    (CONTROL_PERIOD_TICKS / 20)
+
+    /*Timing stats, in Timer 2 ticks*/
+    extern volatile unsigned int ControlJitterMax;
+    extern volatile unsigned int ControlJitterCount;
+    extern volatile unsigned int ControlOverrunCount;
+
+    void control_init(void);
+    void ControlSetTarget(int speed, int servoUS);
+
+    void __attribute__((__interrupt__, no_auto_psv)) _T1Interrupt(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CONTROL_H */
+
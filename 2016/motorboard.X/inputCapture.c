@@ -7,6 +7,7 @@
 
 #include "inputCapture.h"
 #include "userVariables.h"
+#include "wheelSpeed.h"
 
 //toggle variables used to blink led with pole changes 
 char FLtoggle = 0;
@@ -52,9 +53,9 @@ void inputCapture_init (void)
     
     //configure IC1 setup registers 
     IC1CON1bits.ICSIDL = 0;         //Input capture will continue to operate in CPU idle mode
-    IC1CON1bits.ICTSEL = 0b111;     //use peripheral clock as source
+    IC1CON1bits.ICTSEL = 0b001;     //use Timer 2 as source, see wheelSpeed.c
     IC1CON1bits.ICM = 0b001;       //capture mode every rising/falling edge, interrupt every time
-    IC1CON2bits.SYNCSEL = 0;        //No sync/trigger source
+    IC1CON2bits.SYNCSEL = 0b01100;  //Synchronize to Timer 2
     
     //setup IC1 interrupt
     IFS0bits.IC1IF = 0;     //clear IC1 interrupt status flag
@@ -68,9 +69,9 @@ void inputCapture_init (void)
     
     //configure IC2 setup registers 
     IC2CON1bits.ICSIDL = 0;         //Input capture will continue to operate in CPU idle mode
-    IC2CON1bits.ICTSEL = 0b111;     //use peripheral clock as source
+    IC2CON1bits.ICTSEL = 0b001;     //use Timer 2 as source, see wheelSpeed.c
     IC2CON1bits.ICM = 0b001;       //capture mode every rising/falling edge, interrupt every time
-    IC2CON2bits.SYNCSEL = 0;        //No sync/trigger source
+    IC2CON2bits.SYNCSEL = 0b01100;  //Synchronize to Timer 2
     
     //setup IC2 interrupt
     IFS0bits.IC2IF = 0;     //clear IC2 interrupt status flag
@@ -84,9 +85,9 @@ void inputCapture_init (void)
     
     //configure IC3 setup registers 
     IC3CON1bits.ICSIDL = 0;         //Input capture will continue to operate in CPU idle mode
-    IC3CON1bits.ICTSEL = 0b111;     //use peripheral clock as source
+    IC3CON1bits.ICTSEL = 0b001;     //use Timer 2 as source, see wheelSpeed.c
     IC3CON1bits.ICM = 0b001;       //capture mode every rising/falling edge, interrupt every time
-    IC3CON2bits.SYNCSEL = 0;        //No sync/trigger source
+    IC3CON2bits.SYNCSEL = 0b01100;  //Synchronize to Timer 2
     
     //setup IC3 interrupt
     IFS2bits.IC3IF = 0;     //clear IC3 interrupt status flag
@@ -100,9 +101,9 @@ void inputCapture_init (void)
     
     //configure IC4 setup registers 
     IC4CON1bits.ICSIDL = 0;         //Input capture will continue to operate in CPU idle mode
-    IC4CON1bits.ICTSEL = 0b111;     //use peripheral clock as source
+    IC4CON1bits.ICTSEL = 0b001;     //use Timer 2 as source, see wheelSpeed.c
     IC4CON1bits.ICM = 0b001;       //capture mode every rising/falling edge, interrupt every time
-    IC4CON2bits.SYNCSEL = 0;        //No sync/trigger source
+    IC4CON2bits.SYNCSEL = 0b01100;  //Synchronize to Timer 2
     
     //setup IC4 interrupt
     IFS2bits.IC4IF = 0;     //clear IC3 interrupt status flag
@@ -119,6 +120,7 @@ void __attribute__ ((__interrupt__, no_auto_psv)) _IC1Interrupt(void)
 {  
     FLcaptime = IC1BUF;
     IC1CON2bits.TRIGSTAT = 0;
+    WheelSpeedCapture(WHEEL_FL, (unsigned int) FLcaptime);
     FLcount = FLcount + 1;
     
     if (FLtoggle == 0)
@@ -140,6 +142,7 @@ void __attribute__ ((__interrupt__, no_auto_psv)) _IC2Interrupt(void)
 {  
     FRcaptime = IC2BUF;
     IC2CON2bits.TRIGSTAT = 0;
+    WheelSpeedCapture(WHEEL_FR, (unsigned int) FRcaptime);
     FRcount = FRcount + 1;
     
     if (FRtoggle == 0)
@@ -161,6 +164,7 @@ void __attribute__ ((__interrupt__, no_auto_psv)) _IC3Interrupt(void)
 {  
     BLcaptime = IC3BUF;
     IC3CON2bits.TRIGSTAT = 0;
+    WheelSpeedCapture(WHEEL_BL, (unsigned int) BLcaptime);
     BLcount = BLcount + 1;
     
     if (BLtoggle == 0)
@@ -182,6 +186,7 @@ void __attribute__ ((__interrupt__, no_auto_psv)) _IC4Interrupt(void)
 {  
     BRcaptime = IC4BUF;
     IC4CON2bits.TRIGSTAT = 0;
+    WheelSpeedCapture(WHEEL_BR, (unsigned int) BRcaptime);
     BRcount = BRcount + 1;
     
     if (BRtoggle == 0)
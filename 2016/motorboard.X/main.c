@@ -11,12 +11,14 @@
 #include "inputCapture.h"
 #include "PWM.h"
 #include "UART.h"
+#include "wheelSpeed.h"
+#include "control.h"
 
 int motorDuty = 1500;
 int servoDuty = 1500;
 
 float desMotor=0;
-float desServo=0;
+float desServo=1500;
 
 char EStopRemote=0;
 
@@ -41,8 +43,12 @@ int main(void)
     LATBbits.LATB2 = 0;         //turn on 
     
     //run input capture init function
+    wheelSpeed_init();
     inputCapture_init();
     PWMInit();
+    UART1Init(57600);
+    UART2Init(9600);
+    initWatchdog();
     
     //start button 
     ANSELBbits.ANSB2 = 0;       //set as general IO
@@ -50,13 +56,26 @@ int main(void)
     
     //collision avoidance flag 
     TRISDbits.TRISD8 = 1;
+    
+    //start the control loop once its inputs are set up
+    control_init();
    
     
     while (1)
     {
+        //desMotor is the target speed in mm/s, desServo the steering pulse in us
+        UART1CheckReceiveBuffer();
+        UART2CheckReceiveBuffer();
+        ControlSetTarget((int) desMotor, (int) desServo);
+        
+        //report wheel speeds to the host as a CANMSG_WHEELSPD frame
+        if (WheelSpeedReady())
+        {
+            unsigned int wheelFrame[4];
+            WheelSpeedGetFrame(wheelFrame);
+            UART1WriteCANFrame(WHEELSPD_SID, 8, wheelFrame);
+        }
         
-        //PWM1SetDutyCycleUS(motorDuty);
-        //PWM2SetDutyCycleUS(servoDuty);
         /*
         LATDbits.LATD3 = 1;
         while (i < 10000)
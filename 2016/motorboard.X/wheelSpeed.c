@@ -0,0 +1,210 @@
+/*
+ * File:   wheelSpeed.c
+ * Author: Jacob
+ *
+ * Description: Wheel speed estimation, see wheelSpeed.h.
+ */
+
+#include "wheelSpeed.h"
+
+typedef struct
+{
+    unsigned long lastEdge;     //extended timer ticks of the last capture
+    unsigned long windowStart;  //last edge before the current publish window
+    unsigned long periods[WHEEL_MEDIAN_TAPS];
+    unsigned int periodIndex;
+    unsigned int validPeriods;
+    unsigned int edges;         //captures in the current publish window
+    char started;
+} WheelState;
+
+volatile int WheelSpeed[WHEEL_COUNT];
+
+/*Written by the capture ISRs and Timer 3, which share priority 4 and so never
+ *preempt each other*/
+static WheelState wheels[WHEEL_COUNT];
+static volatile unsigned int wheelTimerOverflow = 0;
+static volatile char wheelSpeedReady = 0;
+
+/*Timer 2 ISR, extends the capture timebase*/
+void __attribute__((__interrupt__, no_auto_psv)) _T2Interrupt(void)
+{
+    wheelTimerOverflow++;
+    IFS0bits.T2IF = 0;
+}
+
+void wheelSpeed_init(void)
+{
+    unsigned int i;
+    for (i = 0; i < WHEEL_COUNT; i++)
+    {
+        wheels[i].started = 0;
+        wheels[i].validPeriods = 0;
+        wheels[i].periodIndex = 0;
+        wheels[i].edges = 0;
+        WheelSpeed[i] = 0;
+    }
+    wheelTimerOverflow = 0;
+    wheelSpeedReady = 0;
+
+    //Timer 2: free running capture timebase, 1:8
+    T2CON = 0;
+    T2CONbits.TCKPS = 0b01;
+    TMR2 = 0;
+    PR2 = 0xFFFF;
+    IPC1bits.T2IP = 5;      //above the captures so overflows are never late
+    IFS0bits.T2IF = 0;
+    IEC0bits.T2IE = 1;
+    T2CONbits.TON = 1;
+
+    //Timer 3: publish rate, 1:64
+    T3CON = 0;
+    T3CONbits.TCKPS = 0b10;
+    TMR3 = 0;
+    PR3 = (unsigned int) (FCY / 64 / WHEEL_PUBLISH_HZ - 1);
+    IPC2bits.T3IP = 4;      //same as the captures
+    IFS0bits.T3IF = 0;
+    IEC0bits.T3IE = 1;
+    T3CONbits.TON = 1;
+}
+
+/*32-bit time of a 16-bit value read from Timer 2 (or a capture synced to it)
+ *some time before now*/
+static unsigned long WheelExtend(unsigned int ticks)
+{
+    unsigned int overflow;
+    unsigned int now;
+    do
+    {
+        overflow = wheelTimerOverflow;
+        now = TMR2;
+    } while (overflow != wheelTimerOverflow);
+    /*Wrapped, but Timer 2's interrupt hasn't run yet*/
+    if (IFS0bits.T2IF && now < 0x8000)
+    {
+        overflow++;
+    }
+    /*Timer wrapped between the capture and now*/
+    if (ticks > now)
+    {
+        overflow--;
+    }
+    return ((unsigned long) overflow << 16) | ticks;
+}
+
+unsigned long WheelTimeNow(void)
+{
+    return WheelExtend(TMR2);
+}
+
+/*Called from the capture ISRs with the ICxBUF value, constant time*/
+void WheelSpeedCapture(unsigned int wheel, unsigned int capture)
+{
+    WheelState* w = &wheels[wheel];
+    unsigned long t = WheelExtend(capture);
+    if (w->started)
+    {
+        w->periods[w->periodIndex] = t - w->lastEdge;
+        if (++w->periodIndex >= WHEEL_MEDIAN_TAPS)
+            w->periodIndex = 0;
+        if (w->validPeriods < WHEEL_MEDIAN_TAPS)
+            w->validPeriods++;
+        w->edges++;
+    }
+    else
+    {
+        w->windowStart = t;
+        w->started = 1;
+    }
+    w->lastEdge = t;
+}
+
+static unsigned long WheelMedian(WheelState* w)
+{
+    unsigned long sorted[WHEEL_MEDIAN_TAPS];
+    unsigned int n = w->validPeriods;
+    unsigned int i, j;
+    /*insertion sort, at most WHEEL_MEDIAN_TAPS entries*/
+    for (i = 0; i < n; i++)
+    {
+        unsigned long p = w->periods[i];
+        for (j = i; j > 0 && sorted[j - 1] > p; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = p;
+    }
+    return sorted[n / 2];
+}
+
+static int WheelEstimate(WheelState* w, unsigned long now)
+{
+    unsigned long period;
+    unsigned long sinceEdge = now - w->lastEdge;
+
+    if (!w->started || sinceEdge > WHEEL_STOP_TICKS)
+    {
+        /*Stopped, the next edge only restarts the timing*/
+        w->validPeriods = 0;
+        w->periodIndex = 0; /*the median reads periods[0..validPeriods-1]*/
+        w->edges = 0;
+        w->started = 0;
+        return 0;
+    }
+    if (w->validPeriods == 0)
+    {
+        /*Started, waiting on the second edge*/
+        return 0;
+    }
+    if (w->edges >= WHEEL_COUNT_THRESHOLD)
+    {
+        /*Plenty of edges, average over the whole window*/
+        period = (w->lastEdge - w->windowStart) / w->edges;
+    }
+    else
+    {
+        period = WheelMedian(w);
+    }
+    /*Slowing down: the wheel can't be faster than the time since the last edge*/
+    if (sinceEdge > period)
+    {
+        period = sinceEdge;
+    }
+    w->edges = 0;
+    w->windowStart = w->lastEdge;
+
+    if (period <= WHEEL_SPEED_K / 32767)
+        return 32767;
+    return (int) (WHEEL_SPEED_K / period);
+}
+
+/*Timer 3 ISR, fixed rate speed update*/
+void __attribute__((__interrupt__, no_auto_psv)) _T3Interrupt(void)
+{
+    unsigned long now = WheelTimeNow();
+    unsigned int i;
+    for (i = 0; i < WHEEL_COUNT; i++)
+    {
+        WheelSpeed[i] = WheelEstimate(&wheels[i], now);
+    }
+    wheelSpeedReady = 1;
+    IFS0bits.T3IF = 0;
+}
+
+/*Returns 1 once per update*/
+int WheelSpeedReady(void)
+{
+    if (!wheelSpeedReady)
+        return 0;
+    wheelSpeedReady = 0;
+    return 1;
+}
+
+/*_WHLSPD_ payload: FR, FL, BR, BL as little endian int16 mm/s*/
+void WheelSpeedGetFrame(unsigned int * data)
+{
+    IEC0bits.T3IE = 0;
+    data[0] = WheelSpeed[WHEEL_FR];
+    data[1] = WheelSpeed[WHEEL_FL];
+    data[2] = WheelSpeed[WHEEL_BR];
+    data[3] = WheelSpeed[WHEEL_BL];
+    IEC0bits.T3IE = 1;
+}
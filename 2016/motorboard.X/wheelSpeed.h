@@ -0,0 +1,66 @@
+/*
+ * File:   wheelSpeed.h
+ * Author: Jacob
+ *
+ * Description: Wheel speed estimation from the hall effect input captures.
+ *              The capture ISRs hand over timestamps from a 32-bit extended
+ *              Timer 2, and Timer 3 turns them into speeds at a fixed rate:
+ *              median capture-to-capture period at low speed, edge count
+ *              over the window at high speed, zero after a timeout.
+ *              Integer math only.
+ */
+
+#ifndef WHEELSPEED_H
+#define	WHEELSPEED_H
+
+#include <p33Exxxx.h>
+#include "../CAN_to_USB_transceiver.X/CAN_Msg_Priorities.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define FCY                     3685000UL   //instruction clock
+
+    /*Capture timebase: Timer 2 at 1:8, extended to 32 bits by its overflows*/
+#define WHEEL_TIMER_HZ          (FCY / 8)
+
+    /*Wheel geometry, measure on the car. The captures fire on both edges.*/
+#define WHEEL_EDGES_PER_REV     12
+#define WHEEL_CIRCUMFERENCE_MM  330UL
+
+    /*mm/s = WHEEL_SPEED_K / period in timer ticks*/
+#define WHEEL_SPEED_K           (WHEEL_CIRCUMFERENCE_MM * WHEEL_TIMER_HZ / WHEEL_EDGES_PER_REV)
+
+#define WHEEL_PUBLISH_HZ        50
+#define WHEEL_MEDIAN_TAPS       5   //periods kept per wheel for the median
+#define WHEEL_COUNT_THRESHOLD   4   //edges per window above which counts are used
+#define WHEEL_STOP_TICKS        (WHEEL_TIMER_HZ / 2)    //no edge for 0.5s = stopped
+
+    /*CAN ID and layout of the published frame, see _WHLSPD_*/
+#define WHEELSPD_SID            CLC_PRTY01  //CANMSG_WHEELSPD
+
+#define WHEEL_FL 0
+#define WHEEL_FR 1
+#define WHEEL_BL 2
+#define WHEEL_BR 3
+#define WHEEL_COUNT 4
+
+    /*Latest speeds in mm/s, updated at WHEEL_PUBLISH_HZ*/
+    extern volatile int WheelSpeed[WHEEL_COUNT];
+
+    void wheelSpeed_init(void);
+    void WheelSpeedCapture(unsigned int wheel, unsigned int capture);
+    unsigned long WheelTimeNow(void);
+    int WheelSpeedReady(void);
+    void WheelSpeedGetFrame(unsigned int * data);
+
+    void __attribute__((__interrupt__, no_auto_psv)) _T2Interrupt(void);
+    void __attribute__((__interrupt__, no_auto_psv)) _T3Interrupt(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* WHEELSPEED_H */
+
@@ -0,0 +1,136 @@
+/*
+ * @brief: The CAR's planar pose filter. State is x, y (m, east and north of
+ *         the first GPS fix), yaw (rad, counterclockwise from east), forward
+ *         speed v (m/s) and yaw rate w (rad/s), moved on by a constant
+ *         velocity and turn rate model.
+ *
+ *         Measurements from the different sources come in whenever they
+ *         arrive, each with the time it was taken. They wait in a small
+ *         time-ordered queue and are fused oldest first once the filter is
+ *         run up to a time past them, so a late CAN frame or camera frame
+ *         still lands in the right place. Nothing allocates after
+ *         construction and every step has a fixed cost.
+ */
+
+#ifndef CAR_LOCALIZATION_CAR_FILTER_H
+#define CAR_LOCALIZATION_CAR_FILTER_H
+
+#include "car_localization/ekf.h"
+
+#include <stddef.h>
+
+namespace car_localization
+{
+
+// State vector layout
+enum StateIndex
+{
+  STATE_X = 0,
+  STATE_Y,
+  STATE_YAW,
+  STATE_V,
+  STATE_W,
+  STATE_SIZE
+};
+
+enum MeasurementType
+{
+  MEAS_VELOCITY,      // z = v, w. Rear wheels or visual odometry
+  MEAS_HEADING,       // z = yaw. IMU attitude frame
+  MEAS_POSITION       // z = x, y. GPS
+};
+
+struct Measurement
+{
+  double stamp;       // s, when it was taken
+  int type;           // MeasurementType
+  double z[2];
+  double variance[2];
+};
+
+// Fusion queue depth: 100ms of every source at its full rate
+#define MEASUREMENT_QUEUE_SIZE 64
+
+class CarFilter
+{
+public:
+  typedef Ekf<STATE_SIZE> Filter;
+
+  struct Params
+  {
+    double accel_sigma;         // m/s^2, unmodelled acceleration
+    double yaw_accel_sigma;     // rad/s^2, unmodelled change in turn rate
+    double initial_yaw_sigma;   // rad, before the first heading
+    double gate_1d;             // chi-square rejection bounds, 1 and 2 dof
+    double gate_2d;
+    double max_step;            // s, longest single prediction step
+
+    Params()
+      : accel_sigma(2.0), yaw_accel_sigma(4.0), initial_yaw_sigma(3.2),
+        gate_1d(10.83), gate_2d(13.82), max_step(0.1)
+    {}
+  };
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  CarFilter(const Params &params = Params());
+
+  /*
+   * add - queue a measurement.
+   * @return: false if it is older than what has already been fused (late)
+   *          or pushed out the oldest queued one (overflow)
+   */
+  bool add(const Measurement &m);
+
+  /*
+   * process - fuse every queued measurement taken up to time, oldest first.
+   * @return: number fused, rejected ones included
+   */
+  unsigned process(double time);
+
+  /*
+   * extrapolate - state and covariance moved on to time without changing
+   * the filter, for publishing in between measurements.
+   */
+  void extrapolate(double time, Filter::State &x, Filter::Covariance &P) const;
+
+  bool started() const { return started_; }
+  double time() const { return time_; }
+
+  // Counters for diagnostics
+  unsigned long late;         // arrived after the filter had passed them
+  unsigned long overflow;     // pushed out of a full queue
+  unsigned long rejected;     // failed the innovation gate
+
+private:
+  //----------------------------------------------------------------------------
+  // Member objects
+  Params params_;
+  Filter ekf_;
+  double time_;
+  bool started_;
+  bool have_heading_;
+  bool have_velocity_;
+
+  // Time-ordered, oldest at head_
+  Measurement queue_[MEASUREMENT_QUEUE_SIZE];
+  size_t head_;
+  size_t count_;
+
+  //----------------------------------------------------------------------------
+  // Member functions
+  void model(const Filter::State &x, double dt, Filter::State &x_next,
+    Filter::Covariance &F, Filter::Covariance &Q) const;
+  void predictTo(double time);
+  void setState(int i, double value, double variance);
+  void fuse(const Measurement &m);
+};
+
+/*
+ * wrapAngle - the same angle in -pi..pi.
+ */
+double wrapAngle(double a);
+
+} // namespace car_localization
+
+#endif // CAR_LOCALIZATION_CAR_FILTER_H
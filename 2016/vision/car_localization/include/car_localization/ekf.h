@@ -0,0 +1,85 @@
+/*
+ * @brief: Extended Kalman filter on fixed-size Eigen matrices. The state
+ *         size and every measurement size are template parameters, so a
+ *         predict or an update works on the stack only and costs the same
+ *         every time. The model (what f, F, h and H are) is left to the
+ *         caller, see CarFilter::model in car_filter.cpp.
+ */
+
+#ifndef CAR_LOCALIZATION_EKF_H
+#define CAR_LOCALIZATION_EKF_H
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+namespace car_localization
+{
+
+template <int N>
+class Ekf
+{
+public:
+  typedef Eigen::Matrix<double, N, 1> State;
+  typedef Eigen::Matrix<double, N, N> Covariance;
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  //----------------------------------------------------------------------------
+  // Member objects
+  State x;
+  Covariance P;
+
+  Ekf()
+  {
+    x.setZero();
+    P.setIdentity();
+  }
+
+  /*
+   * predict - move the state on to x_next, already run through f by the
+   * caller, with F the Jacobian of f at the old state and Q the process
+   * noise over the step.
+   */
+  void predict(const State &x_next, const Covariance &F, const Covariance &Q)
+  {
+    x = x_next;
+    P = F * P * F.transpose() + Q;
+    P = 0.5 * (P + P.transpose());
+  }
+
+  /*
+   * update - fold in an M-dimensional measurement.
+   * @y: innovation z - h(x), angles already wrapped by the caller
+   * @H: Jacobian of h at x
+   * @R: measurement noise
+   * @gate: chi-square bound on y' S^-1 y, outliers past it are rejected
+   * @return: false if rejected, the state is then unchanged
+   */
+  template <int M>
+  bool update(const Eigen::Matrix<double, M, 1> &y,
+    const Eigen::Matrix<double, M, N> &H,
+    const Eigen::Matrix<double, M, M> &R, double gate)
+  {
+    const Eigen::Matrix<double, N, M> PHt = P * H.transpose();
+    const Eigen::Matrix<double, M, M> S = H * PHt + R;
+    const Eigen::LLT<Eigen::Matrix<double, M, M> > llt(S);
+    if (llt.info() != Eigen::Success)
+      return false;
+
+    if (y.dot(llt.solve(y)) > gate)
+      return false;
+
+    // K = P H' S^-1, solved rather than inverted
+    const Eigen::Matrix<double, N, M> K = llt.solve(PHt.transpose()).transpose();
+    x += K * y;
+
+    // Joseph form keeps P symmetric and positive through rounding
+    const Covariance I_KH = Covariance::Identity() - K * H;
+    P = I_KH * P * I_KH.transpose() + K * R * K.transpose();
+    return true;
+  }
+};
+
+} // namespace car_localization
+
+#endif // CAR_LOCALIZATION_EKF_H
@@ -0,0 +1,225 @@
+/*
+ * @brief: CarFilter, see car_filter.h
+ */
+
+#include "car_localization/car_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace car_localization
+{
+
+double wrapAngle(double a)
+{
+  return std::atan2(std::sin(a), std::cos(a));
+}
+
+CarFilter::CarFilter(const Params &params)
+  : late(0), overflow(0), rejected(0), params_(params), time_(0.0),
+    started_(false), have_heading_(false), have_velocity_(false),
+    head_(0), count_(0)
+{
+  // Starts at the origin, at rest, heading unknown until the IMU says
+  ekf_.P.setZero();
+  ekf_.P(STATE_X, STATE_X) = 1.0;
+  ekf_.P(STATE_Y, STATE_Y) = 1.0;
+  ekf_.P(STATE_YAW, STATE_YAW) = params_.initial_yaw_sigma * params_.initial_yaw_sigma;
+  ekf_.P(STATE_V, STATE_V) = 0.25;
+  ekf_.P(STATE_W, STATE_W) = 0.25;
+}
+
+bool CarFilter::add(const Measurement &m)
+{
+  if (started_ && m.stamp < time_)
+  {
+    ++late;
+    return false;
+  }
+
+  bool dropped = false;
+  if (count_ == MEASUREMENT_QUEUE_SIZE)
+  {
+    head_ = (head_ + 1) % MEASUREMENT_QUEUE_SIZE;
+    --count_;
+    ++overflow;
+    dropped = true;
+  }
+
+  // Insertion from the back, sources are nearly in order so this is short
+  size_t i = count_;
+  while (i > 0)
+  {
+    const Measurement &before = queue_[(head_ + i - 1) % MEASUREMENT_QUEUE_SIZE];
+    if (before.stamp <= m.stamp)
+      break;
+    queue_[(head_ + i) % MEASUREMENT_QUEUE_SIZE] = before;
+    --i;
+  }
+  queue_[(head_ + i) % MEASUREMENT_QUEUE_SIZE] = m;
+  ++count_;
+  return !dropped;
+}
+
+unsigned CarFilter::process(double time)
+{
+  unsigned fused = 0;
+  while (count_ > 0 && queue_[head_].stamp <= time)
+  {
+    const Measurement m = queue_[head_];
+    head_ = (head_ + 1) % MEASUREMENT_QUEUE_SIZE;
+    --count_;
+
+    if (!started_)
+    {
+      time_ = m.stamp;
+      started_ = true;
+    }
+    predictTo(m.stamp);
+    fuse(m);
+    ++fused;
+  }
+  if (started_)
+    predictTo(time);
+  return fused;
+}
+
+void CarFilter::extrapolate(double time, Filter::State &x,
+  Filter::Covariance &P) const
+{
+  x = ekf_.x;
+  P = ekf_.P;
+  double t = time_;
+  while (started_ && t < time)
+  {
+    const double dt = std::min(time - t, params_.max_step);
+    Filter::State x_next;
+    Filter::Covariance F, Q;
+    model(x, dt, x_next, F, Q);
+    x = x_next;
+    P = F * P * F.transpose() + Q;
+    t += dt;
+  }
+}
+
+/*
+ * model - constant speed and turn rate over dt. Q comes from a constant
+ * acceleration and yaw acceleration over the step, drawn from their sigmas.
+ */
+void CarFilter::model(const Filter::State &x, double dt, Filter::State &x_next,
+  Filter::Covariance &F, Filter::Covariance &Q) const
+{
+  const double c = std::cos(x(STATE_YAW));
+  const double s = std::sin(x(STATE_YAW));
+  const double v = x(STATE_V);
+
+  x_next = x;
+  x_next(STATE_X) += v * c * dt;
+  x_next(STATE_Y) += v * s * dt;
+  x_next(STATE_YAW) = wrapAngle(x(STATE_YAW) + x(STATE_W) * dt);
+
+  F.setIdentity();
+  F(STATE_X, STATE_YAW) = -v * s * dt;
+  F(STATE_X, STATE_V) = c * dt;
+  F(STATE_Y, STATE_YAW) = v * c * dt;
+  F(STATE_Y, STATE_V) = s * dt;
+  F(STATE_YAW, STATE_W) = dt;
+
+  Eigen::Matrix<double, STATE_SIZE, 2> G;
+  G.setZero();
+  G(STATE_X, 0) = 0.5 * dt * dt * c;
+  G(STATE_Y, 0) = 0.5 * dt * dt * s;
+  G(STATE_V, 0) = dt;
+  G(STATE_YAW, 1) = 0.5 * dt * dt;
+  G(STATE_W, 1) = dt;
+  const Eigen::Vector2d q(params_.accel_sigma * params_.accel_sigma,
+    params_.yaw_accel_sigma * params_.yaw_accel_sigma);
+  Q = G * q.asDiagonal() * G.transpose();
+}
+
+void CarFilter::predictTo(double time)
+{
+  while (time_ < time)
+  {
+    const double dt = std::min(time - time_, params_.max_step);
+    Filter::State x_next;
+    Filter::Covariance F, Q;
+    model(ekf_.x, dt, x_next, F, Q);
+    ekf_.predict(x_next, F, Q);
+    time_ += dt;
+  }
+}
+
+/*
+ * setState - one state straight from a measurement, uncorrelated with the rest.
+ */
+void CarFilter::setState(int i, double value, double variance)
+{
+  ekf_.x(i) = value;
+  ekf_.P.row(i).setZero();
+  ekf_.P.col(i).setZero();
+  ekf_.P(i, i) = variance;
+}
+
+void CarFilter::fuse(const Measurement &m)
+{
+  bool ok = true;
+
+  switch (m.type)
+  {
+  case MEAS_VELOCITY:
+  {
+    // The first one sets v and w outright, the node may start on the move
+    if (!have_velocity_)
+    {
+      setState(STATE_V, m.z[0], m.variance[0]);
+      setState(STATE_W, m.z[1], m.variance[1]);
+      have_velocity_ = true;
+      break;
+    }
+    Eigen::Matrix<double, 2, STATE_SIZE> H;
+    H.setZero();
+    H(0, STATE_V) = 1.0;
+    H(1, STATE_W) = 1.0;
+    const Eigen::Vector2d y(m.z[0] - ekf_.x(STATE_V), m.z[1] - ekf_.x(STATE_W));
+    const Eigen::Matrix2d R = Eigen::Vector2d(m.variance[0], m.variance[1]).asDiagonal();
+    ok = ekf_.update<2>(y, H, R, params_.gate_2d);
+    break;
+  }
+  case MEAS_HEADING:
+  {
+    // The first heading sets yaw outright, the initial guess is meaningless
+    if (!have_heading_)
+    {
+      setState(STATE_YAW, wrapAngle(m.z[0]), m.variance[0]);
+      have_heading_ = true;
+      break;
+    }
+    Eigen::Matrix<double, 1, STATE_SIZE> H;
+    H.setZero();
+    H(0, STATE_YAW) = 1.0;
+    Eigen::Matrix<double, 1, 1> y, R;
+    y(0) = wrapAngle(m.z[0] - ekf_.x(STATE_YAW));
+    R(0) = m.variance[0];
+    ok = ekf_.update<1>(y, H, R, params_.gate_1d);
+    ekf_.x(STATE_YAW) = wrapAngle(ekf_.x(STATE_YAW));
+    break;
+  }
+  case MEAS_POSITION:
+  {
+    Eigen::Matrix<double, 2, STATE_SIZE> H;
+    H.setZero();
+    H(0, STATE_X) = 1.0;
+    H(1, STATE_Y) = 1.0;
+    const Eigen::Vector2d y(m.z[0] - ekf_.x(STATE_X), m.z[1] - ekf_.x(STATE_Y));
+    const Eigen::Matrix2d R = Eigen::Vector2d(m.variance[0], m.variance[1]).asDiagonal();
+    ok = ekf_.update<2>(y, H, R, params_.gate_2d);
+    break;
+  }
+  }
+
+  if (!ok)
+    ++rejected;
+}
+
+} // namespace car_localization
@@ -0,0 +1,392 @@
+/*
+ * @brief: Localization node. Fuses the CAR's sensors into one pose with
+ *         CarFilter and publishes it as nav_msgs/Odometry on odom and as
+ *         the world_frame -> base_frame transform, at ~rate (100Hz).
+ *
+ *         Sources, each stamped with when it was taken:
+ *          - CANMSG_WHEELSPD from the motorboard: rear wheel speeds give
+ *            speed and yaw rate
+ *          - CANMSG_NAVRPY from the IMU/GPS board: AHRS heading
+ *          - CANMSG_NAVLONLAT from the IMU/GPS board: GPS position, east
+ *            and north of the first fix
+ *          - nav_msgs/Odometry on visual_odom (rtabmap on the ZED, see
+ *            car-ros): body speed and yaw rate from its twist
+ *         The CAN frames are read straight off the SocketCAN interfaces in
+ *         ~can_interfaces, with the kernel's receive time. slcan_bridged
+ *         (can_tools) makes one of the CAN to USB tranciever and one of the
+ *         motorboard's UART1, which sends its wheel speeds as slcan itself.
+ */
+
+#include <ros/ros.h>
+#include <nav_msgs/Odometry.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <tf/transform_broadcaster.h>
+#include <tf/transform_datatypes.h>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "car_localization/car_filter.h"
+
+// CAN IDs
+#include "CAN.h"
+
+#define EARTH_RADIUS 6371000.0
+#define MAX_CAN_FRAMES 64   // per interface per loop, keeps the loop time bounded
+
+using car_localization::CarFilter;
+using car_localization::Measurement;
+
+class Localization_Manager
+{
+private:
+  //----------------------------------------------------------------------------
+  // Member objects
+  ros::NodeHandle nh_;
+  ros::NodeHandle pnh_;
+  ros::Publisher odom_pub_;
+  ros::Subscriber visual_sub_;
+  tf::TransformBroadcaster tf_broadcaster_;
+  CarFilter filter_;
+  std::vector<int> can_sockets_;
+
+  // Parameters
+  std::string world_frame_;
+  std::string base_frame_;
+  double delay_;              // s, how long to wait for late measurements
+  double track_width_;        // m, between the rear wheels
+  double heading_offset_;     // rad, AHRS heading (from magnetic north, up) to yaw
+  double wheel_sigma_;        // m/s, per wheel
+  double heading_sigma_;      // rad
+  double gps_sigma_;          // m
+  double visual_sigma_;       // m/s and rad/s when the message has none
+
+  // GPS origin, the first fix
+  bool have_origin_;
+  double origin_lat_, origin_lon_, origin_cos_lat_;
+
+  // Reused messages, published every loop
+  nav_msgs::Odometry odom_;
+  geometry_msgs::TransformStamped transform_;
+
+public:
+  //----------------------------------------------------------------------------
+  // Member functions
+  // constructor
+  Localization_Manager()
+    : pnh_("~"), filter_(loadFilterParams()), have_origin_(false)
+  {
+    std::vector<std::string> interfaces;
+    pnh_.param("can_interfaces", interfaces, std::vector<std::string>(1, "can0"));
+    pnh_.param<std::string>("world_frame", world_frame_, "odom");
+    pnh_.param<std::string>("base_frame", base_frame_, "base_link");
+    pnh_.param("delay", delay_, 0.03);
+    pnh_.param("track_width", track_width_, 0.25);
+    pnh_.param("heading_offset", heading_offset_, M_PI / 2);
+    pnh_.param("wheel_sigma", wheel_sigma_, 0.05);
+    pnh_.param("heading_sigma", heading_sigma_, 0.05);
+    pnh_.param("gps_sigma", gps_sigma_, 2.5);
+    pnh_.param("visual_sigma", visual_sigma_, 0.1);
+
+    odom_pub_ = nh_.advertise<nav_msgs::Odometry>("odom", 10);
+    visual_sub_ = nh_.subscribe("visual_odom", 10,
+      &Localization_Manager::visual_callback, this);
+
+    odom_.header.frame_id = world_frame_;
+    odom_.child_frame_id = base_frame_;
+    transform_.header.frame_id = world_frame_;
+    transform_.child_frame_id = base_frame_;
+
+    for (size_t i = 0; i < interfaces.size(); ++i)
+      open_can(interfaces[i]);
+  }
+
+  ~Localization_Manager()
+  {
+    for (size_t i = 0; i < can_sockets_.size(); ++i)
+      close(can_sockets_[i]);
+  }
+
+  /*
+   * loadFilterParams - process noise and gates from the parameter server.
+   */
+  static CarFilter::Params loadFilterParams()
+  {
+    ros::NodeHandle pnh("~");
+    CarFilter::Params params;
+    pnh.param("accel_sigma", params.accel_sigma, params.accel_sigma);
+    pnh.param("yaw_accel_sigma", params.yaw_accel_sigma, params.yaw_accel_sigma);
+    pnh.param("gate_1d", params.gate_1d, params.gate_1d);
+    pnh.param("gate_2d", params.gate_2d, params.gate_2d);
+    return params;
+  }
+
+  /*
+   * open_can - raw non-blocking socket on the interface, kernel receive
+   * timestamps on. Added to can_sockets_ if it opened.
+   */
+  void open_can(const std::string &interface)
+  {
+    int can_socket = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (can_socket < 0)
+    {
+      ROS_ERROR("localization: no CAN socket: %s", strerror(errno));
+      return;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    int on = 1;
+    if (ioctl(can_socket, SIOCGIFINDEX, &ifr) < 0
+      || (addr.can_ifindex = ifr.ifr_ifindex,
+        bind(can_socket, (struct sockaddr *) &addr, sizeof(addr)) < 0))
+    {
+      ROS_ERROR("localization: can't open %s: %s", interface.c_str(),
+        strerror(errno));
+      close(can_socket);
+      return;
+    }
+    setsockopt(can_socket, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+    fcntl(can_socket, F_SETFL, fcntl(can_socket, F_GETFL) | O_NONBLOCK);
+
+    // Only the frames this node uses
+    struct can_filter filters[3];
+    const canid_t ids[3] = {CANMSG_WHEELSPD, CANMSG_NAVRPY, CANMSG_NAVLONLAT};
+    for (int i = 0; i < 3; ++i)
+    {
+      filters[i].can_id = ids[i];
+      filters[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    }
+    setsockopt(can_socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+      sizeof(filters));
+    can_sockets_.push_back(can_socket);
+  }
+
+  /*
+   * check_can - hand every frame waiting on the sockets to the filter.
+   */
+  void check_can()
+  {
+    for (size_t i = 0; i < can_sockets_.size(); ++i)
+      check_can(can_sockets_[i]);
+  }
+
+  void check_can(int can_socket)
+  {
+    for (int n = 0; n < MAX_CAN_FRAMES; ++n)
+    {
+      struct can_frame frame;
+      char control[CMSG_SPACE(sizeof(struct timeval))];
+      struct iovec iov = {&frame, sizeof(frame)};
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+
+      if (recvmsg(can_socket, &msg, 0) < (ssize_t) sizeof(frame))
+        return;
+
+      double stamp = ros::Time::now().toSec();
+      for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+      {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_TIMESTAMP)
+        {
+          struct timeval tv;
+          memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+          stamp = tv.tv_sec + tv.tv_usec * 1e-6;
+        }
+      }
+      can_frame_received(frame, stamp);
+    }
+  }
+
+  /*
+   * can_frame_received - decode one frame into a measurement. Payloads are
+   * little endian, laid out by WheelSpeedGetFrame, AHRSGetFrame and
+   * NMEAGetFrame.
+   */
+  void can_frame_received(const struct can_frame &frame, double stamp)
+  {
+    Measurement m;
+    m.stamp = stamp;
+    if (frame.can_dlc != 8)
+      return;
+
+    switch (frame.can_id)
+    {
+    case CANMSG_WHEELSPD:
+    {
+      // mm/s: front right, front left, back right, back left. The hall
+      // sensors don't see direction, reversing reads as forward.
+      const double right = int16(&frame.data[4]) * 1e-3;
+      const double left = int16(&frame.data[6]) * 1e-3;
+      m.type = car_localization::MEAS_VELOCITY;
+      m.z[0] = 0.5 * (right + left);
+      m.z[1] = (right - left) / track_width_;
+      m.variance[0] = 0.5 * wheel_sigma_ * wheel_sigma_;
+      m.variance[1] = 2.0 * wheel_sigma_ * wheel_sigma_ / (track_width_ * track_width_);
+      break;
+    }
+    case CANMSG_NAVRPY:
+      // Heading in 0.01 degrees about up from magnetic north
+      m.type = car_localization::MEAS_HEADING;
+      m.z[0] = car_localization::wrapAngle(
+        heading_offset_ + int16(&frame.data[6]) * (M_PI / 18000.0));
+      m.variance[0] = heading_sigma_ * heading_sigma_;
+      break;
+    case CANMSG_NAVLONLAT:
+    {
+      // 1e-7 degrees, only sent with a valid fix
+      const double lat = int32(&frame.data[0]) * 1e-7 * M_PI / 180.0;
+      const double lon = int32(&frame.data[4]) * 1e-7 * M_PI / 180.0;
+      if (!have_origin_)
+      {
+        origin_lat_ = lat;
+        origin_lon_ = lon;
+        origin_cos_lat_ = std::cos(lat);
+        have_origin_ = true;
+      }
+      m.type = car_localization::MEAS_POSITION;
+      m.z[0] = (lon - origin_lon_) * origin_cos_lat_ * EARTH_RADIUS;
+      m.z[1] = (lat - origin_lat_) * EARTH_RADIUS;
+      m.variance[0] = m.variance[1] = gps_sigma_ * gps_sigma_;
+      break;
+    }
+    default:
+      return;
+    }
+    filter_.add(m);
+  }
+
+  /*
+   * visual_callback - speed and yaw rate from visual odometry, in the body
+   * frame. Its pose drifts on its own so only the twist is used.
+   */
+  void visual_callback(const nav_msgs::Odometry &msg)
+  {
+    Measurement m;
+    m.stamp = msg.header.stamp.toSec();
+    m.type = car_localization::MEAS_VELOCITY;
+    m.z[0] = msg.twist.twist.linear.x;
+    m.z[1] = msg.twist.twist.angular.z;
+    m.variance[0] = msg.twist.covariance[0] > 0.0
+      ? msg.twist.covariance[0] : visual_sigma_ * visual_sigma_;
+    m.variance[1] = msg.twist.covariance[35] > 0.0
+      ? msg.twist.covariance[35] : visual_sigma_ * visual_sigma_;
+    filter_.add(m);
+  }
+
+  /*
+   * update - fuse what is old enough and publish the pose at now.
+   */
+  void update()
+  {
+    const ros::Time now = ros::Time::now();
+    filter_.process(now.toSec() - delay_);
+    if (!filter_.started())
+      return;
+
+    CarFilter::Filter::State x;
+    CarFilter::Filter::Covariance P;
+    filter_.extrapolate(now.toSec(), x, P);
+
+    const geometry_msgs::Quaternion q =
+      tf::createQuaternionMsgFromYaw(x(car_localization::STATE_YAW));
+
+    odom_.header.stamp = now;
+    odom_.pose.pose.position.x = x(car_localization::STATE_X);
+    odom_.pose.pose.position.y = x(car_localization::STATE_Y);
+    odom_.pose.pose.orientation = q;
+    odom_.twist.twist.linear.x = x(car_localization::STATE_V);
+    odom_.twist.twist.angular.z = x(car_localization::STATE_W);
+
+    // 6x6 row major, x y z roll pitch yaw; z, roll and pitch are not estimated
+    const int pose_index[3] = {0, 1, 5};
+    const int pose_state[3] = {car_localization::STATE_X,
+      car_localization::STATE_Y, car_localization::STATE_YAW};
+    for (int i = 0; i < 36; ++i)
+    {
+      odom_.pose.covariance[i] = 0.0;
+      odom_.twist.covariance[i] = 0.0;
+    }
+    for (int i = 0; i < 3; ++i)
+      for (int j = 0; j < 3; ++j)
+        odom_.pose.covariance[pose_index[i] * 6 + pose_index[j]] =
+          P(pose_state[i], pose_state[j]);
+    odom_.pose.covariance[14] = odom_.pose.covariance[21] =
+      odom_.pose.covariance[28] = 1e6;
+    odom_.twist.covariance[0] = P(car_localization::STATE_V, car_localization::STATE_V);
+    odom_.twist.covariance[5] = odom_.twist.covariance[30] =
+      P(car_localization::STATE_V, car_localization::STATE_W);
+    odom_.twist.covariance[35] = P(car_localization::STATE_W, car_localization::STATE_W);
+    odom_pub_.publish(odom_);
+
+    transform_.header.stamp = now;
+    transform_.transform.translation.x = odom_.pose.pose.position.x;
+    transform_.transform.translation.y = odom_.pose.pose.position.y;
+    transform_.transform.translation.z = 0.0;
+    transform_.transform.rotation = q;
+    tf_broadcaster_.sendTransform(transform_);
+
+    if (filter_.late || filter_.overflow || filter_.rejected)
+      ROS_WARN_THROTTLE(10, "localization: %lu late, %lu overflowed, %lu rejected",
+        filter_.late, filter_.overflow, filter_.rejected);
+  }
+
+private:
+  static int int16(const unsigned char *p)
+  {
+    return (int16_t) (p[0] | (p[1] << 8));
+  }
+
+  static long int32(const unsigned char *p)
+  {
+    return (int32_t) ((uint32_t) p[0] | ((uint32_t) p[1] << 8)
+      | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24));
+  }
+};
+
+
+/*
+ * main - fuse and publish at ~rate.
+ */
+int main(int argc, char **argv)
+{
+  ros::init(argc, argv, "localization");
+  Localization_Manager lm;
+
+  double rate;
+  ros::param::param<double>("~rate", rate, 100.0);
+  ros::Rate loop_rate(rate);
+  while (ros::ok())
+  {
+    // New CAN frames and visual odometry into the queue
+    lm.check_can();
+    ros::spinOnce();
+
+    // Fuse and publish
+    lm.update();
+
+    loop_rate.sleep();
+  }
+
+  return 0;
+}
@@ -1,26 +1,30 @@
 /*
  * @author: Andrew Simpson
  * @createdOn: June 20, 2015
- * @brief: Node for serial communications between Arduino controller and Pi.
+ * @brief: Node for communications between the Pi and the CAR's boards.
  */
 
- /** Expected strings: '<4 bytes of data, 1 byte checksum>'
- * Create an array of bytes, add first four and store in the fifth
- * Expect from Kevin: '<2 byte identifier, between 0 and 8 bytes, checksum>'
- * 2 byte identififier used to determine number of incoming bytes,
+ /** The boards are reached over the CAN bus, through the CAN to USB
+ * tranciever. slcan_bridged (can_tools) speaks slcan to it on the serial
+ * port and makes the bus a SocketCAN interface, which this node reads and
+ * writes. See can_tools/README.md.
+ *  - vision_controller/drive_cmd goes out as CANMSG_DESTRAJ
+ *  - CANMSG_START comes back as arduino_comms
  **/
 
 #include "ros/ros.h"
-#include "std_msgs/String.h"
 
-#include <serial/serial.h>
-
-#include <sstream>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
 
+#include <cerrno>
+#include <cstring>
 #include <string>
-#include <iostream>
-#include <cstdio>
-#include <unistd.h>
 
 // Project headers
 #include "car_serial_comms/MessageParser.h"
@@ -31,103 +35,111 @@
 #include "car_serial_comms/ThrottleAndSteering.h"
 
 
-#define BUFFER_SIZE 20
+#define MAX_CAN_FRAMES 16   // per loop
 
-class Serial_Manager
+class Comms_Manager
 {
 private:
   //----------------------------------------------------------------------------
   // Member objects
-  serial::Serial serial_port_;
+  int can_socket_;
   ros::NodeHandle nh_;
   ros::Publisher comms_pub_;
   ros::Subscriber comms_sub_;
   MessageParser mp_;
 
-  // Reused variables for parsing serial input
-  uint8_t buffer_[BUFFER_SIZE];
-  int8_t cnt_;
-
 public:
   //----------------------------------------------------------------------------
   // Member functions
   // constructor
-  Serial_Manager(std::string port, unsigned long baud)
-    : serial_port_(port, baud,serial::Timeout::simpleTimeout(1000))
+  Comms_Manager(const std::string &interface) : can_socket_(-1)
   {
     // Deal with topics
     comms_pub_ = nh_.advertise<car_serial_comms::Start>(
       "arduino_comms", 10);
     comms_sub_ = nh_.subscribe("vision_controller/drive_cmd", 10,
-      &Serial_Manager::send_serial_callback, this);
+      &Comms_Manager::send_drive_callback, this);
 
-    // Initialize buffer
-    cnt_ = 0;
-    for (int i=0; i<BUFFER_SIZE; ++i)
-      buffer_[i] = 0;
+    open_can(interface);
   }
 
-  // Don't need a destructor for now, nothing to do
+  ~Comms_Manager()
+  {
+    if (can_socket_ >= 0)
+      close(can_socket_);
+  }
 
   /*
-   * send_serial_callback - send a received ROS message to the com port.
+   * open_can - raw non-blocking socket on the interface, only the frames
+   * MessageParser uses come in.
    */
-  void send_serial_callback(const car_serial_comms::ThrottleAndSteering& msg)
+  void open_can(const std::string &interface)
   {
-    //Hackety hack code
-    uint8_t temp, checksum = 0;
-    uint16_t temp16 = msg.throttle;
-    temp = temp16;
-    checksum += temp;
-    temp16 >> 8;
-    temp = temp16;
-    checksum += temp;
-    temp16 = msg.steering;
-    temp = temp16;
-    checksum += temp;
-    temp16 >> 8;
-    temp = temp16;
-    checksum += temp;
-
-    //TODO: Build buffer to send data
-    uint8_t serial_buffer[7] = {'<', msg.throttle, msg.steering, checksum,'>'};
-
-    // Write out over serial port
-    serial_port_.write(serial_buffer, 7);
+    can_socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (can_socket_ < 0)
+    {
+      ROS_ERROR("car_comms: no CAN socket: %s", strerror(errno));
+      return;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interface.c_str(), IFNAMSIZ - 1);
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    if (ioctl(can_socket_, SIOCGIFINDEX, &ifr) < 0
+      || (addr.can_ifindex = ifr.ifr_ifindex,
+        bind(can_socket_, (struct sockaddr *) &addr, sizeof(addr)) < 0))
+    {
+      ROS_ERROR("car_comms: can't open %s: %s", interface.c_str(),
+        strerror(errno));
+      close(can_socket_);
+      can_socket_ = -1;
+      return;
+    }
+    fcntl(can_socket_, F_SETFL, fcntl(can_socket_, F_GETFL) | O_NONBLOCK);
+
+    struct can_filter filters[2];
+    const canid_t ids[2] = {CANMSG_START, CANMSG_WHEELSPD};
+    for (int i = 0; i < 2; ++i)
+    {
+      filters[i].can_id = ids[i];
+      filters[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+    }
+    setsockopt(can_socket_, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+      sizeof(filters));
+  }
+
+  /*
+   * send_drive_callback - send a received ROS message out on the bus.
+   */
+  void send_drive_callback(const car_serial_comms::ThrottleAndSteering& msg)
+  {
+    struct can_frame frame;
+    MessageParser::make_drive_frame(msg.throttle, msg.steering, frame);
+    if (can_socket_ < 0 || write(can_socket_, &frame, sizeof(frame)) != sizeof(frame))
+      ROS_WARN_THROTTLE(5, "car_comms: drive command not sent");
   }
 
   /*
-   * check_serial - check if new data has been received on the serial port
+   * check_can - hand every frame waiting on the socket to the parser.
    */
-  void check_serial()
+  void check_can()
   {
-    // Check for available data
-    if (serial_port_.available() > 0)
+    for (int n = 0; can_socket_ >= 0 && n < MAX_CAN_FRAMES; ++n)
     {
-      // Load up the buffer
-      while (serial_port_.available() && cnt_ < BUFFER_SIZE)
-      {
-        // Get one char at a time because lazy
-        serial_port_.read(&buffer_[cnt_++], 1);
-      }
+      struct can_frame frame;
+      if (read(can_socket_, &frame, sizeof(frame)) != sizeof(frame))
+        return;
 
-      // Hand over the message and see if new values are produced
-      if (mp_.parse_message(buffer_, BUFFER_SIZE, cnt_))
+      if (mp_.parse_frame(frame) && frame.can_id == CANMSG_START)
       {
-        //TODO: Get updated values
-        //int steering = mp_.get_steering();
-        //int throttle = mp_.get_throttle();
-        //short odom_read = mp_.get_odometer();
-        //short throttle_read = mp_.get_wheel_speed();
-        bool start_read = mp_.get_Start();
-
         //Make message, load with data, then publish
         car_serial_comms::Start msg;
         msg.header.stamp = ros::Time::now();
         msg.header.frame_id = "/Start_flag";
-        msg.status = start_read;
-        //msg.steering = steering;
-        //msg.throttle = throttle_read;
+        msg.status = mp_.get_start();
 
         // Publish to send out
         comms_pub_.publish(msg);
@@ -138,7 +150,7 @@ public:
 
 
 /*
- * main - connect to Arduino on specified com port.
+ * main - connect to the bus on ~can_interface.
  */
 int main(int argc, char **argv)
 {
@@ -147,18 +159,11 @@ int main(int argc, char **argv)
   //
   // Pass args and node name to ROS for processing...
   ros::init(argc, argv, "serial_comms");
-  //ros::param::param<std::string>("~port", port, "/dev/ttyUSB0");
-  //ros::param::param<int>("~baud", baud, 115200);
+  std::string interface;
+  ros::param::param<std::string>("~can_interface", interface, "can0");
   //****************************************************************************
 
-  //****************************************************************************
-  // Initialize serial
-  //
-  // Open serial port
-  std::string port = "/dev/ttyUSB0"; //Eg. "/dev/ttyUSB0"
-  unsigned long baud = 115200;
-  Serial_Manager sm(port, baud);
-  //****************************************************************************
+  Comms_Manager cm(interface);
 
   // Main loop
   // Run at 60 Hz - twice that of the camera
@@ -166,8 +171,8 @@ int main(int argc, char **argv)
   ros::Rate loop_rate(60);
   while (ros::ok())
   {
-    // Check for new data
-    sm.check_serial();
+    // Check for new frames
+    cm.check_can();
 
     // Let ROS do stuff
     ros::spinOnce();